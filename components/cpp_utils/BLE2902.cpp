@@ -14,12 +14,31 @@
 
 #include "BLE2902.h"
 
+#define NO_CONN_ID (0xffff)
+
 BLE2902::BLE2902() : BLEDescriptor(BLEUUID((uint16_t) 0x2902)) {
 	uint8_t data[2] = { 0, 0 };
 	setValue(data, 2);
+	for (int i = 0; i < BLE2902_MAX_CLIENTS; i++) {
+		m_clientConfig[i].connId = NO_CONN_ID;
+		m_clientConfig[i].value  = 0;
+	}
 } // BLE2902
 
 
+/**
+ * @brief Get the configuration a client has written.
+ * @param [in] conn_id The connection of the client.
+ * @return The configuration bits, or 0 if the client has not written the descriptor.
+ */
+uint16_t BLE2902::getClientConfig(uint16_t conn_id) {
+	for (int i = 0; i < BLE2902_MAX_CLIENTS; i++) {
+		if (m_clientConfig[i].connId == conn_id) return m_clientConfig[i].value;
+	}
+	return 0;
+} // getClientConfig
+
+
 /**
  * @brief Get the notifications value.
  * @return The notifications value.  True if notifications are enabled and false if not.
@@ -29,6 +48,16 @@ bool BLE2902::getNotifications() {
 } // getNotifications
 
 
+/**
+ * @brief Get the notifications value for one client.
+ * @param [in] conn_id The connection of the client.
+ * @return True if that client has enabled notifications and false if not.
+ */
+bool BLE2902::getNotifications(uint16_t conn_id) {
+	return (getClientConfig(conn_id) & (1 << 0)) != 0;
+} // getNotifications
+
+
 /**
  * @brief Get the indications value.
  * @return The indications value.  True if indications are enabled and false if not.
@@ -38,6 +67,74 @@ bool BLE2902::getIndications() {
 } // getIndications
 
 
+/**
+ * @brief Get the indications value for one client.
+ * @param [in] conn_id The connection of the client.
+ * @return True if that client has enabled indications and false if not.
+ */
+bool BLE2902::getIndications(uint16_t conn_id) {
+	return (getClientConfig(conn_id) & (1 << 1)) != 0;
+} // getIndications
+
+
+/**
+ * @brief Handle GATT server events for the descriptor.
+ *
+ * On top of the generic descriptor handling we record the configuration written by each client and
+ * forget it when that client disconnects.
+ *
+ * @param [in] event
+ * @param [in] gatts_if
+ * @param [in] param
+ */
+void BLE2902::handleGATTServerEvent(
+		esp_gatts_cb_event_t      event,
+		esp_gatt_if_t             gatts_if,
+		esp_ble_gatts_cb_param_t* param) {
+	switch (event) {
+		case ESP_GATTS_WRITE_EVT: {
+			if (param->write.handle == getHandle() && !param->write.is_prep && param->write.len >= 1) {
+				uint16_t value = param->write.value[0];
+				if (param->write.len >= 2) value |= param->write.value[1] << 8;
+				setClientConfig(param->write.conn_id, value);
+			}
+			break;
+		} // ESP_GATTS_WRITE_EVT
+
+		case ESP_GATTS_DISCONNECT_EVT: {
+			setClientConfig(param->disconnect.conn_id, 0);
+			break;
+		} // ESP_GATTS_DISCONNECT_EVT
+
+		default:
+			break;
+	} // switch event
+	BLEDescriptor::handleGATTServerEvent(event, gatts_if, param);
+} // handleGATTServerEvent
+
+
+/**
+ * @brief Record the configuration written by a client.
+ * A value of 0 releases the slot held by the client.
+ * @param [in] conn_id The connection of the client.
+ * @param [in] value The configuration bits.
+ */
+void BLE2902::setClientConfig(uint16_t conn_id, uint16_t value) {
+	int freeSlot = -1;
+	for (int i = 0; i < BLE2902_MAX_CLIENTS; i++) {
+		if (m_clientConfig[i].connId == conn_id) {
+			m_clientConfig[i].value = value;
+			if (value == 0) m_clientConfig[i].connId = NO_CONN_ID;
+			return;
+		}
+		if (freeSlot == -1 && m_clientConfig[i].connId == NO_CONN_ID) freeSlot = i;
+	}
+	if (value == 0 || freeSlot == -1) return;
+	m_clientConfig[freeSlot].value  = value;  // Value first so the slot is never seen with a stale value.
+	m_clientConfig[freeSlot].connId = conn_id;
+} // setClientConfig
+
+
 /**
  * @brief Set the indications flag.
  * @param [in] flag The indications flag.
@@ -12,11 +12,21 @@
 
 #include "BLEDescriptor.h"
 
+#if defined(CONFIG_BTDM_CTRL_BLE_MAX_CONN)
+#define BLE2902_MAX_CLIENTS CONFIG_BTDM_CTRL_BLE_MAX_CONN
+#else
+#define BLE2902_MAX_CLIENTS 9
+#endif
+
 /**
  * @brief Descriptor for Client Characteristic Configuration.
  *
  * This is a convenience descriptor for the Client Characteristic Configuration which has a UUID of 0x2902.
  *
+ * Every connected client has its own configuration.  The value a client writes is remembered against its
+ * connection id until it disconnects, and BLECharacteristic::notify() only sends to the clients that have
+ * subscribed.  The getters without a connection id report the value most recently written by any client.
+ *
  * See also:
  * https://www.bluetooth.com/specifications/gatt/viewer?attributeXmlFile=org.bluetooth.descriptor.gatt.client_characteristic_configuration.xml
  */
@@ -24,9 +34,28 @@ class BLE2902: public BLEDescriptor {
 public:
 	BLE2902();
 	bool getNotifications();
+	bool getNotifications(uint16_t conn_id);
 	bool getIndications();
+	bool getIndications(uint16_t conn_id);
 	void setNotifications(bool flag);
 	void setIndications(bool flag);
+	void handleGATTServerEvent(
+			esp_gatts_cb_event_t      event,
+			esp_gatt_if_t             gatts_if,
+			esp_ble_gatts_cb_param_t* param) override;
+
+private:
+	uint16_t getClientConfig(uint16_t conn_id);
+	void     setClientConfig(uint16_t conn_id, uint16_t value);
+
+	/*
+	 * Written from the BT task and read from whichever task calls notify().  The fields are single
+	 * halfwords so a reader never sees a torn value, only possibly one that is a moment old.
+	 */
+	struct {
+		uint16_t connId;
+		uint16_t value;
+	} m_clientConfig[BLE2902_MAX_CLIENTS];
 
 }; // BLE2902
 
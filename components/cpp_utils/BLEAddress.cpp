@@ -92,4 +92,21 @@ std::string BLEAddress::toString() {
 	stream << std::setfill('0') << std::setw(2) << std::hex << (int) ((uint8_t*) (m_address))[5];
 	return stream.str();
 } // toString
+
+
+/**
+ * @brief Pack the address into the low 48 bits of an integer, first byte most significant.
+ *
+ * Two addresses are equal if and only if their packed values are, so the value can be used as a key
+ * without building the string form of the address.
+ *
+ * @return The packed address.
+ */
+uint64_t BLEAddress::toUint64() const {
+	uint64_t value = 0;
+	for (int i = 0; i < ESP_BD_ADDR_LEN; i++) {
+		value = (value << 8) | m_address[i];
+	}
+	return value;
+} // toUint64
 #endif
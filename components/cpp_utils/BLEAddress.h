@@ -25,6 +25,7 @@ public:
 	bool           equals(BLEAddress otherAddress);
 	esp_bd_addr_t* getNative();
 	std::string    toString();
+	uint64_t       toUint64() const;
 
 private:
 	esp_bd_addr_t m_address;
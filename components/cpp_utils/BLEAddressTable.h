@@ -0,0 +1,164 @@
+/*
+ * BLEAddressTable.h
+ */
+
+#ifndef COMPONENTS_CPP_UTILS_BLEADDRESSTABLE_H_
+#define COMPONENTS_CPP_UTILS_BLEADDRESSTABLE_H_
+#include "sdkconfig.h"
+#if defined(CONFIG_BT_ENABLED)
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+/**
+ * @brief A table of objects keyed by a %BLE address packed into 48 bits, as returned by BLEAddress::toUint64(),
+ * or by any other 64 bit key.
+ *
+ * The objects are kept in a dense vector in the order they were added, which is what begin(), end() and
+ * at() walk.  A power of two sized array of slots, searched by linear probing, maps each key to its place
+ * in that vector.  Room for the given number of objects is reserved up front, so neither adding an object
+ * nor looking one up allocates until the table holds more than that.  Removing an object moves the last
+ * one into its place.
+ *
+ * @tparam T The type of object.  The table holds pointers to them and does not own them.
+ */
+template<typename T>
+class BLEAddressTable {
+public:
+	typedef struct {
+		uint64_t key;
+		T*       pObject;
+	} entry_t;
+	typedef typename std::vector<entry_t>::const_iterator const_iterator;
+
+	/**
+	 * @brief Create a table.
+	 * @param [in] capacity The number of objects the table holds before it has to grow.
+	 */
+	explicit BLEAddressTable(size_t capacity) {
+		size_t slots = 8;
+		while (slots < capacity * 2) slots *= 2;  // Keep the load at or below one half.
+		m_slots.assign(slots, (uint32_t)EMPTY);
+		m_entries.reserve(slots / 2);
+	} // BLEAddressTable
+
+	const_iterator begin() const        { return m_entries.begin(); }
+	const_iterator end() const          { return m_entries.end(); }
+	const entry_t& at(size_t i) const   { return m_entries[i]; }
+	size_t         size() const         { return m_entries.size(); }
+
+
+	/**
+	 * @brief Remove every object from the table.  The room reserved is kept.
+	 */
+	void clear() {
+		m_slots.assign(m_slots.size(), (uint32_t)EMPTY);
+		m_entries.clear();
+	} // clear
+
+
+	/**
+	 * @brief Find the object with a key.
+	 * @param [in] key The key.
+	 * @return The object or nullptr if there is none with the key.
+	 */
+	T* find(uint64_t key) const {
+		size_t slot = findSlot(key);
+		return m_slots[slot] == EMPTY ? nullptr : m_entries[m_slots[slot]].pObject;
+	} // find
+
+
+	/**
+	 * @brief Add an object under a key.
+	 * @param [in] key The key.
+	 * @param [in] pObject The object.
+	 * @return False, and the table is unchanged, if there already is an object with the key.
+	 */
+	bool insert(uint64_t key, T* pObject) {
+		size_t slot = findSlot(key);
+		if (m_slots[slot] != EMPTY) return false;
+		if ((m_entries.size() + 1) * 2 > m_slots.size()) {
+			grow();
+			slot = findSlot(key);
+		}
+		m_slots[slot] = m_entries.size();
+		entry_t entry = { key, pObject };
+		m_entries.push_back(entry);
+		return true;
+	} // insert
+
+
+	/**
+	 * @brief Remove the object with a key.
+	 * @param [in] key The key.
+	 * @return The object removed or nullptr if there was none with the key.
+	 */
+	T* remove(uint64_t key) {
+		size_t slot = findSlot(key);
+		if (m_slots[slot] == EMPTY) return nullptr;
+
+		uint32_t index   = m_slots[slot];
+		T*       pObject = m_entries[index].pObject;
+
+		// Shift back any slot later in the probe sequence that could have used the one freed, so that a
+		// search never stops early at an empty slot.
+		size_t mask = m_slots.size() - 1;
+		size_t hole = slot;
+		for (size_t next = (hole + 1) & mask; m_slots[next] != EMPTY; next = (next + 1) & mask) {
+			size_t home = hash(m_entries[m_slots[next]].key);
+			if (((next - home) & mask) >= ((next - hole) & mask)) {
+				m_slots[hole] = m_slots[next];
+				hole = next;
+			}
+		}
+		m_slots[hole] = EMPTY;
+
+		// Move the last object into the hole left in the vector and point its slot at the new place.
+		if (index != m_entries.size() - 1) {
+			m_slots[findSlot(m_entries.back().key)] = index;
+			m_entries[index] = m_entries.back();
+		}
+		m_entries.pop_back();
+		return pObject;
+	} // remove
+
+private:
+	static const uint32_t EMPTY = 0xffffffff;
+
+	std::vector<uint32_t> m_slots;    // Index into m_entries, or EMPTY.
+	std::vector<entry_t>  m_entries;
+
+
+	/**
+	 * @brief The slot a key starts its search at.  The low bits of an address are the ones that differ
+	 * between devices from one vendor, so all of them are mixed into the top bits that are kept.
+	 */
+	size_t hash(uint64_t key) const {
+		return (size_t)((key * 0x9e3779b97f4a7c15ULL) >> 32) & (m_slots.size() - 1);
+	} // hash
+
+
+	/**
+	 * @brief Find the slot holding a key or, if it is not in the table, the empty slot it would go in.
+	 */
+	size_t findSlot(uint64_t key) const {
+		size_t mask = m_slots.size() - 1;
+		size_t slot = hash(key);
+		while (m_slots[slot] != EMPTY && m_entries[m_slots[slot]].key != key) {
+			slot = (slot + 1) & mask;
+		}
+		return slot;
+	} // findSlot
+
+
+	void grow() {
+		m_slots.assign(m_slots.size() * 2, (uint32_t)EMPTY);
+		m_entries.reserve(m_slots.size() / 2);
+		for (uint32_t i = 0; i < m_entries.size(); i++) {
+			m_slots[findSlot(m_entries[i].key)] = i;
+		}
+	} // grow
+}; // BLEAddressTable
+
+#endif /* CONFIG_BT_ENABLED */
+#endif /* COMPONENTS_CPP_UTILS_BLEADDRESSTABLE_H_ */
@@ -13,6 +13,7 @@
  */
 #include "sdkconfig.h"
 #if defined(CONFIG_BT_ENABLED)
+#include <string.h>
 #include <sstream>
 #include "BLEAdvertisedDevice.h"
 #include "BLEUtils.h"
@@ -26,23 +27,11 @@ static const char* LOG_TAG="BLEAdvertisedDevice";
 
 BLEAdvertisedDevice::BLEAdvertisedDevice() {
 	m_adFlag           = 0;
-	m_appearance       = 0;
 	m_deviceType       = 0;
-	m_manufacturerData = "";
-	m_name             = "";
 	m_rssi             = -9999;
-	m_serviceData      = "";
-	m_txPower          = 0;
 	m_pScan            = nullptr;
-
-	m_haveAppearance       = false;
-	m_haveManufacturerData = false;
-	m_haveName             = false;
-	m_haveRSSI             = false;
-	m_haveServiceData      = false;
-	m_haveServiceUUID      = false;
-	m_haveTXPower          = false;
-
+	m_haveRSSI         = false;
+	m_addressType      = BLE_ADDR_TYPE_PUBLIC;
 } // BLEAdvertisedDevice
 
 
@@ -59,6 +48,19 @@ BLEAddress BLEAdvertisedDevice::getAddress() {
 } // getAddress
 
 
+/**
+ * @brief Get a view of the advertising data.
+ *
+ * The view points into this device, so it is valid for as long as the device is and until the device is
+ * given another report.
+ *
+ * @return The view.
+ */
+BLEAdvertisementView BLEAdvertisedDevice::getAdvertisement() {
+	return BLEAdvertisementView(m_payload, m_payloadLength);
+} // getAdvertisement
+
+
 /**
  * @brief Get the appearance.
  *
@@ -68,7 +70,9 @@ BLEAddress BLEAdvertisedDevice::getAddress() {
  * @return The appearance of the advertised device.
  */
 uint16_t BLEAdvertisedDevice::getAppearance() {
-	return m_appearance;
+	uint16_t appearance = 0;
+	getAdvertisement().getAppearance(&appearance);
+	return appearance;
 } // getAppearance
 
 
@@ -77,7 +81,10 @@ uint16_t BLEAdvertisedDevice::getAppearance() {
  * @return The manufacturer data of the advertised device.
  */
 std::string BLEAdvertisedDevice::getManufacturerData() {
-	return m_manufacturerData;
+	const uint8_t* pData;
+	size_t         length;
+	if (!getAdvertisement().getManufacturerData(&pData, &length)) return "";
+	return std::string(reinterpret_cast<const char*>(pData), length);
 } // getManufacturerData
 
 
@@ -86,7 +93,10 @@ std::string BLEAdvertisedDevice::getManufacturerData() {
  * @return The name of the advertised device.
  */
 std::string BLEAdvertisedDevice::getName() {
-	return m_name;
+	const char* pName;
+	size_t      length;
+	if (!getAdvertisement().getName(&pName, &length)) return "";
+	return std::string(pName, length);
 } // getName
 
 
@@ -113,7 +123,11 @@ BLEScan* BLEAdvertisedDevice::getScan() {
  * @return The ServiceData of the advertised device.
  */
 std::string BLEAdvertisedDevice::getServiceData() {
-	return m_serviceData;
+	BLEUUID        uuid;
+	const uint8_t* pData;
+	size_t         length;
+	if (!getAdvertisement().getServiceData(&uuid, &pData, &length)) return "";
+	return std::string(reinterpret_cast<const char*>(pData), length);
 } //getServiceData
 
 
@@ -122,16 +136,22 @@ std::string BLEAdvertisedDevice::getServiceData() {
  * @return The service data UUID.
  */
 BLEUUID BLEAdvertisedDevice::getServiceDataUUID() {
-	return m_serviceDataUUID;
+	BLEUUID        uuid;
+	const uint8_t* pData;
+	size_t         length;
+	getAdvertisement().getServiceData(&uuid, &pData, &length);
+	return uuid;
 } // getServiceDataUUID
 
 
 /**
  * @brief Get the Service UUID.
- * @return The Service UUID of the advertised device.
+ * @return The first Service UUID of the advertised device.
  */
 BLEUUID BLEAdvertisedDevice::getServiceUUID() {  //TODO Remove it eventually, is no longer useful
-	return m_serviceUUIDs[0];
+	BLEUUID uuid;
+	getAdvertisement().getServiceUUID(0, &uuid);
+	return uuid;
 } // getServiceUUID
 
 /**
@@ -139,10 +159,7 @@ BLEUUID BLEAdvertisedDevice::getServiceUUID() {  //TODO Remove it eventually, is
  * @return Return true if service is advertised
  */
 bool BLEAdvertisedDevice::isAdvertisingService(BLEUUID uuid){
-	for (int i = 0; i < m_serviceUUIDs.size(); i++) {
-		if (m_serviceUUIDs[i].equals(uuid)) return true;
-	}
-	return false;
+	return getAdvertisement().hasServiceUUID(uuid);
 }
 
 /**
@@ -150,7 +167,9 @@ bool BLEAdvertisedDevice::isAdvertisingService(BLEUUID uuid){
  * @return The TX Power of the advertised device.
  */
 int8_t BLEAdvertisedDevice::getTXPower() {
-	return m_txPower;
+	int8_t txPower = 0;
+	getAdvertisement().getTXPower(&txPower);
+	return txPower;
 } // getTXPower
 
 
@@ -160,7 +179,8 @@ int8_t BLEAdvertisedDevice::getTXPower() {
  * @return True if there is an appearance value present.
  */
 bool BLEAdvertisedDevice::haveAppearance() {
-	return m_haveAppearance;
+	uint16_t appearance;
+	return getAdvertisement().getAppearance(&appearance);
 } // haveAppearance
 
 
@@ -169,7 +189,8 @@ bool BLEAdvertisedDevice::haveAppearance() {
  * @return True if there is manufacturer data present.
  */
 bool BLEAdvertisedDevice::haveManufacturerData() {
-	return m_haveManufacturerData;
+	ble_ad_record_t record;
+	return getAdvertisement().find(ESP_BLE_AD_MANUFACTURER_SPECIFIC_TYPE, &record);
 } // haveManufacturerData
 
 
@@ -178,7 +199,9 @@ bool BLEAdvertisedDevice::haveManufacturerData() {
  * @return True if there is a name value present.
  */
 bool BLEAdvertisedDevice::haveName() {
-	return m_haveName;
+	const char* pName;
+	size_t      length;
+	return getAdvertisement().getName(&pName, &length);
 } // haveName
 
 
@@ -196,7 +219,10 @@ bool BLEAdvertisedDevice::haveRSSI() {
  * @return True if there is a service data value present.
  */
 bool BLEAdvertisedDevice::haveServiceData() {
-	return m_haveServiceData;
+	BLEUUID        uuid;
+	const uint8_t* pData;
+	size_t         length;
+	return getAdvertisement().getServiceData(&uuid, &pData, &length);
 } // haveServiceData
 
 
@@ -205,7 +231,7 @@ bool BLEAdvertisedDevice::haveServiceData() {
  * @return True if there is a service UUID value present.
  */
 bool BLEAdvertisedDevice::haveServiceUUID() {
-	return m_haveServiceUUID;
+	return getAdvertisement().getServiceUUIDCount() > 0;
 } // haveServiceUUID
 
 
@@ -214,150 +240,27 @@ bool BLEAdvertisedDevice::haveServiceUUID() {
  * @return True if there is a transmission power value present.
  */
 bool BLEAdvertisedDevice::haveTXPower() {
-	return m_haveTXPower;
+	int8_t txPower;
+	return getAdvertisement().getTXPower(&txPower);
 } // haveTXPower
 
 
 /**
- * @brief Parse the advertising pay load.
+ * @brief Take the advertising pay load of a report.
  *
- * The pay load is a buffer of bytes that is either 31 bytes long or terminated by
- * a 0 length value.  Each entry in the buffer has the format:
+ * The pay load is a run of records, the advertisement followed by any scan response.  Each has the format:
  * [length][type][data...]
  *
- * The length does not include itself but does include everything after it until the next record.  A record
- * with a length value of 0 indicates a terminator.
+ * The pay load is only copied here; its records are read when they are asked for, through a
+ * BLEAdvertisementView.  The copy replaces the pay load of any earlier report.
  *
  * https://www.bluetooth.com/specifications/assigned-numbers/generic-access-profile
  */
 void BLEAdvertisedDevice::parseAdvertisement(uint8_t* payload, size_t total_len) {
-	uint8_t length;
-	uint8_t ad_type;
-	uint8_t sizeConsumed = 0;
-	bool finished = false;
-	m_payload = payload;
+	if (total_len > sizeof(m_payload)) total_len = sizeof(m_payload);
+	memcpy(m_payload, payload, total_len);
 	m_payloadLength = total_len;
-
-	while(!finished) {
-		length = *payload;          // Retrieve the length of the record.
-		payload++;                  // Skip to type
-		sizeConsumed += 1 + length; // increase the size consumed.
-
-		if (length != 0) { // A length of 0 indicates that we have reached the end.
-			ad_type = *payload;
-			payload++;
-			length--;
-
-			char* pHex = BLEUtils::buildHexData(nullptr, payload, length);
-			ESP_LOGD(LOG_TAG, "Type: 0x%.2x (%s), length: %d, data: %s",
-					ad_type, BLEUtils::advTypeToString(ad_type), length, pHex);
-			free(pHex);
-
-			switch(ad_type) {
-				case ESP_BLE_AD_TYPE_NAME_CMPL: {   // Adv Data Type: 0x09
-					setName(std::string(reinterpret_cast<char*>(payload), length));
-					break;
-				} // ESP_BLE_AD_TYPE_NAME_CMPL
-
-				case ESP_BLE_AD_TYPE_TX_PWR: {      // Adv Data Type: 0x0A
-					setTXPower(*payload);
-					break;
-				} // ESP_BLE_AD_TYPE_TX_PWR
-
-				case ESP_BLE_AD_TYPE_APPEARANCE: { // Adv Data Type: 0x19
-					setAppearance(*reinterpret_cast<uint16_t*>(payload));
-					break;
-				} // ESP_BLE_AD_TYPE_APPEARANCE
-
-				case ESP_BLE_AD_TYPE_FLAG: {        // Adv Data Type: 0x01
-					setAdFlag(*payload);
-					break;
-				} // ESP_BLE_AD_TYPE_FLAG
-
-				case ESP_BLE_AD_TYPE_16SRV_CMPL:
-				case ESP_BLE_AD_TYPE_16SRV_PART: {   // Adv Data Type: 0x02
-					for (int var = 0; var < length/2; ++var) {
-						setServiceUUID(BLEUUID(*reinterpret_cast<uint16_t*>(payload + var * 2)));
-					}
-					break;
-				} // ESP_BLE_AD_TYPE_16SRV_PART
-
-				case ESP_BLE_AD_TYPE_32SRV_CMPL:
-				case ESP_BLE_AD_TYPE_32SRV_PART: {   // Adv Data Type: 0x04
-					for (int var = 0; var < length/4; ++var) {
-						setServiceUUID(BLEUUID(*reinterpret_cast<uint32_t*>(payload + var * 4)));
-					}
-					break;
-				} // ESP_BLE_AD_TYPE_32SRV_PART
-
-				case ESP_BLE_AD_TYPE_128SRV_CMPL: { // Adv Data Type: 0x07
-					setServiceUUID(BLEUUID(payload, 16, false));
-					break;
-				} // ESP_BLE_AD_TYPE_128SRV_CMPL
-
-				case ESP_BLE_AD_TYPE_128SRV_PART: { // Adv Data Type: 0x06
-					setServiceUUID(BLEUUID(payload, 16, false));
-					break;
-				} // ESP_BLE_AD_TYPE_128SRV_PART
-
-				// See CSS Part A 1.4 Manufacturer Specific Data
-				case ESP_BLE_AD_MANUFACTURER_SPECIFIC_TYPE: {
-					setManufacturerData(std::string(reinterpret_cast<char*>(payload), length));
-					break;
-				} // ESP_BLE_AD_MANUFACTURER_SPECIFIC_TYPE
-
-				case ESP_BLE_AD_TYPE_SERVICE_DATA: {  // Adv Data Type: 0x16 (Service Data) - 2 byte UUID
-					if (length < 2) {
-						ESP_LOGE(LOG_TAG, "Length too small for ESP_BLE_AD_TYPE_SERVICE_DATA");
-						break;
-					}
-					uint16_t uuid = *(uint16_t*)payload;
-					setServiceDataUUID(BLEUUID(uuid));
-					if (length > 2) {
-						setServiceData(std::string(reinterpret_cast<char*>(payload + 2), length - 2));
-					}
-					break;
-				} //ESP_BLE_AD_TYPE_SERVICE_DATA
-
-				case ESP_BLE_AD_TYPE_32SERVICE_DATA: {  // Adv Data Type: 0x20 (Service Data) - 4 byte UUID
-					if (length < 4) {
-						ESP_LOGE(LOG_TAG, "Length too small for ESP_BLE_AD_TYPE_32SERVICE_DATA");
-						break;
-					}
-					uint32_t uuid = *(uint32_t*) payload;
-					setServiceDataUUID(BLEUUID(uuid));
-					if (length > 4) {
-						setServiceData(std::string(reinterpret_cast<char*>(payload + 4), length - 4));
-					}
-					break;
-				} //ESP_BLE_AD_TYPE_32SERVICE_DATA
-
-				case ESP_BLE_AD_TYPE_128SERVICE_DATA: {  // Adv Data Type: 0x21 (Service Data) - 16 byte UUID
-					if (length < 16) {
-						ESP_LOGE(LOG_TAG, "Length too small for ESP_BLE_AD_TYPE_128SERVICE_DATA");
-						break;
-					}
-
-					setServiceDataUUID(BLEUUID(payload, (size_t)16, false));
-					if (length > 16) {
-						setServiceData(std::string(reinterpret_cast<char*>(payload + 16), length - 16));
-					}
-					break;
-				} //ESP_BLE_AD_TYPE_32SERVICE_DATA
-
-				default: {
-					ESP_LOGD(LOG_TAG, "Unhandled type: adType: %d - 0x%.2x", ad_type, ad_type);
-					break;
-				}
-			} // switch
-			payload += length;
-		} // Length <> 0
-
-
-		if (sizeConsumed >= total_len)
-			finished = true;
-
-	} // !finished
+	ESP_LOG_BUFFER_HEXDUMP(LOG_TAG, m_payload, m_payloadLength, ESP_LOG_VERBOSE);
 } // parseAdvertisement
 
 
@@ -379,41 +282,6 @@ void BLEAdvertisedDevice::setAdFlag(uint8_t adFlag) {
 } // setAdFlag
 
 
-/**
- * @brief Set the appearance for this device.
- * @param [in] The discovered appearance.
- */
-void BLEAdvertisedDevice::setAppearance(uint16_t appearance) {
-	m_appearance     = appearance;
-	m_haveAppearance = true;
-	ESP_LOGD(LOG_TAG, "- appearance: %d", m_appearance);
-} // setAppearance
-
-
-/**
- * @brief Set the manufacturer data for this device.
- * @param [in] The discovered manufacturer data.
- */
-void BLEAdvertisedDevice::setManufacturerData(std::string manufacturerData) {
-	m_manufacturerData     = manufacturerData;
-	m_haveManufacturerData = true;
-	char* pHex = BLEUtils::buildHexData(nullptr, (uint8_t*) m_manufacturerData.data(), (uint8_t) m_manufacturerData.length());
-	ESP_LOGD(LOG_TAG, "- manufacturer data: %s", pHex);
-	free(pHex);
-} // setManufacturerData
-
-
-/**
- * @brief Set the name for this device.
- * @param [in] name The discovered name.
- */
-void BLEAdvertisedDevice::setName(std::string name) {
-	m_name     = name;
-	m_haveName = true;
-	ESP_LOGD(LOG_TAG, "- setName(): name: %s", m_name.c_str());
-} // setName
-
-
 /**
  * @brief Set the RSSI for this device.
  * @param [in] rssi The discovered RSSI.
@@ -421,7 +289,6 @@ void BLEAdvertisedDevice::setName(std::string name) {
 void BLEAdvertisedDevice::setRSSI(int rssi) {
 	m_rssi     = rssi;
 	m_haveRSSI = true;
-	ESP_LOGD(LOG_TAG, "- setRSSI(): rssi: %d", m_rssi);
 } // setRSSI
 
 
@@ -434,57 +301,6 @@ void BLEAdvertisedDevice::setScan(BLEScan* pScan) {
 } // setScan
 
 
-/**
- * @brief Set the Service UUID for this device.
- * @param [in] serviceUUID The discovered serviceUUID
- */
-void BLEAdvertisedDevice::setServiceUUID(const char* serviceUUID) {
-	return setServiceUUID(BLEUUID(serviceUUID));
-} // setServiceUUID
-
-
-/**
- * @brief Set the Service UUID for this device.
- * @param [in] serviceUUID The discovered serviceUUID
- */
-void BLEAdvertisedDevice::setServiceUUID(BLEUUID serviceUUID) {
-	m_serviceUUIDs.push_back(serviceUUID);
-	m_haveServiceUUID = true;
-	ESP_LOGD(LOG_TAG, "- addServiceUUID(): serviceUUID: %s", serviceUUID.toString().c_str());
-} // setServiceUUID
-
-
-/**
- * @brief Set the ServiceData value.
- * @param [in] data ServiceData value.
- */
-void BLEAdvertisedDevice::setServiceData(std::string serviceData) {
-	m_haveServiceData = true;         // Set the flag that indicates we have service data.
-	m_serviceData     = serviceData;  // Save the service data that we received.
-} //setServiceData
-
-
-/**
- * @brief Set the ServiceDataUUID value.
- * @param [in] data ServiceDataUUID value.
- */
-void BLEAdvertisedDevice::setServiceDataUUID(BLEUUID uuid) {
-	m_haveServiceData = true;         // Set the flag that indicates we have service data.
-	m_serviceDataUUID = uuid;
-} // setServiceDataUUID
-
-
-/**
- * @brief Set the power level for this device.
- * @param [in] txPower The discovered power level.
- */
-void BLEAdvertisedDevice::setTXPower(int8_t txPower) {
-	m_txPower     = txPower;
-	m_haveTXPower = true;
-	ESP_LOGD(LOG_TAG, "- txPower: %d", m_txPower);
-} // setTXPower
-
-
 /**
  * @brief Create a string representation of this device.
  * @return A string representation of this device.
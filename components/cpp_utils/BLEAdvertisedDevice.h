@@ -14,6 +14,7 @@
 #include <map>
 
 #include "BLEAddress.h"
+#include "BLEAdvertisementView.h"
 #include "BLEScan.h"
 #include "BLEUUID.h"
 
@@ -24,12 +25,18 @@ class BLEScan;
  *
  * When we perform a %BLE scan, the result will be a set of devices that are advertising.  This
  * class provides a model of a detected device.
+ *
+ * The device keeps its own copy of the advertising data of the report, at most 62 bytes, and answers
+ * the get and have methods from it when they are called.  To look at the data without building any
+ * strings or UUIDs, as in a BLEAdvertisedDeviceCallbacks::onResult() that decides whether a device is
+ * of interest, use getAdvertisement().
  */
 class BLEAdvertisedDevice {
 public:
 	BLEAdvertisedDevice();
 
 	BLEAddress  getAddress();
+	BLEAdvertisementView getAdvertisement();
 	uint16_t    getAppearance();
 	std::string getManufacturerData();
 	std::string getName();
@@ -58,44 +65,23 @@ public:
 
 private:
 	friend class BLEScan;
+	friend class BLEScanStream;
 
 	void parseAdvertisement(uint8_t* payload, size_t total_len=62);
 	void setAddress(BLEAddress address);
 	void setAdFlag(uint8_t adFlag);
-	void setAdvertizementResult(uint8_t* payload);
-	void setAppearance(uint16_t appearance);
-	void setManufacturerData(std::string manufacturerData);
-	void setName(std::string name);
 	void setRSSI(int rssi);
 	void setScan(BLEScan* pScan);
-	void setServiceData(std::string data);
-	void setServiceDataUUID(BLEUUID uuid);
-	void setServiceUUID(const char* serviceUUID);
-	void setServiceUUID(BLEUUID serviceUUID);
-	void setTXPower(int8_t txPower);
-
-	bool m_haveAppearance;
-	bool m_haveManufacturerData;
-	bool m_haveName;
+
 	bool m_haveRSSI;
-	bool m_haveServiceData;
-	bool m_haveServiceUUID;
-	bool m_haveTXPower;
 
 
 	BLEAddress  m_address = BLEAddress((uint8_t*)"\0\0\0\0\0\0");
 	uint8_t     m_adFlag;
-	uint16_t    m_appearance;
 	int         m_deviceType;
-	std::string m_manufacturerData;
-	std::string m_name;
 	BLEScan*    m_pScan;
 	int         m_rssi;
-	std::vector<BLEUUID> m_serviceUUIDs;
-	int8_t      m_txPower;
-	std::string m_serviceData;
-	BLEUUID     m_serviceDataUUID;
-	uint8_t*	m_payload = nullptr;
+	uint8_t     m_payload[ESP_BLE_ADV_DATA_LEN_MAX + ESP_BLE_SCAN_RSP_DATA_LEN_MAX];
 	size_t		m_payloadLength = 0;
 	esp_ble_addr_type_t m_addressType;
 };
@@ -0,0 +1,272 @@
+/*
+ * BLEAdvertisementView.cpp
+ *
+ * See also:
+ * https://www.bluetooth.com/specifications/assigned-numbers/generic-access-profile
+ */
+#include "sdkconfig.h"
+#if defined(CONFIG_BT_ENABLED)
+#include <esp_gap_ble_api.h>
+#include "BLEAdvertisementView.h"
+
+
+/**
+ * @brief The size of each UUID in a list of service UUIDs of the given AD type.
+ * @return The size in bytes, or 0 if the type is not a list of service UUIDs.
+ */
+static size_t serviceUUIDSize(uint8_t type) {
+	switch (type) {
+		case ESP_BLE_AD_TYPE_16SRV_PART:
+		case ESP_BLE_AD_TYPE_16SRV_CMPL:
+			return 2;
+		case ESP_BLE_AD_TYPE_32SRV_PART:
+		case ESP_BLE_AD_TYPE_32SRV_CMPL:
+			return 4;
+		case ESP_BLE_AD_TYPE_128SRV_PART:
+		case ESP_BLE_AD_TYPE_128SRV_CMPL:
+			return 16;
+		default:
+			return 0;
+	}
+} // serviceUUIDSize
+
+
+/**
+ * @brief Build a UUID from its little endian form in advertising data.
+ */
+static BLEUUID uuidFromData(const uint8_t* pData, size_t size) {
+	switch (size) {
+		case 2:
+			return BLEUUID((uint16_t) (pData[0] | (pData[1] << 8)));
+		case 4:
+			return BLEUUID((uint32_t) (pData[0] | (pData[1] << 8) | (pData[2] << 16) | ((uint32_t) pData[3] << 24)));
+		default:
+			return BLEUUID(const_cast<uint8_t*>(pData), 16, false);
+	}
+} // uuidFromData
+
+
+BLEAdvertisementView::iterator::iterator(const uint8_t* pPayload, size_t length, size_t offset) {
+	m_pPayload = pPayload;
+	m_length   = length;
+	m_next     = offset;
+	advance();
+} // iterator
+
+
+/**
+ * @brief Move to the next record, or to the end.
+ */
+void BLEAdvertisementView::iterator::advance() {
+	while (m_next < m_length && m_pPayload[m_next] == 0) {  // Skip padding.
+		m_next++;
+	}
+	if (m_next >= m_length || m_next + 1 + m_pPayload[m_next] > m_length) {
+		m_offset = m_next = m_length;
+		return;
+	}
+	m_offset        = m_next;
+	m_record.length = m_pPayload[m_offset] - 1;
+	m_record.type   = m_pPayload[m_offset + 1];
+	m_record.data   = m_pPayload + m_offset + 2;
+	m_next          = m_offset + 1 + m_pPayload[m_offset];
+} // advance
+
+
+/**
+ * @brief Create a view of advertising data.
+ * @param [in] pPayload The data.
+ * @param [in] length The length of the data.
+ */
+BLEAdvertisementView::BLEAdvertisementView(const uint8_t* pPayload, size_t length) {
+	m_pPayload = pPayload;
+	m_length   = pPayload != nullptr ? length : 0;
+} // BLEAdvertisementView
+
+
+BLEAdvertisementView::iterator BLEAdvertisementView::begin() const {
+	return iterator(m_pPayload, m_length, 0);
+} // begin
+
+
+BLEAdvertisementView::iterator BLEAdvertisementView::end() const {
+	return iterator(m_pPayload, m_length, m_length);
+} // end
+
+
+/**
+ * @brief Find the first record of a type.
+ * @param [in] type The AD type.
+ * @param [out] pRecord The record found.
+ * @return True if there is a record of the type.
+ */
+bool BLEAdvertisementView::find(uint8_t type, ble_ad_record_t* pRecord) const {
+	for (auto& record : *this) {
+		if (record.type == type) {
+			*pRecord = record;
+			return true;
+		}
+	}
+	return false;
+} // find
+
+
+/**
+ * @brief Get the appearance.
+ * @param [out] pAppearance The appearance.
+ * @return True if the data has an appearance.
+ */
+bool BLEAdvertisementView::getAppearance(uint16_t* pAppearance) const {
+	ble_ad_record_t record;
+	if (!find(ESP_BLE_AD_TYPE_APPEARANCE, &record) || record.length < 2) return false;
+	*pAppearance = record.data[0] | (record.data[1] << 8);
+	return true;
+} // getAppearance
+
+
+/**
+ * @brief Get the flags.
+ * @param [out] pFlags The flags, such as ESP_BLE_ADV_FLAG_GEN_DISC.
+ * @return True if the data has flags.
+ */
+bool BLEAdvertisementView::getFlags(uint8_t* pFlags) const {
+	ble_ad_record_t record;
+	if (!find(ESP_BLE_AD_TYPE_FLAG, &record) || record.length < 1) return false;
+	*pFlags = record.data[0];
+	return true;
+} // getFlags
+
+
+/**
+ * @brief Get the manufacturer specific data, including the company identifier it starts with.
+ * @param [out] ppData Set to point at the data.
+ * @param [out] pLength The length of the data.
+ * @return True if the data has manufacturer specific data.
+ */
+bool BLEAdvertisementView::getManufacturerData(const uint8_t** ppData, size_t* pLength) const {
+	ble_ad_record_t record;
+	if (!find(ESP_BLE_AD_MANUFACTURER_SPECIFIC_TYPE, &record)) return false;
+	*ppData  = record.data;
+	*pLength = record.length;
+	return true;
+} // getManufacturerData
+
+
+/**
+ * @brief Get the company identifier that starts the manufacturer specific data.
+ * @param [out] pId The company identifier.
+ * @return True if the data has manufacturer specific data with an identifier.
+ */
+bool BLEAdvertisementView::getManufacturerId(uint16_t* pId) const {
+	ble_ad_record_t record;
+	if (!find(ESP_BLE_AD_MANUFACTURER_SPECIFIC_TYPE, &record) || record.length < 2) return false;
+	*pId = record.data[0] | (record.data[1] << 8);
+	return true;
+} // getManufacturerId
+
+
+/**
+ * @brief Get the local name, complete if there is one, else shortened.  It is not null terminated.
+ * @param [out] ppName Set to point at the name.
+ * @param [out] pLength The length of the name.
+ * @return True if the data has a name.
+ */
+bool BLEAdvertisementView::getName(const char** ppName, size_t* pLength) const {
+	ble_ad_record_t record;
+	if (!find(ESP_BLE_AD_TYPE_NAME_CMPL, &record) && !find(ESP_BLE_AD_TYPE_NAME_SHORT, &record)) return false;
+	*ppName  = reinterpret_cast<const char*>(record.data);
+	*pLength = record.length;
+	return true;
+} // getName
+
+
+/**
+ * @brief Get the first service data, of a 16, 32 or 128 bit UUID.
+ * @param [out] pUUID The UUID of the service.
+ * @param [out] ppData Set to point at the data that follows the UUID.
+ * @param [out] pLength The length of that data.
+ * @return True if the data has service data.
+ */
+bool BLEAdvertisementView::getServiceData(BLEUUID* pUUID, const uint8_t** ppData, size_t* pLength) const {
+	for (auto& record : *this) {
+		size_t size;
+		switch (record.type) {
+			case ESP_BLE_AD_TYPE_SERVICE_DATA:    size = 2;  break;
+			case ESP_BLE_AD_TYPE_32SERVICE_DATA:  size = 4;  break;
+			case ESP_BLE_AD_TYPE_128SERVICE_DATA: size = 16; break;
+			default: continue;
+		}
+		if (record.length < size) continue;
+		*pUUID   = uuidFromData(record.data, size);
+		*ppData  = record.data + size;
+		*pLength = record.length - size;
+		return true;
+	}
+	return false;
+} // getServiceData
+
+
+/**
+ * @brief Get the number of service UUIDs in all the lists of service UUIDs.
+ * @return The number of service UUIDs.
+ */
+size_t BLEAdvertisementView::getServiceUUIDCount() const {
+	size_t count = 0;
+	for (auto& record : *this) {
+		size_t size = serviceUUIDSize(record.type);
+		if (size > 0) count += record.length / size;
+	}
+	return count;
+} // getServiceUUIDCount
+
+
+/**
+ * @brief Get a service UUID from the lists of service UUIDs.
+ * @param [in] index The index of the UUID, from 0 to getServiceUUIDCount() - 1.
+ * @param [out] pUUID The UUID.
+ * @return False if there is no such UUID.
+ */
+bool BLEAdvertisementView::getServiceUUID(size_t index, BLEUUID* pUUID) const {
+	for (auto& record : *this) {
+		size_t size = serviceUUIDSize(record.type);
+		if (size == 0) continue;
+		if (index < record.length / size) {
+			*pUUID = uuidFromData(record.data + index * size, size);
+			return true;
+		}
+		index -= record.length / size;
+	}
+	return false;
+} // getServiceUUID
+
+
+/**
+ * @brief Get the transmit power level.
+ * @param [out] pTXPower The power level in dBm.
+ * @return True if the data has a power level.
+ */
+bool BLEAdvertisementView::getTXPower(int8_t* pTXPower) const {
+	ble_ad_record_t record;
+	if (!find(ESP_BLE_AD_TYPE_TX_PWR, &record) || record.length < 1) return false;
+	*pTXPower = (int8_t) record.data[0];
+	return true;
+} // getTXPower
+
+
+/**
+ * @brief Is a service listed in the lists of service UUIDs?
+ * @param [in] uuid The UUID of the service.
+ * @return True if the service is listed.
+ */
+bool BLEAdvertisementView::hasServiceUUID(const BLEUUID& uuid) const {
+	for (auto& record : *this) {
+		size_t size = serviceUUIDSize(record.type);
+		if (size == 0) continue;
+		for (size_t offset = 0; offset + size <= record.length; offset += size) {
+			if (uuidFromData(record.data + offset, size).equals(uuid)) return true;
+		}
+	}
+	return false;
+} // hasServiceUUID
+
+#endif /* CONFIG_BT_ENABLED */
@@ -0,0 +1,85 @@
+/*
+ * BLEAdvertisementView.h
+ */
+
+#ifndef COMPONENTS_CPP_UTILS_BLEADVERTISEMENTVIEW_H_
+#define COMPONENTS_CPP_UTILS_BLEADVERTISEMENTVIEW_H_
+#include "sdkconfig.h"
+#if defined(CONFIG_BT_ENABLED)
+#include <stddef.h>
+#include <stdint.h>
+#include "BLEUUID.h"
+
+/**
+ * @brief One record of advertising data.
+ */
+typedef struct {
+	uint8_t        type;    // The AD type, such as ESP_BLE_AD_TYPE_NAME_CMPL.
+	uint8_t        length;  // The number of bytes of data, not counting the type.
+	const uint8_t* data;
+} ble_ad_record_t;
+
+
+/**
+ * @brief A read-only view of advertising data, as found in a scan report.
+ *
+ * The data is a run of records, each of the form
+ *
+ *   [length: 1 byte][type: 1 byte][length - 1 bytes of data]
+ *
+ * with the scan response, if any, following the advertisement.  The view holds only a pointer to the
+ * data and its length; nothing is copied or allocated, and each question walks the records again, which
+ * for at most 62 bytes costs less than building the answers up front.  The data must outlive the view.
+ *
+ * A record that claims to run past the end of the data ends the walk.  A zero length byte is skipped.
+ */
+class BLEAdvertisementView {
+public:
+	/**
+	 * @brief Walks the records of a view in order.
+	 */
+	class iterator {
+	public:
+		const ble_ad_record_t& operator*() const  { return m_record; }
+		const ble_ad_record_t* operator->() const { return &m_record; }
+		iterator& operator++()                    { advance(); return *this; }
+		bool operator==(const iterator& other) const { return m_offset == other.m_offset; }
+		bool operator!=(const iterator& other) const { return m_offset != other.m_offset; }
+
+	private:
+		friend class BLEAdvertisementView;
+		iterator(const uint8_t* pPayload, size_t length, size_t offset);
+		void advance();
+
+		const uint8_t*  m_pPayload;
+		size_t          m_length;
+		size_t          m_offset;  // Of the current record, or m_length at the end.
+		size_t          m_next;    // Of the record after the current one.
+		ble_ad_record_t m_record;
+	}; // iterator
+
+	BLEAdvertisementView(const uint8_t* pPayload, size_t length);
+
+	iterator       begin() const;
+	iterator       end() const;
+	bool           find(uint8_t type, ble_ad_record_t* pRecord) const;
+	bool           getAppearance(uint16_t* pAppearance) const;
+	bool           getFlags(uint8_t* pFlags) const;
+	bool           getManufacturerData(const uint8_t** ppData, size_t* pLength) const;
+	bool           getManufacturerId(uint16_t* pId) const;
+	bool           getName(const char** ppName, size_t* pLength) const;
+	size_t         getLength() const { return m_length; }
+	const uint8_t* getPayload() const { return m_pPayload; }
+	bool           getServiceData(BLEUUID* pUUID, const uint8_t** ppData, size_t* pLength) const;
+	size_t         getServiceUUIDCount() const;
+	bool           getServiceUUID(size_t index, BLEUUID* pUUID) const;
+	bool           getTXPower(int8_t* pTXPower) const;
+	bool           hasServiceUUID(const BLEUUID& uuid) const;
+
+private:
+	const uint8_t* m_pPayload;
+	size_t         m_length;
+}; // BLEAdvertisementView
+
+#endif /* CONFIG_BT_ENABLED */
+#endif /* COMPONENTS_CPP_UTILS_BLEADVERTISEMENTVIEW_H_ */
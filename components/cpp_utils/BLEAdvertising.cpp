@@ -178,12 +178,32 @@ void BLEAdvertising::setScanResponseData(BLEAdvertisementData& advertisementData
 } // setScanResponseData
 
 /**
- * @brief Start advertising.
- * Start advertising.
- * @return N/A.
+ * @brief Set the manufacturer specific data carried in the advertising packet.
+ *
+ * The data may be changed while advertising; the new data goes out without advertising being stopped and
+ * restarted, so it can be used to broadcast a small live status to passive observers.  The data includes
+ * the 2 byte company identifier and must fit in the space left by the flags and advertised services.  It
+ * is not used if custom advertising data has been set.
+ *
+ * @param [in] data The manufacturer data.
  */
-void BLEAdvertising::start() {
-	ESP_LOGD(LOG_TAG, ">> start: customAdvData: %d, customScanResponseData: %d", m_customAdvData, m_customScanResponseData);
+void BLEAdvertising::setManufacturerData(std::string data) {
+	m_semaphoreSetAdv.take("setManufacturerData");
+	m_manufacturerData = data;
+	m_semaphoreSetAdv.give();
+	if (!m_customAdvData) {
+		configureAdvData(false);
+	}
+} // setManufacturerData
+
+
+/**
+ * @brief Hand the advertising data, and optionally the scan response data, to the BLE stack.
+ * @param [in] scanResponse True to configure the scan response data as well.
+ * @return True on success.
+ */
+bool BLEAdvertising::configureAdvData(bool scanResponse) {
+	m_semaphoreSetAdv.take("configureAdvData");
 
 	// We have a vector of service UUIDs that we wish to advertise.  In order to use the
 	// ESP-IDF framework, these must be supplied in a contiguous array of their 128bit (16 byte)
@@ -205,28 +225,30 @@ void BLEAdvertising::start() {
 		ESP_LOGD(LOG_TAG, "- no services advertised");
 	}
 
-	esp_err_t errRc;
+	esp_err_t errRc = ESP_OK;
 
 	if (!m_customAdvData) {
 		// Set the configuration for advertising.
 		m_advData.set_scan_rsp = false;
 		m_advData.include_name = !m_scanResp;
 		m_advData.include_txpower = !m_scanResp;
+		m_advData.manufacturer_len    = m_manufacturerData.length();
+		m_advData.p_manufacturer_data = m_manufacturerData.empty() ? nullptr : (uint8_t*)m_manufacturerData.data();
 		errRc = ::esp_ble_gap_config_adv_data(&m_advData);
 		if (errRc != ESP_OK) {
 			ESP_LOGE(LOG_TAG, "<< esp_ble_gap_config_adv_data: rc=%d %s", errRc, GeneralUtils::errorToString(errRc));
-			return;
 		}
 	}
 
-	if (!m_customScanResponseData && m_scanResp) {
+	if (errRc == ESP_OK && scanResponse && !m_customScanResponseData && m_scanResp) {
 		m_advData.set_scan_rsp = true;
 		m_advData.include_name = m_scanResp;
 		m_advData.include_txpower = m_scanResp;
+		m_advData.manufacturer_len    = 0;  // The manufacturer data is only in the advertising packet.
+		m_advData.p_manufacturer_data = nullptr;
 		errRc = ::esp_ble_gap_config_adv_data(&m_advData);
 		if (errRc != ESP_OK) {
 			ESP_LOGE(LOG_TAG, "<< esp_ble_gap_config_adv_data (Scan response): rc=%d %s", errRc, GeneralUtils::errorToString(errRc));
-			return;
 		}
 	}
 
@@ -236,9 +258,28 @@ void BLEAdvertising::start() {
 		delete[] m_advData.p_service_uuid;
 		m_advData.p_service_uuid = nullptr;
 	}
+	m_advData.manufacturer_len    = 0;
+	m_advData.p_manufacturer_data = nullptr;
+
+	m_semaphoreSetAdv.give();
+	return errRc == ESP_OK;
+} // configureAdvData
+
+
+/**
+ * @brief Start advertising.
+ * Start advertising.
+ * @return N/A.
+ */
+void BLEAdvertising::start() {
+	ESP_LOGD(LOG_TAG, ">> start: customAdvData: %d, customScanResponseData: %d", m_customAdvData, m_customScanResponseData);
+
+	if (!configureAdvData(true)) {
+		return;
+	}
 
 	// Start advertising.
-	errRc = ::esp_ble_gap_start_advertising(&m_advParams);
+	esp_err_t errRc = ::esp_ble_gap_start_advertising(&m_advParams);
 	if (errRc != ESP_OK) {
 		ESP_LOGE(LOG_TAG, "<< esp_ble_gap_start_advertising: rc=%d %s", errRc, GeneralUtils::errorToString(errRc));
 		return;
@@ -493,7 +534,6 @@ void BLEAdvertising::handleGAPEvent(
 		}
 		case ESP_GAP_BLE_ADV_STOP_COMPLETE_EVT: {
 			ESP_LOGI(LOG_TAG, "STOP advertising");
-			start();
 			break;
 		}
 		default:
@@ -63,8 +63,11 @@ public:
 	void setMinPreferred(uint16_t);
 	void setMaxPreferred(uint16_t);
 	void setScanResponse(bool);
+	void setManufacturerData(std::string data);
 
 private:
+	bool                 configureAdvData(bool scanResponse);
+
 	esp_ble_adv_data_t   m_advData;
 	esp_ble_adv_params_t m_advParams;
 	std::vector<BLEUUID> m_serviceUUIDs;
@@ -72,6 +75,7 @@ private:
 	bool                 m_customScanResponseData = false;  // Are we using custom scan response data?
 	FreeRTOS::Semaphore  m_semaphoreSetAdv = FreeRTOS::Semaphore("startAdvert");
 	bool				m_scanResp = true;
+	std::string          m_manufacturerData;
 
 };
 #endif /* CONFIG_BT_ENABLED */
@@ -0,0 +1,219 @@
+/*
+ * BLEAdvertisingManager.cpp
+ */
+#include "sdkconfig.h"
+#if defined(CONFIG_BT_ENABLED)
+#include "BLEAdvertisingManager.h"
+#if defined(ARDUINO_ARCH_ESP32) && defined(CONFIG_ARDUHAL_ESP_LOG)
+#include "esp32-hal-log.h"
+#define LOG_TAG ""
+#else
+#include "esp_log.h"
+static const char* LOG_TAG = "BLEAdvertisingManager";
+#endif
+
+
+/**
+ * @brief Construct an advertising manager.
+ *
+ * The default fast interval is 20-30ms for 30 seconds and the default slow interval is 1000-1050ms.
+ *
+ * @param [in] pAdvertising The advertising to manage.
+ * @param [in] maxConnections The number of connections at which advertising stops.
+ */
+BLEAdvertisingManager::BLEAdvertisingManager(BLEAdvertising* pAdvertising, uint16_t maxConnections) {
+	m_pAdvertising   = pAdvertising;
+	m_maxConnections = maxConnections;
+	m_fastMin        = 0x20;    // 20ms
+	m_fastMax        = 0x30;    // 30ms
+	m_fastTimeoutMs  = 30000;
+	m_slowMin        = 0x640;   // 1000ms
+	m_slowMax        = 0x690;   // 1050ms
+	m_phase          = ADV_OFF;
+	m_pendingPhase   = ADV_OFF;
+	m_pending        = false;
+	m_lastRestart    = 0;
+	m_restarts       = 0;
+	m_windowStart    = 0;
+	m_windowRestarts = 0;
+	m_pFastTimer     = new FreeRTOSTimer((char*)"advFast", pdMS_TO_TICKS(m_fastTimeoutMs), pdFALSE, this, fastTimeout);
+	m_pRestartTimer  = new FreeRTOSTimer((char*)"advRestart", pdMS_TO_TICKS(MIN_RESTART_MS), pdFALSE, this, restartTimeout);
+} // BLEAdvertisingManager
+
+
+BLEAdvertisingManager::~BLEAdvertisingManager() {
+	delete m_pFastTimer;
+	delete m_pRestartTimer;
+} // ~BLEAdvertisingManager
+
+
+/**
+ * @brief Move to a phase, holding the change back if the last restart was too recent or the restarts
+ * of the current window have been used up.
+ * Called with the lock held.
+ * @param [in] phase The phase to move to.
+ */
+void BLEAdvertisingManager::apply(phase_t phase) {
+	if (phase == m_phase) {
+		m_pending = false;  // Whatever was held back is no longer wanted.
+		return;
+	}
+
+	TickType_t now  = xTaskGetTickCount();
+	TickType_t wait = 0;
+	if (m_restarts > 0 && now - m_lastRestart < pdMS_TO_TICKS(MIN_RESTART_MS)) {
+		wait = pdMS_TO_TICKS(MIN_RESTART_MS) - (now - m_lastRestart);
+	}
+	if (m_windowRestarts >= MAX_RESTARTS && now - m_windowStart < pdMS_TO_TICKS(RESTART_WINDOW_MS)) {
+		TickType_t windowLeft = pdMS_TO_TICKS(RESTART_WINDOW_MS) - (now - m_windowStart);
+		if (windowLeft > wait) wait = windowLeft;
+	}
+	if (wait > 0) {
+		m_pendingPhase = phase;
+		if (!m_pending) {
+			m_pending = true;
+			m_pRestartTimer->changePeriod(wait, 0);  // Also starts the timer.
+		}
+		return;
+	}
+	applyNow(phase);
+} // apply
+
+
+/**
+ * @brief Restart advertising in a phase.  Called with the lock held.
+ * @param [in] phase The phase to move to.
+ */
+void BLEAdvertisingManager::applyNow(phase_t phase) {
+	ESP_LOGD(LOG_TAG, ">> applyNow: phase: %d -> %d", m_phase, phase);
+	if (m_phase != ADV_OFF) {
+		m_pAdvertising->stop();
+	}
+	if (phase == ADV_FAST) {
+		m_pAdvertising->setMinInterval(m_fastMin);
+		m_pAdvertising->setMaxInterval(m_fastMax);
+	} else if (phase == ADV_SLOW) {
+		m_pAdvertising->setMinInterval(m_slowMin);
+		m_pAdvertising->setMaxInterval(m_slowMax);
+	}
+	if (phase != ADV_OFF) {
+		m_pAdvertising->start();
+	}
+	m_phase       = phase;
+	m_pending     = false;
+	m_lastRestart = xTaskGetTickCount();
+	m_restarts++;
+	if (m_lastRestart - m_windowStart >= pdMS_TO_TICKS(RESTART_WINDOW_MS)) {
+		m_windowStart    = m_lastRestart;
+		m_windowRestarts = 0;
+	}
+	m_windowRestarts++;
+	ESP_LOGD(LOG_TAG, "<< applyNow");
+} // applyNow
+
+
+/**
+ * @brief Called by the fast timer when the fast period is over.
+ */
+void BLEAdvertisingManager::fastTimeout(FreeRTOSTimer* pTimer) {
+	BLEAdvertisingManager* pManager = (BLEAdvertisingManager*)pTimer->getData();
+	pManager->m_semaphore.take("fastTimeout");
+	if (pManager->m_pending ? pManager->m_pendingPhase == ADV_FAST : pManager->m_phase == ADV_FAST) {
+		pManager->apply(ADV_SLOW);
+	}
+	pManager->m_semaphore.give();
+} // fastTimeout
+
+
+/**
+ * @brief Get the number of times advertising has been (re)started or stopped by the manager.
+ * @return The number of restarts.
+ */
+uint32_t BLEAdvertisingManager::getRestarts() {
+	return m_restarts;
+} // getRestarts
+
+
+/**
+ * @brief Handle a client having connected.
+ * The controller stops advertising when a client connects.  Advertising resumes at the slow interval
+ * unless all the connection slots are now in use.
+ * @param [in] connectedCount The number of connected clients, including the new one.
+ */
+void BLEAdvertisingManager::handleConnect(uint32_t connectedCount) {
+	m_semaphore.take("handleConnect");
+	m_phase = ADV_OFF;
+	m_pFastTimer->stop(0);
+	apply(connectedCount < m_maxConnections ? ADV_SLOW : ADV_OFF);
+	m_semaphore.give();
+} // handleConnect
+
+
+/**
+ * @brief Handle a client having disconnected.
+ * Advertising goes to the fast interval so that the client can reconnect quickly, unless the clients
+ * still connected take every connection slot.
+ * @param [in] connectedCount The number of clients still connected.
+ */
+void BLEAdvertisingManager::handleDisconnect(uint32_t connectedCount) {
+	m_semaphore.take("handleDisconnect");
+	if (connectedCount >= m_maxConnections) {
+		apply(ADV_OFF);
+	} else {
+		apply(ADV_FAST);
+		m_pFastTimer->changePeriod(pdMS_TO_TICKS(m_fastTimeoutMs), 0);  // (Re)starts the fast period.
+	}
+	m_semaphore.give();
+} // handleDisconnect
+
+
+/**
+ * @brief Called by the restart timer when a held back change may be applied.
+ */
+void BLEAdvertisingManager::restartTimeout(FreeRTOSTimer* pTimer) {
+	BLEAdvertisingManager* pManager = (BLEAdvertisingManager*)pTimer->getData();
+	pManager->m_semaphore.take("restartTimeout");
+	if (pManager->m_pending) {
+		pManager->m_pending = false;
+		pManager->apply(pManager->m_pendingPhase);
+	}
+	pManager->m_semaphore.give();
+} // restartTimeout
+
+
+/**
+ * @brief Set the fast advertising interval.
+ * The new values are used from the next restart.
+ * @param [in] minInterval The minimum interval in units of 0.625ms.
+ * @param [in] maxInterval The maximum interval in units of 0.625ms.
+ * @param [in] timeoutMs How long to advertise at the fast interval before backing off.
+ */
+void BLEAdvertisingManager::setFastIntervals(uint16_t minInterval, uint16_t maxInterval, uint32_t timeoutMs) {
+	m_fastMin       = minInterval;
+	m_fastMax       = maxInterval;
+	m_fastTimeoutMs = timeoutMs;
+} // setFastIntervals
+
+
+/**
+ * @brief Set the slow advertising interval.
+ * @param [in] minInterval The minimum interval in units of 0.625ms.
+ * @param [in] maxInterval The maximum interval in units of 0.625ms.
+ */
+void BLEAdvertisingManager::setSlowIntervals(uint16_t minInterval, uint16_t maxInterval) {
+	m_slowMin = minInterval;
+	m_slowMax = maxInterval;
+} // setSlowIntervals
+
+
+/**
+ * @brief Start advertising at the fast interval, as at boot.
+ */
+void BLEAdvertisingManager::start() {
+	m_semaphore.take("start");
+	apply(ADV_FAST);
+	m_pFastTimer->changePeriod(pdMS_TO_TICKS(m_fastTimeoutMs), 0);  // (Re)starts the fast period.
+	m_semaphore.give();
+} // start
+
+#endif /* CONFIG_BT_ENABLED */
@@ -0,0 +1,83 @@
+/*
+ * BLEAdvertisingManager.h
+ */
+
+#ifndef COMPONENTS_CPP_UTILS_BLEADVERTISINGMANAGER_H_
+#define COMPONENTS_CPP_UTILS_BLEADVERTISINGMANAGER_H_
+#include "sdkconfig.h"
+#if defined(CONFIG_BT_ENABLED)
+#include <stdint.h>
+#include "BLEAdvertising.h"
+#include "FreeRTOS.h"
+#include "FreeRTOSTimer.h"
+
+#if defined(CONFIG_BTDM_CTRL_BLE_MAX_CONN)
+#define BLE_ADV_MANAGER_MAX_CONN CONFIG_BTDM_CTRL_BLE_MAX_CONN
+#else
+#define BLE_ADV_MANAGER_MAX_CONN 3
+#endif
+
+/**
+ * @brief Decide when and how fast a %BLE server advertises.
+ *
+ * Right after start() and after a client disconnects the server advertises at a fast interval so that a
+ * phone finds it, or reconnects, quickly.  Once the fast period has run out it backs off to a slow
+ * interval to save power.  While every connection slot is in use it does not advertise at all.
+ *
+ * Changing the interval means stopping and restarting advertising.  Restarts are spaced at least
+ * MIN_RESTART_MS apart and there are at most MAX_RESTARTS in any RESTART_WINDOW_MS, so that clients
+ * connecting and dropping in a loop cannot keep the radio busy restarting.  A change asked for sooner is
+ * held back and applied when the time is up, and only the latest change is applied.
+ *
+ * Install it with BLEServer::setAdvertisingManager(); the server then reports connections and
+ * disconnections to it instead of restarting advertising itself.
+ */
+class BLEAdvertisingManager {
+public:
+	static const uint32_t MIN_RESTART_MS    = 500;
+	static const uint32_t MAX_RESTARTS      = 10;
+	static const uint32_t RESTART_WINDOW_MS = 60000;
+
+	BLEAdvertisingManager(BLEAdvertising* pAdvertising, uint16_t maxConnections = BLE_ADV_MANAGER_MAX_CONN);
+	~BLEAdvertisingManager();
+
+	uint32_t getRestarts();
+	void     handleConnect(uint32_t connectedCount);
+	void     handleDisconnect(uint32_t connectedCount);
+	void     setFastIntervals(uint16_t minInterval, uint16_t maxInterval, uint32_t timeoutMs);
+	void     setSlowIntervals(uint16_t minInterval, uint16_t maxInterval);
+	void     start();
+
+private:
+	typedef enum {
+		ADV_OFF,
+		ADV_FAST,
+		ADV_SLOW
+	} phase_t;
+
+	void        apply(phase_t phase);
+	void        applyNow(phase_t phase);
+	static void fastTimeout(FreeRTOSTimer* pTimer);
+	static void restartTimeout(FreeRTOSTimer* pTimer);
+
+	BLEAdvertising*     m_pAdvertising;
+	uint16_t            m_maxConnections;
+	uint16_t            m_fastMin;
+	uint16_t            m_fastMax;
+	uint32_t            m_fastTimeoutMs;
+	uint16_t            m_slowMin;
+	uint16_t            m_slowMax;
+	phase_t             m_phase;         // What the controller is doing now.
+	phase_t             m_pendingPhase;  // A change held back until MIN_RESTART_MS has passed.
+	bool                m_pending;
+	TickType_t          m_lastRestart;
+	uint32_t            m_restarts;
+	TickType_t          m_windowStart;     // When the current RESTART_WINDOW_MS began.
+	uint32_t            m_windowRestarts;  // Restarts made since then.
+	FreeRTOSTimer*      m_pFastTimer;
+	FreeRTOSTimer*      m_pRestartTimer;
+	FreeRTOS::Semaphore m_semaphore = FreeRTOS::Semaphore("AdvManager");
+}; // BLEAdvertisingManager
+
+#endif /* CONFIG_BT_ENABLED */
+#endif /* COMPONENTS_CPP_UTILS_BLEADVERTISINGMANAGER_H_ */
@@ -0,0 +1,137 @@
+/*
+ * BLEAttributeRegistry.h
+ */
+
+#ifndef COMPONENTS_CPP_UTILS_BLEATTRIBUTEREGISTRY_H_
+#define COMPONENTS_CPP_UTILS_BLEATTRIBUTEREGISTRY_H_
+#include "sdkconfig.h"
+#if defined(CONFIG_BT_ENABLED)
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#include <vector>
+#include "BLEUUID.h"
+
+/**
+ * @brief The storage behind the service, characteristic and descriptor maps.
+ *
+ * Attributes are kept in three flat vectors: in the order they were registered, sorted by handle and
+ * sorted by the hash of their UUID.  They are registered while a service is being built and their
+ * handles are known once it has been created, so the sorted vectors are only touched then; looking an
+ * attribute up while events are dispatched is a binary search over contiguous memory.
+ *
+ * Iterate with begin() and end().  Iterators hold no state in the registry, so a handler may walk the
+ * registry while another walk of it is in progress.  Registering attributes invalidates them.
+ *
+ * @tparam T The attribute type.  It must have a getUUID() method.
+ */
+template<typename T>
+class BLEAttributeRegistry {
+public:
+	typedef typename std::vector<T*>::const_iterator const_iterator;
+
+	const_iterator begin() const { return m_entries.begin(); }
+	const_iterator end() const   { return m_entries.end(); }
+	size_t         size() const  { return m_entries.size(); }
+
+
+	/**
+	 * @brief Register an attribute under its UUID.  Registering it again does nothing.
+	 * @param [in] pAttribute The attribute.
+	 * @param [in] uuid The UUID of the attribute.
+	 */
+	void add(T* pAttribute, const BLEUUID& uuid) {
+		if (std::find(m_entries.begin(), m_entries.end(), pAttribute) != m_entries.end()) return;
+		m_entries.push_back(pAttribute);
+		uuid_entry_t entry = { uuid.hash(), uuid, pAttribute };
+		m_byUUID.insert(std::upper_bound(m_byUUID.begin(), m_byUUID.end(), entry, compareHash), entry);
+	} // add
+
+
+	/**
+	 * @brief Find an attribute by handle.
+	 * @param [in] handle The handle.
+	 * @return The attribute or nullptr if no attribute has the handle.
+	 */
+	T* getByHandle(uint16_t handle) const {
+		handle_entry_t key = { handle, nullptr };
+		auto it = std::lower_bound(m_byHandle.begin(), m_byHandle.end(), key, compareHandle);
+		if (it == m_byHandle.end() || it->handle != handle) return nullptr;
+		return it->pAttribute;
+	} // getByHandle
+
+
+	/**
+	 * @brief Find an attribute by UUID.
+	 * @param [in] uuid The UUID.
+	 * @return The first attribute registered with the UUID or nullptr if there is none.
+	 */
+	T* getByUUID(const BLEUUID& uuid) const {
+		uuid_entry_t key = { uuid.hash(), uuid, nullptr };
+		for (auto it = std::lower_bound(m_byUUID.begin(), m_byUUID.end(), key, compareHash);
+				it != m_byUUID.end() && it->hash == key.hash; ++it) {
+			if (it->uuid.equals(uuid)) return it->pAttribute;
+		}
+		return nullptr;
+	} // getByUUID
+
+
+	/**
+	 * @brief Forget an attribute.
+	 * @param [in] pAttribute The attribute.
+	 */
+	void remove(T* pAttribute) {
+		m_entries.erase(std::remove(m_entries.begin(), m_entries.end(), pAttribute), m_entries.end());
+		m_byHandle.erase(std::remove_if(m_byHandle.begin(), m_byHandle.end(),
+			[pAttribute](const handle_entry_t& entry) { return entry.pAttribute == pAttribute; }), m_byHandle.end());
+		m_byUUID.erase(std::remove_if(m_byUUID.begin(), m_byUUID.end(),
+			[pAttribute](const uuid_entry_t& entry) { return entry.pAttribute == pAttribute; }), m_byUUID.end());
+	} // remove
+
+
+	/**
+	 * @brief Record the handle of an attribute.  A handle that is already known is reassigned.
+	 * @param [in] handle The handle.
+	 * @param [in] pAttribute The attribute.
+	 */
+	void setHandle(uint16_t handle, T* pAttribute) {
+		handle_entry_t entry = { handle, pAttribute };
+		auto it = std::lower_bound(m_byHandle.begin(), m_byHandle.end(), entry, compareHandle);
+		if (it != m_byHandle.end() && it->handle == handle) {
+			it->pAttribute = pAttribute;
+		} else {
+			m_byHandle.insert(it, entry);
+		}
+	} // setHandle
+
+
+	/**
+	 * @brief Get the number of attributes whose handle is known.
+	 * @return The number of handles.
+	 */
+	size_t getHandleCount() const {
+		return m_byHandle.size();
+	} // getHandleCount
+
+private:
+	typedef struct {
+		uint16_t handle;
+		T*       pAttribute;
+	} handle_entry_t;
+
+	typedef struct {
+		size_t   hash;
+		BLEUUID  uuid;
+		T*       pAttribute;
+	} uuid_entry_t;
+
+	static bool compareHandle(const handle_entry_t& a, const handle_entry_t& b) { return a.handle < b.handle; }
+	static bool compareHash(const uuid_entry_t& a, const uuid_entry_t& b) { return a.hash < b.hash; }
+
+	std::vector<T*>             m_entries;   // In the order registered.
+	std::vector<handle_entry_t> m_byHandle;  // Sorted by handle.
+	std::vector<uuid_entry_t>   m_byUUID;    // Sorted by UUID hash.
+}; // BLEAttributeRegistry
+
+#endif /* CONFIG_BT_ENABLED */
+#endif /* COMPONENTS_CPP_UTILS_BLEATTRIBUTEREGISTRY_H_ */
@@ -76,6 +76,55 @@ void BLECharacteristic::addDescriptor(BLEDescriptor* pDescriptor) {
 } // addDescriptor
 
 
+/**
+ * @brief Append the attributes of this characteristic to a service attribute table.
+ *
+ * The entries are the characteristic declaration, the characteristic value and then one entry for each
+ * descriptor.  They point into this characteristic and its descriptors, which must stay alive until
+ * ESP_GATTS_CREAT_ATTR_TAB_EVT has arrived.
+ *
+ * @param [in] pService The service with which to associate this characteristic.
+ * @param [in] pAttrTable The table being built.
+ */
+void BLECharacteristic::appendAttrTable(BLEService* pService, std::vector<esp_gatts_attr_db_t>* pAttrTable) {
+	static uint16_t charDeclareUUID = ESP_GATT_UUID_CHAR_DECLARE;
+
+	m_pService = pService; // Save the service to which this characteristic belongs.
+
+	esp_gatts_attr_db_t attr;
+	attr.attr_control.auto_rsp = ESP_GATT_AUTO_RSP;
+	attr.att_desc.uuid_length  = ESP_UUID_LEN_16;
+	attr.att_desc.uuid_p       = (uint8_t*)&charDeclareUUID;
+	attr.att_desc.perm         = ESP_GATT_PERM_READ;
+	attr.att_desc.max_length   = sizeof(m_properties);
+	attr.att_desc.length       = sizeof(m_properties);
+	attr.att_desc.value        = (uint8_t*)&m_properties;
+	pAttrTable->push_back(attr);
+
+	esp_bt_uuid_t* pUUID = m_bleUUID.getNative();
+	attr.attr_control.auto_rsp = ESP_GATT_RSP_BY_APP;
+	attr.att_desc.uuid_length  = pUUID->len;
+	attr.att_desc.uuid_p       = (uint8_t*)&pUUID->uuid;
+	attr.att_desc.perm         = m_permissions;
+	attr.att_desc.max_length   = ESP_GATT_MAX_ATTR_LEN;
+	attr.att_desc.length       = 0;
+	attr.att_desc.value        = nullptr;
+	pAttrTable->push_back(attr);
+
+	for (auto pDescriptor : m_descriptorMap) {
+		pUUID = pDescriptor->m_bleUUID.getNative();
+		attr.attr_control.auto_rsp = ESP_GATT_AUTO_RSP;
+		attr.att_desc.uuid_length  = pUUID->len;
+		attr.att_desc.uuid_p       = (uint8_t*)&pUUID->uuid;
+		attr.att_desc.perm         = pDescriptor->m_permissions;
+		attr.att_desc.max_length   = pDescriptor->m_value.attr_max_len;
+		attr.att_desc.length       = pDescriptor->m_value.attr_len;
+		attr.att_desc.value        = pDescriptor->m_value.attr_value;
+		pAttrTable->push_back(attr);
+	} // End for
+} // appendAttrTable
+
+
 /**
  * @brief Register a new characteristic with the ESP runtime.
  * @param [in] pService The service with which to associate this characteristic.
@@ -112,11 +161,9 @@ void BLECharacteristic::executeCreate(BLEService* pService) {
 	}
 	m_semaphoreCreateEvt.wait("executeCreate");
 
-	BLEDescriptor* pDescriptor = m_descriptorMap.getFirst();
-	while (pDescriptor != nullptr) {
+	for (auto pDescriptor : m_descriptorMap) {
 		pDescriptor->executeCreate(this);
-		pDescriptor = m_descriptorMap.getNext();
-	} // End while
+	} // End for
 
 	ESP_LOGD(LOG_TAG, "<< executeCreate");
 } // executeCreate
@@ -193,6 +240,15 @@ uint8_t* BLECharacteristic::getData() {
 } // getData
 
 
+/**
+ * @brief Get the length of the current value of the characteristic.
+ * @return The length of the value in bytes.
+ */
+size_t BLECharacteristic::getLength() {
+	return m_value.getLength();
+} // getLength
+
+
 /**
  * Handle a GATT server event.
  */
@@ -200,15 +256,12 @@ void BLECharacteristic::handleGATTServerEvent(
 		esp_gatts_cb_event_t      event,
 		esp_gatt_if_t             gatts_if,
 		esp_ble_gatts_cb_param_t* param) {
-	ESP_LOGD(LOG_TAG, ">> handleGATTServerEvent: %s", BLEUtils::gattServerEventTypeToString(event).c_str());
+	ESP_LOGD(LOG_TAG, ">> handleGATTServerEvent: %s", BLEUtils::gattServerEventTypeToString(event));
 
 	switch(event) {
 	// Events handled:
 	//
 	// ESP_GATTS_ADD_CHAR_EVT
-	// ESP_GATTS_CONF_EVT
-	// ESP_GATTS_CONNECT_EVT
-	// ESP_GATTS_DISCONNECT_EVT
 	// ESP_GATTS_EXEC_WRITE_EVT
 	// ESP_GATTS_READ_EVT
 	// ESP_GATTS_WRITE_EVT
@@ -256,11 +309,9 @@ void BLECharacteristic::handleGATTServerEvent(
 		case ESP_GATTS_ADD_CHAR_EVT: {
 			if (getHandle() == param->add_char.attr_handle) {
 				// we have created characteristic, now we can create descriptors
-				// BLEDescriptor* pDescriptor = m_descriptorMap.getFirst();
-				// while (pDescriptor != nullptr) {
+				// for (auto pDescriptor : m_descriptorMap) {
 				// 	pDescriptor->executeCreate(this);
-				// 	pDescriptor = m_descriptorMap.getNext();
-				// } // End while
+				// } // End for
 				m_semaphoreCreateEvt.give();
 			}
 			break;
@@ -285,6 +336,15 @@ void BLECharacteristic::handleGATTServerEvent(
 // we save the new value.  Next we look at the need_rsp flag which indicates whether or not we need
 // to send a response.  If we do, then we formulate a response and send it.
 			if (param->write.handle == m_handle) {
+				// Write without response: nothing to answer, so hand the value straight to the application.
+				if (!param->write.need_rsp && !param->write.is_prep) {
+					setValue(param->write.value, param->write.len);
+					if (m_pCallbacks != nullptr) {
+						m_pCallbacks->onWrite(this);
+					}
+					break;
+				}
+
 				if (param->write.is_prep) {
 					m_value.addPart(param->write.value, param->write.len);
 					m_writeEvt = true;
@@ -298,18 +358,23 @@ void BLECharacteristic::handleGATTServerEvent(
 				ESP_LOGD(LOG_TAG, " - Response to write event: New value: handle: %.2x, uuid: %s",
 						getHandle(), getUUID().toString().c_str());
 
+#if CONFIG_LOG_DEFAULT_LEVEL > 3
 				char* pHexData = BLEUtils::buildHexData(nullptr, param->write.value, param->write.len);
 				ESP_LOGD(LOG_TAG, " - Data: length: %d, data: %s", param->write.len, pHexData);
 				free(pHexData);
+#endif
 
 				if (param->write.need_rsp) {
 					esp_gatt_rsp_t rsp;
 
-					rsp.attr_value.len      = param->write.len;
+					// Only a prepare write response echoes the value back; a write response carries none.
+					rsp.attr_value.len      = param->write.is_prep ? param->write.len : 0;
 					rsp.attr_value.handle   = m_handle;
 					rsp.attr_value.offset   = param->write.offset;
 					rsp.attr_value.auth_req = ESP_GATT_AUTH_REQ_NONE;
-					memcpy(rsp.attr_value.value, param->write.value, param->write.len);
+					if (param->write.is_prep) {
+						memcpy(rsp.attr_value.value, param->write.value, param->write.len);
+					}
 
 					esp_err_t errRc = ::esp_ble_gatts_send_response(
 							gatts_if,
@@ -431,28 +496,6 @@ void BLECharacteristic::handleGATTServerEvent(
 		} // ESP_GATTS_READ_EVT
 
 
-		// ESP_GATTS_CONF_EVT
-		//
-		// conf:
-		// - esp_gatt_status_t status  – The status code.
-		// - uint16_t          conn_id – The connection used.
-		//
-		case ESP_GATTS_CONF_EVT: {
-			// ESP_LOGD(LOG_TAG, "m_handle = %d, conf->handle = %d", m_handle, param->conf.handle);
-			if(param->conf.conn_id == getService()->getServer()->getConnId()) // && param->conf.handle == m_handle) // bug in esp-idf and not implemented in arduino yet
-				m_semaphoreConfEvt.give(param->conf.status);
-			break;
-		}
-
-		case ESP_GATTS_CONNECT_EVT: {
-			break;
-		}
-
-		case ESP_GATTS_DISCONNECT_EVT: {
-			m_semaphoreConfEvt.give();
-			break;
-		}
-
 		default: {
 			break;
 		} // default
@@ -470,7 +513,9 @@ void BLECharacteristic::handleGATTServerEvent(
 /**
  * @brief Send an indication.
  * An indication is a transmission of up to the first 20 bytes of the characteristic value.  An indication
- * will block waiting a positive confirmation from the client.
+ * is sent to every subscribed client at once and does not block the caller.  As each client confirms it
+ * (or disconnects first) the onIndicate() callback is invoked, and once every client has answered
+ * onIndicateComplete() is invoked.
  * @return N/A
  */
 void BLECharacteristic::indicate() {
@@ -481,70 +526,115 @@ void BLECharacteristic::indicate() {
 } // indicate
 
 
+/**
+ * @brief Report the outcome of an indication to one client.
+ * @param [in] conn_id The connection the indication was sent on.
+ * @param [in] status ESP_GATT_OK if the client confirmed the indication, otherwise the reason it failed.
+ * @param [in] allDone True if no other client is still to answer.
+ */
+void BLECharacteristic::indicateCompleted(uint16_t conn_id, esp_gatt_status_t status, bool allDone) {
+	ESP_LOGD(LOG_TAG, ">> indicateCompleted: conn_id: %d, status: %d, allDone: %d", conn_id, status, allDone);
+	if (m_pCallbacks != nullptr) {
+		m_pCallbacks->onIndicate(this, conn_id, status);
+		if (allDone) {
+			m_pCallbacks->onIndicateComplete(this);
+		}
+	}
+	ESP_LOGD(LOG_TAG, "<< indicateCompleted");
+} // indicateCompleted
+
+
 /**
  * @brief Send a notify.
  * A notification is a transmission of up to the first 20 bytes of the characteristic value.  An notification
- * will not block; it is a fire and forget.
+ * will not block; it is a fire and forget.  The value is placed on the outbound queue of each client that has
+ * subscribed through the 0x2902 descriptor and sent as soon as that link is not congested.  A value that has
+ * not yet been sent is replaced by a newer one.
  * @return N/A.
  */
 void BLECharacteristic::notify(bool is_notification) {
-	ESP_LOGD(LOG_TAG, ">> notify: length: %d", m_value.getValue().length());
+	ESP_LOGD(LOG_TAG, ">> notify: length: %d", m_value.getLength());
 
 	assert(getService() != nullptr);
 	assert(getService()->getServer() != nullptr);
 
-	GeneralUtils::hexDump((uint8_t*)m_value.getValue().data(), m_value.getValue().length());
+	GeneralUtils::hexDump(m_value.getData(), m_value.getLength());
 
 	if (getService()->getServer()->getConnectedCount() == 0) {
 		ESP_LOGD(LOG_TAG, "<< notify: No connected clients.");
 		return;
 	}
 
-	// Test to see if we have a 0x2902 descriptor.  If we do, then check to see if notification is enabled
-	// and, if not, prevent the notification.
+	// Test to see if we have a 0x2902 descriptor.  Each client subscribes through it independently, so
+	// we only send to the clients that have enabled notifications (or indications).
 
 	BLE2902* p2902 = (BLE2902*)getDescriptorByUUID((uint16_t)0x2902);
 	if(p2902 == nullptr){
 		ESP_LOGE(LOG_TAG, "Characteristic without 0x2902 descriptor");
 		return;
 	}
-	if(is_notification) {
-		if (p2902 != nullptr && !p2902->getNotifications()) {
-			ESP_LOGD(LOG_TAG, "<< notifications disabled; ignoring");
-			return;
-		}
-	}
-	else{
-		if (p2902 != nullptr && !p2902->getIndications()) {
-			ESP_LOGD(LOG_TAG, "<< indications disabled; ignoring");
-			return;
-		}
-	}
-	for (auto &myPair : getService()->getServer()->getPeerDevices(false)) {
-		uint16_t _mtu = (myPair.second.mtu);
-		if (m_value.getValue().length() > _mtu - 3) {
-			ESP_LOGW(LOG_TAG, "- Truncating to %d bytes (maximum notify size)", _mtu - 3);
+	BLEServer* pServer = getService()->getServer();
+	uint16_t   conn_id = 0;
+	uint16_t   mtu;
+	for (bool found = pServer->getNextPeer(true, &conn_id, &mtu); found; found = pServer->getNextPeer(false, &conn_id, &mtu)) {
+		bool subscribed = is_notification ? p2902->getNotifications(conn_id) : p2902->getIndications(conn_id);
+		if (!subscribed) {
+			ESP_LOGD(LOG_TAG, "- conn_id %d has %s disabled; skipping", conn_id, is_notification ? "notifications" : "indications");
+			continue;
 		}
 
-		size_t length = m_value.getValue().length();
-		if(!is_notification)
-			m_semaphoreConfEvt.take("indicate");
-		esp_err_t errRc = ::esp_ble_gatts_send_indicate(
-				getService()->getServer()->getGattsIf(),
-				myPair.first,
-				getHandle(), length, (uint8_t*)m_value.getValue().data(), !is_notification); // The need_confirm = false makes this a notify.
-		if (errRc != ESP_OK) {
-			ESP_LOGE(LOG_TAG, "<< esp_ble_gatts_send_ %s: rc=%d %s",is_notification?"notify":"indicate", errRc, GeneralUtils::errorToString(errRc));
-			m_semaphoreConfEvt.give();
-			return;
+		size_t length    = m_value.getLength();
+		size_t maxLength = mtu > 3 ? (size_t)(mtu - 3) : 0;
+		if (length > maxLength) {
+			ESP_LOGW(LOG_TAG, "- Truncating to %u bytes (maximum notify size)", (unsigned) maxLength);
+			length = maxLength;
 		}
-		if(!is_notification)
-			m_semaphoreConfEvt.wait("indicate");
+
+		// The value is copied into the per connection queue which sends it as the link allows.
+		pServer->queueNotification(conn_id, this, m_value.getData(), length, !is_notification);
 	}
 	ESP_LOGD(LOG_TAG, "<< notify");
 } // Notify
 
 
+/**
+ * @brief Send a record to each client that has subscribed to notifications.
+ * Unlike notify(), the characteristic value is not changed.  The record is framed with a one byte type and a
+ * one byte length and queued for each client; records still waiting for a client are packed together into
+ * notifications as large as the MTU of that client allows.  Every record is delivered unless it is a state
+ * record, which replaces a waiting state record of the same type.
+ * @param [in] type The record type.
+ * @param [in] pData The record data.
+ * @param [in] length The length of the record data.
+ * @param [in] isState True if only the latest record of this type matters, such as a position.
+ * @return N/A.
+ */
+void BLECharacteristic::notifyRecord(uint8_t type, const uint8_t* pData, uint8_t length, bool isState) {
+	ESP_LOGD(LOG_TAG, ">> notifyRecord: type: %d, length: %d", type, length);
+
+	assert(getService() != nullptr);
+	assert(getService()->getServer() != nullptr);
+
+	BLE2902* p2902 = (BLE2902*)getDescriptorByUUID((uint16_t)0x2902);
+	if (p2902 == nullptr) {
+		ESP_LOGE(LOG_TAG, "Characteristic without 0x2902 descriptor");
+		return;
+	}
+	BLEServer* pServer = getService()->getServer();
+	uint16_t   conn_id = 0;
+	uint16_t   mtu;
+	for (bool found = pServer->getNextPeer(true, &conn_id, &mtu); found; found = pServer->getNextPeer(false, &conn_id, &mtu)) {
+		if (!p2902->getNotifications(conn_id)) continue;
+		if (mtu <= 3 || length + BLENotifyQueue::RECORD_HEADER_SIZE > (size_t)(mtu - 3)) {
+			ESP_LOGW(LOG_TAG, "- Record of %d bytes does not fit the MTU of conn_id %d; skipping", length, conn_id);
+			continue;
+		}
+		pServer->queueRecord(conn_id, this, type, pData, length, isState);
+	}
+	ESP_LOGD(LOG_TAG, "<< notifyRecord");
+} // notifyRecord
+
+
 /**
  * @brief Set the permission to broadcast.
  * A characteristics has properties associated with it which define what it is capable of doing.
@@ -567,12 +657,32 @@ void BLECharacteristic::setBroadcastProperty(bool value) {
  * @param [in] pCallbacks An instance of a callbacks structure used to define any callbacks for the characteristic.
  */
 void BLECharacteristic::setCallbacks(BLECharacteristicCallbacks* pCallbacks) {
-	ESP_LOGD(LOG_TAG, ">> setCallbacks: 0x%x", (uint32_t)pCallbacks);
+	ESP_LOGD(LOG_TAG, ">> setCallbacks: %p", pCallbacks);
 	m_pCallbacks = pCallbacks;
 	ESP_LOGD(LOG_TAG, "<< setCallbacks");
 } // setCallbacks
 
 
+/**
+ * @brief Take the handles allocated to this characteristic from a created attribute table.
+ * @param [in] pHandles The handles starting at the declaration of this characteristic, in the order
+ * produced by appendAttrTable().
+ * @return The number of handles consumed.
+ */
+uint16_t BLECharacteristic::setAttrTableHandles(uint16_t* pHandles) {
+	uint16_t count = 1;                 // Skip the characteristic declaration.
+	setHandle(pHandles[count++]);
+
+	for (auto pDescriptor : m_descriptorMap) {
+		pDescriptor->m_pCharacteristic = this;
+		pDescriptor->setHandle(pHandles[count]);
+		m_descriptorMap.setByHandle(pHandles[count], pDescriptor);
+		count++;
+	} // End for
+	return count;
+} // setAttrTableHandles
+
+
 /**
  * @brief Set the BLE handle associated with this characteristic.
  * A user program will request that a characteristic be created against a service.  When the characteristic has been
@@ -749,6 +859,28 @@ std::string BLECharacteristic::toString() {
 BLECharacteristicCallbacks::~BLECharacteristicCallbacks() {}
 
 
+/**
+ * @brief Callback function invoked when one client has answered an indication.
+ * @param [in] pCharacteristic The characteristic that is the source of the event.
+ * @param [in] conn_id The connection of the client.
+ * @param [in] status ESP_GATT_OK if the client confirmed the indication, otherwise the reason it failed.
+ */
+void BLECharacteristicCallbacks::onIndicate(BLECharacteristic* pCharacteristic, uint16_t conn_id, esp_gatt_status_t status) {
+	ESP_LOGD("BLECharacteristicCallbacks", ">> onIndicate: default");
+	ESP_LOGD("BLECharacteristicCallbacks", "<< onIndicate");
+} // onIndicate
+
+
+/**
+ * @brief Callback function invoked when every client has answered the outstanding indications.
+ * @param [in] pCharacteristic The characteristic that is the source of the event.
+ */
+void BLECharacteristicCallbacks::onIndicateComplete(BLECharacteristic* pCharacteristic) {
+	ESP_LOGD("BLECharacteristicCallbacks", ">> onIndicateComplete: default");
+	ESP_LOGD("BLECharacteristicCallbacks", "<< onIndicateComplete");
+} // onIndicateComplete
+
+
 /**
  * @brief Callback function to support a read request.
  * @param [in] pCharacteristic The characteristic that is the source of the event.
@@ -11,7 +11,9 @@
 #if defined(CONFIG_BT_ENABLED)
 #include <string>
 #include <map>
+#include <vector>
 #include "BLEUUID.h"
+#include "BLEAttributeRegistry.h"
 #include <esp_gatts_api.h>
 #include <esp_gap_ble_api.h>
 #include "BLEDescriptor.h"
@@ -35,12 +37,10 @@ public:
 	BLEDescriptor* getByHandle(uint16_t handle);
 	std::string	toString();
 	void handleGATTServerEvent(esp_gatts_cb_event_t event, esp_gatt_if_t gatts_if, esp_ble_gatts_cb_param_t* param);
-	BLEDescriptor* getFirst();
-	BLEDescriptor* getNext();
+	BLEAttributeRegistry<BLEDescriptor>::const_iterator begin() const;
+	BLEAttributeRegistry<BLEDescriptor>::const_iterator end() const;
 private:
-	std::map<BLEDescriptor*, std::string> m_uuidMap;
-	std::map<uint16_t, BLEDescriptor*> m_handleMap;
-	std::map<BLEDescriptor*, std::string>::iterator m_iterator;
+	BLEAttributeRegistry<BLEDescriptor> m_registry;
 };
 
 
@@ -62,9 +62,11 @@ public:
 	BLEUUID        getUUID();
 	std::string    getValue();
 	uint8_t*       getData();
+	size_t         getLength();
 
 	void indicate();
 	void notify(bool is_notification = true);
+	void notifyRecord(uint8_t type, const uint8_t* pData, uint8_t length, bool isState = false);
 	void setBroadcastProperty(bool value);
 	void setCallbacks(BLECharacteristicCallbacks* pCallbacks);
 	void setIndicateProperty(bool value);
@@ -106,18 +108,21 @@ private:
 	BLEValue                    m_value;
 	esp_gatt_perm_t             m_permissions = ESP_GATT_PERM_READ | ESP_GATT_PERM_WRITE;
 	bool						m_writeEvt = false;
+	uint32_t                    m_indicatePending = 0;  // Clients yet to answer an indication; guarded by the server.
 
 	void handleGATTServerEvent(
 			esp_gatts_cb_event_t      event,
 			esp_gatt_if_t             gatts_if,
 			esp_ble_gatts_cb_param_t* param);
 
+	void                 appendAttrTable(BLEService* pService, std::vector<esp_gatts_attr_db_t>* pAttrTable);
 	void                 executeCreate(BLEService* pService);
 	esp_gatt_char_prop_t getProperties();
 	BLEService*          getService();
+	void                 indicateCompleted(uint16_t conn_id, esp_gatt_status_t status, bool allDone);
+	uint16_t             setAttrTableHandles(uint16_t* pHandles);
 	void                 setHandle(uint16_t handle);
 	FreeRTOS::Semaphore m_semaphoreCreateEvt = FreeRTOS::Semaphore("CreateEvt");
-	FreeRTOS::Semaphore m_semaphoreConfEvt   = FreeRTOS::Semaphore("ConfEvt");
 }; // BLECharacteristic
 
 
@@ -133,6 +138,8 @@ public:
 	virtual ~BLECharacteristicCallbacks();
 	virtual void onRead(BLECharacteristic* pCharacteristic);
 	virtual void onWrite(BLECharacteristic* pCharacteristic);
+	virtual void onIndicate(BLECharacteristic* pCharacteristic, uint16_t conn_id, esp_gatt_status_t status);
+	virtual void onIndicateComplete(BLECharacteristic* pCharacteristic);
 };
 #endif /* CONFIG_BT_ENABLED */
 #endif /* COMPONENTS_CPP_UTILS_BLECHARACTERISTIC_H_ */
@@ -17,10 +17,10 @@
 /**
  * @brief Return the characteristic by handle.
  * @param [in] handle The handle to look up the characteristic.
- * @return The characteristic.
+ * @return The characteristic or nullptr if no characteristic has the handle.
  */
 BLECharacteristic* BLECharacteristicMap::getByHandle(uint16_t handle) {
-	return m_handleMap.at(handle);
+	return m_registry.getByHandle(handle);
 } // getByHandle
 
 
@@ -40,39 +40,26 @@ BLECharacteristic* BLECharacteristicMap::getByUUID(const char* uuid) {
  * @return The characteristic.
  */
 BLECharacteristic* BLECharacteristicMap::getByUUID(BLEUUID uuid) {
-	for (auto &myPair : m_uuidMap) {
-		if (myPair.first->getUUID().equals(uuid)) {
-			return myPair.first;
-		}
-	}
-	//return m_uuidMap.at(uuid.toString());
-	return nullptr;
+	return m_registry.getByUUID(uuid);
 } // getByUUID
 
 
 /**
- * @brief Get the first characteristic in the map.
- * @return The first characteristic in the map.
+ * @brief Get an iterator to the first characteristic in the map, in the order they were added.
+ * @return The iterator.
  */
-BLECharacteristic* BLECharacteristicMap::getFirst() {
-	m_iterator = m_uuidMap.begin();
-	if (m_iterator == m_uuidMap.end()) return nullptr;
-	BLECharacteristic* pRet = m_iterator->first;
-	m_iterator++;
-	return pRet;
-} // getFirst
+BLEAttributeRegistry<BLECharacteristic>::const_iterator BLECharacteristicMap::begin() const {
+	return m_registry.begin();
+} // begin
 
 
 /**
- * @brief Get the next characteristic in the map.
- * @return The next characteristic in the map.
+ * @brief Get an iterator past the last characteristic in the map.
+ * @return The iterator.
  */
-BLECharacteristic* BLECharacteristicMap::getNext() {
-	if (m_iterator == m_uuidMap.end()) return nullptr;
-	BLECharacteristic* pRet = m_iterator->first;
-	m_iterator++;
-	return pRet;
-} // getNext
+BLEAttributeRegistry<BLECharacteristic>::const_iterator BLECharacteristicMap::end() const {
+	return m_registry.end();
+} // end
 
 
 /**
@@ -83,8 +70,8 @@ BLECharacteristic* BLECharacteristicMap::getNext() {
  */
 void BLECharacteristicMap::handleGATTServerEvent(esp_gatts_cb_event_t event, esp_gatt_if_t gatts_if, esp_ble_gatts_cb_param_t* param) {
 	// Invoke the handler for every Service we have.
-	for (auto& myPair : m_uuidMap) {
-		myPair.first->handleGATTServerEvent(event, gatts_if, param);
+	for (auto pCharacteristic : m_registry) {
+		pCharacteristic->handleGATTServerEvent(event, gatts_if, param);
 	}
 } // handleGATTServerEvent
 
@@ -96,7 +83,7 @@ void BLECharacteristicMap::handleGATTServerEvent(esp_gatts_cb_event_t event, esp
  * @return N/A.
  */
 void BLECharacteristicMap::setByHandle(uint16_t handle, BLECharacteristic* characteristic) {
-	m_handleMap.insert(std::pair<uint16_t, BLECharacteristic*>(handle, characteristic));
+	m_registry.setHandle(handle, characteristic);
 } // setByHandle
 
 
@@ -107,7 +94,7 @@ void BLECharacteristicMap::setByHandle(uint16_t handle, BLECharacteristic* chara
  * @return N/A.
  */
 void BLECharacteristicMap::setByUUID(BLECharacteristic* pCharacteristic, BLEUUID uuid) {
-	m_uuidMap.insert(std::pair<BLECharacteristic*, std::string>(pCharacteristic, uuid.toString()));
+	m_registry.add(pCharacteristic, uuid);
 } // setByUUID
 
 
@@ -119,12 +106,12 @@ std::string BLECharacteristicMap::toString() {
 	std::stringstream stringStream;
 	stringStream << std::hex << std::setfill('0');
 	int count = 0;
-	for (auto &myPair: m_uuidMap) {
+	for (auto pCharacteristic : m_registry) {
 		if (count > 0) {
 			stringStream << "\n";
 		}
 		count++;
-		stringStream << "handle: 0x" << std::setw(2) << myPair.first->getHandle() << ", uuid: " + myPair.first->getUUID().toString();
+		stringStream << "handle: 0x" << std::setw(2) << pCharacteristic->getHandle() << ", uuid: " + pCharacteristic->getUUID().toString();
 	}
 	return stringStream.str();
 } // toString
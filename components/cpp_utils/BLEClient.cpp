@@ -10,7 +10,9 @@
 #include <esp_bt_main.h>
 #include <esp_gap_ble_api.h>
 #include <esp_gattc_api.h>
+#include <esp_timer.h>
 #include "BLEClient.h"
+#include "BLEDiscoveryCache.h"
 #include "BLEUtils.h"
 #include "BLEService.h"
 #include "GeneralUtils.h"
@@ -76,11 +78,12 @@ BLEClient::BLEClient() {
  * @brief Destructor.
  */
 BLEClient::~BLEClient() {
+	// Stop receiving events first; this waits for one being handled in the Bluedroid task.
+	BLEDevice::removePeerDevice(m_appId, true);
 	// We may have allocated service references associated with this client.  Before we are finished
 	// with the client, we must release resources.
 	clearServices();
 	esp_ble_gattc_app_unregister(m_gattc_if);
-	BLEDevice::removePeerDevice(m_appId, true);
 	if(m_deleteCallbacks)
 		delete m_pClientCallbacks;
 
@@ -167,7 +170,7 @@ void BLEClient::gattClientEventHandler(
 	esp_ble_gattc_cb_param_t* evtParam) {
 
 	ESP_LOGD(LOG_TAG, "gattClientEventHandler [esp_gatt_if: %d] ... %s",
-		gattc_if, BLEUtils::gattClientEventTypeToString(event).c_str());
+		gattc_if, BLEUtils::gattClientEventTypeToString(event));
 
 	// Execute handler code based on the type of event received.
 	switch(event) {
@@ -177,6 +180,12 @@ void BLEClient::gattClientEventHandler(
 				break;
 
 			ESP_LOGI(LOG_TAG, "SERVICE CHANGED");
+#ifdef CONFIG_BLE_GATTC_DISCOVERY_CACHE
+			BLEDiscoveryCache::erase(BLEAddress(evtParam->srvc_chg.remote_bda));
+#endif
+			if (BLEAddress(evtParam->srvc_chg.remote_bda).equals(m_peerAddress)) {
+				m_haveServices = false;   // Discover them again on the next getService().
+			}
 			break;
 
 		case ESP_GATTC_CLOSE_EVT: 
@@ -194,6 +203,7 @@ void BLEClient::gattClientEventHandler(
 			if(m_gattc_if != gattc_if)
 				break;
 			m_semaphoreOpenEvt.give(evtParam->disconnect.reason);
+			failOperations();   // No answers will come for requests still outstanding.
 			if(!m_isConnected)
 				break;
 			// If we receive a disconnect event, set the class flag that indicates that we are
@@ -294,7 +304,13 @@ void BLEClient::gattClientEventHandler(
 			// 	ESP_LOGI(LOG_TAG, "unknown service source");
 			// }
 #endif
-			m_semaphoreSearchCmplEvt.give(evtParam->search_cmpl.status);
+			// If sucessfull, remember that we now have services.
+			m_haveServices = (evtParam->search_cmpl.status == ESP_GATT_OK);
+#ifdef CONFIG_BLE_GATTC_DISCOVERY_CACHE
+			if (m_haveServices) {
+				BLEDiscoveryCache::store(this);
+			}
+#endif
 			break;
 		} // ESP_GATTC_SEARCH_CMPL_EVT
 
@@ -312,15 +328,13 @@ void BLEClient::gattClientEventHandler(
 			if(m_gattc_if != gattc_if)
 				break;
 
-			BLEUUID uuid = BLEUUID(evtParam->search_res.srvc_id);
 			BLERemoteService* pRemoteService = new BLERemoteService(
 				evtParam->search_res.srvc_id,
 				this,
 				evtParam->search_res.start_handle,
 				evtParam->search_res.end_handle
 			);
-			m_servicesMap.insert(std::pair<std::string, BLERemoteService*>(uuid.toString(), pRemoteService));
-			m_servicesMapByInstID.insert(std::pair<BLERemoteService *, uint16_t>(pRemoteService, evtParam->search_res.srvc_id.inst_id));
+			addService(pRemoteService);
 			break;
 		} // ESP_GATTC_SEARCH_RES_EVT
 
@@ -335,9 +349,141 @@ void BLEClient::gattClientEventHandler(
 	   myPair.second->gattClientEventHandler(event, gattc_if, evtParam);
 	}
 
+	// Now that the services and characteristics have seen the answer, complete the operation that asked for it.
+	switch(event) {
+		case ESP_GATTC_READ_CHAR_EVT: {
+			if (m_gattc_if != gattc_if || evtParam->read.conn_id != m_conn_id) break;
+			if (evtParam->read.status == ESP_GATT_OK) {
+				completeOperation(BLERemoteOperation::READ, evtParam->read.handle, evtParam->read.status, evtParam->read.value, evtParam->read.value_len);
+			} else {
+				completeOperation(BLERemoteOperation::READ, evtParam->read.handle, evtParam->read.status);
+			}
+			break;
+		} // ESP_GATTC_READ_CHAR_EVT
+
+		case ESP_GATTC_WRITE_CHAR_EVT: {
+			if (m_gattc_if != gattc_if || evtParam->write.conn_id != m_conn_id) break;
+			completeOperation(BLERemoteOperation::WRITE, evtParam->write.handle, evtParam->write.status);
+			break;
+		} // ESP_GATTC_WRITE_CHAR_EVT
+
+		case ESP_GATTC_SEARCH_CMPL_EVT: {
+			if (m_gattc_if != gattc_if) break;
+			// Every caller that joined the discovery is answered by the one completion.
+			while (completeOperation(BLERemoteOperation::GET_SERVICES, 0, evtParam->search_cmpl.status)) {}
+			break;
+		} // ESP_GATTC_SEARCH_CMPL_EVT
+
+		default:
+			break;
+	} // Switch
 } // gattClientEventHandler
 
 
+/**
+ * @brief Remember an operation that is about to be sent to the server.
+ *
+ * It must be added before the request is made as the answer may arrive before the call that makes the
+ * request returns.
+ * @param [in] pOperation The operation.
+ */
+void BLEClient::addOperation(std::shared_ptr<BLERemoteOperation> pOperation) {
+	m_semaphoreOperations.take("addOperation");
+	m_operations.push_back(pOperation);
+	m_semaphoreOperations.give();
+} // addOperation
+
+
+/**
+ * @brief Add a service that has been discovered, or built from the discovery cache.
+ * @param [in] pRemoteService The service.
+ */
+void BLEClient::addService(BLERemoteService* pRemoteService) {
+	m_servicesMap.insert(std::pair<std::string, BLERemoteService*>(pRemoteService->getUUID().toString(), pRemoteService));
+	m_servicesMapByInstID.insert(std::pair<BLERemoteService *, uint16_t>(pRemoteService, pRemoteService->getSrvcId()->inst_id));
+} // addService
+
+
+/**
+ * @brief Complete an operation whose request could not be made.
+ * @param [in] pOperation The operation.
+ * @param [in] status The status to complete it with.
+ */
+void BLEClient::cancelOperation(BLERemoteOperation* pOperation, esp_gatt_status_t status) {
+	std::shared_ptr<BLERemoteOperation> pFound;
+	m_semaphoreOperations.take("cancelOperation");
+	for (auto it = m_operations.begin(); it != m_operations.end(); ++it) {
+		if (it->get() == pOperation) {
+			pFound = *it;
+			m_operations.erase(it);
+			break;
+		}
+	}
+	m_semaphoreOperations.give();
+	if (pFound) {
+		pFound->complete(status);
+	}
+} // cancelOperation
+
+
+/**
+ * @brief Complete the oldest outstanding operation of a type on a handle.
+ *
+ * The operation is completed, and its callback invoked, after the lock is released so that the callback
+ * may start further operations.
+ * @param [in] type The type of the operation.
+ * @param [in] handle The handle of the characteristic, or 0 for discovery.
+ * @param [in] status The status the server answered with.
+ * @param [in] pValue The value read, if any.
+ * @param [in] length The length of the value read.
+ * @return True if there was such an operation.
+ */
+bool BLEClient::completeOperation(BLERemoteOperation::type_t type, uint16_t handle, esp_gatt_status_t status, const uint8_t* pValue, size_t length) {
+	std::shared_ptr<BLERemoteOperation> pFound;
+	m_semaphoreOperations.take("complete");
+	for (auto it = m_operations.begin(); it != m_operations.end(); ++it) {
+		if ((*it)->m_type == type && (*it)->m_handle == handle) {
+			pFound = *it;
+			m_operations.erase(it);
+			break;
+		}
+	}
+	if (pFound && (type == BLERemoteOperation::READ || type == BLERemoteOperation::WRITE)) {
+		uint32_t latencyUs = (uint32_t) (::esp_timer_get_time() - pFound->m_startUs);
+		m_operationStats.operations++;
+		m_operationStats.latencyUs += latencyUs;
+		if (latencyUs > m_operationStats.maxLatencyUs) {
+			m_operationStats.maxLatencyUs = latencyUs;
+		}
+	}
+	m_semaphoreOperations.give();
+	if (!pFound) {
+		return false;
+	}
+#ifdef CONFIG_BLE_GATTC_DISCOVERY_CACHE
+	if (status == ESP_GATT_INVALID_HANDLE) {   // The server's attributes are no longer those stored for it.
+		BLEDiscoveryCache::erase(m_peerAddress);
+	}
+#endif
+	pFound->complete(status, pValue, length);
+	return true;
+} // completeOperation
+
+
+/**
+ * @brief Fail every outstanding operation, as when the connection has dropped.
+ */
+void BLEClient::failOperations() {
+	m_semaphoreOperations.take("failOperations");
+	std::deque<std::shared_ptr<BLERemoteOperation>> operations;
+	operations.swap(m_operations);
+	m_semaphoreOperations.give();
+	for (auto& pOperation : operations) {
+		pOperation->complete(ESP_GATT_ERROR);
+	}
+} // failOperations
+
+
 uint16_t BLEClient::getConnId() {
 	return m_conn_id;
 } // getConnId
@@ -411,9 +557,8 @@ BLERemoteService* BLEClient::getService(BLEUUID uuid) {
 	if (!m_haveServices) {
 		getServices();
 	}
-	std::string uuidStr = uuid.toString();
 	for (auto &myPair : m_servicesMap) {
-		if (myPair.first == uuidStr) {
+		if (myPair.second->getUUID().equals(uuid)) {
 			ESP_LOGD(LOG_TAG, "<< getService: found the service with uuid: %s", uuid.toString().c_str());
 			return myPair.second;
 		}
@@ -430,6 +575,28 @@ BLERemoteService* BLEClient::getService(BLEUUID uuid) {
  * @return N/A
  */
 std::map<std::string, BLERemoteService*>* BLEClient::getServices() {
+	ESP_LOGD(LOG_TAG, ">> getServices");
+	getServicesAsync()->wait();
+	ESP_LOGD(LOG_TAG, "<< getServices");
+	return &m_servicesMap;
+} // getServices
+
+
+/**
+ * @brief Ask the remote %BLE server for its services without waiting for them.
+ *
+ * The services found so far are forgotten and the server is asked again.  If a discovery is already under
+ * way the new operation joins it instead: it completes, and its callback is invoked, when that discovery
+ * does.  Once the operation completes with ESP_GATT_OK, getServices() and getService() answer from what was
+ * found.
+ *
+ * With CONFIG_BLE_GATTC_DISCOVERY_CACHE set, a server whose attributes were stored by an earlier discovery
+ * is not asked: the services, characteristics and descriptors are built from what was stored and the
+ * operation has completed by the time this returns.  See BLEDiscoveryCache.
+ * @param [in] callback Invoked when the discovery completes, or nullptr.
+ * @return The operation.
+ */
+std::shared_ptr<BLERemoteOperation> BLEClient::getServicesAsync(remote_operation_callback callback) {
 /*
  * Design
  * ------
@@ -437,8 +604,32 @@ std::map<std::string, BLERemoteService*>* BLEClient::getServices() {
  * peer BLE partner to be returned as events.  Each event will be an an instance of ESP_GATTC_SEARCH_RES_EVT
  * and will culminate with an ESP_GATTC_SEARCH_CMPL_EVT when all have been received.
  */
-	ESP_LOGD(LOG_TAG, ">> getServices");
-// TODO implement retrieving services from cache
+	ESP_LOGD(LOG_TAG, ">> getServicesAsync");
+	std::shared_ptr<BLERemoteOperation> pOperation(new BLERemoteOperation(BLERemoteOperation::GET_SERVICES, this, callback));
+
+	m_semaphoreOperations.take("getServicesAsync");
+	bool searching = false;
+	for (auto& pPending : m_operations) {
+		if (pPending->m_type == BLERemoteOperation::GET_SERVICES) {
+			searching = true;
+			break;
+		}
+	}
+	m_operations.push_back(pOperation);
+	m_semaphoreOperations.give();
+	if (searching) {
+		ESP_LOGD(LOG_TAG, "<< getServicesAsync: joined the discovery under way");
+		return pOperation;
+	}
+
+#ifdef CONFIG_BLE_GATTC_DISCOVERY_CACHE
+	if (BLEDiscoveryCache::load(this)) {
+		m_haveServices = true;
+		while (completeOperation(BLERemoteOperation::GET_SERVICES, 0, ESP_GATT_OK)) {}
+		ESP_LOGD(LOG_TAG, "<< getServicesAsync: from the discovery cache");
+		return pOperation;
+	}
+#endif
 	clearServices(); // Clear any services that may exist.
 
 	esp_err_t errRc = esp_ble_gattc_search_service(
@@ -447,16 +638,13 @@ std::map<std::string, BLERemoteService*>* BLEClient::getServices() {
 		NULL            // Filter UUID
 	);
 
-	m_semaphoreSearchCmplEvt.take("getServices");
 	if (errRc != ESP_OK) {
 		ESP_LOGE(LOG_TAG, "esp_ble_gattc_search_service: rc=%d %s", errRc, GeneralUtils::errorToString(errRc));
-		return &m_servicesMap;
+		while (completeOperation(BLERemoteOperation::GET_SERVICES, 0, ESP_GATT_ERROR)) {}
 	}
-	// If sucessfull, remember that we now have services.
-	m_haveServices = (m_semaphoreSearchCmplEvt.wait("getServices") == 0);
-	ESP_LOGD(LOG_TAG, "<< getServices");
-	return &m_servicesMap;
-} // getServices
+	ESP_LOGD(LOG_TAG, "<< getServicesAsync");
+	return pOperation;
+} // getServicesAsync
 
 
 /**
@@ -503,6 +691,30 @@ void BLEClient::handleGAPEvent(
 } // handleGAPEvent
 
 
+/**
+ * @brief Get the callbacks set by setClientCallbacks().
+ * @return The callbacks, or nullptr if none have been set.
+ */
+BLEClientCallbacks* BLEClient::getClientCallbacks() {
+	return m_pClientCallbacks;
+} // getClientCallbacks
+
+
+/**
+ * @brief Get how many reads and writes the server has answered and how long it took to answer them.
+ *
+ * The figures accumulate over every connection the client makes.  Discovery and writes without response,
+ * which the server does not answer, are not counted.
+ * @return The statistics.
+ */
+BLEClient::operation_stats_t BLEClient::getOperationStats() {
+	m_semaphoreOperations.take("getOpStats");
+	operation_stats_t stats = m_operationStats;
+	m_semaphoreOperations.give();
+	return stats;
+} // getOperationStats
+
+
 /**
  * @brief Are we connected to a partner?
  * @return True if we are connected and false if we are not connected.
@@ -13,9 +13,12 @@
 
 #include <esp_gattc_api.h>
 #include <string.h>
+#include <deque>
 #include <map>
+#include <memory>
 #include <string>
 #include "BLEExceptions.h"
+#include "BLERemoteOperation.h"
 #include "BLERemoteService.h"
 #include "BLEService.h"
 #include "BLEAddress.h"
@@ -30,15 +33,27 @@ class BLEAdvertisedDevice;
  */
 class BLEClient {
 public:
+	/**
+	 * @brief The reads and writes the server has answered, and how long it took.
+	 */
+	typedef struct {
+		uint32_t operations;     // Reads and writes answered, successfully or not.
+		uint64_t latencyUs;      // The sum of the time each took; see BLERemoteOperation::getLatencyUs().
+		uint32_t maxLatencyUs;   // The longest any took.
+	} operation_stats_t;
+
 	BLEClient();
 	~BLEClient();
 
 	bool 									   connect(BLEAdvertisedDevice* device);
 	bool                                       connect(BLEAddress address, esp_ble_addr_type_t type = BLE_ADDR_TYPE_PUBLIC);   // Connect to the remote BLE Server
 	void                                       disconnect();                  // Disconnect from the remote BLE Server
+	BLEClientCallbacks*                        getClientCallbacks();          // Get the callbacks set by setClientCallbacks().
+	operation_stats_t                          getOperationStats();           // Get how quickly the server has answered.
 	BLEAddress                                 getPeerAddress();              // Get the address of the remote BLE Server
 	int                                        getRssi();                     // Get the RSSI of the remote BLE Server
 	std::map<std::string, BLERemoteService*>*  getServices();                 // Get a map of the services offered by the remote BLE Server
+	std::shared_ptr<BLERemoteOperation>        getServicesAsync(remote_operation_callback callback = nullptr);   // Ask for the services without waiting.
 	BLERemoteService*                          getService(const char* uuid);  // Get a reference to a specified service offered by the remote BLE server.
 	BLERemoteService*                          getService(BLEUUID uuid);      // Get a reference to a specified service offered by the remote BLE server.
 	std::string                                getValue(BLEUUID serviceUUID, BLEUUID characteristicUUID);   // Get the value of a given characteristic at a given service.
@@ -61,11 +76,17 @@ public:
 uint16_t m_appId;
 private:
 	friend class BLEDevice;
+	friend class BLEDiscoveryCache;
 	friend class BLERemoteService;
 	friend class BLERemoteCharacteristic;
 	friend class BLERemoteDescriptor;
 
 	void gattClientEventHandler(esp_gattc_cb_event_t event, esp_gatt_if_t gattc_if, esp_ble_gattc_cb_param_t* param);
+	void addOperation(std::shared_ptr<BLERemoteOperation> pOperation);
+	void addService(BLERemoteService* pRemoteService);
+	void cancelOperation(BLERemoteOperation* pOperation, esp_gatt_status_t status);
+	bool completeOperation(BLERemoteOperation::type_t type, uint16_t handle, esp_gatt_status_t status, const uint8_t* pValue = nullptr, size_t length = 0);
+	void failOperations();
 
 	BLEAddress    m_peerAddress = BLEAddress((uint8_t*)"\0\0\0\0\0\0");   // The BD address of the remote server.
 	uint16_t      m_conn_id;
@@ -77,8 +98,10 @@ private:
 	BLEClientCallbacks* m_pClientCallbacks = nullptr;
 	FreeRTOS::Semaphore m_semaphoreRegEvt        = FreeRTOS::Semaphore("RegEvt");
 	FreeRTOS::Semaphore m_semaphoreOpenEvt       = FreeRTOS::Semaphore("OpenEvt");
-	FreeRTOS::Semaphore m_semaphoreSearchCmplEvt = FreeRTOS::Semaphore("SearchCmplEvt");
 	FreeRTOS::Semaphore m_semaphoreRssiCmplEvt   = FreeRTOS::Semaphore("RssiCmplEvt");
+	FreeRTOS::Semaphore m_semaphoreOperations    = FreeRTOS::Semaphore("Operations");
+	std::deque<std::shared_ptr<BLERemoteOperation>> m_operations;   // Outstanding, in the order they were started.
+	operation_stats_t   m_operationStats     = {0, 0, 0};
 	std::map<std::string, BLERemoteService*> m_servicesMap;
 	std::map<BLERemoteService*, uint16_t> m_servicesMapByInstID;
 	void clearServices();   // Clear any existing services.
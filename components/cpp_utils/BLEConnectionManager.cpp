@@ -0,0 +1,462 @@
+/*
+ * BLEConnectionManager.cpp
+ */
+#include "sdkconfig.h"
+#if defined(CONFIG_BT_ENABLED)
+#include <string.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <sstream>
+#include "BLEConnectionManager.h"
+#include "BLEDevice.h"
+#include "BLERemoteCharacteristic.h"
+#include "BLERemoteService.h"
+
+static const char* LOG_TAG = "BLEConnectionManager";
+
+
+/**
+ * @brief Construct a manager without peers.
+ *
+ * Peers are connected at least 100 ms apart and retried after a backoff of 500 ms doubling up to 30 s;
+ * see setStagger() and setBackoff().
+ */
+BLEConnectionManager::BLEConnectionManager() {
+	m_queue        = ::xQueueCreate(CONFIG_BLE_CONNECTION_QUEUE_SIZE, sizeof(ble_connection_event_t));
+	m_task         = nullptr;
+	m_running      = false;
+	m_staggerMs    = 100;
+	m_minBackoffMs = 500;
+	m_maxBackoffMs = 30000;
+	m_dropped      = 0;
+} // BLEConnectionManager
+
+
+/**
+ * @brief Stop the manager, disconnect from every peer and release their clients.
+ *
+ * A client is deleted only once its disconnect event has been handled, so that the event finds neither
+ * the client nor the peer gone and the client's outstanding operations have been failed.
+ */
+BLEConnectionManager::~BLEConnectionManager() {
+	stop();
+	for (auto pPeer : m_peers) {
+		if (pPeer->m_pClient->isConnected()) {
+			::ulTaskNotifyTake(pdTRUE, 0);   // Drop a notification left over from an earlier wait.
+			pPeer->m_disconnectWaiter = ::xTaskGetCurrentTaskHandle();
+			pPeer->m_pClient->disconnect();
+			if (::ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(DISCONNECT_TIMEOUT_MS)) == 0) {
+				ESP_LOGW(LOG_TAG, "Peer %d did not disconnect", pPeer->m_index);
+			}
+		}
+		delete pPeer->m_pClient;
+		delete pPeer;
+	}
+	::vQueueDelete(m_queue);
+} // ~BLEConnectionManager
+
+
+/**
+ * @brief Register for notifications of a characteristic on every peer once it is connected.
+ *
+ * Call before start().  A peer that does not have the characteristic fails to set up and is tried again
+ * after the backoff.
+ * @param [in] serviceUUID The service that owns the characteristic.
+ * @param [in] characteristicUUID The characteristic.
+ * @param [in] notifications True for notifications, false for indications.
+ */
+void BLEConnectionManager::addNotify(BLEUUID serviceUUID, BLEUUID characteristicUUID, bool notifications) {
+	notify_t notify;
+	notify.serviceUUID        = serviceUUID;
+	notify.characteristicUUID = characteristicUUID;
+	notify.notifications      = notifications;
+	m_notifies.push_back(notify);
+} // addNotify
+
+
+/**
+ * @brief Add a peripheral to keep connected to.
+ *
+ * Call before start().  A BLEClient is created for the peer, which registers an application with
+ * Bluedroid, so BLEDevice::init() must have been called.
+ * @param [in] address The address of the peripheral.
+ * @param [in] type The type of the address.
+ * @return The number of the peer, used in events and by the other methods.
+ */
+int BLEConnectionManager::addPeer(BLEAddress address, esp_ble_addr_type_t type) {
+	ESP_LOGD(LOG_TAG, ">> addPeer: %s", address.toString().c_str());
+	Peer* pPeer = new Peer();
+	pPeer->m_pManager      = this;
+	pPeer->m_index         = m_peers.size();
+	pPeer->m_address       = address;
+	pPeer->m_type          = type;
+	pPeer->m_state         = PEER_WAITING;
+	pPeer->m_nextAttempt   = 0;
+	pPeer->m_backoffMs     = m_minBackoffMs;
+	pPeer->m_connectedAtUs = 0;
+	pPeer->m_disconnectWaiter = nullptr;
+	memset(&pPeer->m_stats, 0, sizeof(pPeer->m_stats));
+	pPeer->m_pClient = BLEDevice::createClient();
+	pPeer->m_pClient->setClientCallbacks(pPeer, false);
+	m_peers.push_back(pPeer);
+	ESP_LOGD(LOG_TAG, "<< addPeer: %d", pPeer->m_index);
+	return pPeer->m_index;
+} // addPeer
+
+
+/**
+ * @brief Connect to a peer, discover its services and register for notifications.  Called from the task.
+ * @param [in] pPeer The peer.
+ * @return True if the connection was set up.
+ */
+bool BLEConnectionManager::connectPeer(Peer* pPeer) {
+	ESP_LOGD(LOG_TAG, ">> connectPeer: %d %s", pPeer->m_index, pPeer->m_address.toString().c_str());
+	int64_t startUs = ::esp_timer_get_time();
+	pPeer->m_state = PEER_CONNECTING;
+
+	BLEClient* pClient = pPeer->m_pClient;
+	bool setUp = pClient->connect(pPeer->m_address, pPeer->m_type);
+	for (auto it = m_notifies.begin(); setUp && it != m_notifies.end(); ++it) {
+		BLERemoteService* pService = pClient->getService(it->serviceUUID);   // From the discovery cache when it can be.
+		BLERemoteCharacteristic* pCharacteristic = pService != nullptr ? pService->getCharacteristic(it->characteristicUUID) : nullptr;
+		if (pCharacteristic == nullptr) {
+			ESP_LOGW(LOG_TAG, "Peer %d has no characteristic %s in service %s", pPeer->m_index,
+				it->characteristicUUID.toString().c_str(), it->serviceUUID.toString().c_str());
+			setUp = false;
+			break;
+		}
+		pCharacteristic->registerForNotify(onNotify, it->notifications);
+	}
+
+	int64_t nowUs = ::esp_timer_get_time();
+	m_semaphorePeers.take("connectPeer");
+	setUp = setUp && pClient->isConnected();   // A drop while setting up is a failure; onDisconnect() leaves it to us.
+	if (setUp) {
+		uint32_t setupMs = (uint32_t) ((nowUs - startUs) / 1000);
+		pPeer->m_state         = PEER_CONNECTED;
+		pPeer->m_backoffMs     = m_minBackoffMs;
+		pPeer->m_connectedAtUs = nowUs;
+		pPeer->m_stats.connects++;
+		pPeer->m_stats.setupMs = setupMs;
+		if (setupMs > pPeer->m_stats.maxSetupMs) {
+			pPeer->m_stats.maxSetupMs = setupMs;
+		}
+	} else {
+		pPeer->m_state       = PEER_WAITING;
+		pPeer->m_nextAttempt = ::xTaskGetTickCount() + pdMS_TO_TICKS(pPeer->m_backoffMs);
+		pPeer->m_backoffMs   = pPeer->m_backoffMs * 2 < m_maxBackoffMs ? pPeer->m_backoffMs * 2 : m_maxBackoffMs;
+		pPeer->m_stats.failures++;
+	}
+	m_semaphorePeers.give();
+
+	if (setUp) {
+		post(EVENT_CONNECTED, pPeer->m_index);
+	} else if (pClient->isConnected()) {
+		pClient->disconnect();   // Connected but without what we need; start afresh next time.
+	}
+	ESP_LOGD(LOG_TAG, "<< connectPeer: %d", setUp);
+	return setUp;
+} // connectPeer
+
+
+/**
+ * @brief Get the client of a peer, to read and write its characteristics.
+ * @param [in] peer The number of the peer.
+ * @return The client, or nullptr if there is no such peer.
+ */
+BLEClient* BLEConnectionManager::getClient(int peer) {
+	if (peer < 0 || peer >= (int) m_peers.size()) return nullptr;
+	return m_peers[peer]->m_pClient;
+} // getClient
+
+
+/**
+ * @brief Get the number of events dropped because the queue was full.
+ * @return The number of dropped events.
+ */
+uint32_t BLEConnectionManager::getDropped() {
+	return m_dropped.load(std::memory_order_relaxed);
+} // getDropped
+
+
+/**
+ * @brief Get the number of peers added.
+ * @return The number of peers.
+ */
+size_t BLEConnectionManager::getPeerCount() {
+	return m_peers.size();
+} // getPeerCount
+
+
+/**
+ * @brief Get the state of the connection to a peer.
+ * @param [in] peer The number of the peer.
+ * @return The state.
+ */
+BLEConnectionManager::peer_state_t BLEConnectionManager::getState(int peer) {
+	if (peer < 0 || peer >= (int) m_peers.size()) return PEER_WAITING;
+	return m_peers[peer]->m_state;
+} // getState
+
+
+/**
+ * @brief Get the statistics of a peer.
+ *
+ * The throughput of the peer is notifications, or notifyBytes, divided by connectedUs.
+ * @param [in] peer The number of the peer.
+ * @return The statistics, accumulated since the peer was added.
+ */
+BLEConnectionManager::peer_stats_t BLEConnectionManager::getStats(int peer) {
+	peer_stats_t stats;
+	memset(&stats, 0, sizeof(stats));
+	if (peer < 0 || peer >= (int) m_peers.size()) return stats;
+
+	Peer* pPeer = m_peers[peer];
+	m_semaphorePeers.take("getStats");
+	stats = pPeer->m_stats;
+	if (pPeer->m_connectedAtUs != 0) {
+		stats.connectedUs += ::esp_timer_get_time() - pPeer->m_connectedAtUs;
+	}
+	m_semaphorePeers.give();
+
+	BLEClient::operation_stats_t operationStats = pPeer->m_pClient->getOperationStats();
+	stats.operations    = operationStats.operations;
+	stats.meanLatencyUs = operationStats.operations > 0 ? (uint32_t) (operationStats.latencyUs / operationStats.operations) : 0;
+	stats.maxLatencyUs  = operationStats.maxLatencyUs;
+	return stats;
+} // getStats
+
+
+/**
+ * @brief Queue a notification from a peer.  Called in the Bluedroid task.
+ *
+ * The peer is found from the client of the characteristic, whose callbacks are the peer itself.
+ */
+void BLEConnectionManager::onNotify(BLERemoteCharacteristic* pCharacteristic, uint8_t* pData, size_t length, bool isNotify) {
+	Peer* pPeer = static_cast<Peer*>(pCharacteristic->getRemoteService()->getClient()->getClientCallbacks());
+	BLEConnectionManager* pManager = pPeer->m_pManager;
+	bool queued = pManager->post(EVENT_NOTIFY, pPeer->m_index, pCharacteristic->getHandle(), pData, length, isNotify);
+
+	pManager->m_semaphorePeers.take("onNotify");
+	pPeer->m_stats.notifications++;
+	pPeer->m_stats.notifyBytes += length;
+	if (!queued) {
+		pPeer->m_stats.dropped++;
+	}
+	pManager->m_semaphorePeers.give();
+} // onNotify
+
+
+/**
+ * @brief Called when the client of a peer opens a connection; the task carries on from there.
+ * @param [in] pClient The client of the peer.
+ */
+void BLEConnectionManager::Peer::onConnect(BLEClient* pClient) {
+	ESP_LOGD(LOG_TAG, "Peer %d opened, conn_id: %d", m_index, pClient->getConnId());
+} // onConnect
+
+
+/**
+ * @brief Called when the connection of a peer drops.  Schedule the reconnect and wake the task.
+ * @param [in] pClient The client of the peer.
+ */
+void BLEConnectionManager::Peer::onDisconnect(BLEClient* pClient) {
+	m_pManager->m_semaphorePeers.take("onDisconnect");
+	if (m_state != PEER_CONNECTED) {   // Dropped while being set up, or by connectPeer() itself.
+		m_pManager->m_semaphorePeers.give();
+		TaskHandle_t waiter = m_disconnectWaiter;
+		if (waiter != nullptr) {
+			::xTaskNotifyGive(waiter);   // The last use of the peer, which may be deleted at once.
+		}
+		return;
+	}
+	m_state       = PEER_WAITING;
+	m_nextAttempt = ::xTaskGetTickCount() + pdMS_TO_TICKS(m_backoffMs);
+	m_backoffMs   = m_backoffMs * 2 < m_pManager->m_maxBackoffMs ? m_backoffMs * 2 : m_pManager->m_maxBackoffMs;
+	m_stats.disconnects++;
+	m_stats.connectedUs += ::esp_timer_get_time() - m_connectedAtUs;
+	m_connectedAtUs = 0;
+	if (m_pManager->m_task != nullptr) {   // Under the lock, so the task cannot end in between.
+		::xTaskNotifyGive(m_pManager->m_task);
+	}
+	m_pManager->m_semaphorePeers.give();
+
+	ESP_LOGI(LOG_TAG, "Peer %d disconnected, conn_id: %d", m_index, pClient->getConnId());
+	m_pManager->post(EVENT_DISCONNECTED, m_index);
+	TaskHandle_t waiter = m_disconnectWaiter;
+	if (waiter != nullptr) {
+		::xTaskNotifyGive(waiter);   // The last use of the peer, which may be deleted at once.
+	}
+} // onDisconnect
+
+
+/**
+ * @brief Add an event to the queue without blocking.
+ * @return True if the event was queued, false if the queue was full and the event was dropped.
+ */
+bool BLEConnectionManager::post(event_type_t type, uint8_t peer, uint16_t handle, const uint8_t* pData, size_t length, bool isNotify) {
+	ble_connection_event_t event;
+	event.type      = type;
+	event.peer      = peer;
+	event.handle    = handle;
+	event.isNotify  = isNotify;
+	event.truncated = length > CONFIG_BLE_CONNECTION_EVENT_DATA_SIZE;
+	event.length    = event.truncated ? CONFIG_BLE_CONNECTION_EVENT_DATA_SIZE : length;
+	event.timeUs    = ::esp_timer_get_time();
+	if (pData != nullptr && event.length > 0) {
+		memcpy(event.data, pData, event.length);
+	}
+	if (::xQueueSend(m_queue, &event, 0) != pdTRUE) {
+		m_dropped.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+	return true;
+} // post
+
+
+/**
+ * @brief Take the oldest event from the queue, waiting for one if there is none.
+ * @param [out] pEvent The event.
+ * @param [in] ticksToWait The maximum time to wait.
+ * @return True if an event was returned, false on timeout.
+ */
+bool BLEConnectionManager::receive(ble_connection_event_t* pEvent, TickType_t ticksToWait) {
+	return ::xQueueReceive(m_queue, pEvent, ticksToWait) == pdTRUE;
+} // receive
+
+
+/**
+ * @brief Connect to the peers that are due, one at a time and a stagger apart, until stopped.
+ */
+void BLEConnectionManager::run() {
+	TickType_t lastAttempt = 0;
+	bool       attempted   = false;
+	while (m_running) {
+		TickType_t now     = ::xTaskGetTickCount();
+		TickType_t stagger = pdMS_TO_TICKS(m_staggerMs);
+		TickType_t wait    = portMAX_DELAY;
+		Peer*      pDue    = nullptr;
+
+		m_semaphorePeers.take("run");
+		for (auto pPeer : m_peers) {
+			if (pPeer->m_state != PEER_WAITING) continue;
+			TickType_t due = pPeer->m_nextAttempt;
+			if (attempted && (int32_t) (due - (lastAttempt + stagger)) < 0) {
+				due = lastAttempt + stagger;
+			}
+			if ((int32_t) (due - now) <= 0) {
+				pDue = pPeer;
+				break;
+			}
+			if (due - now < wait) {
+				wait = due - now;
+			}
+		}
+		m_semaphorePeers.give();
+
+		if (pDue != nullptr) {
+			lastAttempt = now;
+			attempted   = true;
+			connectPeer(pDue);
+		} else {
+			::ulTaskNotifyTake(pdTRUE, wait);   // Until the next peer is due, a peer drops or we are stopped.
+		}
+	}
+} // run
+
+
+/**
+ * @brief Body of the task of the manager.
+ */
+void BLEConnectionManager::runTask(void* pData) {
+	BLEConnectionManager* pManager = (BLEConnectionManager*) pData;
+	pManager->run();
+	pManager->m_semaphorePeers.take("runTask");
+	pManager->m_task = nullptr;
+	pManager->m_semaphorePeers.give();
+	pManager->m_semaphoreStopped.give();
+	::vTaskDelete(nullptr);
+} // runTask
+
+
+/**
+ * @brief Set how long to wait before trying a peer again.
+ *
+ * The first attempt after a failure, or after a connection drops, waits the minimum.  Each further
+ * failure doubles the wait, up to the maximum.
+ * @param [in] minMs The shortest wait, in milliseconds.
+ * @param [in] maxMs The longest wait, in milliseconds.
+ */
+void BLEConnectionManager::setBackoff(uint32_t minMs, uint32_t maxMs) {
+	m_minBackoffMs = minMs;
+	m_maxBackoffMs = maxMs < minMs ? minMs : maxMs;
+	for (auto pPeer : m_peers) {
+		pPeer->m_backoffMs = m_minBackoffMs;
+	}
+} // setBackoff
+
+
+/**
+ * @brief Set the least time between the start of one connect and the next.
+ * @param [in] ms The time in milliseconds.
+ */
+void BLEConnectionManager::setStagger(uint32_t ms) {
+	m_staggerMs = ms;
+} // setStagger
+
+
+/**
+ * @brief Start the task that connects to the peers.
+ */
+void BLEConnectionManager::start() {
+	ESP_LOGD(LOG_TAG, ">> start");
+	if (m_running) {
+		ESP_LOGW(LOG_TAG, "Already started");
+		return;
+	}
+	m_running = true;
+	m_semaphoreStopped.take("start");
+	m_semaphorePeers.take("start");   // So that the task sees m_task set.
+	::xTaskCreate(&runTask, "BLEConnMgr", 4096, this, 5, &m_task);
+	m_semaphorePeers.give();
+	ESP_LOGD(LOG_TAG, "<< start");
+} // start
+
+
+/**
+ * @brief Stop the task that connects to the peers and wait for it to end.
+ *
+ * A connect in progress is finished first.  The peers stay connected, and their notifications are still
+ * queued, but no longer reconnect.
+ */
+void BLEConnectionManager::stop() {
+	ESP_LOGD(LOG_TAG, ">> stop");
+	if (!m_running) return;
+	m_running = false;
+	::xTaskNotifyGive(m_task);
+	m_semaphoreStopped.wait("stop");
+	ESP_LOGD(LOG_TAG, "<< stop");
+} // stop
+
+
+/**
+ * @brief Return a string representation of the peers, their state and statistics.
+ * @return A line for each peer.
+ */
+std::string BLEConnectionManager::toString() {
+	static const char* states[] = { "waiting", "connecting", "connected" };
+	std::ostringstream ss;
+	for (auto pPeer : m_peers) {
+		peer_stats_t stats = getStats(pPeer->m_index);
+		double seconds = stats.connectedUs / 1000000.0;
+		ss << "peer " << (int) pPeer->m_index << " " << pPeer->m_address.toString() << ": " << states[pPeer->m_state]
+			<< ", connects " << stats.connects << ", failures " << stats.failures << ", disconnects " << stats.disconnects
+			<< ", setup " << stats.setupMs << " ms (max " << stats.maxSetupMs << ")"
+			<< ", latency " << stats.meanLatencyUs << " us (max " << stats.maxLatencyUs << ") over " << stats.operations
+			<< ", notifications " << stats.notifications << " (" << (seconds > 0 ? stats.notifications / seconds : 0) << "/s, "
+			<< (seconds > 0 ? stats.notifyBytes / seconds : 0) << " B/s), dropped " << stats.dropped << "\n";
+	}
+	return ss.str();
+} // toString
+
+#endif /* CONFIG_BT_ENABLED */
@@ -0,0 +1,170 @@
+/*
+ * BLEConnectionManager.h
+ */
+
+#ifndef COMPONENTS_CPP_UTILS_BLECONNECTIONMANAGER_H_
+#define COMPONENTS_CPP_UTILS_BLECONNECTIONMANAGER_H_
+#include "sdkconfig.h"
+#if defined(CONFIG_BT_ENABLED)
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+#include "BLEAddress.h"
+#include "BLEClient.h"
+#include "BLEUUID.h"
+#include "FreeRTOS.h"
+
+#ifndef CONFIG_BLE_CONNECTION_QUEUE_SIZE
+#define CONFIG_BLE_CONNECTION_QUEUE_SIZE 32
+#endif
+#ifndef CONFIG_BLE_CONNECTION_EVENT_DATA_SIZE
+#define CONFIG_BLE_CONNECTION_EVENT_DATA_SIZE 32
+#endif
+
+class BLERemoteCharacteristic;
+
+/**
+ * @brief An event from one of the peers of a BLEConnectionManager.
+ */
+typedef struct {
+	uint8_t  type;        // BLEConnectionManager::EVENT_CONNECTED, EVENT_DISCONNECTED or EVENT_NOTIFY.
+	uint8_t  peer;        // The peer, as numbered by BLEConnectionManager::addPeer().
+	uint16_t handle;      // The characteristic notified.
+	uint16_t length;      // Number of valid bytes in data.
+	bool     isNotify;    // A notification rather than an indication.
+	bool     truncated;   // The value did not fit and was cut to CONFIG_BLE_CONNECTION_EVENT_DATA_SIZE.
+	int64_t  timeUs;      // When the event happened, from esp_timer_get_time().
+	uint8_t  data[CONFIG_BLE_CONNECTION_EVENT_DATA_SIZE];
+} ble_connection_event_t;
+
+
+/**
+ * @brief Keep connections to a set of peripherals and gather their notifications onto one queue.
+ *
+ * Each peer added with addPeer() gets a BLEClient of its own.  Once start() is called a task of the
+ * manager connects to every peer, discovers its services and registers for the notifications asked for
+ * with addNotify().  The connects are made one at a time and at least the stagger apart, so that peers
+ * do not all take the radio at once after a restart.  A peer that cannot be reached, or whose connection
+ * drops, is tried again after a backoff that doubles with each failed attempt, up to a maximum, and
+ * returns to the minimum once a connection has been set up.  The controller holds at most
+ * CONFIG_BTDM_CTRL_BLE_MAX_CONN connections, counting those of a BLEServer; peers beyond that keep failing.
+ *
+ * Notifications from every peer, and each peer connecting and disconnecting, arrive as events on a
+ * single queue that the application takes them from with receive().  Notifications are copied into the
+ * queue in the Bluedroid task without blocking; when the queue is full they are dropped and counted.
+ *
+ * getStats() reports for each peer how long connections took to set up, how quickly the peer answered
+ * reads and writes, and how many notifications and bytes it sent over the time it was connected.
+ *
+ * @code{.cpp}
+ * BLEConnectionManager manager;
+ * manager.addPeer(BLEAddress("24:0a:c4:00:00:02"));
+ * manager.addPeer(BLEAddress("24:0a:c4:00:00:03"));
+ * manager.addNotify(serviceUUID, statusUUID);
+ * manager.start();
+ * ble_connection_event_t event;
+ * while (manager.receive(&event)) {
+ *    if (event.type == BLEConnectionManager::EVENT_NOTIFY) { ... }
+ * }
+ * @endcode
+ */
+class BLEConnectionManager {
+public:
+	typedef enum {
+		EVENT_CONNECTED,      // The peer is connected and registered for notifications.
+		EVENT_DISCONNECTED,   // The connection to the peer was lost; it will be tried again.
+		EVENT_NOTIFY          // The peer notified or indicated a characteristic.
+	} event_type_t;
+
+	typedef enum {
+		PEER_WAITING,         // Not connected; waiting for the stagger or the backoff to pass.
+		PEER_CONNECTING,      // Connecting, discovering or registering for notifications.
+		PEER_CONNECTED        // Connected and registered for notifications.
+	} peer_state_t;
+
+	typedef struct {
+		uint32_t connects;        // Connections made and set up.
+		uint32_t failures;        // Attempts to connect, or to set up the connection, that failed.
+		uint32_t disconnects;     // Connections lost after being set up.
+		uint32_t setupMs;         // How long the last connection took to set up, from starting to connect.
+		uint32_t maxSetupMs;      // The longest any connection took to set up.
+		uint64_t connectedUs;     // Time spent connected, including the current connection.
+		uint32_t notifications;   // Notifications and indications received.
+		uint64_t notifyBytes;     // Bytes of value they carried.
+		uint32_t dropped;         // Of those, the ones lost because the queue was full.
+		uint32_t operations;      // Reads and writes the peer answered; see BLEClient::getOperationStats().
+		uint32_t meanLatencyUs;   // The mean time the peer took to answer them.
+		uint32_t maxLatencyUs;    // The longest it took.
+	} peer_stats_t;
+
+	BLEConnectionManager();
+	~BLEConnectionManager();
+
+	void         addNotify(BLEUUID serviceUUID, BLEUUID characteristicUUID, bool notifications = true);
+	int          addPeer(BLEAddress address, esp_ble_addr_type_t type = BLE_ADDR_TYPE_PUBLIC);
+	BLEClient*   getClient(int peer);
+	uint32_t     getDropped();
+	size_t       getPeerCount();
+	peer_state_t getState(int peer);
+	peer_stats_t getStats(int peer);
+	bool         receive(ble_connection_event_t* pEvent, TickType_t ticksToWait = portMAX_DELAY);
+	void         setBackoff(uint32_t minMs, uint32_t maxMs);
+	void         setStagger(uint32_t ms);
+	void         start();
+	void         stop();
+	std::string  toString();
+
+private:
+	class Peer : public BLEClientCallbacks {
+	public:
+		void onConnect(BLEClient* pClient);
+		void onDisconnect(BLEClient* pClient);
+
+		BLEConnectionManager* m_pManager;
+		uint8_t               m_index;
+		BLEAddress            m_address = BLEAddress((uint8_t*)"\0\0\0\0\0\0");
+		esp_ble_addr_type_t   m_type;
+		BLEClient*            m_pClient;
+		volatile peer_state_t m_state;
+		TickType_t            m_nextAttempt;   // When it may next be connected to.
+		uint32_t              m_backoffMs;     // How long to wait after the next failure.
+		int64_t               m_connectedAtUs; // When the current connection was set up, 0 if none.
+		peer_stats_t          m_stats;
+		TaskHandle_t volatile m_disconnectWaiter;  // Notified when onDisconnect() is done with the peer, or nullptr.
+	}; // Peer
+
+	typedef struct {
+		BLEUUID serviceUUID;
+		BLEUUID characteristicUUID;
+		bool    notifications;
+	} notify_t;
+
+	static const uint32_t DISCONNECT_TIMEOUT_MS = 5000;   // How long the destructor waits for each peer to disconnect.
+
+	static void onNotify(BLERemoteCharacteristic* pCharacteristic, uint8_t* pData, size_t length, bool isNotify);
+	static void runTask(void* pData);
+
+	bool connectPeer(Peer* pPeer);
+	bool post(event_type_t type, uint8_t peer, uint16_t handle = 0, const uint8_t* pData = nullptr, size_t length = 0, bool isNotify = false);
+	void run();
+
+	std::vector<Peer*>    m_peers;
+	std::vector<notify_t> m_notifies;
+	QueueHandle_t         m_queue;
+	TaskHandle_t          m_task;
+	volatile bool         m_running;
+	uint32_t              m_staggerMs;
+	uint32_t              m_minBackoffMs;
+	uint32_t              m_maxBackoffMs;
+	std::atomic<uint32_t> m_dropped;
+	FreeRTOS::Semaphore   m_semaphorePeers   = FreeRTOS::Semaphore("Peers");     // Guards the state and statistics of the peers.
+	FreeRTOS::Semaphore   m_semaphoreStopped = FreeRTOS::Semaphore("Stopped");   // Given when the task ends.
+}; // BLEConnectionManager
+
+#endif /* CONFIG_BT_ENABLED */
+#endif /* COMPONENTS_CPP_UTILS_BLECONNECTIONMANAGER_H_ */
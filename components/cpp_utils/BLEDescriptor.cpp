@@ -213,7 +213,7 @@ void BLEDescriptor::handleGATTServerEvent(
  * @param [in] pCallbacks An instance of a callback structure used to define any callbacks for the descriptor.
  */
 void BLEDescriptor::setCallbacks(BLEDescriptorCallbacks* pCallback) {
-	ESP_LOGD(LOG_TAG, ">> setCallbacks: 0x%x", (uint32_t) pCallback);
+	ESP_LOGD(LOG_TAG, ">> setCallbacks: %p", pCallback);
 	m_pCallback = pCallback;
 	ESP_LOGD(LOG_TAG, "<< setCallbacks");
 } // setCallbacks
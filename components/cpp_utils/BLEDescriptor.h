@@ -32,7 +32,7 @@ public:
 	size_t   getLength();                                   // Get the length of the value of the descriptor.
 	BLEUUID  getUUID();                                     // Get the UUID of the descriptor.
 	uint8_t* getValue();                                    // Get a pointer to the value of the descriptor.
-	void handleGATTServerEvent(
+	virtual void handleGATTServerEvent(
 			esp_gatts_cb_event_t      event,
 			esp_gatt_if_t             gatts_if,
 			esp_ble_gatts_cb_param_t* param);
@@ -31,23 +31,17 @@ BLEDescriptor* BLEDescriptorMap::getByUUID(const char* uuid) {
  * @return The descriptor.  If not present, then nullptr is returned.
  */
 BLEDescriptor* BLEDescriptorMap::getByUUID(BLEUUID uuid) {
-	for (auto &myPair : m_uuidMap) {
-		if (myPair.first->getUUID().equals(uuid)) {
-			return myPair.first;
-		}
-	}
-	//return m_uuidMap.at(uuid.toString());
-	return nullptr;
+	return m_registry.getByUUID(uuid);
 } // getByUUID
 
 
 /**
  * @brief Return the descriptor by handle.
  * @param [in] handle The handle to look up the descriptor.
- * @return The descriptor.
+ * @return The descriptor or nullptr if no descriptor has the handle.
  */
 BLEDescriptor* BLEDescriptorMap::getByHandle(uint16_t handle) {
-	return m_handleMap.at(handle);
+	return m_registry.getByHandle(handle);
 } // getByHandle
 
 
@@ -58,7 +52,7 @@ BLEDescriptor* BLEDescriptorMap::getByHandle(uint16_t handle) {
  * @return N/A.
  */
 void BLEDescriptorMap::setByUUID(const char* uuid, BLEDescriptor* pDescriptor){
-	m_uuidMap.insert(std::pair<BLEDescriptor*, std::string>(pDescriptor, uuid));
+	m_registry.add(pDescriptor, BLEUUID(uuid));
 } // setByUUID
 
 
@@ -70,7 +64,7 @@ void BLEDescriptorMap::setByUUID(const char* uuid, BLEDescriptor* pDescriptor){
  * @return N/A.
  */
 void BLEDescriptorMap::setByUUID(BLEUUID uuid, BLEDescriptor* pDescriptor) {
-	m_uuidMap.insert(std::pair<BLEDescriptor*, std::string>(pDescriptor, uuid.toString()));
+	m_registry.add(pDescriptor, uuid);
 } // setByUUID
 
 
@@ -81,7 +75,7 @@ void BLEDescriptorMap::setByUUID(BLEUUID uuid, BLEDescriptor* pDescriptor) {
  * @return N/A.
  */
 void BLEDescriptorMap::setByHandle(uint16_t handle, BLEDescriptor* pDescriptor) {
-	m_handleMap.insert(std::pair<uint16_t, BLEDescriptor*>(handle, pDescriptor));
+	m_registry.setHandle(handle, pDescriptor);
 } // setByHandle
 
 
@@ -93,12 +87,12 @@ std::string BLEDescriptorMap::toString() {
 	std::stringstream stringStream;
 	stringStream << std::hex << std::setfill('0');
 	int count = 0;
-	for (auto &myPair : m_uuidMap) {
+	for (auto pDescriptor : m_registry) {
 		if (count > 0) {
 			stringStream << "\n";
 		}
 		count++;
-		stringStream << "handle: 0x" << std::setw(2) << myPair.first->getHandle() << ", uuid: " + myPair.first->getUUID().toString();
+		stringStream << "handle: 0x" << std::setw(2) << pDescriptor->getHandle() << ", uuid: " + pDescriptor->getUUID().toString();
 	}
 	return stringStream.str();
 } // toString
@@ -115,33 +109,26 @@ void BLEDescriptorMap::handleGATTServerEvent(
 		esp_gatt_if_t             gatts_if,
 		esp_ble_gatts_cb_param_t* param) {
 	// Invoke the handler for every descriptor we have.
-	for (auto &myPair : m_uuidMap) {
-		myPair.first->handleGATTServerEvent(event, gatts_if, param);
+	for (auto pDescriptor : m_registry) {
+		pDescriptor->handleGATTServerEvent(event, gatts_if, param);
 	}
 } // handleGATTServerEvent
 
 
 /**
- * @brief Get the first descriptor in the map.
- * @return The first descriptor in the map.
+ * @brief Get an iterator to the first descriptor in the map, in the order they were added.
+ * @return The iterator.
  */
-BLEDescriptor* BLEDescriptorMap::getFirst() {
-	m_iterator = m_uuidMap.begin();
-	if (m_iterator == m_uuidMap.end()) return nullptr;
-	BLEDescriptor* pRet = m_iterator->first;
-	m_iterator++;
-	return pRet;
-} // getFirst
+BLEAttributeRegistry<BLEDescriptor>::const_iterator BLEDescriptorMap::begin() const {
+	return m_registry.begin();
+} // begin
 
 
 /**
- * @brief Get the next descriptor in the map.
- * @return The next descriptor in the map.
+ * @brief Get an iterator past the last descriptor in the map.
+ * @return The iterator.
  */
-BLEDescriptor* BLEDescriptorMap::getNext() {
-	if (m_iterator == m_uuidMap.end()) return nullptr;
-	BLEDescriptor* pRet = m_iterator->first;
-	m_iterator++;
-	return pRet;
-} // getNext
+BLEAttributeRegistry<BLEDescriptor>::const_iterator BLEDescriptorMap::end() const {
+	return m_registry.end();
+} // end
 #endif /* CONFIG_BT_ENABLED */
@@ -25,6 +25,7 @@
 
 #include "BLEDevice.h"
 #include "BLEClient.h"
+#include "BLERemoteCharacteristic.h"
 #include "BLEUtils.h"
 #include "GeneralUtils.h"
 #if defined(CONFIG_ARDUHAL_ESP_LOG)
@@ -52,6 +53,15 @@ uint16_t   BLEDevice::m_localMTU = 23;  // not sure if this variable is useful
 BLEAdvertising* BLEDevice::m_bleAdvertising = nullptr;
 uint16_t BLEDevice::m_appId = 0;
 std::map<uint16_t, conn_status_t> BLEDevice::m_connectedClientsMap;
+BLEAddressTable<BLERemoteCharacteristic> BLEDevice::m_notifyTargets(8);
+FreeRTOS::Mutex BLEDevice::m_mutexNotifyTargets;
+BLERemoteCharacteristic* BLEDevice::m_pNotifyDispatching = nullptr;
+TaskHandle_t BLEDevice::m_notifyDispatchTask = nullptr;
+TaskHandle_t BLEDevice::m_notifyWaiter = nullptr;
+FreeRTOS::Mutex BLEDevice::m_mutexPeerDevices;
+BLEClient* BLEDevice::m_pGattcDispatching = nullptr;
+TaskHandle_t BLEDevice::m_gattcDispatchTask = nullptr;
+TaskHandle_t BLEDevice::m_gattcWaiter = nullptr;
 gap_event_handler BLEDevice::m_customGapHandler = nullptr;
 gattc_event_handler BLEDevice::m_customGattcHandler = nullptr;
 gatts_event_handler BLEDevice::m_customGattsHandler = nullptr;
@@ -103,9 +113,11 @@ gatts_event_handler BLEDevice::m_customGattsHandler = nullptr;
 ) {
 	ESP_LOGD(LOG_TAG, "gattServerEventHandler [esp_gatt_if: %d] ... %s",
 		gatts_if,
-		BLEUtils::gattServerEventTypeToString(event).c_str());
+		BLEUtils::gattServerEventTypeToString(event));
 
+#if CONFIG_LOG_DEFAULT_LEVEL > 4   // The dumps log only at verbose level.
 	BLEUtils::dumpGattServerEvent(event, gatts_if, param);
+#endif
 
 	switch (event) {
 		case ESP_GATTS_CONNECT_EVT: {
@@ -149,8 +161,10 @@ gatts_event_handler BLEDevice::m_customGattsHandler = nullptr;
 	esp_ble_gattc_cb_param_t* param) {
 
 	ESP_LOGD(LOG_TAG, "gattClientEventHandler [esp_gatt_if: %d] ... %s",
-		gattc_if, BLEUtils::gattClientEventTypeToString(event).c_str());
+		gattc_if, BLEUtils::gattClientEventTypeToString(event));
+#if CONFIG_LOG_DEFAULT_LEVEL > 4
 	BLEUtils::dumpGattClientEvent(event, gattc_if, param);
+#endif
 
 	switch(event) {
 		case ESP_GATTC_CONNECT_EVT: {
@@ -165,11 +179,52 @@ gatts_event_handler BLEDevice::m_customGattsHandler = nullptr;
 		default:
 			break;
 	} // switch
-	for(auto &myPair : BLEDevice::getPeerDevices(true)) {
-		conn_status_t conn_status = (conn_status_t)myPair.second;
-		if(((BLEClient*)conn_status.peer_device)->getGattcIf() == gattc_if || ((BLEClient*)conn_status.peer_device)->getGattcIf() == ESP_GATT_IF_NONE || gattc_if == ESP_GATT_IF_NONE){
-			((BLEClient*)conn_status.peer_device)->gattClientEventHandler(event, gattc_if, param);
+	if (event == ESP_GATTC_NOTIFY_EVT) {
+		// A notification goes straight to the characteristic registered for it, however many clients,
+		// services and characteristics there are.  None of them has anything else to do with it.  While it is
+		// handed over the characteristic is marked, so that removeNotifyTarget() waits before it is destroyed.
+		m_mutexNotifyTargets.lock();
+		BLERemoteCharacteristic* pCharacteristic = m_notifyTargets.find(notifyTargetKey(gattc_if, param->notify.conn_id, param->notify.handle));
+		if (pCharacteristic != nullptr) {
+			m_pNotifyDispatching = pCharacteristic;
+			m_notifyDispatchTask = ::xTaskGetCurrentTaskHandle();
+		}
+		m_mutexNotifyTargets.unlock();
+		if (pCharacteristic != nullptr) {
+			pCharacteristic->gattClientEventHandler(event, gattc_if, param);
+			m_mutexNotifyTargets.lock();
+			m_pNotifyDispatching = nullptr;
+			if (m_notifyWaiter != nullptr) {
+				::xTaskNotifyGive(m_notifyWaiter);
+				m_notifyWaiter = nullptr;
+			}
+			m_mutexNotifyTargets.unlock();
+		}
+	} else {
+		// The clients are handed the event straight from the map, which is unlocked while each one handles it
+		// as that may change the map.  The next client is found by key, so a client removed meanwhile is
+		// skipped, and removePeerDevice() waits for the client being handed the event.
+		TaskHandle_t currentTask = ::xTaskGetCurrentTaskHandle();
+		m_mutexPeerDevices.lock();
+		auto it = m_connectedClientsMap.begin();
+		while (it != m_connectedClientsMap.end()) {
+			uint16_t   key     = it->first;
+			BLEClient* pClient = (BLEClient*)it->second.peer_device;
+			m_pGattcDispatching = pClient;
+			m_gattcDispatchTask = currentTask;
+			m_mutexPeerDevices.unlock();
+			if(pClient->getGattcIf() == gattc_if || pClient->getGattcIf() == ESP_GATT_IF_NONE || gattc_if == ESP_GATT_IF_NONE){
+				pClient->gattClientEventHandler(event, gattc_if, param);
+			}
+			m_mutexPeerDevices.lock();
+			m_pGattcDispatching = nullptr;
+			if (m_gattcWaiter != nullptr) {
+				::xTaskNotifyGive(m_gattcWaiter);
+				m_gattcWaiter = nullptr;
+			}
+			it = m_connectedClientsMap.upper_bound(key);
 		}
+		m_mutexPeerDevices.unlock();
 	}
 
 	if(m_customGattcHandler != nullptr) {
@@ -187,7 +242,9 @@ gatts_event_handler BLEDevice::m_customGattsHandler = nullptr;
 	esp_gap_ble_cb_event_t event,
 	esp_ble_gap_cb_param_t *param) {
 
+#if CONFIG_LOG_DEFAULT_LEVEL > 4
 	BLEUtils::dumpGapEvent(event, param);
+#endif
 
 	switch(event) {
 
@@ -266,6 +323,10 @@ gatts_event_handler BLEDevice::m_customGattsHandler = nullptr;
 		}
 	} // switch
 
+	if (BLEDevice::m_pServer != nullptr) {
+		BLEDevice::m_pServer->handleGAPEvent(event, param);
+	}
+
 	if (BLEDevice::m_pScan != nullptr) {
 		BLEDevice::getScan()->handleGAPEvent(event, param);
 	}
@@ -567,27 +628,36 @@ void BLEDevice::startAdvertising() {
 /* multi connect support */
 /* requires a little more work */
 std::map<uint16_t, conn_status_t> BLEDevice::getPeerDevices(bool _client) {
-	return m_connectedClientsMap;
+	m_mutexPeerDevices.lock();
+	std::map<uint16_t, conn_status_t> peers = m_connectedClientsMap;
+	m_mutexPeerDevices.unlock();
+	return peers;
 }
 
 BLEClient* BLEDevice::getClientByGattIf(uint16_t conn_id) {
-	return (BLEClient*)m_connectedClientsMap.find(conn_id)->second.peer_device;
+	m_mutexPeerDevices.lock();
+	BLEClient* pClient = (BLEClient*)m_connectedClientsMap.find(conn_id)->second.peer_device;
+	m_mutexPeerDevices.unlock();
+	return pClient;
 }
 
 void BLEDevice::updatePeerDevice(void* peer, bool _client, uint16_t conn_id) {
 	ESP_LOGD(LOG_TAG, "update conn_id: %d, GATT role: %s", conn_id, _client? "client":"server");
+	m_mutexPeerDevices.lock();
 	std::map<uint16_t, conn_status_t>::iterator it = m_connectedClientsMap.find(ESP_GATT_IF_NONE);
 	if (it != m_connectedClientsMap.end()) {
 		std::swap(m_connectedClientsMap[conn_id], it->second);
 		m_connectedClientsMap.erase(it);
 	}else{
 		it = m_connectedClientsMap.find(conn_id);
-		if (it != m_connectedClientsMap.end()) {
+		// Clients are keyed by app id, which may be the interface of another client; never take over its entry.
+		if (it != m_connectedClientsMap.end() && it->second.peer_device == peer) {
 			conn_status_t _st = it->second;
 			_st.peer_device = peer;
 			std::swap(m_connectedClientsMap[conn_id], _st);
 		}
 	}
+	m_mutexPeerDevices.unlock();
 }
 
 void BLEDevice::addPeerDevice(void* peer, bool _client, uint16_t conn_id) {
@@ -598,13 +668,99 @@ void BLEDevice::addPeerDevice(void* peer, bool _client, uint16_t conn_id) {
 		.mtu = 23
 	};
 
+	m_mutexPeerDevices.lock();
 	m_connectedClientsMap.insert(std::pair<uint16_t, conn_status_t>(conn_id, status));
+	m_mutexPeerDevices.unlock();
 }
 
+/**
+ * @brief Route the notifications and indications of a remote characteristic to it.
+ *
+ * The characteristic is found by the interface and connection of its client and its handle, as they are
+ * now.  Adding it again after its client has reconnected routes the new connection instead.
+ * @param [in] pCharacteristic The characteristic, which has a notification callback.
+ */
+void BLEDevice::addNotifyTarget(BLERemoteCharacteristic* pCharacteristic) {
+	BLEClient* pClient = pCharacteristic->getRemoteService()->getClient();
+	removeNotifyTarget(pCharacteristic);
+	m_mutexNotifyTargets.lock();
+	pCharacteristic->m_notifyKey = notifyTargetKey(pClient->getGattcIf(), pClient->getConnId(), pCharacteristic->getHandle());
+	BLERemoteCharacteristic* pPrevious = m_notifyTargets.remove(pCharacteristic->m_notifyKey);
+	if (pPrevious != nullptr) {   // A characteristic of an earlier connection that was never released.
+		pPrevious->m_notifyKey = BLERemoteCharacteristic::NOT_ROUTED;
+	}
+	m_notifyTargets.insert(pCharacteristic->m_notifyKey, pCharacteristic);
+	m_mutexNotifyTargets.unlock();
+} // addNotifyTarget
+
+
+/**
+ * @brief The key a notification is routed by.
+ * @param [in] gattc_if The interface of the client.
+ * @param [in] conn_id The connection to the server.
+ * @param [in] handle The handle of the characteristic.
+ * @return The key.
+ */
+uint64_t BLEDevice::notifyTargetKey(esp_gatt_if_t gattc_if, uint16_t conn_id, uint16_t handle) {
+	return ((uint64_t) gattc_if << 32) | ((uint32_t) conn_id << 16) | handle;
+} // notifyTargetKey
+
+
+/**
+ * @brief Stop routing notifications to a remote characteristic.
+ *
+ * If another task is handing the characteristic a notification, this waits until it has finished, so
+ * that the characteristic may be destroyed once this returns.  The characteristic's own notify callback
+ * may call this without waiting.
+ * @param [in] pCharacteristic The characteristic.
+ */
+void BLEDevice::removeNotifyTarget(BLERemoteCharacteristic* pCharacteristic) {
+	m_mutexNotifyTargets.lock();
+	if (pCharacteristic->m_notifyKey != BLERemoteCharacteristic::NOT_ROUTED) {
+		if (m_notifyTargets.find(pCharacteristic->m_notifyKey) == pCharacteristic) {
+			m_notifyTargets.remove(pCharacteristic->m_notifyKey);
+		}
+		pCharacteristic->m_notifyKey = BLERemoteCharacteristic::NOT_ROUTED;
+	}
+	// Only the one characteristic being dispatched to can be waited for, so there is at most one waiter.
+	TaskHandle_t currentTask = ::xTaskGetCurrentTaskHandle();
+	while (m_pNotifyDispatching == pCharacteristic && m_notifyDispatchTask != currentTask) {
+		::ulTaskNotifyTake(pdTRUE, 0);   // Drop a notification left over from an earlier wait.
+		m_notifyWaiter = currentTask;
+		m_mutexNotifyTargets.unlock();
+		::ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+		m_mutexNotifyTargets.lock();
+	}
+	m_mutexNotifyTargets.unlock();
+} // removeNotifyTarget
+
+
+/**
+ * @brief Stop handing GATT client events to a client.
+ *
+ * If another task is handing the client an event, this waits until it has finished, so that the client
+ * may be destroyed once this returns.
+ * @param [in] conn_id The key the client was added under.
+ * @param [in] _client True for a client.
+ */
 void BLEDevice::removePeerDevice(uint16_t conn_id, bool _client) {
 	ESP_LOGI(LOG_TAG, "remove: %d, GATT role %s", conn_id, _client?"client":"server");
-	if(m_connectedClientsMap.find(conn_id) != m_connectedClientsMap.end())
-		m_connectedClientsMap.erase(conn_id);
+	m_mutexPeerDevices.lock();
+	std::map<uint16_t, conn_status_t>::iterator it = m_connectedClientsMap.find(conn_id);
+	if (it != m_connectedClientsMap.end()) {
+		void* peer = it->second.peer_device;
+		m_connectedClientsMap.erase(it);
+		// Only the one client being dispatched to can be waited for, so there is at most one waiter.
+		TaskHandle_t currentTask = ::xTaskGetCurrentTaskHandle();
+		while (m_pGattcDispatching == peer && m_gattcDispatchTask != currentTask) {
+			::ulTaskNotifyTake(pdTRUE, 0);   // Drop a notification left over from an earlier wait.
+			m_gattcWaiter = currentTask;
+			m_mutexPeerDevices.unlock();
+			::ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+			m_mutexPeerDevices.lock();
+		}
+	}
+	m_mutexPeerDevices.unlock();
 }
 
 /* multi connect support */
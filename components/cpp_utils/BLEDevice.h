@@ -15,6 +15,7 @@
 #include <string>
 #include <esp_bt.h>
 
+#include "BLEAddressTable.h"
 #include "BLEServer.h"
 #include "BLEClient.h"
 #include "BLEUtils.h"
@@ -65,6 +66,8 @@ public:
 	static esp_ble_sec_act_t 	m_securityLevel;
 
 private:
+	friend class BLERemoteCharacteristic;
+
 	static BLEServer*	m_pServer;
 	static BLEScan*		m_pScan;
 	// static BLEClient*	m_pClient;
@@ -72,6 +75,19 @@ private:
 	static BLEAdvertising* m_bleAdvertising;
 	static esp_gatt_if_t getGattcIF();
 	static std::map<uint16_t, conn_status_t> m_connectedClientsMap;	
+	static FreeRTOS::Mutex m_mutexPeerDevices;   // Guards m_connectedClientsMap and the client being dispatched to.
+	static BLEClient*   m_pGattcDispatching;   // Being handed a GATT client event, or nullptr.
+	static TaskHandle_t m_gattcDispatchTask;   // The task handing it over.
+	static TaskHandle_t m_gattcWaiter;         // Task in removePeerDevice() waiting for it, or nullptr.
+	static BLEAddressTable<BLERemoteCharacteristic> m_notifyTargets;   // By notifyTargetKey().
+	static FreeRTOS::Mutex          m_mutexNotifyTargets;
+	static BLERemoteCharacteristic* m_pNotifyDispatching;   // Being handed a notification, or nullptr.
+	static TaskHandle_t             m_notifyDispatchTask;   // The task handing it over.
+	static TaskHandle_t             m_notifyWaiter;         // Task in removeNotifyTarget() waiting for it, or nullptr.
+
+	static void     addNotifyTarget(BLERemoteCharacteristic* pCharacteristic);
+	static uint64_t notifyTargetKey(esp_gatt_if_t gattc_if, uint16_t conn_id, uint16_t handle);
+	static void     removeNotifyTarget(BLERemoteCharacteristic* pCharacteristic);
 
 	static void gattClientEventHandler(
 		esp_gattc_cb_event_t      event,
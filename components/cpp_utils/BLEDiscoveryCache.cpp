@@ -0,0 +1,309 @@
+/*
+ * BLEDiscoveryCache.cpp
+ */
+#include "sdkconfig.h"
+#if defined(CONFIG_BT_ENABLED)
+#include <nvs.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "BLEClient.h"
+#include "BLEDiscoveryCache.h"
+#include "BLERemoteCharacteristic.h"
+#include "BLERemoteDescriptor.h"
+#include "BLERemoteService.h"
+#include "GeneralUtils.h"
+#if defined(ARDUINO_ARCH_ESP32) && defined(CONFIG_ARDUHAL_ESP_LOG)
+#include "esp32-hal-log.h"
+#define LOG_TAG ""
+#else
+#include "esp_log.h"
+static const char* LOG_TAG = "BLEDiscoveryCache";
+#endif
+
+/*
+ * Design
+ * ------
+ * Each server has one blob in the NVS namespace "ble_discovery", keyed by its address as 12 hex digits.
+ * The blob holds, in little endian:
+ *
+ *   version (1), service count (1)
+ *   for each service:        UUID, instance id (1), start handle (2), end handle (2), characteristic count (1)
+ *     for each characteristic: handle (2), properties (1), UUID, descriptor count (1)
+ *       for each descriptor:     handle (2), UUID
+ *
+ * where a UUID is its length (1) followed by that many bytes of it.  A blob that does not parse, or that
+ * was written by another version, is treated as missing.
+ */
+static const char*   NVS_NAMESPACE = "ble_discovery";
+static const uint8_t BLOB_VERSION  = 1;
+static const size_t  BLOB_RESERVE  = 256;   // Room for a server with a few services.
+
+
+/*
+ * The NVS key of a server: its address as 12 hex digits, within the 15 characters NVS allows.
+ */
+static void keyOf(BLEAddress address, char* key) {
+	esp_bd_addr_t* pAddress = address.getNative();
+	for (int i = 0; i < ESP_BD_ADDR_LEN; i++) {
+		sprintf(key + i * 2, "%02x", (*pAddress)[i]);
+	}
+} // keyOf
+
+
+static void putUint16(std::vector<uint8_t>& blob, uint16_t value) {
+	blob.push_back(value & 0xff);
+	blob.push_back(value >> 8);
+} // putUint16
+
+
+static void putUUID(std::vector<uint8_t>& blob, BLEUUID uuid) {
+	esp_bt_uuid_t* pUUID  = uuid.getNative();
+	const uint8_t* pBytes = (const uint8_t*) &pUUID->uuid;
+	blob.push_back(pUUID->len);
+	blob.insert(blob.end(), pBytes, pBytes + pUUID->len);
+} // putUUID
+
+
+/*
+ * Reads the fields of a blob in turn.  Reading past the end yields zeros and marks the reader as failed.
+ */
+class BlobReader {
+public:
+	BlobReader(const uint8_t* pBlob, size_t length) : m_p(pBlob), m_end(pBlob + length), m_ok(true) {}
+
+	bool ok() {
+		return m_ok;
+	}
+
+	uint8_t getUint8() {
+		if (m_p + 1 > m_end) {
+			m_ok = false;
+			return 0;
+		}
+		return *m_p++;
+	}
+
+	uint16_t getUint16() {
+		uint8_t low = getUint8();
+		return low | (getUint8() << 8);
+	}
+
+	esp_bt_uuid_t getUUID() {
+		esp_bt_uuid_t uuid;
+		memset(&uuid, 0, sizeof(uuid));
+		uuid.len = getUint8();
+		if ((uuid.len != ESP_UUID_LEN_16 && uuid.len != ESP_UUID_LEN_32 && uuid.len != ESP_UUID_LEN_128) || m_p + uuid.len > m_end) {
+			m_ok = false;
+			return uuid;
+		}
+		memcpy(&uuid.uuid, m_p, uuid.len);
+		m_p += uuid.len;
+		return uuid;
+	}
+
+private:
+	const uint8_t* m_p;
+	const uint8_t* m_end;
+	bool           m_ok;
+}; // BlobReader
+
+
+/**
+ * @brief Forget the attributes of every server.
+ */
+void BLEDiscoveryCache::clear() {
+	ESP_LOGD(LOG_TAG, ">> clear");
+	nvs_handle handle;
+	esp_err_t errRc = ::nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle);
+	if (errRc != ESP_OK) {
+		ESP_LOGE(LOG_TAG, "nvs_open: rc=%d %s", errRc, GeneralUtils::errorToString(errRc));
+		return;
+	}
+	errRc = ::nvs_erase_all(handle);
+	if (errRc == ESP_OK) {
+		errRc = ::nvs_commit(handle);
+	}
+	if (errRc != ESP_OK) {
+		ESP_LOGE(LOG_TAG, "nvs_erase_all: rc=%d %s", errRc, GeneralUtils::errorToString(errRc));
+	}
+	::nvs_close(handle);
+	ESP_LOGD(LOG_TAG, "<< clear");
+} // clear
+
+
+/**
+ * @brief Forget the attributes of a server.
+ * @param [in] address The address of the server.
+ */
+void BLEDiscoveryCache::erase(BLEAddress address) {
+	ESP_LOGD(LOG_TAG, ">> erase: %s", address.toString().c_str());
+	char key[ESP_BD_ADDR_LEN * 2 + 1];
+	keyOf(address, key);
+	nvs_handle handle;
+	esp_err_t errRc = ::nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle);
+	if (errRc != ESP_OK) {
+		ESP_LOGE(LOG_TAG, "nvs_open: rc=%d %s", errRc, GeneralUtils::errorToString(errRc));
+		return;
+	}
+	errRc = ::nvs_erase_key(handle, key);
+	if (errRc == ESP_OK) {
+		errRc = ::nvs_commit(handle);
+	}
+	if (errRc != ESP_OK && errRc != ESP_ERR_NVS_NOT_FOUND) {
+		ESP_LOGE(LOG_TAG, "nvs_erase_key: rc=%d %s", errRc, GeneralUtils::errorToString(errRc));
+	}
+	::nvs_close(handle);
+	ESP_LOGD(LOG_TAG, "<< erase");
+} // erase
+
+
+/**
+ * @brief Build the services of a client from what was stored for its server.
+ *
+ * The services, characteristics and descriptors the client had are released first.  If nothing usable
+ * was stored the client is left with none.
+ * @param [in] pClient The client, connected to the server.
+ * @return True if the services were built.
+ */
+bool BLEDiscoveryCache::load(BLEClient* pClient) {
+	ESP_LOGD(LOG_TAG, ">> load: %s", pClient->getPeerAddress().toString().c_str());
+	pClient->clearServices();
+
+	char key[ESP_BD_ADDR_LEN * 2 + 1];
+	keyOf(pClient->getPeerAddress(), key);
+	nvs_handle handle;
+	if (::nvs_open(NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {   // Nothing has been stored yet.
+		ESP_LOGD(LOG_TAG, "<< load: none stored");
+		return false;
+	}
+	size_t               length = 0;
+	uint8_t              smallBlob[BLOB_RESERVE];   // A typical server is read without allocating.
+	std::vector<uint8_t> largeBlob;
+	uint8_t*             pBlob = smallBlob;
+	esp_err_t errRc = ::nvs_get_blob(handle, key, nullptr, &length);
+	if (errRc == ESP_OK) {
+		if (length > sizeof(smallBlob)) {
+			largeBlob.resize(length);
+			pBlob = largeBlob.data();
+		}
+		errRc = ::nvs_get_blob(handle, key, pBlob, &length);
+	}
+	::nvs_close(handle);
+	if (errRc != ESP_OK) {
+		if (errRc != ESP_ERR_NVS_NOT_FOUND) {
+			ESP_LOGE(LOG_TAG, "nvs_get_blob: rc=%d %s", errRc, GeneralUtils::errorToString(errRc));
+		}
+		ESP_LOGD(LOG_TAG, "<< load: none stored");
+		return false;
+	}
+
+	BlobReader reader(pBlob, length);
+	if (reader.getUint8() != BLOB_VERSION) {
+		ESP_LOGD(LOG_TAG, "<< load: stored by another version");
+		return false;
+	}
+	uint8_t serviceCount = reader.getUint8();
+	for (uint8_t i = 0; i < serviceCount && reader.ok(); i++) {
+		esp_gatt_id_t srvcId;
+		srvcId.uuid    = reader.getUUID();
+		srvcId.inst_id = reader.getUint8();
+		uint16_t startHandle = reader.getUint16();
+		uint16_t endHandle   = reader.getUint16();
+		BLERemoteService* pService = new BLERemoteService(srvcId, pClient, startHandle, endHandle);
+		pClient->addService(pService);
+
+		uint8_t characteristicCount = reader.getUint8();
+		for (uint8_t j = 0; j < characteristicCount && reader.ok(); j++) {
+			uint16_t             charHandle = reader.getUint16();
+			esp_gatt_char_prop_t charProp   = reader.getUint8();
+			BLERemoteCharacteristic* pCharacteristic = new BLERemoteCharacteristic(charHandle, BLEUUID(reader.getUUID()), charProp, pService);
+			pService->addCharacteristic(pCharacteristic);
+
+			uint8_t descriptorCount = reader.getUint8();
+			for (uint8_t k = 0; k < descriptorCount && reader.ok(); k++) {
+				uint16_t descrHandle = reader.getUint16();
+				pCharacteristic->addDescriptor(new BLERemoteDescriptor(descrHandle, BLEUUID(reader.getUUID()), pCharacteristic));
+			}
+		}
+		pService->m_haveCharacteristics = true;
+	}
+	if (!reader.ok()) {
+		ESP_LOGE(LOG_TAG, "Stored attributes of %s are damaged", pClient->getPeerAddress().toString().c_str());
+		pClient->clearServices();
+		erase(pClient->getPeerAddress());
+		return false;
+	}
+	ESP_LOGD(LOG_TAG, "<< load: %d services", serviceCount);
+	return true;
+} // load
+
+
+/**
+ * @brief Store the services of a client, with their characteristics and descriptors, for its server.
+ *
+ * The characteristics of each service are retrieved if they have not been.  Nothing is written if the
+ * same was already stored, to spare the flash.
+ * @param [in] pClient The client, which has discovered the services of its server.
+ */
+void BLEDiscoveryCache::store(BLEClient* pClient) {
+	ESP_LOGD(LOG_TAG, ">> store: %s", pClient->getPeerAddress().toString().c_str());
+	std::vector<uint8_t> blob;
+	blob.reserve(BLOB_RESERVE);
+	blob.push_back(BLOB_VERSION);
+	blob.push_back(pClient->m_servicesMap.size());
+	bool fits = pClient->m_servicesMap.size() <= UINT8_MAX;   // Each count is held in a byte.
+	for (auto& servicePair : pClient->m_servicesMap) {
+		BLERemoteService* pService = servicePair.second;
+		std::map<uint16_t, BLERemoteCharacteristic*>* pCharacteristics = pService->getCharacteristicsByHandle();
+		putUUID(blob, BLEUUID(pService->getSrvcId()->uuid));
+		blob.push_back(pService->getSrvcId()->inst_id);
+		putUint16(blob, pService->getStartHandle());
+		putUint16(blob, pService->getEndHandle());
+		blob.push_back(pCharacteristics->size());
+		fits = fits && pCharacteristics->size() <= UINT8_MAX;
+		for (auto& characteristicPair : *pCharacteristics) {
+			BLERemoteCharacteristic* pCharacteristic = characteristicPair.second;
+			putUint16(blob, pCharacteristic->getHandle());
+			blob.push_back(pCharacteristic->m_charProp);
+			putUUID(blob, pCharacteristic->getUUID());
+			blob.push_back(pCharacteristic->getDescriptors()->size());
+			fits = fits && pCharacteristic->getDescriptors()->size() <= UINT8_MAX;
+			for (auto& descriptorPair : *pCharacteristic->getDescriptors()) {
+				putUint16(blob, descriptorPair.second->getHandle());
+				putUUID(blob, descriptorPair.second->getUUID());
+			}
+		}
+	}
+	if (!fits) {
+		ESP_LOGW(LOG_TAG, "<< store: too many attributes to store");
+		return;
+	}
+
+	char key[ESP_BD_ADDR_LEN * 2 + 1];
+	keyOf(pClient->getPeerAddress(), key);
+	nvs_handle handle;
+	esp_err_t errRc = ::nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle);
+	if (errRc != ESP_OK) {
+		ESP_LOGE(LOG_TAG, "nvs_open: rc=%d %s", errRc, GeneralUtils::errorToString(errRc));
+		return;
+	}
+	std::vector<uint8_t> stored(blob.size());
+	size_t length = stored.size();
+	if (::nvs_get_blob(handle, key, stored.data(), &length) == ESP_OK && length == blob.size() && stored == blob) {
+		::nvs_close(handle);
+		ESP_LOGD(LOG_TAG, "<< store: unchanged");
+		return;
+	}
+	errRc = ::nvs_set_blob(handle, key, blob.data(), blob.size());
+	if (errRc == ESP_OK) {
+		errRc = ::nvs_commit(handle);
+	}
+	if (errRc != ESP_OK) {
+		ESP_LOGE(LOG_TAG, "nvs_set_blob: rc=%d %s", errRc, GeneralUtils::errorToString(errRc));
+	}
+	::nvs_close(handle);
+	ESP_LOGD(LOG_TAG, "<< store: %u bytes", (unsigned) blob.size());
+} // store
+
+#endif /* CONFIG_BT_ENABLED */
@@ -0,0 +1,41 @@
+/*
+ * BLEDiscoveryCache.h
+ */
+
+#ifndef COMPONENTS_CPP_UTILS_BLEDISCOVERYCACHE_H_
+#define COMPONENTS_CPP_UTILS_BLEDISCOVERYCACHE_H_
+#include "sdkconfig.h"
+#if defined(CONFIG_BT_ENABLED)
+#include "BLEAddress.h"
+
+class BLEClient;
+
+/**
+ * @brief The attributes of known servers, kept in NVS across connections and restarts.
+ *
+ * Discovering the services, characteristics and descriptors of a server takes an exchange with it for
+ * each, which over a connection adds up to hundreds of milliseconds.  When CONFIG_BLE_GATTC_DISCOVERY_CACHE
+ * is set a BLEClient stores the handles and UUIDs it discovered under the address of the server.  The next
+ * time it connects to that address BLEClient::getServices() builds the services, characteristics and
+ * descriptors from what was stored without asking the server, so they can be used as soon as the
+ * connection is open.
+ *
+ * A server that changes its attributes tells its bonded clients with a Service Changed indication, upon
+ * which its entry is dropped and the next getServices() asks it again.  A server that is not bonded cannot
+ * tell; its entry is dropped when it refuses a request as being for an invalid handle.  Call erase() for a
+ * server whose firmware has been updated, or clear(), to have it discovered afresh.
+ */
+class BLEDiscoveryCache {
+public:
+	static void clear();
+	static void erase(BLEAddress address);
+
+private:
+	friend class BLEClient;
+
+	static bool load(BLEClient* pClient);
+	static void store(BLEClient* pClient);
+}; // BLEDiscoveryCache
+
+#endif /* CONFIG_BT_ENABLED */
+#endif /* COMPONENTS_CPP_UTILS_BLEDISCOVERYCACHE_H_ */
@@ -0,0 +1,107 @@
+/*
+ * BLEEventRing.cpp
+ */
+#include "sdkconfig.h"
+#if defined(CONFIG_BT_ENABLED)
+#include <string.h>
+#include "BLEEventRing.h"
+
+// The head and tail are free running counters that wrap at 2^32.  A slot index taken from them
+// only stays continuous across that wrap when the ring size divides 2^32.
+static_assert((CONFIG_BLE_EVENT_RING_SIZE & (CONFIG_BLE_EVENT_RING_SIZE - 1)) == 0,
+	"CONFIG_BLE_EVENT_RING_SIZE must be a power of two");
+static const uint32_t RING_MASK = CONFIG_BLE_EVENT_RING_SIZE - 1;
+
+/**
+ * @brief Construct an empty event ring.
+ */
+BLEEventRing::BLEEventRing() {
+	m_head     = 0;
+	m_tail     = 0;
+	m_consumer = nullptr;
+	m_dropped  = 0;
+} // BLEEventRing
+
+
+/**
+ * @brief Get the number of events dropped because the ring was full.
+ * @return The number of dropped events.
+ */
+uint32_t BLEEventRing::getDropped() {
+	return m_dropped.load(std::memory_order_relaxed);
+} // getDropped
+
+
+/**
+ * @brief Take the oldest event from the ring.  Called from the consumer task only.
+ * @param [out] pEvent The event.
+ * @return True if an event was returned, false if the ring was empty.
+ */
+bool BLEEventRing::pop(ble_event_t* pEvent) {
+	uint32_t tail = m_tail.load(std::memory_order_relaxed);
+	if (tail == m_head.load(std::memory_order_acquire)) return false;
+
+	ble_event_t* pSlot = &m_slots[tail & RING_MASK];
+	pEvent->type            = pSlot->type;
+	pEvent->connId          = pSlot->connId;
+	pEvent->pCharacteristic = pSlot->pCharacteristic;
+	pEvent->length          = pSlot->length;
+	pEvent->truncated       = pSlot->truncated;
+	memcpy(pEvent->data, pSlot->data, pSlot->length);
+	m_tail.store(tail + 1, std::memory_order_release);  // Hand the slot back to the producer.
+	return true;
+} // pop
+
+
+/**
+ * @brief Add an event to the ring and wake the consumer.  Called from the producer task only; never blocks.
+ * @param [in] type The application defined event type.
+ * @param [in] connId The connection the event belongs to.
+ * @param [in] pCharacteristic The characteristic concerned, if any.
+ * @param [in] pData Data to copy into the event, if any.
+ * @param [in] length The length of the data.
+ * @return True if the event was added, false if the ring was full and the event was dropped.
+ */
+bool BLEEventRing::push(uint8_t type, uint16_t connId, BLECharacteristic* pCharacteristic, const uint8_t* pData, size_t length) {
+	uint32_t head = m_head.load(std::memory_order_relaxed);
+	if (head - m_tail.load(std::memory_order_acquire) == CONFIG_BLE_EVENT_RING_SIZE) {
+		m_dropped.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	ble_event_t* pSlot = &m_slots[head & RING_MASK];
+	pSlot->type            = type;
+	pSlot->connId          = connId;
+	pSlot->pCharacteristic = pCharacteristic;
+	pSlot->truncated       = length > CONFIG_BLE_EVENT_RING_DATA_SIZE;
+	pSlot->length          = pSlot->truncated ? CONFIG_BLE_EVENT_RING_DATA_SIZE : length;
+	if (pSlot->length > 0) {
+		memcpy(pSlot->data, pData, pSlot->length);
+	}
+	m_head.store(head + 1, std::memory_order_release);  // Publish the slot to the consumer.
+
+	TaskHandle_t consumer = m_consumer.load(std::memory_order_acquire);
+	if (consumer != nullptr) {
+		::xTaskNotifyGive(consumer);
+	}
+	return true;
+} // push
+
+
+/**
+ * @brief Block the calling task until the ring holds an event.  Called from the consumer task only.
+ * @param [in] ticksToWait The maximum time to wait.
+ * @return True if there is an event to pop, false on timeout.
+ */
+bool BLEEventRing::wait(TickType_t ticksToWait) {
+	// Register before looking at the ring so a push in between still notifies us.
+	m_consumer.store(::xTaskGetCurrentTaskHandle(), std::memory_order_release);
+	while (m_tail.load(std::memory_order_relaxed) == m_head.load(std::memory_order_acquire)) {
+		if (::ulTaskNotifyTake(pdTRUE, ticksToWait) == 0) {
+			return m_tail.load(std::memory_order_relaxed) != m_head.load(std::memory_order_acquire);
+		}
+	}
+	return true;
+} // wait
+
+#endif /* CONFIG_BT_ENABLED */
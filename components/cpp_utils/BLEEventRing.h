@@ -0,0 +1,66 @@
+/*
+ * BLEEventRing.h
+ */
+
+#ifndef COMPONENTS_CPP_UTILS_BLEEVENTRING_H_
+#define COMPONENTS_CPP_UTILS_BLEEVENTRING_H_
+#include "sdkconfig.h"
+#if defined(CONFIG_BT_ENABLED)
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#ifndef CONFIG_BLE_EVENT_RING_SIZE
+#define CONFIG_BLE_EVENT_RING_SIZE 16
+#endif
+#ifndef CONFIG_BLE_EVENT_RING_DATA_SIZE
+#define CONFIG_BLE_EVENT_RING_DATA_SIZE 32
+#endif
+
+class BLECharacteristic;
+
+/**
+ * @brief An event handed from the BLE stack to the application.
+ */
+typedef struct {
+	uint8_t            type;             // Application defined.
+	uint16_t           connId;
+	BLECharacteristic* pCharacteristic;  // The characteristic concerned, if any.
+	uint16_t           length;           // Number of valid bytes in data.
+	bool               truncated;        // The data did not fit and was cut to CONFIG_BLE_EVENT_RING_DATA_SIZE.
+	uint8_t            data[CONFIG_BLE_EVENT_RING_DATA_SIZE];
+} ble_event_t;
+
+
+/**
+ * @brief A lock-free single producer, single consumer ring of BLE events.
+ *
+ * Callbacks such as BLECharacteristicCallbacks::onWrite() and BLEServerCallbacks::onConnect() run in
+ * the Bluedroid task; anything slow done there holds up every other connection.  Instead the callback
+ * copies what it needs into the ring with push(), which never blocks, and returns.  An application task
+ * loops on wait() and pop() and does the real work.
+ *
+ * The producer is the Bluedroid task and the consumer is the one task that calls wait()/pop().  All the
+ * storage is fixed in the object.  When the ring is full the new event is dropped and counted.
+ */
+class BLEEventRing {
+public:
+	BLEEventRing();
+
+	uint32_t getDropped();
+	bool     pop(ble_event_t* pEvent);
+	bool     push(uint8_t type, uint16_t connId, BLECharacteristic* pCharacteristic = nullptr, const uint8_t* pData = nullptr, size_t length = 0);
+	bool     wait(TickType_t ticksToWait = portMAX_DELAY);
+
+private:
+	ble_event_t                m_slots[CONFIG_BLE_EVENT_RING_SIZE];
+	std::atomic<uint32_t>      m_head;      // Written only by the producer.
+	std::atomic<uint32_t>      m_tail;      // Written only by the consumer.
+	std::atomic<TaskHandle_t>  m_consumer;  // The task to wake when an event is pushed.
+	std::atomic<uint32_t>      m_dropped;
+}; // BLEEventRing
+
+#endif /* CONFIG_BT_ENABLED */
+#endif /* COMPONENTS_CPP_UTILS_BLEEVENTRING_H_ */
@@ -0,0 +1,328 @@
+/*
+ * BLENotifyQueue.cpp
+ */
+#include "sdkconfig.h"
+#if defined(CONFIG_BT_ENABLED)
+#include <sstream>
+#include <string.h>
+#include "BLENotifyQueue.h"
+#if defined(ARDUINO_ARCH_ESP32) && defined(CONFIG_ARDUHAL_ESP_LOG)
+#include "esp32-hal-log.h"
+#define LOG_TAG ""
+#else
+#include "esp_log.h"
+static const char* LOG_TAG = "BLENotifyQueue";
+#endif
+
+
+/**
+ * @brief Construct a notification queue.
+ * @param [in] capacity The maximum number of values that may be waiting at any one time.
+ */
+BLENotifyQueue::BLENotifyQueue(size_t capacity) {
+	if (capacity == 0) capacity = 1;
+	m_entries.resize(capacity);
+	m_count          = 0;
+	m_draining       = false;
+	m_notifyInFlight = 0;
+	m_pIndicating    = nullptr;
+	m_mtu            = 23;
+	memset(&m_stats, 0, sizeof(m_stats));
+} // BLENotifyQueue
+
+
+/**
+ * @brief Remove the entry at the given position, keeping the order of the others.
+ * The storage of the removed entry is moved to the end so that it can be reused.
+ * @param [in] index The position of the entry to remove.
+ */
+void BLENotifyQueue::erase(size_t index) {
+	for (size_t i = index; i + 1 < m_count; i++) {
+		std::swap(m_entries[i], m_entries[i + 1]);
+	}
+	m_count--;
+} // erase
+
+
+/**
+ * @brief Get a copy of the queue counters.
+ * @return The queue counters.
+ */
+notify_queue_stats_t BLENotifyQueue::getStats() {
+	m_stats.depth = m_count;
+	return m_stats;
+} // getStats
+
+
+/**
+ * @brief Is the link this queue feeds currently congested?
+ * @return True if sending is paused.
+ */
+bool BLENotifyQueue::isCongested() {
+	return m_stats.congested;
+} // isCongested
+
+
+/**
+ * @brief Is the queue empty?
+ * @return True if there is nothing waiting to be sent.
+ */
+bool BLENotifyQueue::isEmpty() {
+	return m_count == 0;
+} // isEmpty
+
+
+/**
+ * @brief Remove the oldest entry from the queue.
+ * @param [out] pEntry The entry.  The value storage is exchanged with the queue slot so no copy is made.
+ * @return True if an entry was removed, false if the queue was empty.
+ */
+bool BLENotifyQueue::pop(entry_t* pEntry) {
+	if (m_count == 0) return false;
+	std::swap(*pEntry, m_entries[0]);
+	erase(0);
+	return true;
+} // pop
+
+
+/**
+ * @brief Append to a popped record entry the records that follow it for the same characteristic.
+ *
+ * Records are appended for as long as they fit in one notification.  Records are not taken past a plain
+ * value for the same characteristic so that the order seen by the client is kept.
+ *
+ * @param [in,out] pEntry A record entry just returned by pop().
+ */
+void BLENotifyQueue::popRecords(entry_t* pEntry) {
+	size_t room = m_mtu - 3;
+	size_t i = 0;
+	while (i < m_count && pEntry->value.length() < room) {
+		entry_t& entry = m_entries[i];
+		if (entry.handle != pEntry->handle) {
+			i++;
+			continue;
+		}
+		if (!entry.isRecord || pEntry->value.length() + entry.value.length() > room) break;
+		pEntry->value.append(entry.value);
+		erase(i);
+	}
+} // popRecords
+
+
+/**
+ * @brief Make room for a new entry at the end of the queue.
+ *
+ * If the queue is full the oldest notification or record is discarded.
+ *
+ * @return The slot for the new entry, or nullptr if the queue is full of indications.
+ */
+BLENotifyQueue::entry_t* BLENotifyQueue::reserve() {
+	if (m_count == m_entries.size()) {
+		size_t i = 0;
+		while (i < m_count && m_entries[i].needConfirm) i++;
+		if (i == m_count) {
+			m_stats.dropped++;
+			return nullptr;
+		}
+		ESP_LOGW(LOG_TAG, "Queue full; dropping oldest notification for handle 0x%.2x", m_entries[i].handle);
+		erase(i);
+		m_stats.dropped++;
+	}
+	entry_t* pEntry = &m_entries[m_count++];
+	if (m_count > m_stats.maxDepth) m_stats.maxDepth = m_count;
+	return pEntry;
+} // reserve
+
+
+/**
+ * @brief Queue a value for sending.
+ *
+ * If a value of the same kind for the same handle is already waiting it is replaced.  If the queue is
+ * full the oldest notification is discarded to make room.
+ *
+ * @param [in] pCharacteristic The characteristic the value belongs to.
+ * @param [in] handle The characteristic handle.
+ * @param [in] pData The value to send.
+ * @param [in] length The length of the value.
+ * @param [in] needConfirm True for an indication, false for a notification.
+ * @return Whether the value was queued, replaced a waiting value or was rejected.
+ */
+BLENotifyQueue::push_result_t BLENotifyQueue::push(BLECharacteristic* pCharacteristic, uint16_t handle, const uint8_t* pData, size_t length, bool needConfirm) {
+	for (size_t i = 0; i < m_count; i++) {
+		entry_t& entry = m_entries[i];
+		if (entry.handle == handle && !entry.isRecord && entry.needConfirm == needConfirm) {
+			entry.value.assign((const char*) pData, length);
+			m_stats.coalesced++;
+			return COALESCED;
+		}
+	}
+
+	entry_t* pEntry = reserve();
+	if (pEntry == nullptr) {
+		ESP_LOGW(LOG_TAG, "Queue full of indications; rejecting value for handle 0x%.2x", handle);
+		return REJECTED;
+	}
+	pEntry->pCharacteristic = pCharacteristic;
+	pEntry->handle          = handle;
+	pEntry->needConfirm     = needConfirm;
+	pEntry->isRecord        = false;
+	pEntry->isState         = false;
+	pEntry->recordType      = 0;
+	pEntry->value.assign((const char*) pData, length);
+	return QUEUED;
+} // push
+
+
+/**
+ * @brief Give back the value storage of an entry that has been sent.
+ * The storage is kept in a free slot so that a later push() can fill it without allocating.
+ * @param [in,out] pEntry An entry returned by pop() whose value is no longer needed.
+ */
+void BLENotifyQueue::recycle(entry_t* pEntry) {
+	if (m_count < m_entries.size()) {
+		m_entries[m_count].value.swap(pEntry->value);
+	}
+} // recycle
+
+
+/**
+ * @brief Queue a record for sending.
+ *
+ * A state record replaces a state record of the same type still waiting for the same handle.  An event
+ * record is appended to the event records waiting at the end of the queue for the same handle if they
+ * would still fit in one notification, and otherwise takes an entry of its own.
+ *
+ * @param [in] pCharacteristic The characteristic the record belongs to.
+ * @param [in] handle The characteristic handle.
+ * @param [in] type The record type.
+ * @param [in] pData The record data.
+ * @param [in] length The length of the record data.
+ * @param [in] isState True if only the latest record of this type matters.
+ * @return Whether the record was queued, replaced a waiting record or was rejected.
+ */
+BLENotifyQueue::push_result_t BLENotifyQueue::pushRecord(BLECharacteristic* pCharacteristic, uint16_t handle, uint8_t type, const uint8_t* pData, uint8_t length, bool isState) {
+	if (isState) {
+		for (size_t i = 0; i < m_count; i++) {
+			entry_t& entry = m_entries[i];
+			if (entry.handle == handle && entry.isRecord && entry.isState && entry.recordType == type) {
+				entry.value.resize(RECORD_HEADER_SIZE);
+				entry.value.append((const char*)pData, length);
+				entry.value[1] = (char)length;
+				m_stats.coalesced++;
+				return COALESCED;
+			}
+		}
+	} else {
+		// Only the newest entry for the handle may be appended to, so that the order is kept.
+		for (size_t i = m_count; i > 0; i--) {
+			entry_t& entry = m_entries[i - 1];
+			if (entry.handle != handle) continue;
+			if (entry.isRecord && !entry.isState && entry.value.length() + RECORD_HEADER_SIZE + length <= (size_t)(m_mtu - 3)) {
+				entry.value.push_back((char)type);
+				entry.value.push_back((char)length);
+				entry.value.append((const char*)pData, length);
+				return QUEUED;
+			}
+			break;
+		}
+	}
+
+	entry_t* pEntry = reserve();
+	if (pEntry == nullptr) {
+		ESP_LOGW(LOG_TAG, "Queue full of indications; rejecting record for handle 0x%.2x", handle);
+		return REJECTED;
+	}
+	pEntry->pCharacteristic = pCharacteristic;
+	pEntry->handle          = handle;
+	pEntry->needConfirm     = false;
+	pEntry->isRecord        = true;
+	pEntry->isState         = isState;
+	pEntry->recordType      = type;
+	pEntry->value.resize(RECORD_HEADER_SIZE);
+	pEntry->value[0] = (char)type;
+	pEntry->value[1] = (char)length;
+	pEntry->value.append((const char*)pData, length);
+	return QUEUED;
+} // pushRecord
+
+
+/**
+ * @brief Put back an entry that could not be sent so that it is the next one out.
+ *
+ * A notification is discarded instead if a newer value for the same handle has been queued in the
+ * meantime or if the queue is full.  Records are only discarded if the queue is full.  An indication
+ * displaces the newest notification if the queue is full, and is itself discarded if the queue has filled
+ * with indications; the queue never grows past its capacity.
+ *
+ * @param [in] pEntry The entry that could not be sent.  Its value storage is exchanged with the queue slot.
+ * @return True if the entry was put back or replaced by a newer value, false if it was discarded.
+ */
+bool BLENotifyQueue::pushFront(entry_t* pEntry) {
+	if (!pEntry->needConfirm) {
+		for (size_t i = 0; i < m_count && !pEntry->isRecord; i++) {
+			if (m_entries[i].handle == pEntry->handle && !m_entries[i].needConfirm && !m_entries[i].isRecord) {
+				m_stats.coalesced++;
+				return true;
+			}
+		}
+		if (m_count == m_entries.size()) {
+			m_stats.dropped++;
+			return false;
+		}
+	} else if (m_count == m_entries.size()) {
+		size_t i = m_count;
+		while (i > 0 && m_entries[i - 1].needConfirm) i--;
+		if (i == 0) {
+			ESP_LOGW(LOG_TAG, "Queue full of indications; dropping indication for handle 0x%.2x", pEntry->handle);
+			m_stats.dropped++;
+			return false;
+		}
+		erase(i - 1);
+		m_stats.dropped++;
+	}
+
+	std::swap(m_entries[m_count], *pEntry);
+	for (size_t i = m_count; i > 0; i--) {
+		std::swap(m_entries[i], m_entries[i - 1]);
+	}
+	m_count++;
+	if (m_count > m_stats.maxDepth) m_stats.maxDepth = m_count;
+	return true;
+} // pushFront
+
+
+/**
+ * @brief Pause or resume sending.
+ * @param [in] congested True to pause sending, false to resume.
+ */
+void BLENotifyQueue::setCongested(bool congested) {
+	m_stats.congested = congested;
+} // setCongested
+
+
+/**
+ * @brief Set the MTU negotiated with the client, which bounds how many records go in one notification.
+ * @param [in] mtu The MTU.
+ */
+void BLENotifyQueue::setMTU(uint16_t mtu) {
+	m_mtu = mtu;
+} // setMTU
+
+
+/**
+ * @brief Return a string representation of the queue counters.
+ * @return A string representation of the queue counters.
+ */
+std::string BLENotifyQueue::toString() {
+	std::stringstream ss;
+	ss << "depth: " << m_count << "/" << m_entries.size() <<
+		", maxDepth: " << m_stats.maxDepth <<
+		", sent: " << m_stats.sent <<
+		", coalesced: " << m_stats.coalesced <<
+		", dropped: " << m_stats.dropped <<
+		", congested: " << (m_stats.congested ? "yes" : "no") <<
+		", indicating: " << (m_pIndicating != nullptr ? "yes" : "no");
+	return ss.str();
+} // toString
+
+#endif /* CONFIG_BT_ENABLED */
@@ -0,0 +1,107 @@
+/*
+ * BLENotifyQueue.h
+ */
+
+#ifndef COMPONENTS_CPP_UTILS_BLENOTIFYQUEUE_H_
+#define COMPONENTS_CPP_UTILS_BLENOTIFYQUEUE_H_
+#include "sdkconfig.h"
+#if defined(CONFIG_BT_ENABLED)
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#ifndef CONFIG_BLE_NOTIFY_QUEUE_SIZE
+#define CONFIG_BLE_NOTIFY_QUEUE_SIZE 8
+#endif
+
+class BLECharacteristic;
+
+/**
+ * @brief Counters describing the state of one outbound notification queue.
+ */
+typedef struct {
+	uint16_t depth;      // Number of values currently waiting to be sent.
+	uint16_t maxDepth;   // High water mark of depth since the connection was opened.
+	uint32_t sent;       // Number of values handed to the stack.
+	uint32_t coalesced;  // Number of values replaced by a newer value for the same handle before being sent.
+	uint32_t dropped;    // Number of values discarded because the queue was full.
+	bool     congested;  // True while the link reports congestion and sending is paused.
+} notify_queue_stats_t;
+
+
+/**
+ * @brief A bounded queue of notifications and indications waiting to be sent to one connected client.
+ *
+ * Each connection owns one of these.  A value queued for a characteristic handle that already has a
+ * value of the same kind waiting replaces the older value in place, so a slow or congested link only
+ * ever sees the latest state of each characteristic.  When the queue is full the oldest notification is
+ * discarded; a new indication is rejected if there is none to discard.  All the storage is allocated when
+ * the queue is constructed and the queue never grows.
+ *
+ * A characteristic may also send records: small typed payloads that the queue packs, several to a
+ * notification, up to the MTU negotiated with the client.  Each record is framed as
+ *
+ *   [type: 1 byte][length: 1 byte][length bytes of data]
+ *
+ * so the client can walk a notification and split it back into records.  A state record, such as a
+ * position, replaces one still waiting for the same characteristic with the same type.  Any other record
+ * is an event, such as a call being made, and is always delivered; it is appended to the records already
+ * waiting for the characteristic while they fit in one notification.
+ *
+ * The queue does no locking of its own; the owning BLEServer serializes access to it.
+ */
+class BLENotifyQueue {
+public:
+	/**
+	 * @brief The outcome of queueing a value.
+	 */
+	typedef enum {
+		QUEUED,     // The value was added to the queue.
+		COALESCED,  // The value, or state record, replaced one for the same handle that was still waiting.
+		REJECTED    // The queue is full of indications and the value was not queued.
+	} push_result_t;
+
+	typedef struct {
+		BLECharacteristic* pCharacteristic;
+		uint16_t           handle;
+		bool               needConfirm;
+		bool               isRecord;     // The value is one or more framed records.
+		bool               isState;      // The value is a single state record, replaced by a newer one.
+		uint8_t            recordType;   // Type of the (first) record when isRecord is set.
+		std::string        value;
+	} entry_t;
+
+	static const size_t RECORD_HEADER_SIZE = 2;
+
+	BLENotifyQueue(size_t capacity = CONFIG_BLE_NOTIFY_QUEUE_SIZE);
+
+	bool                 isCongested();
+	bool                 isEmpty();
+	bool                 pop(entry_t* pEntry);
+	void                 popRecords(entry_t* pEntry);
+	push_result_t        push(BLECharacteristic* pCharacteristic, uint16_t handle, const uint8_t* pData, size_t length, bool needConfirm);
+	bool                 pushFront(entry_t* pEntry);
+	push_result_t        pushRecord(BLECharacteristic* pCharacteristic, uint16_t handle, uint8_t type, const uint8_t* pData, uint8_t length, bool isState);
+	void                 recycle(entry_t* pEntry);
+	void                 setCongested(bool congested);
+	void                 setMTU(uint16_t mtu);
+	notify_queue_stats_t getStats();
+	std::string          toString();
+
+private:
+	friend class BLEServer;
+
+	void                 erase(size_t index);
+	entry_t*             reserve();
+
+	std::vector<entry_t> m_entries;
+	size_t               m_count;
+	bool                 m_draining;
+	uint16_t             m_notifyInFlight;  // Notifications sent whose ESP_GATTS_CONF_EVT has not yet arrived.
+	BLECharacteristic*   m_pIndicating;     // Characteristic whose indication awaits confirmation, if any.
+	uint16_t             m_mtu;
+	notify_queue_stats_t m_stats;
+}; // BLENotifyQueue
+
+#endif /* CONFIG_BT_ENABLED */
+#endif /* COMPONENTS_CPP_UTILS_BLENOTIFYQUEUE_H_ */
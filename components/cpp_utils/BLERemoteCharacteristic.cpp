@@ -14,6 +14,7 @@
 #include <esp_err.h>
 
 #include <sstream>
+#include "BLEDevice.h"
 #include "BLEExceptions.h"
 #include "BLEUtils.h"
 #include "GeneralUtils.h"
@@ -46,8 +47,7 @@ BLERemoteCharacteristic::BLERemoteCharacteristic(
 	m_charProp       = charProp;
 	m_pRemoteService = pRemoteService;
 	m_notifyCallback = nullptr;
-
-	retrieveDescriptors(); // Get the descriptors for this characteristic
+	m_notifyKey      = NOT_ROUTED;
 	ESP_LOGD(LOG_TAG, "<< BLERemoteCharacteristic");
 } // BLERemoteCharacteristic
 
@@ -56,6 +56,7 @@ BLERemoteCharacteristic::BLERemoteCharacteristic(
  *@brief Destructor.
  */
 BLERemoteCharacteristic::~BLERemoteCharacteristic() {
+	BLEDevice::removeNotifyTarget(this);
 	removeDescriptors();   // Release resources for any descriptor information we may have allocated.
 	if(m_rawData != nullptr) free(m_rawData);	
 } // ~BLERemoteCharacteristic
@@ -186,8 +187,8 @@ void BLERemoteCharacteristic::gattClientEventHandler(esp_gattc_cb_event_t event,
 			// If this event is not for us, then nothing further to do.
 			if (evtParam->read.handle != getHandle()) break;
 
-			// At this point, we have determined that the event is for us, so now we save the value
-			// and unlock the semaphore to ensure that the requestor of the data can continue.
+			// At this point, we have determined that the event is for us, so now we save the value.
+			// The client then completes the operation that asked for it.
 			if (evtParam->read.status == ESP_GATT_OK) {
 				m_value = std::string((char*) evtParam->read.value, evtParam->read.value_len);
 				if(m_rawData != nullptr) free(m_rawData);
@@ -196,8 +197,6 @@ void BLERemoteCharacteristic::gattClientEventHandler(esp_gattc_cb_event_t event,
 			} else {
 				m_value = "";
 			}
-
-			m_semaphoreReadCharEvt.give();
 			break;
 		} // ESP_GATTC_READ_CHAR_EVT
 
@@ -233,16 +232,10 @@ void BLERemoteCharacteristic::gattClientEventHandler(esp_gattc_cb_event_t event,
 		// - esp_gatt_status_t status
 		// - uint16_t          conn_id
 		// - uint16_t          handle
-		case ESP_GATTC_WRITE_CHAR_EVT: {
-			// Determine if this event is for us and, if not, pass onwards.
-			if (evtParam->write.handle != getHandle()) break;
-
-			// There is nothing further we need to do here.  This is merely an indication
-			// that the write has completed and we can unlock the caller.
-			m_semaphoreWriteCharEvt.give();
-			break;
-		} // ESP_GATTC_WRITE_CHAR_EVT
-
+		// ESP_GATTC_WRITE_CHAR_EVT
+		//
+		// There is nothing we need to do here.  This is merely an indication that the write has completed,
+		// and the client completes the operation that asked for it.
 
 		default:
 			break;
@@ -250,6 +243,15 @@ void BLERemoteCharacteristic::gattClientEventHandler(esp_gattc_cb_event_t event,
 }; // gattClientEventHandler
 
 
+/**
+ * @brief Add a descriptor that has been retrieved, or built from the discovery cache.
+ * @param [in] pDescriptor The descriptor.
+ */
+void BLERemoteCharacteristic::addDescriptor(BLERemoteDescriptor* pDescriptor) {
+	m_descriptorMap.insert(std::pair<std::string, BLERemoteDescriptor*>(pDescriptor->getUUID().toString(), pDescriptor));
+} // addDescriptor
+
+
 /**
  * @brief Populate the descriptors (if any) for this characteristic.
  */
@@ -278,7 +280,7 @@ void BLERemoteCharacteristic::retrieveDescriptors() {
 		}
 
 		if (status != ESP_GATT_OK) {
-			ESP_LOGE(LOG_TAG, "esp_ble_gattc_get_all_descr: %s", BLEUtils::gattStatusToString(status).c_str());
+			ESP_LOGE(LOG_TAG, "esp_ble_gattc_get_all_descr: %s", BLEUtils::gattStatusToString(status));
 			break;
 		}
 
@@ -293,7 +295,7 @@ void BLERemoteCharacteristic::retrieveDescriptors() {
 			this
 		);
 
-		m_descriptorMap.insert(std::pair<std::string, BLERemoteDescriptor*>(pNewRemoteDescriptor->getUUID().toString(), pNewRemoteDescriptor));
+		addDescriptor(pNewRemoteDescriptor);
 
 		offset++;
 	} // while true
@@ -328,9 +330,8 @@ uint16_t BLERemoteCharacteristic::getHandle() {
  */
 BLERemoteDescriptor* BLERemoteCharacteristic::getDescriptor(BLEUUID uuid) {
 	ESP_LOGD(LOG_TAG, ">> getDescriptor: uuid: %s", uuid.toString().c_str());
-	std::string v = uuid.toString();
 	for (auto &myPair : m_descriptorMap) {
-		if (myPair.first == v) {
+		if (myPair.second->getUUID().equals(uuid)) {
 			ESP_LOGD(LOG_TAG, "<< getDescriptor: found");
 			return myPair.second;
 		}
@@ -399,6 +400,9 @@ uint8_t BLERemoteCharacteristic::readUInt8() {
 
 /**
  * @brief Read the value of the remote characteristic.
+ *
+ * Blocking reads and writes of the characteristic take turns and share one operation, so that nothing is
+ * allocated for them once the first has been made.
  * @return The value of the remote characteristic.
  */
 std::string BLERemoteCharacteristic::readValue() {
@@ -410,31 +414,39 @@ std::string BLERemoteCharacteristic::readValue() {
 		throw BLEDisconnectedException();
 	}
 
-	m_semaphoreReadCharEvt.take("readValue");
-
-	// Ask the BLE subsystem to retrieve the value for the remote hosted characteristic.
-	// This is an asynchronous request which means that we must block waiting for the response
-	// to become available.
-	esp_err_t errRc = ::esp_ble_gattc_read_char(
-		m_pRemoteService->getClient()->getGattcIf(),
-		m_pRemoteService->getClient()->getConnId(),    // The connection ID to the BLE server
-		getHandle(),                                   // The handle of this characteristic
-		ESP_GATT_AUTH_REQ_NONE);                       // Security
-
-	if (errRc != ESP_OK) {
-		ESP_LOGE(LOG_TAG, "esp_ble_gattc_read_char: rc=%d %s", errRc, GeneralUtils::errorToString(errRc));
-		return "";
+	// Block waiting for the read to complete.  The value is empty if it failed.
+	m_semaphoreBlockingOp.take("readValue");
+	if (m_pBlockingOperation) {
+		m_pBlockingOperation->restart(BLERemoteOperation::READ);
+	} else {
+		m_pBlockingOperation.reset(new BLERemoteOperation(BLERemoteOperation::READ, getRemoteService()->getClient(), nullptr));
 	}
+	startRead(m_pBlockingOperation);
+	m_pBlockingOperation->wait();
+	std::string value = m_pBlockingOperation->m_value;
+	m_semaphoreBlockingOp.give();
 
-	// Block waiting for the event that indicates that the read has completed.  When it has, the std::string found
-	// in m_value will contain our data.
-	m_semaphoreReadCharEvt.wait("readValue");
-
-	ESP_LOGD(LOG_TAG, "<< readValue(): length: %d", m_value.length());
-	return m_value;
+	ESP_LOGD(LOG_TAG, "<< readValue(): length: %d", value.length());
+	return value;
 } // readValue
 
 
+/**
+ * @brief Read the value of the remote characteristic without waiting for it.
+ *
+ * Reads of any number of characteristics, on this connection and others, may be outstanding at once.
+ * @param [in] callback Invoked when the read completes, or nullptr.
+ * @return The operation, whose getValue() holds the value once it completes with ESP_GATT_OK.
+ */
+std::shared_ptr<BLERemoteOperation> BLERemoteCharacteristic::readValueAsync(remote_operation_callback callback) {
+	ESP_LOGD(LOG_TAG, ">> readValueAsync(): handle: %d 0x%.2x", getHandle(), getHandle());
+	std::shared_ptr<BLERemoteOperation> pOperation(new BLERemoteOperation(BLERemoteOperation::READ, getRemoteService()->getClient(), callback));
+	startRead(pOperation);
+	ESP_LOGD(LOG_TAG, "<< readValueAsync()");
+	return pOperation;
+} // readValueAsync
+
+
 /**
  * @brief Register for notifications.
  * @param [in] notifyCallback A callback to be invoked for a notification.  If NULL is provided then we are
@@ -449,6 +461,7 @@ void BLERemoteCharacteristic::registerForNotify(notify_callback notifyCallback,
 	m_semaphoreRegForNotifyEvt.take("registerForNotify");
 
 	if (notifyCallback != nullptr) {   // If we have a callback function, then this is a registration.
+		BLEDevice::addNotifyTarget(this);   // Before asking, as the first notification may follow at once.
 		esp_err_t errRc = ::esp_ble_gattc_register_for_notify(
 			m_pRemoteService->getClient()->getGattcIf(),
 			*m_pRemoteService->getClient()->getPeerAddress().getNative(),
@@ -466,6 +479,7 @@ void BLERemoteCharacteristic::registerForNotify(notify_callback notifyCallback,
 			desc->writeValue(val, 2);
 	} // End Register
 	else {   // If we weren't passed a callback function, then this is an unregistration.
+		BLEDevice::removeNotifyTarget(this);
 		esp_err_t errRc = ::esp_ble_gattc_unregister_for_notify(
 			m_pRemoteService->getClient()->getGattcIf(),
 			*m_pRemoteService->getClient()->getPeerAddress().getNative(),
@@ -496,12 +510,12 @@ void BLERemoteCharacteristic::registerForNotify(notify_callback notifyCallback,
  * @return N/A.
  */
 void BLERemoteCharacteristic::removeDescriptors() {
-	// Iterate through all the descriptors releasing their storage and erasing them from the map.
+	// Iterate through all the descriptors releasing their storage, then empty the map.  Erasing each entry
+	// from within the loop would free the node the loop stands on.
 	for (auto &myPair : m_descriptorMap) {
-	   m_descriptorMap.erase(myPair.first);
 	   delete myPair.second;
 	}
-	m_descriptorMap.clear();   // Technically not neeeded, but just to be sure.
+	m_descriptorMap.clear();
 } // removeCharacteristics
 
 
@@ -559,11 +573,117 @@ bool BLERemoteCharacteristic::writeValue(uint8_t* data, size_t length, bool resp
 		return false;
 	}
 
-	m_semaphoreWriteCharEvt.take("writeValue");
+	// Block waiting for the write to complete, sharing the operation of readValue().
+	m_semaphoreBlockingOp.take("writeValue");
+	if (m_pBlockingOperation) {
+		m_pBlockingOperation->restart(BLERemoteOperation::WRITE);
+	} else {
+		m_pBlockingOperation.reset(new BLERemoteOperation(BLERemoteOperation::WRITE, getRemoteService()->getClient(), nullptr));
+	}
+	startWrite(m_pBlockingOperation, data, length, response);
+	esp_gatt_status_t status = m_pBlockingOperation->wait();
+	m_semaphoreBlockingOp.give();
+
+	ESP_LOGD(LOG_TAG, "<< writeValue");
+	return status == ESP_GATT_OK;
+} // writeValue
+
+
+/**
+ * @brief Write the new value for the characteristic without waiting for the write to complete.
+ *
+ * Bluedroid copies the data before this returns.  A write without response completes once it has been
+ * sent.
+ * @param [in] data A pointer to a data buffer.
+ * @param [in] length The length of the data in the data buffer.
+ * @param [in] response Whether we require a response from the write.
+ * @param [in] callback Invoked when the write completes, or nullptr.
+ * @return The operation.
+ */
+std::shared_ptr<BLERemoteOperation> BLERemoteCharacteristic::writeValueAsync(uint8_t* data, size_t length, bool response, remote_operation_callback callback) {
+	ESP_LOGD(LOG_TAG, ">> writeValueAsync(), length: %d", length);
+	std::shared_ptr<BLERemoteOperation> pOperation(new BLERemoteOperation(BLERemoteOperation::WRITE, getRemoteService()->getClient(), callback));
+	startWrite(pOperation, data, length, response);
+	ESP_LOGD(LOG_TAG, "<< writeValueAsync");
+	return pOperation;
+} // writeValueAsync
+
+
+/**
+ * @brief Write the new value for the characteristic without waiting for the write to complete.
+ * @param [in] newValue The new value to write.
+ * @param [in] response Whether we require a response from the write.
+ * @param [in] callback Invoked when the write completes, or nullptr.
+ * @return The operation.
+ */
+std::shared_ptr<BLERemoteOperation> BLERemoteCharacteristic::writeValueAsync(std::string newValue, bool response, remote_operation_callback callback) {
+	return writeValueAsync((uint8_t*) newValue.data(), newValue.length(), response, callback);
+} // writeValueAsync
+
+/**
+ * @brief Ask the server for the value of the characteristic on behalf of an operation.
+ *
+ * The operation completes when the answer arrives, or at once if the request cannot be made.
+ * @param [in] pOperation The operation, of type READ.
+ */
+void BLERemoteCharacteristic::startRead(std::shared_ptr<BLERemoteOperation> pOperation) {
+	BLEClient* pClient = getRemoteService()->getClient();
+	pOperation->m_pService        = m_pRemoteService;
+	pOperation->m_pCharacteristic = this;
+	pOperation->m_handle          = getHandle();
+
+	// Check to see that we are connected.
+	if (!pClient->isConnected()) {
+		ESP_LOGE(LOG_TAG, "Disconnected");
+		pOperation->complete(ESP_GATT_ERROR);
+		return;
+	}
+
+	pClient->addOperation(pOperation);
+
+	// Ask the BLE subsystem to retrieve the value for the remote hosted characteristic.
+	// This is an asynchronous request; the client completes the operation when the response arrives.
+	esp_err_t errRc = ::esp_ble_gattc_read_char(
+		pClient->getGattcIf(),
+		pClient->getConnId(),                          // The connection ID to the BLE server
+		getHandle(),                                   // The handle of this characteristic
+		ESP_GATT_AUTH_REQ_NONE);                       // Security
+
+	if (errRc != ESP_OK) {
+		ESP_LOGE(LOG_TAG, "esp_ble_gattc_read_char: rc=%d %s", errRc, GeneralUtils::errorToString(errRc));
+		pClient->cancelOperation(pOperation.get(), ESP_GATT_ERROR);
+	}
+} // startRead
+
+
+/**
+ * @brief Write a new value for the characteristic on behalf of an operation.
+ *
+ * The operation completes when the answer arrives, or at once if the request cannot be made.
+ * @param [in] pOperation The operation, of type WRITE.
+ * @param [in] data A pointer to a data buffer.
+ * @param [in] length The length of the data in the data buffer.
+ * @param [in] response Whether we require a response from the write.
+ */
+void BLERemoteCharacteristic::startWrite(std::shared_ptr<BLERemoteOperation> pOperation, uint8_t* data, size_t length, bool response) {
+	BLEClient* pClient = getRemoteService()->getClient();
+	pOperation->m_pService        = m_pRemoteService;
+	pOperation->m_pCharacteristic = this;
+	pOperation->m_handle          = getHandle();
+
+	// Check to see that we are connected.
+	if (!pClient->isConnected()) {
+		ESP_LOGE(LOG_TAG, "Disconnected");
+		pOperation->complete(ESP_GATT_ERROR);
+		return;
+	}
+
+	pClient->addOperation(pOperation);
+
 	// Invoke the ESP-IDF API to perform the write.
 	esp_err_t errRc = ::esp_ble_gattc_write_char(
-		m_pRemoteService->getClient()->getGattcIf(),
-		m_pRemoteService->getClient()->getConnId(),
+		pClient->getGattcIf(),
+		pClient->getConnId(),
 		getHandle(),
 		length,
 		data,
@@ -573,14 +693,10 @@ bool BLERemoteCharacteristic::writeValue(uint8_t* data, size_t length, bool resp
 
 	if (errRc != ESP_OK) {
 		ESP_LOGE(LOG_TAG, "esp_ble_gattc_write_char: rc=%d %s", errRc, GeneralUtils::errorToString(errRc));
-		return false;
+		pClient->cancelOperation(pOperation.get(), ESP_GATT_ERROR);
 	}
+} // startWrite
 
-	m_semaphoreWriteCharEvt.wait("writeValue");
-
-	ESP_LOGD(LOG_TAG, "<< writeValue");
-	return true;
-} // writeValue
 
 /**
  * @brief Read raw data from remote characteristic as hex bytes
@@ -10,10 +10,13 @@
 #include "sdkconfig.h"
 #if defined(CONFIG_BT_ENABLED)
 
+#include <stdint.h>
+#include <memory>
 #include <string>
 
 #include <esp_gattc_api.h>
 
+#include "BLERemoteOperation.h"
 #include "BLERemoteService.h"
 #include "BLERemoteDescriptor.h"
 #include "BLEUUID.h"
@@ -42,6 +45,7 @@ public:
 	uint16_t    getHandle();
 	BLEUUID     getUUID();
 	std::string readValue();
+	std::shared_ptr<BLERemoteOperation> readValueAsync(remote_operation_callback callback = nullptr);
 	uint8_t     readUInt8();
 	uint16_t    readUInt16();
 	uint32_t    readUInt32();
@@ -49,6 +53,8 @@ public:
 	bool        writeValue(uint8_t* data, size_t length, bool response = false);
 	bool        writeValue(std::string newValue, bool response = false);
 	bool        writeValue(uint8_t newValue, bool response = false);
+	std::shared_ptr<BLERemoteOperation> writeValueAsync(uint8_t* data, size_t length, bool response = false, remote_operation_callback callback = nullptr);
+	std::shared_ptr<BLERemoteOperation> writeValueAsync(std::string newValue, bool response = false, remote_operation_callback callback = nullptr);
 	std::string toString();
 	uint8_t*	readRawData();
 	BLERemoteService* getRemoteService();
@@ -56,26 +62,34 @@ public:
 private:
 	BLERemoteCharacteristic(uint16_t handle, BLEUUID uuid, esp_gatt_char_prop_t charProp, BLERemoteService* pRemoteService);
 	friend class BLEClient;
+	friend class BLEDevice;
+	friend class BLEDiscoveryCache;
 	friend class BLERemoteService;
 	friend class BLERemoteDescriptor;
 
 	// Private member functions
 	void gattClientEventHandler(esp_gattc_cb_event_t event, esp_gatt_if_t gattc_if, esp_ble_gattc_cb_param_t* evtParam);
 
+	void              addDescriptor(BLERemoteDescriptor* pDescriptor);
 	void              removeDescriptors();
 	void              retrieveDescriptors();
+	void              startRead(std::shared_ptr<BLERemoteOperation> pOperation);
+	void              startWrite(std::shared_ptr<BLERemoteOperation> pOperation, uint8_t* data, size_t length, bool response);
 
 	// Private properties
 	BLEUUID              m_uuid;
 	esp_gatt_char_prop_t m_charProp;
 	uint16_t             m_handle;
 	BLERemoteService*    m_pRemoteService;
-	FreeRTOS::Semaphore  m_semaphoreReadCharEvt      = FreeRTOS::Semaphore("ReadCharEvt");
 	FreeRTOS::Semaphore  m_semaphoreRegForNotifyEvt  = FreeRTOS::Semaphore("RegForNotifyEvt");
-	FreeRTOS::Semaphore  m_semaphoreWriteCharEvt     = FreeRTOS::Semaphore("WriteCharEvt");
+	FreeRTOS::Semaphore  m_semaphoreBlockingOp       = FreeRTOS::Semaphore("BlockingOp");   // Held by readValue() and writeValue().
+	std::shared_ptr<BLERemoteOperation> m_pBlockingOperation;   // Reused by readValue() and writeValue().
 	std::string          m_value;
 	uint8_t 			 *m_rawData = nullptr;
 	notify_callback		 m_notifyCallback = nullptr;
+	uint64_t             m_notifyKey;        // Under which BLEDevice routes notifications to us, or NOT_ROUTED.
+
+	static const uint64_t NOT_ROUTED = UINT64_MAX;
 
 	// We maintain a map of descriptors owned by this characteristic keyed by a string representation of the UUID.
 	std::map<std::string, BLERemoteDescriptor*> m_descriptorMap;
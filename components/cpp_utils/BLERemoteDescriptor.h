@@ -37,6 +37,7 @@ public:
 
 
 private:
+	friend class BLEDiscoveryCache;
 	friend class BLERemoteCharacteristic;
 	BLERemoteDescriptor(
 		uint16_t                 handle,
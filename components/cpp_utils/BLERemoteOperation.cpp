@@ -0,0 +1,157 @@
+/*
+ * BLERemoteOperation.cpp
+ */
+#include "sdkconfig.h"
+#if defined(CONFIG_BT_ENABLED)
+#include <esp_timer.h>
+#include "BLERemoteOperation.h"
+
+
+/**
+ * @brief Create an operation that has not yet been started.
+ * @param [in] type What the operation does.
+ * @param [in] pClient The client whose connection carries it.
+ * @param [in] callback Invoked when the operation completes, or nullptr.
+ */
+BLERemoteOperation::BLERemoteOperation(type_t type, BLEClient* pClient, remote_operation_callback callback) {
+	m_pClient         = pClient;
+	m_pService        = nullptr;
+	m_pCharacteristic = nullptr;
+	m_handle          = 0;
+	m_callback        = callback;
+	restart(type);
+} // BLERemoteOperation
+
+
+/**
+ * @brief Record the outcome of the operation and release anyone waiting for it.
+ * @param [in] status The status reported by the server or the stack.
+ * @param [in] pValue The value read, if any.
+ * @param [in] length The length of the value read.
+ */
+void BLERemoteOperation::complete(esp_gatt_status_t status, const uint8_t* pValue, size_t length) {
+	m_status    = status;
+	m_latencyUs = (uint32_t) (::esp_timer_get_time() - m_startUs);
+	if (pValue != nullptr) {
+		m_value.assign((const char*) pValue, length);
+	}
+	m_complete = true;
+	if (m_callback != nullptr) {
+		m_callback(this);
+	}
+	m_semaphoreCmplEvt.give();
+} // complete
+
+
+/**
+ * @brief Make the operation outstanding again, so that it can be started anew without being allocated.
+ *
+ * Only an operation that has completed and that is no longer waited on may be restarted.  The value read
+ * is emptied but keeps its storage.
+ * @param [in] type What the operation does now.
+ */
+void BLERemoteOperation::restart(type_t type) {
+	m_type      = type;
+	m_startUs   = ::esp_timer_get_time();
+	m_latencyUs = 0;
+	m_complete  = false;
+	m_status    = ESP_GATT_PENDING;
+	m_value.clear();
+	m_semaphoreCmplEvt.take("operation");
+} // restart
+
+
+/**
+ * @brief Get the characteristic read or written.
+ * @return The characteristic, or nullptr for discovery.
+ */
+BLERemoteCharacteristic* BLERemoteOperation::getCharacteristic() {
+	return m_pCharacteristic;
+} // getCharacteristic
+
+
+/**
+ * @brief Get the client whose connection carries the operation.
+ * @return The client.
+ */
+BLEClient* BLERemoteOperation::getClient() {
+	return m_pClient;
+} // getClient
+
+
+/**
+ * @brief Get the handle of the characteristic read or written.
+ * @return The handle, or 0 for discovery.
+ */
+uint16_t BLERemoteOperation::getHandle() {
+	return m_handle;
+} // getHandle
+
+
+/**
+ * @brief Get the time the operation took, from being started to completing.
+ *
+ * For a request answered by the server this includes the time it waited behind earlier requests on the
+ * same connection.
+ * @return The time in microseconds, 0 until the operation completes.
+ */
+uint32_t BLERemoteOperation::getLatencyUs() {
+	return m_latencyUs;
+} // getLatencyUs
+
+
+/**
+ * @brief Get the service whose characteristics are retrieved, or that owns the characteristic.
+ * @return The service, or nullptr for the discovery of services.
+ */
+BLERemoteService* BLERemoteOperation::getService() {
+	return m_pService;
+} // getService
+
+
+/**
+ * @brief Get the outcome of the operation.
+ * @return ESP_GATT_OK on success, ESP_GATT_PENDING while the operation is outstanding.
+ */
+esp_gatt_status_t BLERemoteOperation::getStatus() {
+	return m_status;
+} // getStatus
+
+
+/**
+ * @brief Get what the operation does.
+ * @return The type of the operation.
+ */
+BLERemoteOperation::type_t BLERemoteOperation::getType() {
+	return m_type;
+} // getType
+
+
+/**
+ * @brief Get the value read.
+ * @return The value, empty until a read completes successfully.
+ */
+std::string BLERemoteOperation::getValue() {
+	return m_value;
+} // getValue
+
+
+/**
+ * @brief Has the operation completed?
+ * @return True once the operation has completed, successfully or not.
+ */
+bool BLERemoteOperation::isComplete() {
+	return m_complete;
+} // isComplete
+
+
+/**
+ * @brief Block until the operation completes.
+ * @return The outcome of the operation.
+ */
+esp_gatt_status_t BLERemoteOperation::wait() {
+	m_semaphoreCmplEvt.wait("wait");
+	return m_status;
+} // wait
+
+#endif /* CONFIG_BT_ENABLED */
@@ -0,0 +1,81 @@
+/*
+ * BLERemoteOperation.h
+ */
+
+#ifndef COMPONENTS_CPP_UTILS_BLEREMOTEOPERATION_H_
+#define COMPONENTS_CPP_UTILS_BLEREMOTEOPERATION_H_
+#include "sdkconfig.h"
+#if defined(CONFIG_BT_ENABLED)
+#include <esp_gatt_defs.h>
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include "FreeRTOS.h"
+
+class BLEClient;
+class BLERemoteCharacteristic;
+class BLERemoteOperation;
+class BLERemoteService;
+
+typedef void (*remote_operation_callback)(BLERemoteOperation* pOperation);
+
+/**
+ * @brief A request made of a remote %BLE server that completes later.
+ *
+ * The asynchronous calls of BLEClient, BLERemoteService and BLERemoteCharacteristic return one of these
+ * at once instead of blocking until the server answers.  Any number may be outstanding on a connection
+ * and across connections: Bluedroid queues the requests of each connection and sends them one at a time,
+ * and the answers are matched back to the requests in the order they were made.
+ *
+ * When the operation completes the callback, if one was given, is invoked and then wait() returns.  The
+ * callback runs in the Bluedroid task, or in the caller's task if the operation fails or completes before
+ * the call that started it returns.  It must not wait() on another operation.  An operation outstanding
+ * when the connection drops completes with ESP_GATT_ERROR.
+ *
+ * The caller may drop the handle at any time; the operation still completes and invokes its callback.
+ */
+class BLERemoteOperation {
+public:
+	typedef enum {
+		READ,                       // BLERemoteCharacteristic::readValueAsync()
+		WRITE,                      // BLERemoteCharacteristic::writeValueAsync()
+		GET_SERVICES,               // BLEClient::getServicesAsync()
+		RETRIEVE_CHARACTERISTICS    // BLERemoteService::retrieveCharacteristicsAsync()
+	} type_t;
+
+	BLERemoteCharacteristic* getCharacteristic();
+	BLEClient*               getClient();
+	uint16_t                 getHandle();
+	BLERemoteService*        getService();
+	uint32_t                 getLatencyUs();
+	esp_gatt_status_t        getStatus();
+	type_t                   getType();
+	std::string              getValue();
+	bool                     isComplete();
+	esp_gatt_status_t        wait();
+
+private:
+	friend class BLEClient;
+	friend class BLERemoteCharacteristic;
+	friend class BLERemoteService;
+
+	BLERemoteOperation(type_t type, BLEClient* pClient, remote_operation_callback callback);
+	void complete(esp_gatt_status_t status, const uint8_t* pValue = nullptr, size_t length = 0);
+	void restart(type_t type);
+
+	type_t                    m_type;
+	BLEClient*                m_pClient;
+	BLERemoteService*         m_pService;
+	BLERemoteCharacteristic*  m_pCharacteristic;
+	uint16_t                  m_handle;
+	remote_operation_callback m_callback;
+	int64_t                   m_startUs;     // When the operation was started.
+	uint32_t                  m_latencyUs;   // From start to completion.
+	volatile bool             m_complete;
+	esp_gatt_status_t         m_status;
+	std::string               m_value;
+	FreeRTOS::Semaphore       m_semaphoreCmplEvt = FreeRTOS::Semaphore("CmplEvt");
+}; // BLERemoteOperation
+
+#endif /* CONFIG_BT_ENABLED */
+#endif /* COMPONENTS_CPP_UTILS_BLEREMOTEOPERATION_H_ */
@@ -102,9 +102,8 @@ BLERemoteCharacteristic* BLERemoteService::getCharacteristic(BLEUUID uuid) {
 	if (!m_haveCharacteristics) {
 		retrieveCharacteristics();
 	}
-	std::string v = uuid.toString();
 	for (auto &myPair : m_characteristicMap) {
-		if (myPair.first == v) {
+		if (myPair.second->getUUID().equals(uuid)) {
 			return myPair.second;
 		}
 	}
@@ -113,6 +112,16 @@ BLERemoteCharacteristic* BLERemoteService::getCharacteristic(BLEUUID uuid) {
 } // getCharacteristic
 
 
+/**
+ * @brief Add a characteristic that has been retrieved, or built from the discovery cache.
+ * @param [in] pCharacteristic The characteristic.
+ */
+void BLERemoteService::addCharacteristic(BLERemoteCharacteristic* pCharacteristic) {
+	m_characteristicMap.insert(std::pair<std::string, BLERemoteCharacteristic*>(pCharacteristic->getUUID().toString(), pCharacteristic));
+	m_characteristicMapByHandle.insert(std::pair<uint16_t, BLERemoteCharacteristic*>(pCharacteristic->getHandle(), pCharacteristic));
+} // addCharacteristic
+
+
 /**
  * @brief Retrieve all the characteristics for this service.
  * This function will not return until we have all the characteristics.
@@ -142,7 +151,7 @@ void BLERemoteService::retrieveCharacteristics() {
 		}
 
 		if (status != ESP_GATT_OK) {   // If we got an error, end.
-			ESP_LOGE(LOG_TAG, "esp_ble_gattc_get_all_char: %s", BLEUtils::gattStatusToString(status).c_str());
+			ESP_LOGE(LOG_TAG, "esp_ble_gattc_get_all_char: %s", BLEUtils::gattStatusToString(status));
 			break;
 		}
 
@@ -159,9 +168,9 @@ void BLERemoteService::retrieveCharacteristics() {
 			result.properties,
 			this
 		);
+		pNewRemoteCharacteristic->retrieveDescriptors(); // Get the descriptors for this characteristic
 
-		m_characteristicMap.insert(std::pair<std::string, BLERemoteCharacteristic*>(pNewRemoteCharacteristic->getUUID().toString(), pNewRemoteCharacteristic));
-		m_characteristicMapByHandle.insert(std::pair<uint16_t, BLERemoteCharacteristic*>(result.char_handle, pNewRemoteCharacteristic));
+		addCharacteristic(pNewRemoteCharacteristic);
 		offset++;   // Increment our count of number of descriptors found.
 	} // Loop forever (until we break inside the loop).
 
@@ -170,6 +179,27 @@ void BLERemoteService::retrieveCharacteristics() {
 } // retrieveCharacteristics
 
 
+/**
+ * @brief Retrieve all the characteristics for this service as an operation.
+ *
+ * Unlike the discovery of services, Bluedroid answers this from the attributes it found during
+ * BLEClient::getServices() without asking the server again, so the operation has completed, and its
+ * callback has been invoked, by the time this returns.  It lets a central chain the discovery of services
+ * and characteristics through the same callbacks.
+ * @param [in] callback Invoked when the characteristics have been retrieved, or nullptr.
+ * @return The operation.
+ */
+std::shared_ptr<BLERemoteOperation> BLERemoteService::retrieveCharacteristicsAsync(remote_operation_callback callback) {
+	std::shared_ptr<BLERemoteOperation> pOperation(new BLERemoteOperation(BLERemoteOperation::RETRIEVE_CHARACTERISTICS, m_pClient, callback));
+	pOperation->m_pService = this;
+	if (!m_haveCharacteristics) {   // Those built from the discovery cache are not in Bluedroid's.
+		retrieveCharacteristics();
+	}
+	pOperation->complete(ESP_GATT_OK);
+	return pOperation;
+} // retrieveCharacteristicsAsync
+
+
 /**
  * @brief Retrieve a map of all the characteristics of this service.
  * @return A map of all the characteristics of this service.
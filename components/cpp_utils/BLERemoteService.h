@@ -11,8 +11,10 @@
 #if defined(CONFIG_BT_ENABLED)
 
 #include <map>
+#include <memory>
 
 #include "BLEClient.h"
+#include "BLERemoteOperation.h"
 #include "BLERemoteCharacteristic.h"
 #include "BLEUUID.h"
 #include "FreeRTOS.h"
@@ -40,6 +42,7 @@ public:
 	uint16_t                 getHandle();                                               // Get the handle of this service.
 	BLEUUID                  getUUID(void);                                             // Get the UUID of this service.
 	std::string              getValue(BLEUUID characteristicUuid);                      // Get the value of a characteristic.
+	std::shared_ptr<BLERemoteOperation> retrieveCharacteristicsAsync(remote_operation_callback callback = nullptr);   // Retrieve the characteristics without blocking.
 	void                     setValue(BLEUUID characteristicUuid, std::string value);   // Set the value of a characteristic.
 	std::string              toString(void);
 
@@ -49,9 +52,11 @@ private:
 
 	// Friends
 	friend class BLEClient;
+	friend class BLEDiscoveryCache;
 	friend class BLERemoteCharacteristic;
 
 	// Private methods
+	void                addCharacteristic(BLERemoteCharacteristic* pCharacteristic);
 	void                retrieveCharacteristics(void);   // Retrieve the characteristics from the BLE Server.
 	esp_gatt_id_t*      getSrvcId(void);
 	uint16_t            getStartHandle();                // Get the start handle for this service.
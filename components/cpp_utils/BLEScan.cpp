@@ -9,11 +9,11 @@
 
 
 #include <esp_err.h>
-
-#include <map>
+#include <string.h>
 
 #include "BLEAdvertisedDevice.h"
 #include "BLEScan.h"
+#include "BLEScanStream.h"
 #include "BLEUtils.h"
 #include "GeneralUtils.h"
 #if defined(ARDUINO_ARCH_ESP32) && defined(CONFIG_ARDUHAL_ESP_LOG)
@@ -37,6 +37,7 @@ BLEScan::BLEScan() {
 	m_pAdvertisedDeviceCallbacks     = nullptr;
 	m_stopped                        = true;
 	m_wantDuplicates                 = false;
+	clearAdvertisementCache();
 	setInterval(100);
 	setWindow(100);
 } // BLEScan
@@ -77,6 +78,9 @@ void BLEScan::handleGAPEvent(
 				case ESP_GAP_SEARCH_INQ_CMPL_EVT: {
 					ESP_LOGW(LOG_TAG, "ESP_GAP_SEARCH_INQ_CMPL_EVT");
 					m_stopped = true;
+					if (m_pStream != nullptr) {
+						m_pStream->stop();
+					}
 					m_semaphoreScanEnd.give();
 					if (m_scanCompleteCB != nullptr) {
 						m_scanCompleteCB(m_scanResults);
@@ -93,43 +97,59 @@ void BLEScan::handleGAPEvent(
 						break;
 					}
 
-// Examine our list of previously scanned addresses and, if we found this one already,
-// ignore it.
-					BLEAddress advertisedAddress(param->scan_rst.bda);
-					bool found = false;
+					// A scan response may be reported on its own, after the advertisement it answers.  The filters
+					// judge it together with that advertisement, which is then reported with it as one.
+					esp_ble_gap_cb_param_t::ble_scan_result_evt_param  combined;
+					esp_ble_gap_cb_param_t::ble_scan_result_evt_param* pResult = &param->scan_rst;
+					if (!m_filters.empty()) {
+						if (pResult->ble_evt_type == ESP_BLE_EVT_SCAN_RSP) {
+							if (combineScanResponse(pResult, &combined)) pResult = &combined;
+						} else if (pResult->scan_rsp_len == 0) {
+							rememberAdvertisement(pResult);
+						}
+					}
 
-					if (m_scanResults.m_vectorAdvertisedDevices.count(advertisedAddress.toString()) != 0) {
-						found = true;
+					if (!passesFilters(pResult)) { // Decided on the raw report, before anything is built for it.
+						m_filteredCount++;
+						break;
 					}
 
+					if (m_pStream != nullptr) { // A streaming scan follows devices in its own fixed table.
+						m_pStream->handleResult(pResult);
+						break;
+					}
+
+// Examine our list of previously scanned addresses and, if we found this one already,
+// ignore it.  The table is keyed by the packed address so no string is built to look it up.
+					BLEAddress advertisedAddress(pResult->bda);
+					BLEAdvertisedDevice* advertisedDevice = m_scanResults.m_advertisedDevices.find(advertisedAddress.toUint64());
+					bool found = advertisedDevice != nullptr;
+
 					if (found && !m_wantDuplicates) {  // If we found a previous entry AND we don't want duplicates, then we are done.
-						ESP_LOGD(LOG_TAG, "Ignoring %s, already seen it.", advertisedAddress.toString().c_str());
+						ESP_LOGD(LOG_TAG, "Ignoring %012llx, already seen it.", (unsigned long long) advertisedAddress.toUint64());
 						vTaskDelay(1);  // <--- allow to switch task in case we scan infinity and dont have new devices to report, or we are blocked here
 						break;
 					}
 
 					// We now construct a model of the advertised device that we have just found for the first
-					// time.
+					// time.  A device seen before is parsed again into the object we already hold.
 					// ESP_LOG_BUFFER_HEXDUMP(LOG_TAG, (uint8_t*)param->scan_rst.ble_adv, param->scan_rst.adv_data_len + param->scan_rst.scan_rsp_len, ESP_LOG_DEBUG);
 					// ESP_LOGW(LOG_TAG, "bytes length: %d + %d, addr type: %d", param->scan_rst.adv_data_len, param->scan_rst.scan_rsp_len, param->scan_rst.ble_addr_type);
-					BLEAdvertisedDevice *advertisedDevice = new BLEAdvertisedDevice();
-					advertisedDevice->setAddress(advertisedAddress);
-					advertisedDevice->setRSSI(param->scan_rst.rssi);
-					advertisedDevice->setAdFlag(param->scan_rst.flag);
-					advertisedDevice->parseAdvertisement((uint8_t*)param->scan_rst.ble_adv, param->scan_rst.adv_data_len + param->scan_rst.scan_rsp_len);
-					advertisedDevice->setScan(this);
-					advertisedDevice->setAddressType(param->scan_rst.ble_addr_type);
-
-					if (!found) {   // If we have previously seen this device, don't record it again.
-						m_scanResults.m_vectorAdvertisedDevices.insert(std::pair<std::string, BLEAdvertisedDevice*>(advertisedAddress.toString(), advertisedDevice));
+					if (!found) {
+						advertisedDevice = new BLEAdvertisedDevice();
+						advertisedDevice->setAddress(advertisedAddress);
+						advertisedDevice->setScan(this);
+						m_scanResults.m_advertisedDevices.insert(advertisedAddress.toUint64(), advertisedDevice);
 					}
+					advertisedDevice->setRSSI(pResult->rssi);
+					advertisedDevice->setAdFlag(pResult->flag);
+					advertisedDevice->parseAdvertisement((uint8_t*)pResult->ble_adv, pResult->adv_data_len + pResult->scan_rsp_len);
+					advertisedDevice->setAddressType(pResult->ble_addr_type);
 
 					if (m_pAdvertisedDeviceCallbacks) {
 						m_pAdvertisedDeviceCallbacks->onResult(advertisedDevice);
 						m_pAdvertisedDeviceCallbacks->onResult(*advertisedDevice);
 					}
-					if(found)
-						delete advertisedDevice;
 
 					break;
 				} // ESP_GAP_SEARCH_INQ_RES_EVT
@@ -150,6 +170,130 @@ void BLEScan::handleGAPEvent(
 } // gapEventHandler
 
 
+/**
+ * @brief Add a filter that reports must match to be of interest.
+ *
+ * Once a filter is added, a report that matches none of the filters is dropped as soon as it arrives.
+ * It is checked against the raw advertising data, so no BLEAdvertisedDevice is created, parsed, kept in
+ * the results or streamed and no callback is invoked for it.  Within a filter every criterion set must
+ * be met; a report need only match one of the filters.  Call this while the scan is stopped.
+ *
+ * A scan response reported apart from its advertisement is checked together with the last advertisement
+ * reported by the same device, so criteria may be spread across the two.  The advertisement alone is
+ * checked as it arrives; if it fails, the device is first reported once its scan response makes it match.
+ *
+ * @param [in] filter The filter.  It is copied.
+ */
+void BLEScan::addFilter(const BLEScanFilter& filter) {
+	m_filters.push_back(filter);
+} // addFilter
+
+
+/**
+ * @brief Remove every filter, so that every report is of interest again.
+ */
+void BLEScan::clearFilters() {
+	m_filters.clear();
+	clearAdvertisementCache();
+} // clearFilters
+
+
+/**
+ * @brief Forget the advertisements kept for scan responses that have yet to arrive.
+ */
+void BLEScan::clearAdvertisementCache() {
+	memset(m_advCache, 0, sizeof(m_advCache));
+	m_advCacheNext = 0;
+} // clearAdvertisementCache
+
+
+/**
+ * @brief Join a scan response reported on its own to the advertisement it answers.
+ *
+ * The combined report is laid out as the stack lays out a report that carries both, the advertising
+ * data first and the scan response after it.
+ *
+ * @param [in] pResult The report of the scan response.
+ * @param [out] pCombined The report of the advertisement and the scan response.
+ * @return True if the advertisement of the device was kept, false if the scan response stands alone.
+ */
+bool BLEScan::combineScanResponse(
+		esp_ble_gap_cb_param_t::ble_scan_result_evt_param* pResult,
+		esp_ble_gap_cb_param_t::ble_scan_result_evt_param* pCombined) {
+	uint64_t address = BLEAddress(pResult->bda).toUint64();
+	for (uint8_t i = 0; i < ADV_CACHE_SIZE; i++) {
+		adv_cache_entry_t& entry = m_advCache[i];
+		if (entry.length == 0 || entry.address != address) continue;
+		uint8_t scanRspLength = pResult->adv_data_len + pResult->scan_rsp_len;  // All of it is the scan response.
+		if (scanRspLength > ESP_BLE_SCAN_RSP_DATA_LEN_MAX) scanRspLength = ESP_BLE_SCAN_RSP_DATA_LEN_MAX;
+		*pCombined = *pResult;
+		memcpy(pCombined->ble_adv, entry.data, entry.length);
+		memcpy(pCombined->ble_adv + entry.length, pResult->ble_adv, scanRspLength);
+		pCombined->adv_data_len = entry.length;
+		pCombined->scan_rsp_len = scanRspLength;
+		return true;
+	}
+	return false;
+} // combineScanResponse
+
+
+/**
+ * @brief Get the number of reports dropped because they matched no filter.
+ * @return The number of reports dropped since the scan object was created.
+ */
+uint32_t BLEScan::getFilteredCount() {
+	return m_filteredCount;
+} // getFilteredCount
+
+
+/**
+ * @brief Does a report match one of the filters, or are there none?
+ * @param [in] pResult The report.
+ * @return True if the report is of interest.
+ */
+bool BLEScan::passesFilters(esp_ble_gap_cb_param_t::ble_scan_result_evt_param* pResult) {
+	if (m_filters.empty()) {
+		return true;
+	}
+	BLEAdvertisementView advertisement(pResult->ble_adv, pResult->adv_data_len + pResult->scan_rsp_len);
+	for (auto& filter : m_filters) {
+		if (filter.matches(advertisement, pResult->rssi)) {
+			return true;
+		}
+	}
+	return false;
+} // passesFilters
+
+
+/**
+ * @brief Keep the advertising data of a report that carries no scan response.
+ *
+ * The entry already held for the device is replaced, else the oldest entry.
+ *
+ * @param [in] pResult The report.
+ */
+void BLEScan::rememberAdvertisement(esp_ble_gap_cb_param_t::ble_scan_result_evt_param* pResult) {
+	if (pResult->adv_data_len == 0 || pResult->adv_data_len > ESP_BLE_ADV_DATA_LEN_MAX) {
+		return;
+	}
+	uint64_t address = BLEAddress(pResult->bda).toUint64();
+	adv_cache_entry_t* pEntry = nullptr;
+	for (uint8_t i = 0; i < ADV_CACHE_SIZE; i++) {
+		if (m_advCache[i].length != 0 && m_advCache[i].address == address) {
+			pEntry = &m_advCache[i];
+			break;
+		}
+	}
+	if (pEntry == nullptr) {
+		pEntry = &m_advCache[m_advCacheNext];
+		m_advCacheNext = (m_advCacheNext + 1) % ADV_CACHE_SIZE;
+	}
+	pEntry->address = address;
+	pEntry->length  = pResult->adv_data_len;
+	memcpy(pEntry->data, pResult->ble_adv, pResult->adv_data_len);
+} // rememberAdvertisement
+
+
 /**
  * @brief Should we perform an active or passive scan?
  * The default is a passive scan.  An active scan means that we will wish a scan response.
@@ -176,6 +320,37 @@ void BLEScan::setAdvertisedDeviceCallbacks(BLEAdvertisedDeviceCallbacks* pAdvert
 } // setAdvertisedDeviceCallbacks
 
 
+/**
+ * @brief Switch the scan to streaming mode, or back.
+ *
+ * In streaming mode the results are not collected into BLEScanResults, which grows with every device
+ * found, and the BLEAdvertisedDeviceCallbacks are not invoked.  Instead a BLEScanStream follows at most
+ * the given number of devices, forgetting the one seen least recently to make room for a new one, and
+ * tells the callbacks as devices are found, seen again and lost.  This suits a continuous scan
+ * (duration 0) that runs for as long as the device does.  Call this while the scan is stopped.
+ *
+ * @param [in] pCallbacks The callbacks to invoke, or nullptr to leave streaming mode.
+ * @param [in] capacity The number of devices to follow at most.
+ * @param [in] lostTimeoutMs How long a device may go unseen before it is reported lost.
+ */
+void BLEScan::setStreamCallbacks(BLEScanStreamCallbacks* pCallbacks, uint16_t capacity, uint32_t lostTimeoutMs) {
+	delete m_pStream;
+	m_pStream = nullptr;
+	if (pCallbacks != nullptr) {
+		m_pStream = new BLEScanStream(this, pCallbacks, capacity, lostTimeoutMs);
+	}
+} // setStreamCallbacks
+
+
+/**
+ * @brief Get the stream of a scan in streaming mode.
+ * @return The stream or nullptr if the scan is not in streaming mode.
+ */
+BLEScanStream* BLEScan::getStream() {
+	return m_pStream;
+} // getStream
+
+
 /**
  * @brief Set the interval to scan.
  * @param [in] The interval in msecs.
@@ -210,10 +385,7 @@ bool BLEScan::start(uint32_t duration, void (*scanCompleteCB)(BLEScanResults), b
 	//  if we are connecting to devices that are advertising even after being connected, multiconnecting peripherals
 	//  then we should not clear map or we will connect the same device few times
 	if(!is_continue) {  
-		for(auto _dev : m_scanResults.m_vectorAdvertisedDevices){
-			delete _dev.second;
-		}
-		m_scanResults.m_vectorAdvertisedDevices.clear();
+		m_scanResults.clear();
 	}
 
 	esp_err_t errRc = ::esp_ble_gap_set_scan_params(&m_scan_params);
@@ -233,6 +405,9 @@ bool BLEScan::start(uint32_t duration, void (*scanCompleteCB)(BLEScanResults), b
 	}
 
 	m_stopped = false;
+	if (m_pStream != nullptr) {
+		m_pStream->start();
+	}
 
 	ESP_LOGD(LOG_TAG, "<< start()");
 	return true;
@@ -262,6 +437,9 @@ void BLEScan::stop() {
 	esp_err_t errRc = ::esp_ble_gap_stop_scanning();
 
 	m_stopped = true;
+	if (m_pStream != nullptr) {
+		m_pStream->stop();
+	}
 	m_semaphoreScanEnd.give();
 
 	if (errRc != ESP_OK) {
@@ -275,12 +453,28 @@ void BLEScan::stop() {
 // delete peer device from cache after disconnecting, it is required in case we are connecting to devices with not public address
 void BLEScan::erase(BLEAddress address) {
 	ESP_LOGI(LOG_TAG, "erase device: %s", address.toString().c_str());
-	BLEAdvertisedDevice *advertisedDevice = m_scanResults.m_vectorAdvertisedDevices.find(address.toString())->second;
-	m_scanResults.m_vectorAdvertisedDevices.erase(address.toString());
-	delete advertisedDevice;
+	delete m_scanResults.m_advertisedDevices.remove(address.toUint64());
 }
 
 
+/**
+ * @brief Create an empty set of scan results with room for CONFIG_BLE_SCAN_TABLE_SIZE devices.
+ */
+BLEScanResults::BLEScanResults() : m_advertisedDevices(CONFIG_BLE_SCAN_TABLE_SIZE) {
+} // BLEScanResults
+
+
+/**
+ * @brief Delete the devices found and empty the results.
+ */
+void BLEScanResults::clear() {
+	for (auto& entry : m_advertisedDevices) {
+		delete entry.pObject;
+	}
+	m_advertisedDevices.clear();
+} // clear
+
+
 /**
  * @brief Dump the scan results to the log.
  */
@@ -297,7 +491,7 @@ void BLEScanResults::dump() {
  * @return The number of devices found in the last scan.
  */
 int BLEScanResults::getCount() {
-	return m_vectorAdvertisedDevices.size();
+	return m_advertisedDevices.size();
 } // getCount
 
 
@@ -308,25 +502,15 @@ int BLEScanResults::getCount() {
  * @return The device at the specified index.
  */
 BLEAdvertisedDevice BLEScanResults::getDevice(uint32_t i) {
-	uint32_t x = 0;
-	BLEAdvertisedDevice dev = *m_vectorAdvertisedDevices.begin()->second;
-	for (auto it = m_vectorAdvertisedDevices.begin(); it != m_vectorAdvertisedDevices.end(); it++) {
-		dev = *it->second;
-		if (x==i)	break;
-		x++;
-	}
-	return dev;
-}
+	return *m_advertisedDevices.at(i).pObject;
+} // getDevice
 
 BLEScanResults BLEScan::getResults() {
 	return m_scanResults;
 }
 
 void BLEScan::clearResults() {
-	for(auto _dev : m_scanResults.m_vectorAdvertisedDevices){
-		delete _dev.second;
-	}
-	m_scanResults.m_vectorAdvertisedDevices.clear();
+	m_scanResults.clear();
 }
 
 #endif /* CONFIG_BT_ENABLED */
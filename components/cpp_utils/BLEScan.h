@@ -11,16 +11,27 @@
 #if defined(CONFIG_BT_ENABLED)
 #include <esp_gap_ble_api.h>
 
-// #include <vector>
+#include <vector>
 #include <string>
+#include "BLEAddressTable.h"
 #include "BLEAdvertisedDevice.h"
 #include "BLEClient.h"
+#include "BLEScanFilter.h"
 #include "FreeRTOS.h"
 
+#ifndef CONFIG_BLE_SCAN_STREAM_SIZE
+#define CONFIG_BLE_SCAN_STREAM_SIZE 32
+#endif
+#ifndef CONFIG_BLE_SCAN_STREAM_LOST_MS
+#define CONFIG_BLE_SCAN_STREAM_LOST_MS 10000
+#endif
+
 class BLEAdvertisedDevice;
 class BLEAdvertisedDeviceCallbacks;
 class BLEClient;
 class BLEScan;
+class BLEScanStream;
+class BLEScanStreamCallbacks;
 
 
 /**
@@ -32,13 +43,16 @@ class BLEScan;
  */
 class BLEScanResults {
 public:
+	BLEScanResults();
 	void                dump();
 	int                 getCount();
 	BLEAdvertisedDevice getDevice(uint32_t i);
 
 private:
 	friend BLEScan;
-	std::map<std::string, BLEAdvertisedDevice*> m_vectorAdvertisedDevices;
+	void clear();
+
+	BLEAddressTable<BLEAdvertisedDevice> m_advertisedDevices;  // Keyed by BLEAddress::toUint64().
 };
 
 /**
@@ -48,17 +62,25 @@ private:
  */
 class BLEScan {
 public:
+	void           addFilter(const BLEScanFilter& filter);
+	void           clearFilters();
+	uint32_t       getFilteredCount();
 	void           setActiveScan(bool active);
 	void           setAdvertisedDeviceCallbacks(
 			              BLEAdvertisedDeviceCallbacks* pAdvertisedDeviceCallbacks,
 										bool wantDuplicates = false);
 	void           setInterval(uint16_t intervalMSecs);
+	void           setStreamCallbacks(
+			              BLEScanStreamCallbacks* pCallbacks,
+			              uint16_t capacity = CONFIG_BLE_SCAN_STREAM_SIZE,
+			              uint32_t lostTimeoutMs = CONFIG_BLE_SCAN_STREAM_LOST_MS);
 	void           setWindow(uint16_t windowMSecs);
 	bool           start(uint32_t duration, void (*scanCompleteCB)(BLEScanResults), bool is_continue = false);
 	BLEScanResults start(uint32_t duration, bool is_continue = false);
 	void           stop();
 	void 		   erase(BLEAddress address);
 	BLEScanResults getResults();
+	BLEScanStream* getStream();
 	void			clearResults();
 
 private:
@@ -76,6 +98,30 @@ private:
 	FreeRTOS::Semaphore           m_semaphoreScanEnd = FreeRTOS::Semaphore("ScanEnd");
 	BLEScanResults                m_scanResults;
 	bool                          m_wantDuplicates;
+	BLEScanStream*                m_pStream = nullptr;
+	std::vector<BLEScanFilter>    m_filters;
+	uint32_t                      m_filteredCount = 0;
+
+	/**
+	 * @brief The advertising data last reported alone by a device, kept so that a scan response reported
+	 * on its own can be filtered together with the advertisement it answers.
+	 */
+	typedef struct {
+		uint64_t address;  // BLEAddress::toUint64().
+		uint8_t  length;
+		uint8_t  data[ESP_BLE_ADV_DATA_LEN_MAX];
+	} adv_cache_entry_t;
+
+	static const uint8_t ADV_CACHE_SIZE = 8;
+	adv_cache_entry_t    m_advCache[ADV_CACHE_SIZE];
+	uint8_t              m_advCacheNext = 0;  // The entry replaced next.
+
+	void clearAdvertisementCache();
+	bool combineScanResponse(
+		esp_ble_gap_cb_param_t::ble_scan_result_evt_param* pResult,
+		esp_ble_gap_cb_param_t::ble_scan_result_evt_param* pCombined);
+	bool passesFilters(esp_ble_gap_cb_param_t::ble_scan_result_evt_param* pResult);
+	void rememberAdvertisement(esp_ble_gap_cb_param_t::ble_scan_result_evt_param* pResult);
 	void                        (*m_scanCompleteCB)(BLEScanResults scanResults);
 }; // BLEScan
 
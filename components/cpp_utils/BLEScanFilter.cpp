@@ -0,0 +1,94 @@
+/*
+ * BLEScanFilter.cpp
+ */
+#include "sdkconfig.h"
+#if defined(CONFIG_BT_ENABLED)
+#include <string.h>
+#include "BLEScanFilter.h"
+
+
+/**
+ * @brief Create a filter that matches every report.
+ */
+BLEScanFilter::BLEScanFilter() {
+	m_haveManufacturerId = false;
+	m_manufacturerId     = 0;
+	m_haveMinRSSI        = false;
+	m_minRSSI            = 0;
+	m_haveNamePrefix     = false;
+	m_haveServiceUUID    = false;
+} // BLEScanFilter
+
+
+/**
+ * @brief Does a report match the filter?
+ *
+ * The cheapest criteria are checked first.  Nothing is allocated.
+ *
+ * @param [in] advertisement The advertising data of the report.
+ * @param [in] rssi The RSSI of the report.
+ * @return True if the report meets every criterion set.
+ */
+bool BLEScanFilter::matches(const BLEAdvertisementView& advertisement, int rssi) const {
+	if (m_haveMinRSSI && rssi < m_minRSSI) {
+		return false;
+	}
+	if (m_haveManufacturerId) {
+		uint16_t id;
+		if (!advertisement.getManufacturerId(&id) || id != m_manufacturerId) return false;
+	}
+	if (m_haveNamePrefix) {
+		const char* pName;
+		size_t      length;
+		if (!advertisement.getName(&pName, &length) || length < m_namePrefix.length() ||
+				memcmp(pName, m_namePrefix.data(), m_namePrefix.length()) != 0) {
+			return false;
+		}
+	}
+	if (m_haveServiceUUID && !advertisement.hasServiceUUID(m_serviceUUID)) {
+		return false;
+	}
+	return true;
+} // matches
+
+
+/**
+ * @brief Require manufacturer specific data starting with a company identifier.
+ * @param [in] manufacturerId The company identifier.
+ */
+void BLEScanFilter::setManufacturerId(uint16_t manufacturerId) {
+	m_manufacturerId     = manufacturerId;
+	m_haveManufacturerId = true;
+} // setManufacturerId
+
+
+/**
+ * @brief Require a signal at least as strong as a threshold.
+ * @param [in] rssi The weakest RSSI accepted, in dBm.
+ */
+void BLEScanFilter::setMinRSSI(int rssi) {
+	m_minRSSI     = rssi;
+	m_haveMinRSSI = true;
+} // setMinRSSI
+
+
+/**
+ * @brief Require a local name, complete or shortened, that starts with a prefix.
+ * @param [in] prefix The prefix.
+ */
+void BLEScanFilter::setNamePrefix(std::string prefix) {
+	m_namePrefix     = prefix;
+	m_haveNamePrefix = true;
+} // setNamePrefix
+
+
+/**
+ * @brief Require a service to be listed in the service UUIDs advertised.
+ * @param [in] uuid The UUID of the service.
+ */
+void BLEScanFilter::setServiceUUID(BLEUUID uuid) {
+	m_serviceUUID     = uuid;
+	m_haveServiceUUID = true;
+} // setServiceUUID
+
+#endif /* CONFIG_BT_ENABLED */
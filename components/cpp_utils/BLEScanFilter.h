@@ -0,0 +1,44 @@
+/*
+ * BLEScanFilter.h
+ */
+
+#ifndef COMPONENTS_CPP_UTILS_BLESCANFILTER_H_
+#define COMPONENTS_CPP_UTILS_BLESCANFILTER_H_
+#include "sdkconfig.h"
+#if defined(CONFIG_BT_ENABLED)
+#include <stdint.h>
+#include <string>
+#include "BLEAdvertisementView.h"
+#include "BLEUUID.h"
+
+/**
+ * @brief What a scan report must hold to be of interest.
+ *
+ * Each criterion is optional; a report matches the filter if it meets every criterion that has been
+ * set.  A filter with none set matches every report.  Filters added to a BLEScan are checked against the
+ * raw advertising data of each report before any object is created for it; see BLEScan::addFilter().
+ * The criteria may be met by the advertisement and its scan response between them.
+ */
+class BLEScanFilter {
+public:
+	BLEScanFilter();
+
+	bool matches(const BLEAdvertisementView& advertisement, int rssi) const;
+	void setManufacturerId(uint16_t manufacturerId);
+	void setMinRSSI(int rssi);
+	void setNamePrefix(std::string prefix);
+	void setServiceUUID(BLEUUID uuid);
+
+private:
+	bool        m_haveManufacturerId;
+	uint16_t    m_manufacturerId;
+	bool        m_haveMinRSSI;
+	int         m_minRSSI;
+	bool        m_haveNamePrefix;
+	std::string m_namePrefix;
+	bool        m_haveServiceUUID;
+	BLEUUID     m_serviceUUID;
+}; // BLEScanFilter
+
+#endif /* CONFIG_BT_ENABLED */
+#endif /* COMPONENTS_CPP_UTILS_BLESCANFILTER_H_ */
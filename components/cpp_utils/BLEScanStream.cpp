@@ -0,0 +1,329 @@
+/*
+ * BLEScanStream.cpp
+ */
+#include "sdkconfig.h"
+#if defined(CONFIG_BT_ENABLED)
+#include "BLEScanStream.h"
+#if defined(ARDUINO_ARCH_ESP32) && defined(CONFIG_ARDUHAL_ESP_LOG)
+#include "esp32-hal-log.h"
+#define LOG_TAG ""
+#else
+#include "esp_log.h"
+static const char* LOG_TAG = "BLEScanStream";
+#endif
+
+
+/**
+ * @brief The time now in milliseconds since boot.
+ */
+static uint32_t now() {
+	return xTaskGetTickCount() * portTICK_PERIOD_MS;
+} // now
+
+
+/**
+ * @brief Get the advertised device as last parsed.
+ * @return The advertised device.
+ */
+BLEAdvertisedDevice* BLETrackedDevice::getAdvertisedDevice() {
+	return &m_device;
+} // getAdvertisedDevice
+
+
+/**
+ * @brief Get the address of the device.
+ * @return The address.
+ */
+BLEAddress BLETrackedDevice::getAddress() {
+	return m_device.getAddress();
+} // getAddress
+
+
+/**
+ * @brief Get the moving average of the RSSI of the reports seen.
+ * @return The average RSSI, rounded to the nearest dBm.
+ */
+int BLETrackedDevice::getAverageRSSI() {
+	return (m_rssiAverage - 8) / 16;  // The RSSI is negative; subtracting half rounds rather than truncates.
+} // getAverageRSSI
+
+
+/**
+ * @brief Get when the device was first seen.
+ * @return Milliseconds since boot.
+ */
+uint32_t BLETrackedDevice::getFirstSeen() {
+	return m_firstSeen;
+} // getFirstSeen
+
+
+/**
+ * @brief Get when the device was last seen.
+ * @return Milliseconds since boot.
+ */
+uint32_t BLETrackedDevice::getLastSeen() {
+	return m_lastSeen;
+} // getLastSeen
+
+
+/**
+ * @brief Get the RSSI of the last report.
+ * @return The RSSI in dBm.
+ */
+int BLETrackedDevice::getRSSI() {
+	return m_device.getRSSI();
+} // getRSSI
+
+
+/**
+ * @brief Get how many reports have been seen since the device was first seen.
+ * @return The number of reports.
+ */
+uint32_t BLETrackedDevice::getSeenCount() {
+	return m_seenCount;
+} // getSeenCount
+
+
+void BLEScanStreamCallbacks::onNew(BLETrackedDevice* pDevice) {}
+void BLEScanStreamCallbacks::onUpdated(BLETrackedDevice* pDevice) {}
+void BLEScanStreamCallbacks::onLost(BLETrackedDevice* pDevice) {}
+
+
+/**
+ * @brief Create a stream.  All of the memory it needs is allocated here.
+ * @param [in] pScan The scan that feeds the stream.
+ * @param [in] pCallbacks The callbacks to invoke.
+ * @param [in] capacity The number of devices to follow at most.
+ * @param [in] lostTimeoutMs How long a device may go unseen before it is lost.
+ */
+BLEScanStream::BLEScanStream(BLEScan* pScan, BLEScanStreamCallbacks* pCallbacks, uint16_t capacity, uint32_t lostTimeoutMs)
+		: m_pScan(pScan),
+		  m_pCallbacks(pCallbacks),
+		  m_lostTimeoutMs(lostTimeoutMs),
+		  m_devices(capacity > 0 && capacity < NONE ? capacity : 1),
+		  m_table(m_devices.size()) {
+	m_evicted = 0;
+	clear();
+
+	// Check a few times per timeout so a device is reported lost no later than a quarter past it.
+	TickType_t period = (lostTimeoutMs / 4) / portTICK_PERIOD_MS;
+	m_pTimer = new FreeRTOSTimer((char*)"ScanStream", period > 0 ? period : 1, pdTRUE, this, timerCallback);
+} // BLEScanStream
+
+
+/**
+ * @brief Stop following devices.
+ *
+ * The timer task is waited for, so that no check for lost devices is still running once this returns.
+ * Must not be called from a callback of the stream.
+ */
+BLEScanStream::~BLEScanStream() {
+	// The timer task carries out requests in order and never while a timer callback runs, so once it has
+	// carried out the call pended after the stop, no check is in flight and none will start.
+	m_pTimer->stop();
+	::ulTaskNotifyTake(pdTRUE, 0);   // Drop a notification left over from an earlier wait.
+	::xTimerPendFunctionCall(timerDrained, ::xTaskGetCurrentTaskHandle(), 0, portMAX_DELAY);
+	::ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+	delete m_pTimer;
+} // ~BLEScanStream
+
+
+/**
+ * @brief Forget every device without reporting it lost.
+ */
+void BLEScanStream::clear() {
+	m_mutexLock.lock();
+	m_table.clear();
+	m_front = NONE;
+	m_back  = NONE;
+	m_count = 0;
+	m_free  = 0;
+	for (size_t i = 0; i < m_devices.size(); i++) {
+		m_devices[i].m_next = (i + 1 < m_devices.size()) ? (uint16_t)(i + 1) : NONE;
+	}
+	m_mutexLock.unlock();
+} // clear
+
+
+/**
+ * @brief Get the number of devices being followed.
+ * @return The number of devices.
+ */
+uint16_t BLEScanStream::getCount() {
+	return m_count;
+} // getCount
+
+
+/**
+ * @brief Get the number of devices lost because the pool was full rather than by timing out.
+ * @return The number of devices evicted.
+ */
+uint32_t BLEScanStream::getEvicted() {
+	return m_evicted;
+} // getEvicted
+
+
+/**
+ * @brief Take in a scan report.
+ *
+ * The callbacks are handed copies of the devices, made with the stream locked, and called once it has been
+ * unlocked.
+ *
+ * @param [in] pResult The ESP_GAP_SEARCH_INQ_RES_EVT report.
+ */
+void BLEScanStream::handleResult(esp_ble_gap_cb_param_t::ble_scan_result_evt_param* pResult) {
+	BLEAddress address(pResult->bda);
+	uint64_t   key  = address.toUint64();
+	uint32_t   time = now();
+
+	m_mutexCallbacks.lock();
+	m_mutexLock.lock();
+	BLETrackedDevice* pDevice = m_table.find(key);
+	bool              isNew   = pDevice == nullptr;
+	bool              evicted = false;
+	uint16_t          index;
+
+	if (isNew) {
+		if (m_free == NONE) {  // Make room by losing the device seen least recently.
+			ESP_LOGD(LOG_TAG, "Pool full, evicting %012llx", (unsigned long long) m_devices[m_back].m_key);
+			m_evicted++;
+			m_lost  = m_devices[m_back];
+			evicted = true;
+			lose(m_back);
+		}
+		index    = m_free;
+		pDevice  = &m_devices[index];
+		m_free   = pDevice->m_next;
+		m_count++;
+		pDevice->m_key         = key;
+		pDevice->m_firstSeen   = time;
+		pDevice->m_seenCount   = 0;
+		pDevice->m_rssiAverage = pResult->rssi * 16;
+		pDevice->m_device.setAddress(address);
+		pDevice->m_device.setScan(m_pScan);
+		m_table.insert(key, pDevice);
+	} else {
+		index = pDevice - &m_devices[0];
+		unlink(index);
+		pDevice->m_rssiAverage += (pResult->rssi * 16 - pDevice->m_rssiAverage) / 4;
+	}
+	link(index);
+
+	pDevice->m_lastSeen = time;
+	pDevice->m_seenCount++;
+	pDevice->m_device.setRSSI(pResult->rssi);
+	pDevice->m_device.setAdFlag(pResult->flag);
+	pDevice->m_device.setAddressType(pResult->ble_addr_type);
+	pDevice->m_device.parseAdvertisement(pResult->ble_adv, pResult->adv_data_len + pResult->scan_rsp_len);
+	m_reported = *pDevice;
+	m_mutexLock.unlock();
+
+	if (m_pCallbacks != nullptr) {
+		if (evicted) {
+			m_pCallbacks->onLost(&m_lost);
+		}
+		if (isNew) {
+			m_pCallbacks->onNew(&m_reported);
+		} else {
+			m_pCallbacks->onUpdated(&m_reported);
+		}
+	}
+	m_mutexCallbacks.unlock();
+} // handleResult
+
+
+/**
+ * @brief Start looking for lost devices.  Called when the scan starts.
+ */
+void BLEScanStream::start() {
+	m_pTimer->start();
+} // start
+
+
+/**
+ * @brief Stop looking for lost devices.  Called when the scan stops, since no device is seen then.
+ */
+void BLEScanStream::stop() {
+	m_pTimer->stop();
+} // stop
+
+
+/**
+ * @brief Lose every device not seen for the lost timeout, starting from the one seen least recently.
+ */
+void BLEScanStream::expire() {
+	// This runs in the timer task, which must not block; if a report is being handed out, try next time.
+	if (!m_mutexCallbacks.tryLock()) return;
+	m_mutexLock.lock();
+	uint32_t time = now();
+	while (m_back != NONE && time - m_devices[m_back].m_lastSeen >= m_lostTimeoutMs) {
+		m_lost = m_devices[m_back];
+		lose(m_back);
+		if (m_pCallbacks != nullptr) {
+			m_mutexLock.unlock();
+			m_pCallbacks->onLost(&m_lost);
+			m_mutexLock.lock();
+		}
+	}
+	m_mutexLock.unlock();
+	m_mutexCallbacks.unlock();
+} // expire
+
+
+/**
+ * @brief Put a device at the front of the list of devices in use.
+ */
+void BLEScanStream::link(uint16_t index) {
+	BLETrackedDevice& device = m_devices[index];
+	device.m_prev = NONE;
+	device.m_next = m_front;
+	if (m_front != NONE) {
+		m_devices[m_front].m_prev = index;
+	} else {
+		m_back = index;
+	}
+	m_front = index;
+} // link
+
+
+/**
+ * @brief Return a device to the free list.  The caller reports it lost.
+ */
+void BLEScanStream::lose(uint16_t index) {
+	BLETrackedDevice& device = m_devices[index];
+	unlink(index);
+	m_table.remove(device.m_key);
+	m_count--;
+	device.m_next = m_free;
+	m_free = index;
+} // lose
+
+
+/**
+ * @brief Take a device out of the list of devices in use.
+ */
+void BLEScanStream::unlink(uint16_t index) {
+	BLETrackedDevice& device = m_devices[index];
+	if (device.m_prev != NONE) {
+		m_devices[device.m_prev].m_next = device.m_next;
+	} else {
+		m_front = device.m_next;
+	}
+	if (device.m_next != NONE) {
+		m_devices[device.m_next].m_prev = device.m_prev;
+	} else {
+		m_back = device.m_prev;
+	}
+} // unlink
+
+
+void BLEScanStream::timerCallback(FreeRTOSTimer* pTimer) {
+	((BLEScanStream*) pTimer->getData())->expire();
+} // timerCallback
+
+
+void BLEScanStream::timerDrained(void* pTask, uint32_t) {
+	::xTaskNotifyGive((TaskHandle_t) pTask);
+} // timerDrained
+
+#endif /* CONFIG_BT_ENABLED */
@@ -0,0 +1,129 @@
+/*
+ * BLEScanStream.h
+ */
+
+#ifndef COMPONENTS_CPP_UTILS_BLESCANSTREAM_H_
+#define COMPONENTS_CPP_UTILS_BLESCANSTREAM_H_
+#include "sdkconfig.h"
+#if defined(CONFIG_BT_ENABLED)
+#include <esp_gap_ble_api.h>
+#include <stdint.h>
+#include <vector>
+#include "BLEAddressTable.h"
+#include "BLEAdvertisedDevice.h"
+#include "FreeRTOS.h"
+#include "FreeRTOSTimer.h"
+
+class BLEScan;
+class BLEScanStream;
+
+/**
+ * @brief A device followed by a streaming scan.
+ *
+ * The object handed to a callback is a copy the stream makes for it and reuses for the next callback.
+ * Copy out anything that is needed after the callback returns.
+ */
+class BLETrackedDevice {
+public:
+	BLEAdvertisedDevice* getAdvertisedDevice();
+	BLEAddress           getAddress();
+	int                  getAverageRSSI();
+	uint32_t             getFirstSeen();
+	uint32_t             getLastSeen();
+	int                  getRSSI();
+	uint32_t             getSeenCount();
+
+private:
+	friend class BLEScanStream;
+
+	BLEAdvertisedDevice m_device;
+	uint64_t            m_key;           // BLEAddress::toUint64().
+	int32_t             m_rssiAverage;   // In 1/16 dBm.
+	uint32_t            m_firstSeen;     // Milliseconds since boot.
+	uint32_t            m_lastSeen;      // Milliseconds since boot.
+	uint32_t            m_seenCount;
+	uint16_t            m_prev;          // Towards the most recently seen device.
+	uint16_t            m_next;          // Towards the least recently seen device, or the next free one.
+}; // BLETrackedDevice
+
+
+/**
+ * @brief Callbacks invoked as a streaming scan finds, sees again and loses devices.
+ *
+ * They run in the Bluedroid task, or in the timer task when a device is lost for want of reports, one at a
+ * time.  The stream is not locked while they run, so they may call its methods, but they must not change
+ * the streaming mode of the scan.
+ */
+class BLEScanStreamCallbacks {
+public:
+	virtual ~BLEScanStreamCallbacks() {}
+	/**
+	 * @brief Called when a device not currently followed is seen.
+	 */
+	virtual void onNew(BLETrackedDevice* pDevice);
+	/**
+	 * @brief Called for every further report from a device that is followed.
+	 */
+	virtual void onUpdated(BLETrackedDevice* pDevice);
+	/**
+	 * @brief Called when a device has not been seen for the lost timeout, or is evicted to make room for
+	 * a new one.
+	 */
+	virtual void onLost(BLETrackedDevice* pDevice);
+};
+
+
+/**
+ * @brief Follow the devices seen by a continuous scan in a fixed amount of memory.
+ *
+ * The stream holds a pool of BLETrackedDevice objects, allocated when it is created, and a table from
+ * address to device that never has to grow.  The devices in use are linked in the order they were last
+ * seen.  A report moves its device to the front; a new device when the pool is full takes the place of the
+ * one at the back, which is the one seen least recently.  A timer running while the scan does walks in
+ * from the back to report the devices not seen for the lost timeout.
+ *
+ * For each device the stream keeps the RSSI of the last report, an exponential moving average of the
+ * RSSI weighting each report by a quarter, and when it was first and last seen.
+ */
+class BLEScanStream {
+public:
+	BLEScanStream(BLEScan* pScan, BLEScanStreamCallbacks* pCallbacks, uint16_t capacity, uint32_t lostTimeoutMs);
+	~BLEScanStream();
+
+	void     clear();
+	uint16_t getCount();
+	uint32_t getEvicted();
+	void     handleResult(esp_ble_gap_cb_param_t::ble_scan_result_evt_param* pResult);
+	void     start();
+	void     stop();
+
+private:
+	static const uint16_t NONE = 0xffff;
+
+	BLEScan*                           m_pScan;
+	BLEScanStreamCallbacks*            m_pCallbacks;
+	uint32_t                           m_lostTimeoutMs;
+	std::vector<BLETrackedDevice>      m_devices;
+	BLEAddressTable<BLETrackedDevice>  m_table;
+	uint16_t                           m_front;    // The device seen most recently.
+	uint16_t                           m_back;     // The device seen least recently.
+	uint16_t                           m_free;     // The first unused device.
+	uint16_t                           m_count;
+	uint32_t                           m_evicted;
+	BLETrackedDevice                   m_reported;  // The copy handed to onNew() or onUpdated().
+	BLETrackedDevice                   m_lost;      // The copy handed to onLost().
+	FreeRTOS::Mutex                    m_mutexLock;
+	FreeRTOS::Mutex                    m_mutexCallbacks;   // Held while the copies are in use.
+	FreeRTOSTimer*                     m_pTimer;
+
+	void expire();
+	void link(uint16_t index);
+	void lose(uint16_t index);
+	void unlink(uint16_t index);
+
+	static void timerCallback(FreeRTOSTimer* pTimer);
+	static void timerDrained(void* pTask, uint32_t ulParameter);
+}; // BLEScanStream
+
+#endif /* CONFIG_BT_ENABLED */
+#endif /* COMPONENTS_CPP_UTILS_BLESCANSTREAM_H_ */
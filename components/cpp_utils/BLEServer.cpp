@@ -18,6 +18,7 @@
 #include <string.h>
 #include <string>
 #include <unordered_set>
+#include <vector>
 #if defined(ARDUINO_ARCH_ESP32) && defined(CONFIG_ARDUHAL_ESP_LOG)
 #include "esp32-hal-log.h"
 #define LOG_TAG ""
@@ -75,7 +76,6 @@ BLEService* BLEServer::createService(const char* uuid) {
  */
 BLEService* BLEServer::createService(BLEUUID uuid, uint32_t numHandles, uint8_t inst_id) {
 	ESP_LOGD(LOG_TAG, ">> createService - %s", uuid.toString().c_str());
-	m_semaphoreCreateEvt.take("createService");
 
 	// Check that a service with the supplied UUID does not already exist.
 	if (m_serviceMap.getByUUID(uuid) != nullptr) {
@@ -86,9 +86,13 @@ BLEService* BLEServer::createService(BLEUUID uuid, uint32_t numHandles, uint8_t
 	BLEService* pService = new BLEService(uuid, numHandles);
 	pService->m_instId = inst_id;
 	m_serviceMap.setByUUID(uuid, pService); // Save a reference to this service being on this server.
+#if defined(CONFIG_BLE_GATTS_ATTR_TABLE)
+	pService->m_pServer = this;             // The service is created from an attribute table when it is started.
+#else
+	m_semaphoreCreateEvt.take("createService");
 	pService->executeCreate(this);          // Perform the API calls to actually create the service.
-
 	m_semaphoreCreateEvt.wait("createService");
+#endif
 
 	ESP_LOGD(LOG_TAG, "<< createService");
 	return pService;
@@ -141,6 +145,178 @@ uint16_t BLEServer::getGattsIf() {
 }
 
 
+/**
+ * @brief Send as many queued notifications and indications to a client as the link will take.
+ *
+ * Only one task drains a given queue at a time so values for the same characteristic can never be
+ * reordered.  The lock is released around each send so that the application can keep queueing.  Sending
+ * stops while the link is congested and while an indication is waiting for its confirmation, since a
+ * client will only accept one outstanding indication at a time.
+ *
+ * @param [in] conn_id The connection whose queue should be drained.
+ */
+void BLEServer::drainNotifyQueue(uint16_t conn_id) {
+	BLENotifyQueue::entry_t entry;
+
+	m_mutexNotifyQueue.lock();
+	auto it = m_notifyQueueMap.find(conn_id);
+	if (it == m_notifyQueueMap.end() || it->second->m_draining) {
+		m_mutexNotifyQueue.unlock();
+		return;
+	}
+	BLENotifyQueue* pQueue = it->second;
+	pQueue->m_draining = true;
+	while (!pQueue->isCongested() && pQueue->m_pIndicating == nullptr && pQueue->pop(&entry)) {
+		if (entry.isRecord) {
+			pQueue->popRecords(&entry);  // Fill the notification with as many records as the MTU allows.
+		}
+		// Account for the send before making it; its ESP_GATTS_CONF_EVT may arrive before we retake the lock.
+		if (entry.needConfirm) {
+			pQueue->m_pIndicating = entry.pCharacteristic;
+		} else {
+			pQueue->m_notifyInFlight++;
+		}
+		m_mutexNotifyQueue.unlock();
+		esp_err_t errRc = ::esp_ble_gatts_send_indicate(
+				getGattsIf(), conn_id, entry.handle, entry.value.length(), (uint8_t*)entry.value.data(), entry.needConfirm);
+		m_mutexNotifyQueue.lock();
+
+		// The client may have gone away while we were sending.
+		it = m_notifyQueueMap.find(conn_id);
+		if (it == m_notifyQueueMap.end()) {
+			m_mutexNotifyQueue.unlock();
+			return;
+		}
+		pQueue = it->second;
+		pQueue->m_draining = true;
+		if (errRc != ESP_OK) {
+			ESP_LOGE(LOG_TAG, "esp_ble_gatts_send_indicate: rc=%d %s", errRc, GeneralUtils::errorToString(errRc));
+			if (entry.needConfirm) {
+				pQueue->m_pIndicating = nullptr;
+			} else if (pQueue->m_notifyInFlight > 0) {
+				pQueue->m_notifyInFlight--;
+			}
+			if (!pQueue->pushFront(&entry) && entry.needConfirm) {
+				// No room to retry the indication later; fail it now.
+				bool allDone = --entry.pCharacteristic->m_indicatePending == 0;
+				pQueue->m_draining = false;
+				m_mutexNotifyQueue.unlock();
+				entry.pCharacteristic->indicateCompleted(conn_id, ESP_GATT_NO_RESOURCES, allDone);
+				return;
+			}
+			break;
+		}
+		pQueue->m_stats.sent++;
+		pQueue->recycle(&entry);
+	}
+	pQueue->m_draining = false;
+	m_mutexNotifyQueue.unlock();
+} // drainNotifyQueue
+
+
+/**
+ * @brief Retrieve the counters of the notification queue for a connection.
+ * @param [in] conn_id The connection of interest.
+ * @param [out] pStats The counters.
+ * @return True if the connection is known, false otherwise.
+ */
+bool BLEServer::getNotifyQueueStats(uint16_t conn_id, notify_queue_stats_t* pStats) {
+	bool rc = false;
+	m_mutexNotifyQueue.lock();
+	auto it = m_notifyQueueMap.find(conn_id);
+	if (it != m_notifyQueueMap.end()) {
+		*pStats = it->second->getStats();
+		rc = true;
+	}
+	m_mutexNotifyQueue.unlock();
+	return rc;
+} // getNotifyQueueStats
+
+
+/**
+ * @brief Step through the connected clients without copying the peer map.
+ * A client that connects or disconnects while we step may or may not be visited, but no client is visited twice.
+ * @param [in] first True to find the first client, false to find the one after *pConnId.
+ * @param [in,out] pConnId The connection found.
+ * @param [out] pMTU The MTU of the connection found.
+ * @return True if a client was found.
+ */
+bool BLEServer::getNextPeer(bool first, uint16_t* pConnId, uint16_t* pMTU) {
+	m_mutexNotifyQueue.lock();
+	auto it = first ? m_notifyQueueMap.begin() : m_notifyQueueMap.upper_bound(*pConnId);
+	bool found = it != m_notifyQueueMap.end();
+	if (found) {
+		*pConnId = it->first;
+		*pMTU    = it->second->m_mtu;
+	}
+	m_mutexNotifyQueue.unlock();
+	return found;
+} // getNextPeer
+
+
+/**
+ * @brief Queue a notification or indication for a client and start sending it if the link allows.
+ *
+ * For an indication the characteristic is told the outcome through BLECharacteristic::indicateCompleted()
+ * once the client confirms it, the client disconnects or the value cannot be queued.
+ *
+ * @param [in] conn_id The connection to send on.
+ * @param [in] pCharacteristic The characteristic being notified.
+ * @param [in] pData The value to send.
+ * @param [in] length The length of the value.
+ * @param [in] needConfirm True for an indication, false for a notification.
+ */
+void BLEServer::queueNotification(uint16_t conn_id, BLECharacteristic* pCharacteristic, const uint8_t* pData, size_t length, bool needConfirm) {
+	m_mutexNotifyQueue.lock();
+	auto it = m_notifyQueueMap.find(conn_id);
+	if (it == m_notifyQueueMap.end()) {
+		m_mutexNotifyQueue.unlock();
+		return;
+	}
+	BLENotifyQueue::push_result_t rc = it->second->push(pCharacteristic, pCharacteristic->getHandle(), pData, length, needConfirm);
+	if (needConfirm && rc == BLENotifyQueue::QUEUED) {
+		pCharacteristic->m_indicatePending++;
+	}
+	m_mutexNotifyQueue.unlock();
+
+	if (rc == BLENotifyQueue::REJECTED) {
+		if (needConfirm) {
+			pCharacteristic->indicateCompleted(conn_id, ESP_GATT_NO_RESOURCES, false);
+		}
+		return;
+	}
+	drainNotifyQueue(conn_id);
+} // queueNotification
+
+
+/**
+ * @brief Queue a record for a client and start sending it if the link allows.
+ *
+ * Records waiting for the same characteristic are packed together into one notification when sent.
+ *
+ * @param [in] conn_id The connection to send on.
+ * @param [in] pCharacteristic The characteristic being notified.
+ * @param [in] type The record type.
+ * @param [in] pData The record data.
+ * @param [in] length The length of the record data.
+ * @param [in] isState True if the record replaces a waiting record of the same type.
+ */
+void BLEServer::queueRecord(uint16_t conn_id, BLECharacteristic* pCharacteristic, uint8_t type, const uint8_t* pData, uint8_t length, bool isState) {
+	m_mutexNotifyQueue.lock();
+	auto it = m_notifyQueueMap.find(conn_id);
+	if (it == m_notifyQueueMap.end()) {
+		m_mutexNotifyQueue.unlock();
+		return;
+	}
+	BLENotifyQueue::push_result_t rc = it->second->pushRecord(pCharacteristic, pCharacteristic->getHandle(), type, pData, length, isState);
+	m_mutexNotifyQueue.unlock();
+
+	if (rc != BLENotifyQueue::REJECTED) {
+		drainNotifyQueue(conn_id);
+	}
+} // queueRecord
+
+
 /**
  * @brief Handle a GATT Server Event.
  *
@@ -151,7 +327,7 @@ uint16_t BLEServer::getGattsIf() {
  */
 void BLEServer::handleGATTServerEvent(esp_gatts_cb_event_t event, esp_gatt_if_t gatts_if, esp_ble_gatts_cb_param_t* param) {
 	ESP_LOGD(LOG_TAG, ">> handleGATTServerEvent: %s",
-		BLEUtils::gattServerEventTypeToString(event).c_str());
+		BLEUtils::gattServerEventTypeToString(event));
 
 	switch(event) {
 		// ESP_GATTS_ADD_CHAR_EVT - Indicate that a characteristic was added to the service.
@@ -177,11 +353,18 @@ void BLEServer::handleGATTServerEvent(esp_gatts_cb_event_t event, esp_gatt_if_t
 		case ESP_GATTS_CONNECT_EVT: {
 			m_connId = param->connect.conn_id;
 			addPeerDevice((void*)this, false, m_connId);
+			memcpy(m_connectedServersMap[m_connId].remote_bda, param->connect.remote_bda, sizeof(esp_bd_addr_t));
+			m_mutexNotifyQueue.lock();
+			m_notifyQueueMap[m_connId] = new BLENotifyQueue();
+			m_mutexNotifyQueue.unlock();
 			if (m_pServerCallbacks != nullptr) {
 				m_pServerCallbacks->onConnect(this);
 				m_pServerCallbacks->onConnect(this, param);			
 			}
 			m_connectedCount++;   // Increment the number of connected devices count.	
+			if (m_pAdvertisingManager != nullptr) {
+				m_pAdvertisingManager->handleConnect(m_connectedCount);
+			}
 			break;
 		} // ESP_GATTS_CONNECT_EVT
 
@@ -216,12 +399,98 @@ void BLEServer::handleGATTServerEvent(esp_gatts_cb_event_t event, esp_gatt_if_t
 			if (m_pServerCallbacks != nullptr) {         // If we have callbacks, call now.
 				m_pServerCallbacks->onDisconnect(this);
 			}
-			startAdvertising(); //- do this with some delay from the loop()
+			if (m_pAdvertisingManager != nullptr) {
+				m_pAdvertisingManager->handleDisconnect(m_connectedCount);
+			} else {
+				startAdvertising(); //- do this with some delay from the loop()
+			}
 			removePeerDevice(param->disconnect.conn_id, false);
+			// Indications that were queued or awaiting confirmation on this connection will never complete.
+			std::vector<std::pair<BLECharacteristic*, bool>> failedIndications;
+			m_mutexNotifyQueue.lock();
+			auto it = m_notifyQueueMap.find(param->disconnect.conn_id);
+			if (it != m_notifyQueueMap.end()) {
+				BLENotifyQueue* pQueue = it->second;
+				ESP_LOGD(LOG_TAG, "Notify queue for conn_id %d: %s", it->first, pQueue->toString().c_str());
+				if (pQueue->m_pIndicating != nullptr) {
+					bool allDone = --pQueue->m_pIndicating->m_indicatePending == 0;
+					failedIndications.push_back(std::make_pair(pQueue->m_pIndicating, allDone));
+				}
+				BLENotifyQueue::entry_t entry;
+				while (pQueue->pop(&entry)) {
+					if (entry.needConfirm) {
+						bool allDone = --entry.pCharacteristic->m_indicatePending == 0;
+						failedIndications.push_back(std::make_pair(entry.pCharacteristic, allDone));
+					}
+				}
+				delete pQueue;
+				m_notifyQueueMap.erase(it);
+			}
+			m_mutexNotifyQueue.unlock();
+			for (auto &failed : failedIndications) {
+				failed.first->indicateCompleted(param->disconnect.conn_id, ESP_GATT_ERROR, failed.second);
+			}
 			break;
 		} // ESP_GATTS_DISCONNECT_EVT
 
 
+		// ESP_GATTS_CONGEST_EVT
+		//
+		// congest
+		// - uint16_t conn_id
+		// - bool     congested
+		//
+		// The link to a client has become congested or has cleared.  While congested we hold notifications
+		// in the queue for that connection and resume sending when the congestion clears.
+		case ESP_GATTS_CONGEST_EVT: {
+			ESP_LOGD(LOG_TAG, "Congestion on conn_id %d: %d", param->congest.conn_id, param->congest.congested);
+			m_mutexNotifyQueue.lock();
+			auto it = m_notifyQueueMap.find(param->congest.conn_id);
+			if (it != m_notifyQueueMap.end()) {
+				it->second->setCongested(param->congest.congested);
+			}
+			m_mutexNotifyQueue.unlock();
+			if (!param->congest.congested) {
+				drainNotifyQueue(param->congest.conn_id);
+			}
+			break;
+		} // ESP_GATTS_CONGEST_EVT
+
+
+		// ESP_GATTS_CONF_EVT
+		//
+		// conf
+		// - esp_gatt_status_t status
+		// - uint16_t          conn_id
+		//
+		// A previous notification has left the stack or a client has confirmed an indication.  Either way the
+		// queue for that connection may be able to move again.
+		case ESP_GATTS_CONF_EVT: {
+			BLECharacteristic* pConfirmed = nullptr;
+			bool               allDone    = false;
+			m_mutexNotifyQueue.lock();
+			auto it = m_notifyQueueMap.find(param->conf.conn_id);
+			if (it != m_notifyQueueMap.end()) {
+				BLENotifyQueue* pQueue = it->second;
+				// Notifications are reported immediately and in order, so any outstanding ones account for
+				// this event before a pending indication does.
+				if (pQueue->m_notifyInFlight > 0) {
+					pQueue->m_notifyInFlight--;
+				} else if (pQueue->m_pIndicating != nullptr) {
+					pConfirmed = pQueue->m_pIndicating;
+					pQueue->m_pIndicating = nullptr;
+					allDone = --pConfirmed->m_indicatePending == 0;
+				}
+			}
+			m_mutexNotifyQueue.unlock();
+			if (pConfirmed != nullptr) {
+				pConfirmed->indicateCompleted(param->conf.conn_id, param->conf.status, allDone);
+			}
+			drainNotifyQueue(param->conf.conn_id);
+			break;
+		} // ESP_GATTS_CONF_EVT
+
+
 		// ESP_GATTS_READ_EVT - A request to read the value of a characteristic has arrived.
 		//
 		// read:
@@ -296,6 +565,17 @@ void BLEServer::registerApp(uint16_t m_appId) {
 } // registerApp
 
 
+/**
+ * @brief Hand the control of advertising to an advertising manager.
+ * The manager is told of each connection and disconnection.  Without one, advertising is simply
+ * restarted whenever a client disconnects.
+ * @param [in] pAdvertisingManager The advertising manager.
+ */
+void BLEServer::setAdvertisingManager(BLEAdvertisingManager* pAdvertisingManager) {
+	m_pAdvertisingManager = pAdvertisingManager;
+} // setAdvertisingManager
+
+
 /**
  * @brief Set the server callbacks.
  *
@@ -384,6 +664,13 @@ void BLEServer::updatePeerMTU(uint16_t conn_id, uint16_t mtu) {
 		it->second.mtu = mtu;
 		std::swap(m_connectedServersMap[conn_id], it->second);
 	}
+
+	m_mutexNotifyQueue.lock();
+	auto queueIt = m_notifyQueueMap.find(conn_id);
+	if (queueIt != m_notifyQueueMap.end()) {
+		queueIt->second->setMTU(mtu);
+	}
+	m_mutexNotifyQueue.unlock();
 }
 
 std::map<uint16_t, conn_status_t> BLEServer::getPeerDevices(bool _client) {
@@ -423,6 +710,68 @@ void BLEServer::updateConnParams(esp_bd_addr_t remote_bda, uint16_t minInterval,
 	esp_ble_gap_update_conn_params(&conn_params); 
 }
 
+/**
+ * @brief Ask for new connection parameters for a connected client.
+ * The parameters granted are reported by ESP_GAP_BLE_UPDATE_CONN_PARAMS_EVT and recorded in the
+ * conn_status_t of the connection.
+ * @param [in] conn_id The connection.
+ * @param [in] minInterval The minimum connection interval in units of 1.25ms.
+ * @param [in] maxInterval The maximum connection interval in units of 1.25ms.
+ * @param [in] latency The number of connection events the client may skip.
+ * @param [in] timeout The supervision timeout in units of 10ms.
+ * @return True if the request was made, false if the connection is not known.
+ */
+bool BLEServer::updateConnParams(uint16_t conn_id, uint16_t minInterval, uint16_t maxInterval, uint16_t latency, uint16_t timeout) {
+	auto it = m_connectedServersMap.find(conn_id);
+	if (it == m_connectedServersMap.end()) {
+		return false;
+	}
+	updateConnParams(it->second.remote_bda, minInterval, maxInterval, latency, timeout);
+	return true;
+} // updateConnParams
+
+
+/**
+ * @brief Handle a GAP event.
+ * Records the connection parameters actually granted for each connection.
+ * @param [in] event The type of event.
+ * @param [in] param The event parameters.
+ */
+void BLEServer::handleGAPEvent(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param_t* param) {
+	switch (event) {
+		// ESP_GAP_BLE_UPDATE_CONN_PARAMS_EVT
+		//
+		// update_conn_params:
+		// - esp_bt_status_t status
+		// - esp_bd_addr_t   bda
+		// - uint16_t        min_int
+		// - uint16_t        max_int
+		// - uint16_t        latency
+		// - uint16_t        conn_int
+		// - uint16_t        timeout
+		case ESP_GAP_BLE_UPDATE_CONN_PARAMS_EVT: {
+			if (param->update_conn_params.status != ESP_BT_STATUS_SUCCESS) {
+				break;
+			}
+			for (auto &myPair : m_connectedServersMap) {
+				if (memcmp(myPair.second.remote_bda, param->update_conn_params.bda, sizeof(esp_bd_addr_t)) == 0) {
+					myPair.second.conn_interval = param->update_conn_params.conn_int;
+					myPair.second.conn_latency  = param->update_conn_params.latency;
+					myPair.second.conn_timeout  = param->update_conn_params.timeout;
+					ESP_LOGD(LOG_TAG, "conn_id %d: interval: %d, latency: %d, timeout: %d", myPair.first,
+						myPair.second.conn_interval, myPair.second.conn_latency, myPair.second.conn_timeout);
+					break;
+				}
+			}
+			break;
+		} // ESP_GAP_BLE_UPDATE_CONN_PARAMS_EVT
+
+		default:
+			break;
+	} // switch
+} // handleGAPEvent
+
+
 void BLEServer::disconnect(uint16_t connId){
 	esp_ble_gatts_close(m_gatts_if, connId);
 }
@@ -16,12 +16,15 @@
 // #include "BLEDevice.h"
 
 #include "BLEUUID.h"
+#include "BLEAttributeRegistry.h"
 #include "BLEAdvertising.h"
 #include "BLECharacteristic.h"
 #include "BLEService.h"
 #include "BLESecurity.h"
 #include "FreeRTOS.h"
 #include "BLEAddress.h"
+#include "BLENotifyQueue.h"
+#include "BLEAdvertisingManager.h"
 
 class BLEServerCallbacks;
 /* TODO possibly refactor this struct */ 
@@ -29,6 +32,10 @@ typedef struct {
 	void *peer_device;		// peer device BLEClient or BLEServer - maybe its better to have 2 structures or union here
 	bool connected;			// do we need it?
 	uint16_t mtu;			// every peer device negotiate own mtu
+	esp_bd_addr_t remote_bda;
+	uint16_t conn_interval;	// connection parameters granted, in the units of esp_ble_conn_update_params_t; 0 until known
+	uint16_t conn_latency;
+	uint16_t conn_timeout;
 } conn_status_t;
 
 
@@ -45,15 +52,13 @@ public:
 	void        setByUUID(const char* uuid, BLEService* service);
 	void        setByUUID(BLEUUID uuid, BLEService* service);
 	std::string toString();
-	BLEService* getFirst();
-	BLEService* getNext();
+	BLEAttributeRegistry<BLEService>::const_iterator begin() const;
+	BLEAttributeRegistry<BLEService>::const_iterator end() const;
 	void 		removeService(BLEService *service);
 	int 		getRegisteredServiceCount();
 
 private:
-	std::map<uint16_t, BLEService*>    m_handleMap;
-	std::map<BLEService*, std::string> m_uuidMap;
-	std::map<BLEService*, std::string>::iterator m_iterator;
+	BLEAttributeRegistry<BLEService> m_registry;
 };
 
 
@@ -66,6 +71,7 @@ public:
 	BLEService*     createService(const char* uuid);	
 	BLEService*     createService(BLEUUID uuid, uint32_t numHandles=15, uint8_t inst_id=0);
 	BLEAdvertising* getAdvertising();
+	void            setAdvertisingManager(BLEAdvertisingManager* pAdvertisingManager);
 	void            setCallbacks(BLEServerCallbacks* pCallbacks);
 	void            startAdvertising();
 	void 			removeService(BLEService* service);
@@ -75,6 +81,7 @@ public:
 	void 			disconnect(uint16_t connId);
 	uint16_t		m_appId;
 	void			updateConnParams(esp_bd_addr_t remote_bda, uint16_t minInterval, uint16_t maxInterval, uint16_t latency, uint16_t timeout);
+	bool			updateConnParams(uint16_t conn_id, uint16_t minInterval, uint16_t maxInterval, uint16_t latency, uint16_t timeout);
 
 	/* multi connection support */
 	std::map<uint16_t, conn_status_t> getPeerDevices(bool client);
@@ -84,6 +91,7 @@ public:
 	void updatePeerMTU(uint16_t connId, uint16_t mtu);
 	uint16_t getPeerMTU(uint16_t conn_id);
 	uint16_t        getConnId();
+	bool            getNotifyQueueStats(uint16_t conn_id, notify_queue_stats_t* pStats);
 
 
 private:
@@ -101,12 +109,20 @@ private:
 	FreeRTOS::Semaphore m_semaphoreRegisterAppEvt 	= FreeRTOS::Semaphore("RegisterAppEvt");
 	FreeRTOS::Semaphore m_semaphoreCreateEvt 		= FreeRTOS::Semaphore("CreateEvt");
 	FreeRTOS::Semaphore m_semaphoreOpenEvt   		= FreeRTOS::Semaphore("OpenEvt");
+	FreeRTOS::Mutex     m_mutexNotifyQueue;
 	BLEServiceMap       m_serviceMap;
 	BLEServerCallbacks* m_pServerCallbacks = nullptr;
+	BLEAdvertisingManager* m_pAdvertisingManager = nullptr;
+	std::map<uint16_t, BLENotifyQueue*> m_notifyQueueMap;
 
 	void            createApp(uint16_t appId);
+	void            drainNotifyQueue(uint16_t conn_id);
 	uint16_t        getGattsIf();
+	bool            getNextPeer(bool first, uint16_t* pConnId, uint16_t* pMTU);
+	void            handleGAPEvent(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param_t* param);
 	void            handleGATTServerEvent(esp_gatts_cb_event_t event, esp_gatt_if_t gatts_if, esp_ble_gatts_cb_param_t *param);
+	void            queueNotification(uint16_t conn_id, BLECharacteristic* pCharacteristic, const uint8_t* pData, size_t length, bool needConfirm);
+	void            queueRecord(uint16_t conn_id, BLECharacteristic* pCharacteristic, uint8_t type, const uint8_t* pData, uint8_t length, bool isState);
 	void            registerApp(uint16_t);
 }; // BLEServer
 
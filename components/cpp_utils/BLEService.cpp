@@ -53,6 +53,7 @@ BLEService::BLEService(BLEUUID uuid, uint16_t numHandles) {
 	//m_serializeMutex.setName("BLEService");
 	m_lastCreatedCharacteristic = nullptr;
 	m_numHandles = numHandles;
+	m_attrTableSize = 0;
 } // BLEService
 
 
@@ -84,6 +85,56 @@ void BLEService::executeCreate(BLEServer* pServer) {
 } // executeCreate
 
 
+/**
+ * @brief Create the service, its characteristics and their descriptors in a single request.
+ *
+ * Rather than one esp_ble_gatts_create_service() / esp_ble_gatts_add_char() / esp_ble_gatts_add_char_descr()
+ * round trip per attribute, we describe the whole service in an attribute table and hand it to
+ * esp_ble_gatts_create_attr_tab().  The handles come back together in ESP_GATTS_CREAT_ATTR_TAB_EVT and
+ * are mapped back onto the objects in the order the table was built.
+ * @return N/A.
+ */
+void BLEService::executeCreateAttrTable() {
+	static uint16_t primaryServiceUUID = ESP_GATT_UUID_PRI_SERVICE;
+
+	ESP_LOGD(LOG_TAG, ">> executeCreateAttrTable() - Creating service (esp_ble_gatts_create_attr_tab) service uuid: %s", getUUID().toString().c_str());
+
+	std::vector<esp_gatts_attr_db_t> attrTable;
+	esp_bt_uuid_t* pUUID = m_uuid.getNative();
+	esp_gatts_attr_db_t attr;
+	attr.attr_control.auto_rsp = ESP_GATT_AUTO_RSP;
+	attr.att_desc.uuid_length  = ESP_UUID_LEN_16;
+	attr.att_desc.uuid_p       = (uint8_t*)&primaryServiceUUID;
+	attr.att_desc.perm         = ESP_GATT_PERM_READ;
+	attr.att_desc.max_length   = pUUID->len;
+	attr.att_desc.length       = pUUID->len;
+	attr.att_desc.value        = (uint8_t*)&pUUID->uuid;
+	attrTable.push_back(attr);
+
+	for (auto pCharacteristic : m_characteristicMap) {
+		pCharacteristic->appendAttrTable(this, &attrTable);
+	}
+
+	if (attrTable.size() > ESP_GATT_ATTR_HANDLE_MAX) {
+		ESP_LOGE(LOG_TAG, "<< executeCreateAttrTable: %u attributes is more than the %d a table can hold", (unsigned) attrTable.size(), ESP_GATT_ATTR_HANDLE_MAX);
+		return;
+	}
+
+	m_semaphoreCreateEvt.take("executeCreateAttrTable"); // Take the mutex and release at event ESP_GATTS_CREAT_ATTR_TAB_EVT
+	m_attrTableSize = attrTable.size();
+	esp_err_t errRc = ::esp_ble_gatts_create_attr_tab(attrTable.data(), getServer()->getGattsIf(), attrTable.size(), m_instId);
+	if (errRc != ESP_OK) {
+		ESP_LOGE(LOG_TAG, "esp_ble_gatts_create_attr_tab: rc=%d %s", errRc, GeneralUtils::errorToString(errRc));
+		m_attrTableSize = 0;
+		m_semaphoreCreateEvt.give();
+		return;
+	}
+
+	m_semaphoreCreateEvt.wait("executeCreateAttrTable");  // The table must stay alive until the stack has read it.
+	ESP_LOGD(LOG_TAG, "<< executeCreateAttrTable");
+} // executeCreateAttrTable
+
+
 /**
  * @brief Delete the service.
  * Delete the service.
@@ -139,19 +190,23 @@ void BLEService::start() {
 // obtained as a result of calling esp_ble_gatts_create_service().
 //
 	ESP_LOGD(LOG_TAG, ">> start(): Starting service (esp_ble_gatts_start_service): %s", toString().c_str());
+#if defined(CONFIG_BLE_GATTS_ATTR_TABLE)
+	// The service was not created by BLEServer::createService(); create it now along with everything in it.
+	if (m_handle == NULL_HANDLE) {
+		executeCreateAttrTable();
+	}
+#endif
 	if (m_handle == NULL_HANDLE) {
 		ESP_LOGE(LOG_TAG, "<< !!! We attempted to start a service but don't know its handle!");
 		return;
 	}
 
-	BLECharacteristic *pCharacteristic = m_characteristicMap.getFirst();
-
-	while (pCharacteristic != nullptr) {
+#if !defined(CONFIG_BLE_GATTS_ATTR_TABLE)
+	for (auto pCharacteristic : m_characteristicMap) {
 		m_lastCreatedCharacteristic = pCharacteristic;
 		pCharacteristic->executeCreate(this);
-
-		pCharacteristic = m_characteristicMap.getNext();
 	}
+#endif
 	// Start each of the characteristics ... these are found in the m_characteristicMap.
 
 	m_semaphoreStartEvt.take("start");
@@ -347,6 +402,41 @@ void BLEService::handleGATTServerEvent(esp_gatts_cb_event_t event, esp_gatt_if_t
 		} // ESP_GATTS_CREATE_EVT
 
 
+		// ESP_GATTS_CREAT_ATTR_TAB_EVT
+		// Called when an attribute table passed to esp_ble_gatts_create_attr_tab() has been created.
+		//
+		// add_attr_tab:
+		// * esp_gatt_status_t status
+		// * esp_bt_uuid_t     svc_uuid
+		// * uint8_t           svc_inst_id
+		// * uint16_t          num_handle
+		// * uint16_t*         handles
+		//
+		// The handles are in the order of the table: the service, then for each characteristic its
+		// declaration, its value and its descriptors.
+		case ESP_GATTS_CREAT_ATTR_TAB_EVT: {
+			if (m_attrTableSize == 0 || !getUUID().equals(BLEUUID(param->add_attr_tab.svc_uuid)) || m_instId != param->add_attr_tab.svc_inst_id) {
+				break;
+			}
+			if (param->add_attr_tab.status != ESP_GATT_OK || param->add_attr_tab.num_handle != m_attrTableSize) {
+				ESP_LOGE(LOG_TAG, "Attribute table creation failed: status=%d, handles=%d, expected=%d",
+					param->add_attr_tab.status, param->add_attr_tab.num_handle, m_attrTableSize);
+			} else {
+				uint16_t* pHandles = param->add_attr_tab.handles;
+				setHandle(pHandles[0]);
+				getServer()->m_serviceMap.setByHandle(pHandles[0], this);
+				uint16_t index = 1;
+				for (auto pCharacteristic : m_characteristicMap) {
+					index += pCharacteristic->setAttrTableHandles(&pHandles[index]);
+					m_characteristicMap.setByHandle(pCharacteristic->getHandle(), pCharacteristic);
+				}
+			}
+			m_attrTableSize = 0;
+			m_semaphoreCreateEvt.give();
+			break;
+		} // ESP_GATTS_CREAT_ATTR_TAB_EVT
+
+
 		// ESP_GATTS_DELETE_EVT
 		// Called when a service is deleted.
 		//
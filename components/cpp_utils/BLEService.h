@@ -11,7 +11,9 @@
 #if defined(CONFIG_BT_ENABLED)
 
 #include <esp_gatts_api.h>
+#include <vector>
 
+#include "BLEAttributeRegistry.h"
 #include "BLECharacteristic.h"
 #include "BLEServer.h"
 #include "BLEUUID.h"
@@ -30,15 +32,13 @@ public:
 	BLECharacteristic* getByUUID(const char* uuid);	
 	BLECharacteristic* getByUUID(BLEUUID uuid);
 	BLECharacteristic* getByHandle(uint16_t handle);
-	BLECharacteristic* getFirst();
-	BLECharacteristic* getNext();
+	BLEAttributeRegistry<BLECharacteristic>::const_iterator begin() const;
+	BLEAttributeRegistry<BLECharacteristic>::const_iterator end() const;
 	std::string toString();
 	void handleGATTServerEvent(esp_gatts_cb_event_t event, esp_gatt_if_t gatts_if, esp_ble_gatts_cb_param_t* param);
 
 private:
-	std::map<BLECharacteristic*, std::string> m_uuidMap;
-	std::map<uint16_t, BLECharacteristic*> m_handleMap;
-	std::map<BLECharacteristic*, std::string>::iterator m_iterator;
+	BLEAttributeRegistry<BLECharacteristic> m_registry;
 };
 
 
@@ -85,7 +85,9 @@ private:
 	FreeRTOS::Semaphore  m_semaphoreStopEvt   = FreeRTOS::Semaphore("StopEvt");
 
 	uint16_t             m_numHandles;
+	uint16_t             m_attrTableSize;  // Number of attributes in a table being created, 0 if none.
 
+	void               executeCreateAttrTable();
 	BLECharacteristic* getLastCreatedCharacteristic();
 	void handleGATTServerEvent(esp_gatts_cb_event_t event, esp_gatt_if_t gatts_if, esp_ble_gatts_cb_param_t* param);
 	void               setHandle(uint16_t handle);
@@ -26,23 +26,17 @@ BLEService* BLEServiceMap::getByUUID(const char* uuid) {
  * @return The characteristic.
  */
 BLEService* BLEServiceMap::getByUUID(BLEUUID uuid, uint8_t inst_id) {
-	for (auto &myPair : m_uuidMap) {
-		if (myPair.first->getUUID().equals(uuid)) {
-			return myPair.first;
-		}
-	}
-	//return m_uuidMap.at(uuid.toString());
-	return nullptr;
+	return m_registry.getByUUID(uuid);
 } // getByUUID
 
 
 /**
  * @brief Return the service by handle.
  * @param [in] handle The handle to look up the service.
- * @return The service.
+ * @return The service or nullptr if no service has the handle.
  */
 BLEService* BLEServiceMap::getByHandle(uint16_t handle) {
-	return m_handleMap.at(handle);
+	return m_registry.getByHandle(handle);
 } // getByHandle
 
 
@@ -53,7 +47,7 @@ BLEService* BLEServiceMap::getByHandle(uint16_t handle) {
  * @return N/A.
  */
 void BLEServiceMap::setByUUID(BLEUUID uuid, BLEService* service) {
-	m_uuidMap.insert(std::pair<BLEService*, std::string>(service, uuid.toString()));
+	m_registry.add(service, uuid);
 } // setByUUID
 
 
@@ -64,7 +58,7 @@ void BLEServiceMap::setByUUID(BLEUUID uuid, BLEService* service) {
  * @return N/A.
  */
 void BLEServiceMap::setByHandle(uint16_t handle, BLEService* service) {
-	m_handleMap.insert(std::pair<uint16_t, BLEService*>(handle, service));
+	m_registry.setHandle(handle, service);
 } // setByHandle
 
 
@@ -75,8 +69,8 @@ void BLEServiceMap::setByHandle(uint16_t handle, BLEService* service) {
 std::string BLEServiceMap::toString() {
 	std::stringstream stringStream;
 	stringStream << std::hex << std::setfill('0');
-	for (auto &myPair: m_handleMap) {
-		stringStream << "handle: 0x" << std::setw(2) << myPair.first << ", uuid: " + myPair.second->getUUID().toString() << "\n";
+	for (auto pService : m_registry) {
+		stringStream << "handle: 0x" << std::setw(2) << pService->getHandle() << ", uuid: " + pService->getUUID().toString() << "\n";
 	}
 	return stringStream.str();
 } // toString
@@ -86,41 +80,34 @@ void BLEServiceMap::handleGATTServerEvent(
 		esp_gatt_if_t             gatts_if,
 		esp_ble_gatts_cb_param_t* param) {
 	// Invoke the handler for every Service we have.
-	for (auto &myPair : m_uuidMap) {
-		myPair.first->handleGATTServerEvent(event, gatts_if, param);
+	for (auto pService : m_registry) {
+		pService->handleGATTServerEvent(event, gatts_if, param);
 	}
 }
 
 /**
- * @brief Get the first service in the map.
- * @return The first service in the map.
+ * @brief Get an iterator to the first service in the map, in the order they were added.
+ * @return The iterator.
  */
-BLEService* BLEServiceMap::getFirst() {
-	m_iterator = m_uuidMap.begin();
-	if (m_iterator == m_uuidMap.end()) return nullptr;
-	BLEService* pRet = m_iterator->first;
-	m_iterator++;
-	return pRet;
-} // getFirst
+BLEAttributeRegistry<BLEService>::const_iterator BLEServiceMap::begin() const {
+	return m_registry.begin();
+} // begin
+
 
 /**
- * @brief Get the next service in the map.
- * @return The next service in the map.
+ * @brief Get an iterator past the last service in the map.
+ * @return The iterator.
  */
-BLEService* BLEServiceMap::getNext() {
-	if (m_iterator == m_uuidMap.end()) return nullptr;
-	BLEService* pRet = m_iterator->first;
-	m_iterator++;
-	return pRet;
-} // getNext
+BLEAttributeRegistry<BLEService>::const_iterator BLEServiceMap::end() const {
+	return m_registry.end();
+} // end
 
 /**
  * @brief Removes service from maps.
  * @return N/A.
  */
 void BLEServiceMap::removeService(BLEService* service) {
-	m_handleMap.erase(service->getHandle());
-	m_uuidMap.erase(service);
+	m_registry.remove(service);
 } // removeService
 
 /**
@@ -128,7 +115,7 @@ void BLEServiceMap::removeService(BLEService* service) {
  * @return amount of registered services
  */
 int BLEServiceMap::getRegisteredServiceCount(){
-	return m_handleMap.size();
+	return m_registry.getHandleCount();
 }
 
 #endif /* CONFIG_BT_ENABLED */
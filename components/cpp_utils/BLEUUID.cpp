@@ -124,9 +124,43 @@ BLEUUID::BLEUUID(std::string value) {
 		ESP_LOGE(LOG_TAG, "ERROR: UUID value not 2, 4, 16 or 36 bytes");
 		m_valueSet = false;
 	}
+	setCanonical();
 } //BLEUUID(std::string)
 
 
+/**
+ * @brief Reached only when a BLEUUIDLiteral is built, outside a constant expression, from bad text.
+ * @return 0.
+ */
+int BLEUUIDLiteral::invalidUUID() {
+	ESP_LOGE(LOG_TAG, "ERROR: UUID literal is not 4, 8 or 36 hex characters");
+	return 0;
+} // invalidUUID
+
+
+/**
+ * @brief Create a UUID from one parsed at compile time.
+ *
+ * @param [in] uuid The parsed UUID.
+ */
+BLEUUID::BLEUUID(const BLEUUIDLiteral& uuid) {
+	m_uuid.len = uuid.m_len;
+	if (uuid.m_len == ESP_UUID_LEN_16) {
+		m_uuid.uuid.uuid16 = (uuid.m_hi >> 32) & 0xffff;
+	} else if (uuid.m_len == ESP_UUID_LEN_32) {
+		m_uuid.uuid.uuid32 = uuid.m_hi >> 32;
+	} else {
+		for (int i = 0; i < 8; i++) {   // The native form is least significant byte first.
+			m_uuid.uuid.uuid128[i]     = uuid.m_lo >> (8 * i);
+			m_uuid.uuid.uuid128[i + 8] = uuid.m_hi >> (8 * i);
+		}
+	}
+	m_valueSet = uuid.m_len != 0;
+	m_hi       = uuid.m_hi;
+	m_lo       = uuid.m_lo;
+} // BLEUUID
+
+
 /**
  * @brief Create a UUID from 16 bytes of memory.
  *
@@ -146,6 +180,7 @@ BLEUUID::BLEUUID(uint8_t* pData, size_t size, bool msbFirst) {
 		memcpy(m_uuid.uuid.uuid128, pData, 16);
 	}
 	m_valueSet = true;
+	setCanonical();
 } // BLEUUID
 
 
@@ -158,6 +193,7 @@ BLEUUID::BLEUUID(uint16_t uuid) {
 	m_uuid.len         = ESP_UUID_LEN_16;
 	m_uuid.uuid.uuid16 = uuid;
 	m_valueSet         = true;
+	setCanonical();
 } // BLEUUID
 
 
@@ -170,6 +206,7 @@ BLEUUID::BLEUUID(uint32_t uuid) {
 	m_uuid.len         = ESP_UUID_LEN_32;
 	m_uuid.uuid.uuid32 = uuid;
 	m_valueSet         = true;
+	setCanonical();
 } // BLEUUID
 
 
@@ -181,6 +218,7 @@ BLEUUID::BLEUUID(uint32_t uuid) {
 BLEUUID::BLEUUID(esp_bt_uuid_t uuid) {
 	m_uuid     = uuid;
 	m_valueSet = true;
+	setCanonical();
 } // BLEUUID
 
 
@@ -221,27 +259,58 @@ uint8_t BLEUUID::bitSize() {
 /**
  * @brief Compare a UUID against this UUID.
  *
+ * UUIDs of different lengths are equal if they stand for the same 128 bit UUID.
+ *
  * @param [in] uuid The UUID to compare against.
  * @return True if the UUIDs are equal and false otherwise.
  */
-bool BLEUUID::equals(BLEUUID uuid) {
-	//ESP_LOGD(TAG, "Comparing: %s to %s", toString().c_str(), uuid.toString().c_str());
+bool BLEUUID::equals(const BLEUUID& uuid) const {
 	if (!m_valueSet || !uuid.m_valueSet) return false;
+	return m_hi == uuid.m_hi && m_lo == uuid.m_lo;
+} // equals
 
-	if (uuid.m_uuid.len != m_uuid.len) {
-		return uuid.toString() == toString();
-	}
 
-	if (uuid.m_uuid.len == ESP_UUID_LEN_16) {
-		return uuid.m_uuid.uuid.uuid16 == m_uuid.uuid.uuid16;
-	}
+/**
+ * @brief Get a hash of the UUID, suitable for a hash table.
+ * UUIDs that are equal have the same hash whatever their length.
+ * @return The hash.
+ */
+size_t BLEUUID::hash() const {
+	uint64_t h = m_hi ^ (m_lo * 0x9e3779b97f4a7c15ULL);
+	h ^= h >> 29;
+	return (size_t)(h ^ (h >> 32));
+} // hash
 
-	if (uuid.m_uuid.len == ESP_UUID_LEN_32) {
-		return uuid.m_uuid.uuid.uuid32 == m_uuid.uuid.uuid32;
-	}
 
-	return memcmp(uuid.m_uuid.uuid.uuid128, m_uuid.uuid.uuid128, 16) == 0;
-} // equals
+/**
+ * @brief Work out the 128 bit form of the UUID used for comparison and hashing.
+ * 16 and 32 bit UUIDs are placed in the Bluetooth base UUID 00000000-0000-1000-8000-00805f9b34fb.
+ */
+void BLEUUID::setCanonical() {
+	if (!m_valueSet) {
+		m_hi = 0;
+		m_lo = 0;
+		return;
+	}
+	switch (m_uuid.len) {
+		case ESP_UUID_LEN_16:
+			m_hi = ((uint64_t)m_uuid.uuid.uuid16 << 32) | 0x1000;
+			m_lo = 0x800000805f9b34fbULL;
+			break;
+		case ESP_UUID_LEN_32:
+			m_hi = ((uint64_t)m_uuid.uuid.uuid32 << 32) | 0x1000;
+			m_lo = 0x800000805f9b34fbULL;
+			break;
+		default:
+			m_hi = 0;
+			m_lo = 0;
+			for (int i = 7; i >= 0; i--) {   // The native form is least significant byte first.
+				m_hi = (m_hi << 8) | m_uuid.uuid.uuid128[i + 8];
+				m_lo = (m_lo << 8) | m_uuid.uuid.uuid128[i];
+			}
+			break;
+	}
+} // setCanonical
 
 
 /**
@@ -356,52 +425,54 @@ BLEUUID BLEUUID::to128() {
  * @return A string representation of the UUID.
  */
 std::string BLEUUID::toString() {
-	if (!m_valueSet) return "<NULL>";   // If we have no value, nothing to format.
-
-	// If the UUIDs are 16 or 32 bit, pad correctly.
-	std::stringstream ss;
-
-	if (m_uuid.len == ESP_UUID_LEN_16) {  // If the UUID is 16bit, pad correctly.
-		ss << "0000" <<
-			std::hex <<
-			std::setfill('0') <<
-			std::setw(4) <<
-			m_uuid.uuid.uuid16 <<
-			"-0000-1000-8000-00805f9b34fb";
-		return ss.str();                    // Return the string
-	} // End 16bit UUID
-
-	if (m_uuid.len == ESP_UUID_LEN_32) {  // If the UUID is 32bit, pad correctly.
-		ss << std::hex <<
-			std::setfill('0') <<
-			std::setw(8) <<
-			m_uuid.uuid.uuid32 <<
-			"-0000-1000-8000-00805f9b34fb";
-		return ss.str();                    // return the string
-	} // End 32bit UUID
-
-	// The UUID is not 16bit or 32bit which means that it is 128bit.
-	//
+	char buffer[STRING_SIZE];
+	return std::string(toString(buffer));
+} // toString
+
+
+/**
+ * @brief Format the UUID into a buffer supplied by the caller, without allocating.
+ *
+ * The format is that of toString().  16 and 32 bit UUIDs are written in their 128 bit form.
+ *
+ * @param [out] buffer A buffer of at least STRING_SIZE characters.
+ * @return The buffer.
+ */
+char* BLEUUID::toString(char* buffer) {
+	static const char hexDigits[] = "0123456789abcdef";
+	static const uint8_t baseUUID[16] = {   // 00000000-0000-1000-8000-00805f9b34fb, least significant byte first.
+		0xfb, 0x34, 0x9b, 0x5f, 0x80, 0x00, 0x00, 0x80, 0x00, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+	};
+
+	if (!m_valueSet) {
+		strcpy(buffer, "<NULL>");   // If we have no value, nothing to format.
+		return buffer;
+	}
+
+	const uint8_t* pBytes = m_uuid.uuid.uuid128;
+	uint8_t        bytes[16];
+	if (m_uuid.len != ESP_UUID_LEN_128) {
+		uint32_t value = (m_uuid.len == ESP_UUID_LEN_16) ? m_uuid.uuid.uuid16 : m_uuid.uuid.uuid32;
+		memcpy(bytes, baseUUID, 16);
+		bytes[12] = value;
+		bytes[13] = value >> 8;
+		bytes[14] = value >> 16;
+		bytes[15] = value >> 24;
+		pBytes = bytes;
+	}
+
 	// UUID string format:
 	// AABBCCDD-EEFF-GGHH-IIJJ-KKLLMMNNOOPP
-	ss << std::hex << std::setfill('0') <<
-		std::setw(2) << (int) m_uuid.uuid.uuid128[15] <<
-		std::setw(2) << (int) m_uuid.uuid.uuid128[14] <<
-		std::setw(2) << (int) m_uuid.uuid.uuid128[13] <<
-		std::setw(2) << (int) m_uuid.uuid.uuid128[12] << "-" <<
-		std::setw(2) << (int) m_uuid.uuid.uuid128[11] <<
-		std::setw(2) << (int) m_uuid.uuid.uuid128[10] << "-" <<
-		std::setw(2) << (int) m_uuid.uuid.uuid128[9]  <<
-		std::setw(2) << (int) m_uuid.uuid.uuid128[8]  << "-" <<
-		std::setw(2) << (int) m_uuid.uuid.uuid128[7]  <<
-		std::setw(2) << (int) m_uuid.uuid.uuid128[6]  << "-" <<
-		std::setw(2) << (int) m_uuid.uuid.uuid128[5]  <<
-		std::setw(2) << (int) m_uuid.uuid.uuid128[4]  <<
-		std::setw(2) << (int) m_uuid.uuid.uuid128[3]  <<
-		std::setw(2) << (int) m_uuid.uuid.uuid128[2]  <<
-		std::setw(2) << (int) m_uuid.uuid.uuid128[1]  <<
-		std::setw(2) << (int) m_uuid.uuid.uuid128[0];
-	return ss.str();
+	char* p = buffer;
+	for (int i = 15; i >= 0; i--) {
+		*p++ = hexDigits[pBytes[i] >> 4];
+		*p++ = hexDigits[pBytes[i] & 0x0f];
+		if (i == 12 || i == 10 || i == 8 || i == 6) {
+			*p++ = '-';
+		}
+	}
+	*p = '\0';
+	return buffer;
 } // toString
 
 #endif /* CONFIG_BT_ENABLED */
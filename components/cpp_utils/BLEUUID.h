@@ -10,14 +10,82 @@
 #include "sdkconfig.h"
 #if defined(CONFIG_BT_ENABLED)
 #include <esp_gatt_defs.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <string>
+#include <functional>
+
+/**
+ * @brief A UUID parsed from a string literal at compile time.
+ *
+ * The text may be a 16 bit ("2902"), 32 bit ("0000180d") or 128 bit
+ * ("beb5483e-36e1-4688-b7f5-ea07361b26a8") UUID in hex.  The value is held in its canonical 128 bit form
+ * as two 64 bit halves, most significant first.  A literal that is not a valid UUID fails to compile when
+ * used in a constant expression:
+ *
+ * @code{.cpp}
+ * constexpr BLEUUIDLiteral SERVICE_UUID("4fafc201-1fb5-459e-8fcc-c5c9c331914b");
+ * BLEService* pService = pServer->createService(SERVICE_UUID);
+ * @endcode
+ */
+class BLEUUIDLiteral {
+public:
+	template<size_t N>
+	constexpr BLEUUIDLiteral(const char (&text)[N]) :
+		m_len(checkFormat(text, N - 1)),
+		m_hi(N - 1 == 36 ? nibbles(text, 0, 16, 0) : (shortValue(text, N - 1) << 32) | 0x1000),
+		m_lo(N - 1 == 36 ? nibbles(text, 16, 16, 0) : 0x800000805f9b34fbULL) {
+	}
+
+	uint8_t  m_len;  // ESP_UUID_LEN_16, ESP_UUID_LEN_32 or ESP_UUID_LEN_128.
+	uint64_t m_hi;
+	uint64_t m_lo;
+
+private:
+	static int invalidUUID();  // Not constexpr: reaching it in a constant expression is a compile error.
+
+	static constexpr uint64_t hexDigit(char c) {
+		return c >= '0' && c <= '9' ? (uint64_t)(c - '0') :
+			c >= 'a' && c <= 'f' ? (uint64_t)(c - 'a' + 10) :
+			c >= 'A' && c <= 'F' ? (uint64_t)(c - 'A' + 10) :
+			(uint64_t)invalidUUID();
+	}
+
+	// Position in the 36 character form of the n-th hex digit, skipping the dashes.
+	static constexpr size_t position(size_t n) {
+		return n + (n >= 8) + (n >= 12) + (n >= 16) + (n >= 20);
+	}
+
+	static constexpr uint64_t nibbles(const char* text, size_t from, size_t count, uint64_t acc) {
+		return count == 0 ? acc : nibbles(text, from + 1, count - 1, (acc << 4) | hexDigit(text[position(from)]));
+	}
+
+	static constexpr uint64_t digits(const char* text, size_t count, uint64_t acc) {
+		return count == 0 ? acc : digits(text + 1, count - 1, (acc << 4) | hexDigit(*text));
+	}
+
+	static constexpr uint64_t shortValue(const char* text, size_t length) {
+		return length == 4 || length == 8 ? digits(text, length, 0) : 0;
+	}
+
+	static constexpr uint8_t checkFormat(const char* text, size_t length) {
+		return length == 4 ? ESP_UUID_LEN_16 :
+			length == 8 ? ESP_UUID_LEN_32 :
+			length == 36 && text[8] == '-' && text[13] == '-' && text[18] == '-' && text[23] == '-' ? ESP_UUID_LEN_128 :
+			(uint8_t)invalidUUID();
+	}
+}; // BLEUUIDLiteral
+
 
 /**
  * @brief A model of a %BLE UUID.
  */
 class BLEUUID {
 public:
+	static const size_t STRING_SIZE = 37;  // Buffer size needed by toString(char*), including the terminator.
+
 	BLEUUID(std::string uuid);
+	BLEUUID(const BLEUUIDLiteral& uuid);
 	BLEUUID(uint16_t uuid);
 	BLEUUID(uint32_t uuid);
 	BLEUUID(esp_bt_uuid_t uuid);
@@ -25,15 +93,33 @@ public:
 	BLEUUID(esp_gatt_id_t gattId);
 	BLEUUID();
 	uint8_t        bitSize();   // Get the number of bits in this uuid.
-	bool           equals(BLEUUID uuid);
+	bool           equals(const BLEUUID& uuid) const;
 	esp_bt_uuid_t* getNative();
+	size_t         hash() const;
 	BLEUUID        to128();
 	std::string    toString();
+	char*          toString(char* buffer);
 	static BLEUUID fromString(std::string uuid);  // Create a BLEUUID from a string
 
+	bool           operator==(const BLEUUID& uuid) const { return equals(uuid); }
+
 private:
+	void          setCanonical();
+
 	esp_bt_uuid_t m_uuid;       		// The underlying UUID structure that this class wraps.
 	bool          m_valueSet = false;   // Is there a value set for this instance.
+	uint64_t      m_hi = 0;             // The UUID in its 128 bit form, most significant half ...
+	uint64_t      m_lo = 0;             // ... and least significant half, whatever the length of m_uuid.
 }; // BLEUUID
+
+
+namespace std {
+	/**
+	 * @brief Allow a BLEUUID to be the key of an unordered container.
+	 */
+	template<> struct hash<BLEUUID> {
+		size_t operator()(const BLEUUID& uuid) const { return uuid.hash(); }
+	};
+} // namespace std
 #endif /* CONFIG_BT_ENABLED */
 #endif /* COMPONENTS_CPP_UTILS_BLEUUID_H_ */
@@ -35,13 +35,20 @@ static std::map<std::string, BLEClient*> g_addressMap;
 static std::map<uint16_t, BLEClient*> g_connIdMap;
 */
 
+/*
+ * The names of the Bluetooth assigned numbers: company identifiers of SIG members, descriptors,
+ * characteristics and services.  Each table is sorted by assigned number so that findAssignedNumber() can
+ * binary search it, which isSortedByAssignedNumber() checks at compile time.  They take flash that a
+ * device seldom needs, so they are only built with CONFIG_BLE_UTILS_ASSIGNED_NUMBER_NAMES; without it the
+ * assigned numbers are not named.
+ */
+#if CONFIG_BLE_UTILS_ASSIGNED_NUMBER_NAMES
 typedef struct {
 	uint32_t    assignedNumber;
 	const char* name;
 } member_t;
 
-static const member_t members_ids[] = {
-#if CONFIG_LOG_DEFAULT_LEVEL > 4
+static constexpr member_t members_ids[] = {
 	{0xFE08, "Microsoft"},
 	{0xFE09, "Pillsy, Inc."},
 	{0xFE0A, "ruwido austria gmbh"},
@@ -290,9 +297,7 @@ static const member_t members_ids[] = {
 	{0xFEFD, "Gimbal, Inc."},
 	{0xFEFE, "GN ReSound A/S"},
 	{0xFEFF, "GN Netcom"},
-	{0xFFFF, "Reserved"}, /*for testing purposes only*/
-#endif
-	{0, "" }
+	{0xFFFF, "Reserved"} /*for testing purposes only*/
 };
 
 typedef struct {
@@ -300,25 +305,22 @@ typedef struct {
 	const char* name;
 } gattdescriptor_t;
 
-static const gattdescriptor_t g_descriptor_ids[] = {
-#if CONFIG_LOG_DEFAULT_LEVEL > 4
-		{0x2905,"Characteristic Aggregate Format"},
+static constexpr gattdescriptor_t g_descriptor_ids[] = {
 		{0x2900,"Characteristic Extended Properties"},
-		{0x2904,"Characteristic Presentation Format"},
 		{0x2901,"Characteristic User Description"},
 		{0x2902,"Client Characteristic Configuration"},
-		{0x290B,"Environmental Sensing Configuration"},
-		{0x290C,"Environmental Sensing Measurement"},
-		{0x290D,"Environmental Sensing Trigger Setting"},
-		{0x2907,"External Report Reference"},
-		{0x2909,"Number of Digitals"},
-		{0x2908,"Report Reference"},
 		{0x2903,"Server Characteristic Configuration"},
-		{0x290E,"Time Trigger Setting"},
+		{0x2904,"Characteristic Presentation Format"},
+		{0x2905,"Characteristic Aggregate Format"},
 		{0x2906,"Valid Range"},
+		{0x2907,"External Report Reference"},
+		{0x2908,"Report Reference"},
+		{0x2909,"Number of Digitals"},
 		{0x290A,"Value Trigger Setting"},
-#endif
-		{ 0, "" }
+		{0x290B,"Environmental Sensing Configuration"},
+		{0x290C,"Environmental Sensing Measurement"},
+		{0x290D,"Environmental Sensing Trigger Setting"},
+		{0x290E,"Time Trigger Setting"}
 };
 
 typedef struct {
@@ -326,226 +328,220 @@ typedef struct {
 	const char* name;
 } characteristicMap_t;
 
-static const characteristicMap_t g_characteristicsMappings[] = {
-#if CONFIG_LOG_DEFAULT_LEVEL > 4
-		{0x2A7E,"Aerobic Heart Rate Lower Limit"},
-		{0x2A84,"Aerobic Heart Rate Upper Limit"},
-		{0x2A7F,"Aerobic Threshold"},
-		{0x2A80,"Age"},
-		{0x2A5A,"Aggregate"},
-		{0x2A43,"Alert Category ID"},
-		{0x2A42,"Alert Category ID Bit Mask"},
-		{0x2A06,"Alert Level"},
-		{0x2A44,"Alert Notification Control Point"},
-		{0x2A3F,"Alert Status"},
-		{0x2AB3,"Altitude"},
-		{0x2A81,"Anaerobic Heart Rate Lower Limit"},
-		{0x2A82,"Anaerobic Heart Rate Upper Limit"},
-		{0x2A83,"Anaerobic Threshold"},
-		{0x2A58,"Analog"},
-		{0x2A59,"Analog Output"},
-		{0x2A73,"Apparent Wind Direction"},
-		{0x2A72,"Apparent Wind Speed"},
+static constexpr characteristicMap_t g_characteristicsMappings[] = {
+		{0x2A00,"Device Name"},
 		{0x2A01,"Appearance"},
-		{0x2AA3,"Barometric Pressure Trend"},
+		{0x2A02,"Peripheral Privacy Flag"},
+		{0x2A03,"Reconnection Address"},
+		{0x2A04,"Peripheral Preferred Connection Parameters"},
+		{0x2A05,"Service Changed"},
+		{0x2A06,"Alert Level"},
+		{0x2A07,"Tx Power Level"},
+		{0x2A08,"Date Time"},
+		{0x2A09,"Day of Week"},
+		{0x2A0A,"Day Date Time"},
+		{0x2A0B,"Exact Time 100"},
+		{0x2A0C,"Exact Time 256"},
+		{0x2A0D,"DST Offset"},
+		{0x2A0E,"Time Zone"},
+		{0x2A0F,"Local Time Information"},
+		{0x2A10,"Secondary Time Zone"},
+		{0x2A11,"Time with DST"},
+		{0x2A12,"Time Accuracy"},
+		{0x2A13,"Time Source"},
+		{0x2A14,"Reference Time Information"},
+		{0x2A15,"Time Broadcast"},
+		{0x2A16,"Time Update Control Point"},
+		{0x2A17,"Time Update State"},
+		{0x2A18,"Glucose Measurement"},
 		{0x2A19,"Battery Level"},
-		{0x2A1B,"Battery Level State"},
 		{0x2A1A,"Battery Power State"},
-		{0x2A49,"Blood Pressure Feature"},
-		{0x2A35,"Blood Pressure Measurement"},
-		{0x2A9B,"Body Composition Feature"},
-		{0x2A9C,"Body Composition Measurement"},
-		{0x2A38,"Body Sensor Location"},
-		{0x2AA4,"Bond Management Control Point"},
-		{0x2AA5,"Bond Management Features"},
+		{0x2A1B,"Battery Level State"},
+		{0x2A1C,"Temperature Measurement"},
+		{0x2A1D,"Temperature Type"},
+		{0x2A1E,"Intermediate Temperature"},
+		{0x2A1F,"Temperature Celsius"},
+		{0x2A20,"Temperature Fahrenheit"},
+		{0x2A21,"Measurement Interval"},
 		{0x2A22,"Boot Keyboard Input Report"},
+		{0x2A23,"System ID"},
+		{0x2A24,"Model Number String"},
+		{0x2A25,"Serial Number String"},
+		{0x2A26,"Firmware Revision String"},
+		{0x2A27,"Hardware Revision String"},
+		{0x2A28,"Software Revision String"},
+		{0x2A29,"Manufacturer Name String"},
+		{0x2A2A,"IEEE 11073-20601 Regulatory Certification Data List"},
+		{0x2A2B,"Current Time"},
+		{0x2A2C,"Magnetic Declination"},
+		{0x2A2F,"Position 2D"},
+		{0x2A30,"Position 3D"},
+		{0x2A31,"Scan Refresh"},
 		{0x2A32,"Boot Keyboard Output Report"},
 		{0x2A33,"Boot Mouse Input Report"},
-		{0x2AA6,"Central Address Resolution"},
-		{0x2AA8,"CGM Feature"},
-		{0x2AA7,"CGM Measurement"},
-		{0x2AAB,"CGM Session Run Time"},
-		{0x2AAA,"CGM Session Start Time"},
-		{0x2AAC,"CGM Specific Ops Control Point"},
-		{0x2AA9,"CGM Status"},
-		{0x2ACE,"Cross Trainer Data"},
-		{0x2A5C,"CSC Feature"},
+		{0x2A34,"Glucose Measurement Context"},
+		{0x2A35,"Blood Pressure Measurement"},
+		{0x2A36,"Intermediate Cuff Pressure"},
+		{0x2A37,"Heart Rate Measurement"},
+		{0x2A38,"Body Sensor Location"},
+		{0x2A39,"Heart Rate Control Point"},
+		{0x2A3A,"Removable"},
+		{0x2A3B,"Service Required"},
+		{0x2A3C,"Scientific Temperature Celsius"},
+		{0x2A3D,"String"},
+		{0x2A3E,"Network Availability"},
+		{0x2A3F,"Alert Status"},
+		{0x2A40,"Ringer Control point"},
+		{0x2A41,"Ringer Setting"},
+		{0x2A42,"Alert Category ID Bit Mask"},
+		{0x2A43,"Alert Category ID"},
+		{0x2A44,"Alert Notification Control Point"},
+		{0x2A45,"Unread Alert Status"},
+		{0x2A46,"New Alert"},
+		{0x2A47,"Supported New Alert Category"},
+		{0x2A48,"Supported Unread Alert Category"},
+		{0x2A49,"Blood Pressure Feature"},
+		{0x2A4A,"HID Information"},
+		{0x2A4B,"Report Map"},
+		{0x2A4C,"HID Control Point"},
+		{0x2A4D,"Report"},
+		{0x2A4E,"Protocol Mode"},
+		{0x2A4F,"Scan Interval Window"},
+		{0x2A50,"PnP ID"},
+		{0x2A51,"Glucose Feature"},
+		{0x2A52,"Record Access Control Point"},
+		{0x2A53,"RSC Measurement"},
+		{0x2A54,"RSC Feature"},
+		{0x2A55,"SC Control Point"},
+		{0x2A56,"Digital"},
+		{0x2A57,"Digital Output"},
+		{0x2A58,"Analog"},
+		{0x2A59,"Analog Output"},
+		{0x2A5A,"Aggregate"},
 		{0x2A5B,"CSC Measurement"},
-		{0x2A2B,"Current Time"},
-		{0x2A66,"Cycling Power Control Point"},
-		{0x2A66,"Cycling Power Control Point"},
-		{0x2A65,"Cycling Power Feature"},
-		{0x2A65,"Cycling Power Feature"},
+		{0x2A5C,"CSC Feature"},
+		{0x2A5D,"Sensor Location"},
+		{0x2A5E,"PLX Spot-Check Measurement"},
+		{0x2A5F,"PLX Continuous Measurement Characteristic"},
+		{0x2A60,"PLX Features"},
+		{0x2A62,"Pulse Oximetry Control Point"},
 		{0x2A63,"Cycling Power Measurement"},
 		{0x2A64,"Cycling Power Vector"},
-		{0x2A99,"Database Change Increment"},
+		{0x2A65,"Cycling Power Feature"},
+		{0x2A66,"Cycling Power Control Point"},
+		{0x2A67,"Location and Speed Characteristic"},
+		{0x2A68,"Navigation"},
+		{0x2A69,"Position Quality"},
+		{0x2A6A,"LN Feature"},
+		{0x2A6B,"LN Control Point"},
+		{0x2A6C,"Elevation"},
+		{0x2A6D,"Pressure"},
+		{0x2A6E,"Temperature"},
+		{0x2A6F,"Humidity"},
+		{0x2A70,"True Wind Speed"},
+		{0x2A71,"True Wind Direction"},
+		{0x2A72,"Apparent Wind Speed"},
+		{0x2A73,"Apparent Wind Direction"},
+		{0x2A74,"Gust Factor"},
+		{0x2A75,"Pollen Concentration"},
+		{0x2A76,"UV Index"},
+		{0x2A77,"Irradiance"},
+		{0x2A78,"Rainfall"},
+		{0x2A79,"Wind Chill"},
+		{0x2A7A,"Heat Index"},
+		{0x2A7B,"Dew Point"},
+		{0x2A7D,"Descriptor Value Changed"},
+		{0x2A7E,"Aerobic Heart Rate Lower Limit"},
+		{0x2A7F,"Aerobic Threshold"},
+		{0x2A80,"Age"},
+		{0x2A81,"Anaerobic Heart Rate Lower Limit"},
+		{0x2A82,"Anaerobic Heart Rate Upper Limit"},
+		{0x2A83,"Anaerobic Threshold"},
+		{0x2A84,"Aerobic Heart Rate Upper Limit"},
 		{0x2A85,"Date of Birth"},
 		{0x2A86,"Date of Threshold Assessment"},
-		{0x2A08,"Date Time"},
-		{0x2A0A,"Day Date Time"},
-		{0x2A09,"Day of Week"},
-		{0x2A7D,"Descriptor Value Changed"},
-		{0x2A00,"Device Name"},
-		{0x2A7B,"Dew Point"},
-		{0x2A56,"Digital"},
-		{0x2A57,"Digital Output"},
-		{0x2A0D,"DST Offset"},
-		{0x2A6C,"Elevation"},
 		{0x2A87,"Email Address"},
-		{0x2A0B,"Exact Time 100"},
-		{0x2A0C,"Exact Time 256"},
 		{0x2A88,"Fat Burn Heart Rate Lower Limit"},
 		{0x2A89,"Fat Burn Heart Rate Upper Limit"},
-		{0x2A26,"Firmware Revision String"},
 		{0x2A8A,"First Name"},
-		{0x2AD9,"Fitness Machine Control Point"},
-		{0x2ACC,"Fitness Machine Feature"},
-		{0x2ADA,"Fitness Machine Status"},
 		{0x2A8B,"Five Zone Heart Rate Limits"},
-		{0x2AB2,"Floor Number"},
 		{0x2A8C,"Gender"},
-		{0x2A51,"Glucose Feature"},
-		{0x2A18,"Glucose Measurement"},
-		{0x2A34,"Glucose Measurement Context"},
-		{0x2A74,"Gust Factor"},
-		{0x2A27,"Hardware Revision String"},
-		{0x2A39,"Heart Rate Control Point"},
 		{0x2A8D,"Heart Rate Max"},
-		{0x2A37,"Heart Rate Measurement"},
-		{0x2A7A,"Heat Index"},
 		{0x2A8E,"Height"},
-		{0x2A4C,"HID Control Point"},
-		{0x2A4A,"HID Information"},
 		{0x2A8F,"Hip Circumference"},
-		{0x2ABA,"HTTP Control Point"},
-		{0x2AB9,"HTTP Entity Body"},
-		{0x2AB7,"HTTP Headers"},
-		{0x2AB8,"HTTP Status Code"},
-		{0x2ABB,"HTTPS Security"},
-		{0x2A6F,"Humidity"},
-		{0x2A2A,"IEEE 11073-20601 Regulatory Certification Data List"},
-		{0x2AD2,"Indoor Bike Data"},
-		{0x2AAD,"Indoor Positioning Configuration"},
-		{0x2A36,"Intermediate Cuff Pressure"},
-		{0x2A1E,"Intermediate Temperature"},
-		{0x2A77,"Irradiance"},
-		{0x2AA2,"Language"},
 		{0x2A90,"Last Name"},
+		{0x2A91,"Maximum Recommended Heart Rate"},
+		{0x2A92,"Resting Heart Rate"},
+		{0x2A93,"Sport Type for Aerobic and Anaerobic Thresholds"},
+		{0x2A94,"Three Zone Heart Rate Limits"},
+		{0x2A95,"Two Zone Heart Rate Limit"},
+		{0x2A96,"VO2 Max"},
+		{0x2A97,"Waist Circumference"},
+		{0x2A98,"Weight"},
+		{0x2A99,"Database Change Increment"},
+		{0x2A9A,"User Index"},
+		{0x2A9B,"Body Composition Feature"},
+		{0x2A9C,"Body Composition Measurement"},
+		{0x2A9D,"Weight Measurement"},
+		{0x2A9E,"Weight Scale Feature"},
+		{0x2A9F,"User Control Point"},
+		{0x2AA0,"Magnetic Flux Density - 2D"},
+		{0x2AA1,"Magnetic Flux Density - 3D"},
+		{0x2AA2,"Language"},
+		{0x2AA3,"Barometric Pressure Trend"},
+		{0x2AA4,"Bond Management Control Point"},
+		{0x2AA5,"Bond Management Features"},
+		{0x2AA6,"Central Address Resolution"},
+		{0x2AA7,"CGM Measurement"},
+		{0x2AA8,"CGM Feature"},
+		{0x2AA9,"CGM Status"},
+		{0x2AAA,"CGM Session Start Time"},
+		{0x2AAB,"CGM Session Run Time"},
+		{0x2AAC,"CGM Specific Ops Control Point"},
+		{0x2AAD,"Indoor Positioning Configuration"},
 		{0x2AAE,"Latitude"},
-		{0x2A6B,"LN Control Point"},
-		{0x2A6A,"LN Feature"},
-		{0x2AB1,"Local East Coordinate"},
+		{0x2AAF,"Longitude"},
 		{0x2AB0,"Local North Coordinate"},
-		{0x2A0F,"Local Time Information"},
-		{0x2A67,"Location and Speed Characteristic"},
+		{0x2AB1,"Local East Coordinate"},
+		{0x2AB2,"Floor Number"},
+		{0x2AB3,"Altitude"},
+		{0x2AB4,"Uncertainty"},
 		{0x2AB5,"Location Name"},
-		{0x2AAF,"Longitude"},
-		{0x2A2C,"Magnetic Declination"},
-		{0x2AA0,"Magnetic Flux Density - 2D"},
-		{0x2AA1,"Magnetic Flux Density - 3D"},
-		{0x2A29,"Manufacturer Name String"},
-		{0x2A91,"Maximum Recommended Heart Rate"},
-		{0x2A21,"Measurement Interval"},
-		{0x2A24,"Model Number String"},
-		{0x2A68,"Navigation"},
-		{0x2A3E,"Network Availability"},
-		{0x2A46,"New Alert"},
-		{0x2AC5,"Object Action Control Point"},
-		{0x2AC8,"Object Changed"},
+		{0x2AB6,"URI"},
+		{0x2AB7,"HTTP Headers"},
+		{0x2AB8,"HTTP Status Code"},
+		{0x2AB9,"HTTP Entity Body"},
+		{0x2ABA,"HTTP Control Point"},
+		{0x2ABB,"HTTPS Security"},
+		{0x2ABC,"TDS Control Point"},
+		{0x2ABD,"OTS Feature"},
+		{0x2ABE,"Object Name"},
+		{0x2ABF,"Object Type"},
+		{0x2AC0,"Object Size"},
 		{0x2AC1,"Object First-Created"},
-		{0x2AC3,"Object ID"},
 		{0x2AC2,"Object Last-Modified"},
+		{0x2AC3,"Object ID"},
+		{0x2AC4,"Object Properties"},
+		{0x2AC5,"Object Action Control Point"},
 		{0x2AC6,"Object List Control Point"},
 		{0x2AC7,"Object List Filter"},
-		{0x2ABE,"Object Name"},
-		{0x2AC4,"Object Properties"},
-		{0x2AC0,"Object Size"},
-		{0x2ABF,"Object Type"},
-		{0x2ABD,"OTS Feature"},
-		{0x2A04,"Peripheral Preferred Connection Parameters"},
-		{0x2A02,"Peripheral Privacy Flag"},
-		{0x2A5F,"PLX Continuous Measurement Characteristic"},
-		{0x2A60,"PLX Features"},
-		{0x2A5E,"PLX Spot-Check Measurement"},
-		{0x2A50,"PnP ID"},
-		{0x2A75,"Pollen Concentration"},
-		{0x2A2F,"Position 2D"},
-		{0x2A30,"Position 3D"},
-		{0x2A69,"Position Quality"},
-		{0x2A6D,"Pressure"},
-		{0x2A4E,"Protocol Mode"},
-		{0x2A62,"Pulse Oximetry Control Point"},
-		{0x2A60,"Pulse Oximetry Pulsatile Event Characteristic"},
-		{0x2A78,"Rainfall"},
-		{0x2A03,"Reconnection Address"},
-		{0x2A52,"Record Access Control Point"},
-		{0x2A14,"Reference Time Information"},
-		{0x2A3A,"Removable"},
-		{0x2A4D,"Report"},
-		{0x2A4B,"Report Map"},
+		{0x2AC8,"Object Changed"},
 		{0x2AC9,"Resolvable Private Address Only"},
-		{0x2A92,"Resting Heart Rate"},
-		{0x2A40,"Ringer Control point"},
-		{0x2A41,"Ringer Setting"},
-		{0x2AD1,"Rower Data"},
-		{0x2A54,"RSC Feature"},
-		{0x2A53,"RSC Measurement"},
-		{0x2A55,"SC Control Point"},
-		{0x2A4F,"Scan Interval Window"},
-		{0x2A31,"Scan Refresh"},
-		{0x2A3C,"Scientific Temperature Celsius"},
-		{0x2A10,"Secondary Time Zone"},
-		{0x2A5D,"Sensor Location"},
-		{0x2A25,"Serial Number String"},
-		{0x2A05,"Service Changed"},
-		{0x2A3B,"Service Required"},
-		{0x2A28,"Software Revision String"},
-		{0x2A93,"Sport Type for Aerobic and Anaerobic Thresholds"},
-		{0x2AD0,"Stair Climber Data"},
+		{0x2ACC,"Fitness Machine Feature"},
+		{0x2ACD,"Treadmill Data"},
+		{0x2ACE,"Cross Trainer Data"},
 		{0x2ACF,"Step Climber Data"},
-		{0x2A3D,"String"},
-		{0x2AD7,"Supported Heart Rate Range"},
+		{0x2AD0,"Stair Climber Data"},
+		{0x2AD1,"Rower Data"},
+		{0x2AD2,"Indoor Bike Data"},
+		{0x2AD3,"Training Status"},
+		{0x2AD4,"Supported Speed Range"},
 		{0x2AD5,"Supported Inclination Range"},
-		{0x2A47,"Supported New Alert Category"},
-		{0x2AD8,"Supported Power Range"},
 		{0x2AD6,"Supported Resistance Level Range"},
-		{0x2AD4,"Supported Speed Range"},
-		{0x2A48,"Supported Unread Alert Category"},
-		{0x2A23,"System ID"},
-		{0x2ABC,"TDS Control Point"},
-		{0x2A6E,"Temperature"},
-		{0x2A1F,"Temperature Celsius"},
-		{0x2A20,"Temperature Fahrenheit"},
-		{0x2A1C,"Temperature Measurement"},
-		{0x2A1D,"Temperature Type"},
-		{0x2A94,"Three Zone Heart Rate Limits"},
-		{0x2A12,"Time Accuracy"},
-		{0x2A15,"Time Broadcast"},
-		{0x2A13,"Time Source"},
-		{0x2A16,"Time Update Control Point"},
-		{0x2A17,"Time Update State"},
-		{0x2A11,"Time with DST"},
-		{0x2A0E,"Time Zone"},
-		{0x2AD3,"Training Status"},
-		{0x2ACD,"Treadmill Data"},
-		{0x2A71,"True Wind Direction"},
-		{0x2A70,"True Wind Speed"},
-		{0x2A95,"Two Zone Heart Rate Limit"},
-		{0x2A07,"Tx Power Level"},
-		{0x2AB4,"Uncertainty"},
-		{0x2A45,"Unread Alert Status"},
-		{0x2AB6,"URI"},
-		{0x2A9F,"User Control Point"},
-		{0x2A9A,"User Index"},
-		{0x2A76,"UV Index"},
-		{0x2A96,"VO2 Max"},
-		{0x2A97,"Waist Circumference"},
-		{0x2A98,"Weight"},
-		{0x2A9D,"Weight Measurement"},
-		{0x2A9E,"Weight Scale Feature"},
-		{0x2A79,"Wind Chill"},
-#endif
-		{0, ""}
+		{0x2AD7,"Supported Heart Rate Range"},
+		{0x2AD8,"Supported Power Range"},
+		{0x2AD9,"Fitness Machine Control Point"},
+		{0x2ADA,"Fitness Machine Status"}
 };
 
 /**
@@ -561,47 +557,172 @@ typedef struct {
 /**
  * Definition of the service ids to names that we know about.
  */
-static const gattService_t g_gattServices[] = {
-#if CONFIG_LOG_DEFAULT_LEVEL > 4
-	{"Alert Notification Service", "org.bluetooth.service.alert_notification", 0x1811},
-	{"Automation IO", "org.bluetooth.service.automation_io",	0x1815 },
-	{"Battery Service","org.bluetooth.service.battery_service",	0x180F},
-	{"Blood Pressure", "org.bluetooth.service.blood_pressure", 0x1810},
-	{"Body Composition", "org.bluetooth.service.body_composition", 0x181B},
-	{"Bond Management", "org.bluetooth.service.bond_management", 0x181E},
-	{"Continuous Glucose Monitoring", "org.bluetooth.service.continuous_glucose_monitoring", 0x181F},
-	{"Current Time Service", "org.bluetooth.service.current_time", 0x1805},
-	{"Cycling Power", "org.bluetooth.service.cycling_power", 0x1818},
-	{"Cycling Speed and Cadence", "org.bluetooth.service.cycling_speed_and_cadence", 0x1816},
-	{"Device Information", "org.bluetooth.service.device_information", 0x180A},
-	{"Environmental Sensing", "org.bluetooth.service.environmental_sensing", 0x181A},
+static constexpr gattService_t g_gattServices[] = {
 	{"Generic Access", "org.bluetooth.service.generic_access", 0x1800},
 	{"Generic Attribute", "org.bluetooth.service.generic_attribute", 0x1801},
-	{"Glucose", "org.bluetooth.service.glucose", 0x1808},
-	{"Health Thermometer", "org.bluetooth.service.health_thermometer", 0x1809},
-	{"Heart Rate", "org.bluetooth.service.heart_rate", 0x180D},
-	{"HTTP Proxy", "org.bluetooth.service.http_proxy", 0x1823},
-	{"Human Interface Device", "org.bluetooth.service.human_interface_device", 0x1812},
 	{"Immediate Alert", "org.bluetooth.service.immediate_alert", 0x1802},
-	{"Indoor Positioning", "org.bluetooth.service.indoor_positioning", 0x1821},
-	{"Internet Protocol Support", "org.bluetooth.service.internet_protocol_support", 0x1820},
 	{"Link Loss", "org.bluetooth.service.link_loss", 0x1803},
-	{"Location and Navigation", "org.bluetooth.service.location_and_navigation", 0x1819},
+	{"Tx Power", "org.bluetooth.service.tx_power", 0x1804},
+	{"Current Time Service", "org.bluetooth.service.current_time", 0x1805},
+	{"Reference Time Update Service", "org.bluetooth.service.reference_time_update", 0x1806},
 	{"Next DST Change Service", "org.bluetooth.service.next_dst_change", 0x1807},
-	{"Object Transfer", "org.bluetooth.service.object_transfer", 0x1825},
+	{"Glucose", "org.bluetooth.service.glucose", 0x1808},
+	{"Health Thermometer", "org.bluetooth.service.health_thermometer", 0x1809},
+	{"Device Information", "org.bluetooth.service.device_information", 0x180A},
+	{"Heart Rate", "org.bluetooth.service.heart_rate", 0x180D},
 	{"Phone Alert Status Service", "org.bluetooth.service.phone_alert_status", 0x180E},
-	{"Pulse Oximeter", "org.bluetooth.service.pulse_oximeter", 0x1822},
-	{"Reference Time Update Service", "org.bluetooth.service.reference_time_update", 0x1806},
-	{"Running Speed and Cadence", "org.bluetooth.service.running_speed_and_cadence", 0x1814},
+	{"Battery Service","org.bluetooth.service.battery_service",	0x180F},
+	{"Blood Pressure", "org.bluetooth.service.blood_pressure", 0x1810},
+	{"Alert Notification Service", "org.bluetooth.service.alert_notification", 0x1811},
+	{"Human Interface Device", "org.bluetooth.service.human_interface_device", 0x1812},
 	{"Scan Parameters", "org.bluetooth.service.scan_parameters", 0x1813},
-	{"Transport Discovery", "org.bluetooth.service.transport_discovery", 0x1824},
-	{"Tx Power", "org.bluetooth.service.tx_power", 0x1804},
+	{"Running Speed and Cadence", "org.bluetooth.service.running_speed_and_cadence", 0x1814},
+	{"Automation IO", "org.bluetooth.service.automation_io",	0x1815 },
+	{"Cycling Speed and Cadence", "org.bluetooth.service.cycling_speed_and_cadence", 0x1816},
+	{"Cycling Power", "org.bluetooth.service.cycling_power", 0x1818},
+	{"Location and Navigation", "org.bluetooth.service.location_and_navigation", 0x1819},
+	{"Environmental Sensing", "org.bluetooth.service.environmental_sensing", 0x181A},
+	{"Body Composition", "org.bluetooth.service.body_composition", 0x181B},
 	{"User Data", "org.bluetooth.service.user_data", 0x181C},
 	{"Weight Scale", "org.bluetooth.service.weight_scale", 0x181D},
-#endif
-	{"", "", 0 }
+	{"Bond Management", "org.bluetooth.service.bond_management", 0x181E},
+	{"Continuous Glucose Monitoring", "org.bluetooth.service.continuous_glucose_monitoring", 0x181F},
+	{"Internet Protocol Support", "org.bluetooth.service.internet_protocol_support", 0x1820},
+	{"Indoor Positioning", "org.bluetooth.service.indoor_positioning", 0x1821},
+	{"Pulse Oximeter", "org.bluetooth.service.pulse_oximeter", 0x1822},
+	{"HTTP Proxy", "org.bluetooth.service.http_proxy", 0x1823},
+	{"Transport Discovery", "org.bluetooth.service.transport_discovery", 0x1824},
+	{"Object Transfer", "org.bluetooth.service.object_transfer", 0x1825}
+};
+
+template <typename T, size_t N>
+static constexpr bool isSortedByAssignedNumber(const T (&table)[N], size_t index = 1) {
+	return index >= N || (table[index - 1].assignedNumber < table[index].assignedNumber && isSortedByAssignedNumber(table, index + 1));
+}
+
+static_assert(isSortedByAssignedNumber(members_ids), "members_ids is not sorted by assigned number");
+static_assert(isSortedByAssignedNumber(g_descriptor_ids), "g_descriptor_ids is not sorted by assigned number");
+static_assert(isSortedByAssignedNumber(g_characteristicsMappings), "g_characteristicsMappings is not sorted by assigned number");
+static_assert(isSortedByAssignedNumber(g_gattServices), "g_gattServices is not sorted by assigned number");
+
+/**
+ * @brief Find the name of an assigned number in a table sorted by assigned number.
+ * @param [in] table The table to search.
+ * @param [in] assignedNumber The assigned number to find.
+ * @return The name of the assigned number or nullptr if it is not in the table.
+ */
+template <typename T, size_t N>
+static const char* findAssignedNumber(const T (&table)[N], uint32_t assignedNumber) {
+	size_t low  = 0;
+	size_t high = N;
+	while (low < high) {
+		size_t middle = low + (high - low) / 2;
+		if (table[middle].assignedNumber < assignedNumber) {
+			low = middle + 1;
+		} else {
+			high = middle;
+		}
+	}
+	return (low < N && table[low].assignedNumber == assignedNumber) ? table[low].name : nullptr;
+} // findAssignedNumber
+#endif // CONFIG_BLE_UTILS_ASSIGNED_NUMBER_NAMES
+
+/*
+ * The names of the GATT server and client events, indexed by event so that naming one costs a bounds check.
+ * isIndexedByEvent() holds each entry to the value of its event at compile time, so a table cannot drift
+ * from the ESP-IDF headers; values ESP-IDF does not use have no name.
+ */
+typedef struct {
+	int         event;
+	const char* name;
+} event_name_t;
+
+#define EVENT_NAME(event) { event, #event }
+
+static constexpr event_name_t g_gattsEventNames[] = {
+	EVENT_NAME(ESP_GATTS_REG_EVT),
+	EVENT_NAME(ESP_GATTS_READ_EVT),
+	EVENT_NAME(ESP_GATTS_WRITE_EVT),
+	EVENT_NAME(ESP_GATTS_EXEC_WRITE_EVT),
+	EVENT_NAME(ESP_GATTS_MTU_EVT),
+	EVENT_NAME(ESP_GATTS_CONF_EVT),
+	EVENT_NAME(ESP_GATTS_UNREG_EVT),
+	EVENT_NAME(ESP_GATTS_CREATE_EVT),
+	EVENT_NAME(ESP_GATTS_ADD_INCL_SRVC_EVT),
+	EVENT_NAME(ESP_GATTS_ADD_CHAR_EVT),
+	EVENT_NAME(ESP_GATTS_ADD_CHAR_DESCR_EVT),
+	EVENT_NAME(ESP_GATTS_DELETE_EVT),
+	EVENT_NAME(ESP_GATTS_START_EVT),
+	EVENT_NAME(ESP_GATTS_STOP_EVT),
+	EVENT_NAME(ESP_GATTS_CONNECT_EVT),
+	EVENT_NAME(ESP_GATTS_DISCONNECT_EVT),
+	EVENT_NAME(ESP_GATTS_OPEN_EVT),
+	EVENT_NAME(ESP_GATTS_CANCEL_OPEN_EVT),
+	EVENT_NAME(ESP_GATTS_CLOSE_EVT),
+	EVENT_NAME(ESP_GATTS_LISTEN_EVT),
+	EVENT_NAME(ESP_GATTS_CONGEST_EVT),
+	EVENT_NAME(ESP_GATTS_RESPONSE_EVT),
+	EVENT_NAME(ESP_GATTS_CREAT_ATTR_TAB_EVT),
+	EVENT_NAME(ESP_GATTS_SET_ATTR_VAL_EVT),
+	EVENT_NAME(ESP_GATTS_SEND_SERVICE_CHANGE_EVT)
+};
+
+static constexpr event_name_t g_gattcEventNames[] = {
+	EVENT_NAME(ESP_GATTC_REG_EVT),
+	EVENT_NAME(ESP_GATTC_UNREG_EVT),
+	EVENT_NAME(ESP_GATTC_OPEN_EVT),
+	EVENT_NAME(ESP_GATTC_READ_CHAR_EVT),
+	EVENT_NAME(ESP_GATTC_WRITE_CHAR_EVT),
+	EVENT_NAME(ESP_GATTC_CLOSE_EVT),
+	EVENT_NAME(ESP_GATTC_SEARCH_CMPL_EVT),
+	EVENT_NAME(ESP_GATTC_SEARCH_RES_EVT),
+	EVENT_NAME(ESP_GATTC_READ_DESCR_EVT),
+	EVENT_NAME(ESP_GATTC_WRITE_DESCR_EVT),
+	EVENT_NAME(ESP_GATTC_NOTIFY_EVT),
+	EVENT_NAME(ESP_GATTC_PREP_WRITE_EVT),
+	EVENT_NAME(ESP_GATTC_EXEC_EVT),
+	EVENT_NAME(ESP_GATTC_ACL_EVT),
+	EVENT_NAME(ESP_GATTC_CANCEL_OPEN_EVT),
+	EVENT_NAME(ESP_GATTC_SRVC_CHG_EVT),
+	{ 16, nullptr },
+	EVENT_NAME(ESP_GATTC_ENC_CMPL_CB_EVT),
+	EVENT_NAME(ESP_GATTC_CFG_MTU_EVT),
+	EVENT_NAME(ESP_GATTC_ADV_DATA_EVT),
+	EVENT_NAME(ESP_GATTC_MULT_ADV_ENB_EVT),
+	EVENT_NAME(ESP_GATTC_MULT_ADV_UPD_EVT),
+	EVENT_NAME(ESP_GATTC_MULT_ADV_DATA_EVT),
+	EVENT_NAME(ESP_GATTC_MULT_ADV_DIS_EVT),
+	EVENT_NAME(ESP_GATTC_CONGEST_EVT),
+	EVENT_NAME(ESP_GATTC_BTH_SCAN_ENB_EVT),
+	EVENT_NAME(ESP_GATTC_BTH_SCAN_CFG_EVT),
+	EVENT_NAME(ESP_GATTC_BTH_SCAN_RD_EVT),
+	EVENT_NAME(ESP_GATTC_BTH_SCAN_THR_EVT),
+	EVENT_NAME(ESP_GATTC_BTH_SCAN_PARAM_EVT),
+	EVENT_NAME(ESP_GATTC_BTH_SCAN_DIS_EVT),
+	EVENT_NAME(ESP_GATTC_SCAN_FLT_CFG_EVT),
+	EVENT_NAME(ESP_GATTC_SCAN_FLT_PARAM_EVT),
+	EVENT_NAME(ESP_GATTC_SCAN_FLT_STATUS_EVT),
+	EVENT_NAME(ESP_GATTC_ADV_VSC_EVT),
+	{ 35, nullptr },
+	{ 36, nullptr },
+	{ 37, nullptr },
+	EVENT_NAME(ESP_GATTC_REG_FOR_NOTIFY_EVT),
+	EVENT_NAME(ESP_GATTC_UNREG_FOR_NOTIFY_EVT),
+	EVENT_NAME(ESP_GATTC_CONNECT_EVT),
+	EVENT_NAME(ESP_GATTC_DISCONNECT_EVT)
 };
 
+#undef EVENT_NAME
+
+static constexpr bool isIndexedByEvent(const event_name_t* pNames, size_t count, size_t index = 0) {
+	return index == count || (pNames[index].event == (int) index && isIndexedByEvent(pNames, count, index + 1));
+}
+
+static_assert(isIndexedByEvent(g_gattsEventNames, sizeof(g_gattsEventNames) / sizeof(g_gattsEventNames[0])),
+	"g_gattsEventNames is not in the order of esp_gatts_cb_event_t");
+static_assert(isIndexedByEvent(g_gattcEventNames, sizeof(g_gattcEventNames) / sizeof(g_gattcEventNames[0])),
+	"g_gattcEventNames is not in the order of esp_gattc_cb_event_t");
+
 
 /**
  * @brief Convert characteristic properties into a string representation.
@@ -818,7 +939,7 @@ std::string BLEUtils::buildPrintData(uint8_t* source, size_t length) {
  * @param [in] reason The close reason.
  * @return A string representation of the reason.
  */
-std::string BLEUtils::gattCloseReasonToString(esp_gatt_conn_reason_t reason) {
+const char* BLEUtils::gattCloseReasonToString(esp_gatt_conn_reason_t reason) {
 	switch (reason) {
 		case ESP_GATT_CONN_UNKNOWN: {
 			return "ESP_GATT_CONN_UNKNOWN";
@@ -854,94 +975,16 @@ std::string BLEUtils::gattCloseReasonToString(esp_gatt_conn_reason_t reason) {
 } // gattCloseReasonToString
 
 
-std::string BLEUtils::gattClientEventTypeToString(esp_gattc_cb_event_t eventType) {
-	switch (eventType) {
-		case ESP_GATTC_ACL_EVT:
-			return "ESP_GATTC_ACL_EVT";
-		case ESP_GATTC_ADV_DATA_EVT:
-			return "ESP_GATTC_ADV_DATA_EVT";
-		case ESP_GATTC_ADV_VSC_EVT:
-			return "ESP_GATTC_ADV_VSC_EVT";
-		case ESP_GATTC_BTH_SCAN_CFG_EVT:
-			return "ESP_GATTC_BTH_SCAN_CFG_EVT";
-		case ESP_GATTC_BTH_SCAN_DIS_EVT:
-			return "ESP_GATTC_BTH_SCAN_DIS_EVT";
-		case ESP_GATTC_BTH_SCAN_ENB_EVT:
-			return "ESP_GATTC_BTH_SCAN_ENB_EVT";
-		case ESP_GATTC_BTH_SCAN_PARAM_EVT:
-			return "ESP_GATTC_BTH_SCAN_PARAM_EVT";
-		case ESP_GATTC_BTH_SCAN_RD_EVT:
-			return "ESP_GATTC_BTH_SCAN_RD_EVT";
-		case ESP_GATTC_BTH_SCAN_THR_EVT:
-			return "ESP_GATTC_BTH_SCAN_THR_EVT";
-		case ESP_GATTC_CANCEL_OPEN_EVT:
-			return "ESP_GATTC_CANCEL_OPEN_EVT";
-		case ESP_GATTC_CFG_MTU_EVT:
-			return "ESP_GATTC_CFG_MTU_EVT";
-		case ESP_GATTC_CLOSE_EVT:
-			return "ESP_GATTC_CLOSE_EVT";
-		case ESP_GATTC_CONGEST_EVT:
-			return "ESP_GATTC_CONGEST_EVT";
-		case ESP_GATTC_CONNECT_EVT:
-			return "ESP_GATTC_CONNECT_EVT";
-		case ESP_GATTC_DISCONNECT_EVT:
-			return "ESP_GATTC_DISCONNECT_EVT";
-		case ESP_GATTC_ENC_CMPL_CB_EVT:
-			return "ESP_GATTC_ENC_CMPL_CB_EVT";
-		case ESP_GATTC_EXEC_EVT:
-			return "ESP_GATTC_EXEC_EVT";
-		//case ESP_GATTC_GET_CHAR_EVT:
-//			return "ESP_GATTC_GET_CHAR_EVT";
-		//case ESP_GATTC_GET_DESCR_EVT:
-//			return "ESP_GATTC_GET_DESCR_EVT";
-		//case ESP_GATTC_GET_INCL_SRVC_EVT:
-//			return "ESP_GATTC_GET_INCL_SRVC_EVT";
-		case ESP_GATTC_MULT_ADV_DATA_EVT:
-			return "ESP_GATTC_MULT_ADV_DATA_EVT";
-		case ESP_GATTC_MULT_ADV_DIS_EVT:
-			return "ESP_GATTC_MULT_ADV_DIS_EVT";
-		case ESP_GATTC_MULT_ADV_ENB_EVT:
-			return "ESP_GATTC_MULT_ADV_ENB_EVT";
-		case ESP_GATTC_MULT_ADV_UPD_EVT:
-			return "ESP_GATTC_MULT_ADV_UPD_EVT";
-		case ESP_GATTC_NOTIFY_EVT:
-			return "ESP_GATTC_NOTIFY_EVT";
-		case ESP_GATTC_OPEN_EVT:
-			return "ESP_GATTC_OPEN_EVT";
-		case ESP_GATTC_PREP_WRITE_EVT:
-			return "ESP_GATTC_PREP_WRITE_EVT";
-		case ESP_GATTC_READ_CHAR_EVT:
-			return "ESP_GATTC_READ_CHAR_EVT";
-		case ESP_GATTC_REG_EVT:
-			return "ESP_GATTC_REG_EVT";
-		case ESP_GATTC_REG_FOR_NOTIFY_EVT:
-			return "ESP_GATTC_REG_FOR_NOTIFY_EVT";
-		case ESP_GATTC_SCAN_FLT_CFG_EVT:
-			return "ESP_GATTC_SCAN_FLT_CFG_EVT";
-		case ESP_GATTC_SCAN_FLT_PARAM_EVT:
-			return "ESP_GATTC_SCAN_FLT_PARAM_EVT";
-		case ESP_GATTC_SCAN_FLT_STATUS_EVT:
-			return "ESP_GATTC_SCAN_FLT_STATUS_EVT";
-		case ESP_GATTC_SEARCH_CMPL_EVT:
-			return "ESP_GATTC_SEARCH_CMPL_EVT";
-		case ESP_GATTC_SEARCH_RES_EVT:
-			return "ESP_GATTC_SEARCH_RES_EVT";
-		case ESP_GATTC_SRVC_CHG_EVT:
-			return "ESP_GATTC_SRVC_CHG_EVT";
-		case ESP_GATTC_READ_DESCR_EVT:
-			return "ESP_GATTC_READ_DESCR_EVT";
-		case ESP_GATTC_UNREG_EVT:
-			return "ESP_GATTC_UNREG_EVT";
-		case ESP_GATTC_UNREG_FOR_NOTIFY_EVT:
-			return "ESP_GATTC_UNREG_FOR_NOTIFY_EVT";
-		case ESP_GATTC_WRITE_CHAR_EVT:
-			return "ESP_GATTC_WRITE_CHAR_EVT";
-		case ESP_GATTC_WRITE_DESCR_EVT:
-			return "ESP_GATTC_WRITE_DESCR_EVT";
-		default:
-			ESP_LOGV(LOG_TAG, "Unknown GATT Client event type: %d", eventType);
-			return "Unknown";
+/**
+ * @brief Return a string representation of a GATT client event code.
+ * @param [in] eventType A GATT client event code.
+ * @return A string representation of the GATT client event code.
+ */
+const char* BLEUtils::gattClientEventTypeToString(esp_gattc_cb_event_t eventType) {
+	if ((size_t) eventType >= sizeof(g_gattcEventNames) / sizeof(g_gattcEventNames[0]) || g_gattcEventNames[eventType].name == nullptr) {
+		return "Unknown";
 	}
+	return g_gattcEventNames[eventType].name;
 } // gattClientEventTypeToString
 
 
@@ -950,61 +993,11 @@ std::string BLEUtils::gattClientEventTypeToString(esp_gattc_cb_event_t eventType
  * @param [in] eventType A GATT server event code.
  * @return A string representation of the GATT server event code.
  */
-std::string BLEUtils::gattServerEventTypeToString(esp_gatts_cb_event_t eventType) {
-	switch (eventType) {
-		case ESP_GATTS_REG_EVT:
-			return "ESP_GATTS_REG_EVT";
-		case ESP_GATTS_READ_EVT:
-			return "ESP_GATTS_READ_EVT";
-		case ESP_GATTS_WRITE_EVT:
-			return "ESP_GATTS_WRITE_EVT";
-		case ESP_GATTS_EXEC_WRITE_EVT:
-			return "ESP_GATTS_EXEC_WRITE_EVT";
-		case ESP_GATTS_MTU_EVT:
-			return "ESP_GATTS_MTU_EVT";
-		case ESP_GATTS_CONF_EVT:
-			return "ESP_GATTS_CONF_EVT";
-		case ESP_GATTS_UNREG_EVT:
-			return "ESP_GATTS_UNREG_EVT";
-		case ESP_GATTS_CREATE_EVT:
-			return "ESP_GATTS_CREATE_EVT";
-		case ESP_GATTS_ADD_INCL_SRVC_EVT:
-			return "ESP_GATTS_ADD_INCL_SRVC_EVT";
-		case ESP_GATTS_ADD_CHAR_EVT:
-			return "ESP_GATTS_ADD_CHAR_EVT";
-		case ESP_GATTS_ADD_CHAR_DESCR_EVT:
-			return "ESP_GATTS_ADD_CHAR_DESCR_EVT";
-		case ESP_GATTS_DELETE_EVT:
-			return "ESP_GATTS_DELETE_EVT";
-		case ESP_GATTS_START_EVT:
-			return "ESP_GATTS_START_EVT";
-		case ESP_GATTS_STOP_EVT:
-			return "ESP_GATTS_STOP_EVT";
-		case ESP_GATTS_CONNECT_EVT:
-			return "ESP_GATTS_CONNECT_EVT";
-		case ESP_GATTS_DISCONNECT_EVT:
-			return "ESP_GATTS_DISCONNECT_EVT";
-		case ESP_GATTS_OPEN_EVT:
-			return "ESP_GATTS_OPEN_EVT";
-		case ESP_GATTS_CANCEL_OPEN_EVT:
-			return "ESP_GATTS_CANCEL_OPEN_EVT";
-		case ESP_GATTS_CLOSE_EVT:
-			return "ESP_GATTS_CLOSE_EVT";
-		case ESP_GATTS_LISTEN_EVT:
-			return "ESP_GATTS_LISTEN_EVT";
-		case ESP_GATTS_CONGEST_EVT:
-			return "ESP_GATTS_CONGEST_EVT";
-		case ESP_GATTS_RESPONSE_EVT:
-			return "ESP_GATTS_RESPONSE_EVT";
-		case ESP_GATTS_CREAT_ATTR_TAB_EVT:
-			return "ESP_GATTS_CREAT_ATTR_TAB_EVT";
-		case ESP_GATTS_SET_ATTR_VAL_EVT:
-			return "ESP_GATTS_SET_ATTR_VAL_EVT";
-		case ESP_GATTS_SEND_SERVICE_CHANGE_EVT:
-			return "ESP_GATTS_SEND_SERVICE_CHANGE_EVT";
-		default:
-			return "Unknown";
+const char* BLEUtils::gattServerEventTypeToString(esp_gatts_cb_event_t eventType) {
+	if ((size_t) eventType >= sizeof(g_gattsEventNames) / sizeof(g_gattsEventNames[0])) {
+		return "Unknown";
 	}
+	return g_gattsEventNames[eventType].name;
 } // gattServerEventTypeToString
 
 
@@ -1267,7 +1260,7 @@ void BLEUtils::dumpGattClientEvent(
 	esp_ble_gattc_cb_param_t* evtParam) {
 
 	//esp_ble_gattc_cb_param_t* evtParam = (esp_ble_gattc_cb_param_t*) param;
-	ESP_LOGV(LOG_TAG, "GATT Event: %s", BLEUtils::gattClientEventTypeToString(event).c_str());
+	ESP_LOGV(LOG_TAG, "GATT Event: %s", BLEUtils::gattClientEventTypeToString(event));
 	switch (event) {
 #if CONFIG_LOG_DEFAULT_LEVEL > 4
 		// ESP_GATTC_CLOSE_EVT
@@ -1279,8 +1272,8 @@ void BLEUtils::dumpGattClientEvent(
 		// - esp_gatt_conn_reason_t reason
 		case ESP_GATTC_CLOSE_EVT: {
 			ESP_LOGV(LOG_TAG, "[status: %s, reason:%s, conn_id: %d]",
-				BLEUtils::gattStatusToString(evtParam->close.status).c_str(),
-				BLEUtils::gattCloseReasonToString(evtParam->close.reason).c_str(),
+				BLEUtils::gattStatusToString(evtParam->close.status),
+				BLEUtils::gattCloseReasonToString(evtParam->close.reason),
 				evtParam->close.conn_id);
 			break;
 		}
@@ -1307,7 +1300,7 @@ void BLEUtils::dumpGattClientEvent(
 		// - esp_bd_addr_t          remote_bda
 		case ESP_GATTC_DISCONNECT_EVT: {
 			ESP_LOGV(LOG_TAG, "[reason: %s, conn_id: %d, remote_bda: %s]",
-				BLEUtils::gattCloseReasonToString(evtParam->disconnect.reason).c_str(),
+				BLEUtils::gattCloseReasonToString(evtParam->disconnect.reason),
 				evtParam->disconnect.conn_id,
 				BLEAddress(evtParam->disconnect.remote_bda).toString().c_str()
 			);
@@ -1333,7 +1326,7 @@ void BLEUtils::dumpGattClientEvent(
 					description = BLEUtils::gattCharacteristicUUIDToString(evtParam->get_char.char_id.uuid.uuid.uuid16);
 				}
 				ESP_LOGV(LOG_TAG, "[status: %s, conn_id: %d, srvc_id: %s, char_id: %s [description: %s]\nchar_prop: %s]",
-					BLEUtils::gattStatusToString(evtParam->get_char.status).c_str(),
+					BLEUtils::gattStatusToString(evtParam->get_char.status),
 					evtParam->get_char.conn_id,
 					BLEUtils::gattServiceIdToString(evtParam->get_char.srvc_id).c_str(),
 					gattIdToString(evtParam->get_char.char_id).c_str(),
@@ -1342,7 +1335,7 @@ void BLEUtils::dumpGattClientEvent(
 				);
 			} else {
 				ESP_LOGV(LOG_TAG, "[status: %s, conn_id: %d, srvc_id: %s]",
-					BLEUtils::gattStatusToString(evtParam->get_char.status).c_str(),
+					BLEUtils::gattStatusToString(evtParam->get_char.status),
 					evtParam->get_char.conn_id,
 					BLEUtils::gattServiceIdToString(evtParam->get_char.srvc_id).c_str()
 				);
@@ -1383,7 +1376,7 @@ void BLEUtils::dumpGattClientEvent(
 		//
 		case ESP_GATTC_OPEN_EVT: {
 			ESP_LOGV(LOG_TAG, "[status: %s, conn_id: %d, remote_bda: %s, mtu: %d]",
-				BLEUtils::gattStatusToString(evtParam->open.status).c_str(),
+				BLEUtils::gattStatusToString(evtParam->open.status),
 				evtParam->open.conn_id,
 				BLEAddress(evtParam->open.remote_bda).toString().c_str(),
 				evtParam->open.mtu);
@@ -1403,7 +1396,7 @@ void BLEUtils::dumpGattClientEvent(
 		// uint16_t           value_len
 		case ESP_GATTC_READ_CHAR_EVT: {
 			ESP_LOGV(LOG_TAG, "[status: %s, conn_id: %d, handle: %d 0x%.2x, value_len: %d]",
-				BLEUtils::gattStatusToString(evtParam->read.status).c_str(),
+				BLEUtils::gattStatusToString(evtParam->read.status),
 				evtParam->read.conn_id,
 				evtParam->read.handle,
 				evtParam->read.handle,
@@ -1427,7 +1420,7 @@ void BLEUtils::dumpGattClientEvent(
 		// - uint16_t          app_id
 		case ESP_GATTC_REG_EVT: {
 			ESP_LOGV(LOG_TAG, "[status: %s, app_id: 0x%x]",
-				BLEUtils::gattStatusToString(evtParam->reg.status).c_str(),
+				BLEUtils::gattStatusToString(evtParam->reg.status),
 				evtParam->reg.app_id);
 			break;
 		} // ESP_GATTC_REG_EVT
@@ -1439,7 +1432,7 @@ void BLEUtils::dumpGattClientEvent(
 		// - uint16_t          handle
 		case ESP_GATTC_REG_FOR_NOTIFY_EVT: {
 			ESP_LOGV(LOG_TAG, "[status: %s, handle: %d 0x%.2x]",
-				BLEUtils::gattStatusToString(evtParam->reg_for_notify.status).c_str(),
+				BLEUtils::gattStatusToString(evtParam->reg_for_notify.status),
 				evtParam->reg_for_notify.handle,
 				evtParam->reg_for_notify.handle
 			);
@@ -1453,7 +1446,7 @@ void BLEUtils::dumpGattClientEvent(
 		// - uint16_t          conn_id
 		case ESP_GATTC_SEARCH_CMPL_EVT: {
 			ESP_LOGV(LOG_TAG, "[status: %s, conn_id: %d]",
-				BLEUtils::gattStatusToString(evtParam->search_cmpl.status).c_str(),
+				BLEUtils::gattStatusToString(evtParam->search_cmpl.status),
 				evtParam->search_cmpl.conn_id);
 			break;
 		} // ESP_GATTC_SEARCH_CMPL_EVT
@@ -1485,7 +1478,7 @@ void BLEUtils::dumpGattClientEvent(
 		// - uint16_t          offset
 		case ESP_GATTC_WRITE_CHAR_EVT: {
 			ESP_LOGV(LOG_TAG, "[status: %s, conn_id: %d, handle: %d 0x%.2x, offset: %d]",
-				BLEUtils::gattStatusToString(evtParam->write.status).c_str(),
+				BLEUtils::gattStatusToString(evtParam->write.status),
 				evtParam->write.conn_id,
 				evtParam->write.handle,
 				evtParam->write.handle,
@@ -1514,13 +1507,13 @@ void BLEUtils::dumpGattServerEvent(
 		esp_gatts_cb_event_t      event,
 		esp_gatt_if_t             gatts_if,
 		esp_ble_gatts_cb_param_t* evtParam) {
-	ESP_LOGV(LOG_TAG, "GATT ServerEvent: %s", BLEUtils::gattServerEventTypeToString(event).c_str());
+	ESP_LOGV(LOG_TAG, "GATT ServerEvent: %s", BLEUtils::gattServerEventTypeToString(event));
 	switch (event) {
 #if CONFIG_LOG_DEFAULT_LEVEL > 4
 
 		case ESP_GATTS_ADD_CHAR_DESCR_EVT: {
 			ESP_LOGV(LOG_TAG, "[status: %s, attr_handle: %d 0x%.2x, service_handle: %d 0x%.2x, char_uuid: %s]",
-				gattStatusToString(evtParam->add_char_descr.status).c_str(),
+				gattStatusToString(evtParam->add_char_descr.status),
 				evtParam->add_char_descr.attr_handle,
 				evtParam->add_char_descr.attr_handle,
 				evtParam->add_char_descr.service_handle,
@@ -1532,7 +1525,7 @@ void BLEUtils::dumpGattServerEvent(
 		case ESP_GATTS_ADD_CHAR_EVT: {
 			if (evtParam->add_char.status == ESP_GATT_OK) {
 				ESP_LOGV(LOG_TAG, "[status: %s, attr_handle: %d 0x%.2x, service_handle: %d 0x%.2x, char_uuid: %s]",
-					gattStatusToString(evtParam->add_char.status).c_str(),
+					gattStatusToString(evtParam->add_char.status),
 					evtParam->add_char.attr_handle,
 					evtParam->add_char.attr_handle,
 					evtParam->add_char.service_handle,
@@ -1540,7 +1533,7 @@ void BLEUtils::dumpGattServerEvent(
 					BLEUUID(evtParam->add_char.char_uuid).toString().c_str());
 			} else {
 				ESP_LOGE(LOG_TAG, "[status: %s, attr_handle: %d 0x%.2x, service_handle: %d 0x%.2x, char_uuid: %s]",
-					gattStatusToString(evtParam->add_char.status).c_str(),
+					gattStatusToString(evtParam->add_char.status),
 					evtParam->add_char.attr_handle,
 					evtParam->add_char.attr_handle,
 					evtParam->add_char.service_handle,
@@ -1558,7 +1551,7 @@ void BLEUtils::dumpGattServerEvent(
 		// - uint16_t          conn_id – The connection used.
 		case ESP_GATTS_CONF_EVT: {
 			ESP_LOGV(LOG_TAG, "[status: %s, conn_id: 0x%.2x]",
-				gattStatusToString(evtParam->conf.status).c_str(),
+				gattStatusToString(evtParam->conf.status),
 				evtParam->conf.conn_id);
 			break;
 		} // ESP_GATTS_CONF_EVT
@@ -1580,7 +1573,7 @@ void BLEUtils::dumpGattServerEvent(
 
 		case ESP_GATTS_CREATE_EVT: {
 			ESP_LOGV(LOG_TAG, "[status: %s, service_handle: %d 0x%.2x, service_id: [%s]]",
-				gattStatusToString(evtParam->create.status).c_str(),
+				gattStatusToString(evtParam->create.status),
 				evtParam->create.service_handle,
 				evtParam->create.service_handle,
 				gattServiceIdToString(evtParam->create.service_id).c_str());
@@ -1649,14 +1642,14 @@ void BLEUtils::dumpGattServerEvent(
 
 		case ESP_GATTS_RESPONSE_EVT: {
 			ESP_LOGV(LOG_TAG, "[status: %s, handle: 0x%.2x]",
-				gattStatusToString(evtParam->rsp.status).c_str(),
+				gattStatusToString(evtParam->rsp.status),
 				evtParam->rsp.handle);
 			break;
 		} // ESP_GATTS_RESPONSE_EVT
 
 		case ESP_GATTS_REG_EVT: {
 			ESP_LOGV(LOG_TAG, "[status: %s, app_id: %d]",
-				gattStatusToString(evtParam->reg.status).c_str(),
+				gattStatusToString(evtParam->reg.status),
 				evtParam->reg.app_id);
 			break;
 		} // ESP_GATTS_REG_EVT
@@ -1669,7 +1662,7 @@ void BLEUtils::dumpGattServerEvent(
 		// - uint16_t          service_handle
 		case ESP_GATTS_START_EVT: {
 			ESP_LOGV(LOG_TAG, "[status: %s, service_handle: 0x%.2x]",
-				gattStatusToString(evtParam->start.status).c_str(),
+				gattStatusToString(evtParam->start.status),
 				evtParam->start.service_handle);
 			break;
 		} // ESP_GATTS_START_EVT
@@ -1803,14 +1796,18 @@ const char* BLEUtils::gapEventToString(uint32_t eventType) {
 } // gapEventToString
 
 
-std::string BLEUtils::gattCharacteristicUUIDToString(uint32_t characteristicUUID) {
-	const characteristicMap_t* p = g_characteristicsMappings;
-	while (strlen(p->name) > 0) {
-		if (p->assignedNumber == characteristicUUID) {
-			return std::string(p->name);
-		}
-		p++;
+/**
+ * @brief Given the UUID for a BLE defined characteristic, return its name.
+ * @param [in] characteristicUUID UUID of the characteristic.
+ * @return The name of the characteristic or "Unknown".
+ */
+const char* BLEUtils::gattCharacteristicUUIDToString(uint32_t characteristicUUID) {
+#if CONFIG_BLE_UTILS_ASSIGNED_NUMBER_NAMES
+	const char* name = findAssignedNumber(g_characteristicsMappings, characteristicUUID);
+	if (name != nullptr) {
+		return name;
 	}
+#endif
 	return "Unknown";
 } // gattCharacteristicUUIDToString
 
@@ -1820,14 +1817,13 @@ std::string BLEUtils::gattCharacteristicUUIDToString(uint32_t characteristicUUID
  * @param [in] descriptorUUID UUID of the descriptor to be returned as a string.
  * @return The string representation of a descriptor UUID.
  */
-std::string BLEUtils::gattDescriptorUUIDToString(uint32_t descriptorUUID) {
-	gattdescriptor_t* p = (gattdescriptor_t*) g_descriptor_ids;
-	while (strlen(p->name) > 0) {
-		if (p->assignedNumber == descriptorUUID) {
-			return std::string(p->name);
-		}
-		p++;
+const char* BLEUtils::gattDescriptorUUIDToString(uint32_t descriptorUUID) {
+#if CONFIG_BLE_UTILS_ASSIGNED_NUMBER_NAMES
+	const char* name = findAssignedNumber(g_descriptor_ids, descriptorUUID);
+	if (name != nullptr) {
+		return name;
 	}
+#endif
 	return "";
 } // gattDescriptorUUIDToString
 
@@ -1856,14 +1852,18 @@ std::string BLEUtils::gattServiceIdToString(esp_gatt_srvc_id_t srvcId) {
 } // gattServiceIdToString
 
 
-std::string BLEUtils::gattServiceToString(uint32_t serviceId) {
-	gattService_t* p = (gattService_t*) g_gattServices;
-	while (strlen(p->name) > 0) {
-		if (p->assignedNumber == serviceId) {
-			return std::string(p->name);
-		}
-		p++;
+/**
+ * @brief Given the UUID for a BLE defined service, return its name.
+ * @param [in] serviceId UUID of the service.
+ * @return The name of the service or "Unknown".
+ */
+const char* BLEUtils::gattServiceToString(uint32_t serviceId) {
+#if CONFIG_BLE_UTILS_ASSIGNED_NUMBER_NAMES
+	const char* name = findAssignedNumber(g_gattServices, serviceId);
+	if (name != nullptr) {
+		return name;
 	}
+#endif
 	return "Unknown";
 } // gattServiceToString
 
@@ -1874,7 +1874,7 @@ std::string BLEUtils::gattServiceToString(uint32_t serviceId) {
  * @param [in] status The status to convert.
  * @return A string representation of the status.
  */
-std::string BLEUtils::gattStatusToString(esp_gatt_status_t status) {
+const char* BLEUtils::gattStatusToString(esp_gatt_status_t status) {
 	switch (status) {
 		case ESP_GATT_OK:
 			return "ESP_GATT_OK";
@@ -1967,19 +1967,20 @@ std::string BLEUtils::gattStatusToString(esp_gatt_status_t status) {
 	}
 } // gattStatusToString
 
-
-
-std::string BLEUtils::getMember(uint32_t memberId) {
-	member_t* p = (member_t*) members_ids;
-
-	while (strlen(p->name) > 0) {
-		if (p->assignedNumber == memberId) {
-			return std::string(p->name);
-		}
-		p++;
+/**
+ * @brief Given a company identifier assigned to a Bluetooth SIG member, return the name of the member.
+ * @param [in] memberId The company identifier.
+ * @return The name of the member or "Unknown".
+ */
+const char* BLEUtils::getMember(uint32_t memberId) {
+#if CONFIG_BLE_UTILS_ASSIGNED_NUMBER_NAMES
+	const char* name = findAssignedNumber(members_ids, memberId);
+	if (name != nullptr) {
+		return name;
 	}
+#endif
 	return "Unknown";
-}
+} // getMember
 
 /**
  * @brief convert a GAP search event to a string.
@@ -44,16 +44,16 @@ public:
 	static BLEClient*  findByAddress(BLEAddress address);
 	static BLEClient*  findByConnId(uint16_t conn_id);
 	static const char* gapEventToString(uint32_t eventType);
-	static std::string gattCharacteristicUUIDToString(uint32_t characteristicUUID);
-	static std::string gattClientEventTypeToString(esp_gattc_cb_event_t eventType);
-	static std::string gattCloseReasonToString(esp_gatt_conn_reason_t reason);
+	static const char* gattCharacteristicUUIDToString(uint32_t characteristicUUID);
+	static const char* gattClientEventTypeToString(esp_gattc_cb_event_t eventType);
+	static const char* gattCloseReasonToString(esp_gatt_conn_reason_t reason);
 	static std::string gattcServiceElementToString(esp_gattc_service_elem_t* pGATTCServiceElement);
-	static std::string gattDescriptorUUIDToString(uint32_t descriptorUUID);
-	static std::string gattServerEventTypeToString(esp_gatts_cb_event_t eventType);
+	static const char* gattDescriptorUUIDToString(uint32_t descriptorUUID);
+	static const char* gattServerEventTypeToString(esp_gatts_cb_event_t eventType);
 	static std::string gattServiceIdToString(esp_gatt_srvc_id_t srvcId);
-	static std::string gattServiceToString(uint32_t serviceId);
-	static std::string gattStatusToString(esp_gatt_status_t status);
-	static std::string getMember(uint32_t memberId);
+	static const char* gattServiceToString(uint32_t serviceId);
+	static const char* gattStatusToString(esp_gatt_status_t status);
+	static const char* getMember(uint32_t memberId);
 	static void        registerByAddress(BLEAddress address, BLEClient* pDevice);
 	static void        registerByConnId(uint16_t conn_id, BLEClient* pDevice);
 	static const char* searchEventTypeToString(esp_gap_search_evt_t searchEvt);
@@ -132,7 +132,7 @@ void BLEValue::setValue(std::string value) {
  * @param [in] The length of the new current value.
  */
 void BLEValue::setValue(uint8_t* pData, size_t length) {
-	m_value = std::string((char*) pData, length);
+	m_value.assign((char*) pData, length);
 } // setValue
 
 
@@ -67,9 +67,8 @@ uint32_t FreeRTOS::getTimeSinceStart() {
  */
 uint32_t FreeRTOS::Semaphore::wait(std::string owner) {
 	ESP_LOGV(LOG_TAG, ">> wait: Semaphore waiting: %s for %s", toString().c_str(), owner.c_str());
-	
-	m_owner = owner;
 
+	// The owner is left alone; we never hold the semaphore for longer than it takes to hand it back.
 	if (m_usePthreads) {
 		pthread_mutex_lock(&m_pthread_mutex);
 	} else {
@@ -117,6 +116,8 @@ FreeRTOS::Semaphore::~Semaphore() {
  */
 void FreeRTOS::Semaphore::give() {
 	ESP_LOGV(LOG_TAG, "Semaphore giving: %s", toString().c_str());
+	// Touch nothing after the give; the task that takes the semaphore next may already be running.
+	m_owner = std::string("<N/A>");
 	if (m_usePthreads) {
 		pthread_mutex_unlock(&m_pthread_mutex);
 	} else {
@@ -125,8 +126,6 @@ void FreeRTOS::Semaphore::give() {
 // #ifdef ARDUINO_ARCH_ESP32
 // 	FreeRTOS::sleep(10);
 // #endif
-
-	m_owner = std::string("<N/A>");
 } // Semaphore::give
 
 
@@ -168,8 +167,8 @@ bool FreeRTOS::Semaphore::take(std::string owner) {
 	} else {
 		rc = ::xSemaphoreTake(m_semaphore, portMAX_DELAY) == pdTRUE;
 	}
-	m_owner = owner;
 	if (rc) {
+		m_owner = owner;
 		ESP_LOGD(LOG_TAG, "Semaphore taken:  %s", toString().c_str());
 	} else {
 		ESP_LOGE(LOG_TAG, "Semaphore NOT taken:  %s", toString().c_str());
@@ -193,8 +192,8 @@ bool FreeRTOS::Semaphore::take(uint32_t timeoutMs, std::string owner) {
 	} else {
 		rc = ::xSemaphoreTake(m_semaphore, timeoutMs / portTICK_PERIOD_MS) == pdTRUE;
 	}
-	m_owner = owner;
 	if (rc) {
+		m_owner = owner;
 		ESP_LOGV(LOG_TAG, "Semaphore taken:  %s", toString().c_str());
 	} else {
 		ESP_LOGE(LOG_TAG, "Semaphore NOT taken:  %s", toString().c_str());
@@ -210,7 +209,7 @@ bool FreeRTOS::Semaphore::take(uint32_t timeoutMs, std::string owner) {
  */
 std::string FreeRTOS::Semaphore::toString() {
 	std::stringstream stringStream;
-	stringStream << "name: "<< m_name << " (0x" << std::hex << std::setfill('0') << (uint32_t)m_semaphore << "), owner: " << m_owner;
+	stringStream << "name: "<< m_name << " (0x" << std::hex << std::setfill('0') << (uintptr_t)m_semaphore << "), owner: " << m_owner;
 	return stringStream.str();
 } // toString
 
@@ -224,6 +223,42 @@ void FreeRTOS::Semaphore::setName(std::string name) {
 } // setName
 
 
+FreeRTOS::Mutex::Mutex() {
+	m_mutex = ::xSemaphoreCreateMutex();
+} // Mutex
+
+
+FreeRTOS::Mutex::~Mutex() {
+	::vSemaphoreDelete(m_mutex);
+} // ~Mutex
+
+
+/**
+ * @brief Lock the mutex, waiting for as long as another task holds it.
+ */
+void FreeRTOS::Mutex::lock() {
+	::xSemaphoreTake(m_mutex, portMAX_DELAY);
+} // lock
+
+
+/**
+ * @brief Lock the mutex if no other task holds it.
+ * @return True if the mutex was locked.
+ */
+bool FreeRTOS::Mutex::tryLock() {
+	return ::xSemaphoreTake(m_mutex, 0) == pdTRUE;
+} // tryLock
+
+
+/**
+ * @brief Unlock the mutex.
+ * Must be called by the task that locked it.
+ */
+void FreeRTOS::Mutex::unlock() {
+	::xSemaphoreGive(m_mutex);
+} // unlock
+
+
 /**
  * @brief Create a ring buffer.
  * @param [in] length The amount of storage to allocate for the ring buffer.
@@ -50,6 +50,23 @@ public:
 		bool              m_usePthreads;
 
 	};
+
+	/**
+	 * @brief A lock shared by tasks.
+	 * Unlike a Semaphore, a Mutex is always unlocked by the task that locked it, lends that task the
+	 * priority of any task waiting for it, and keeps no owner string, so locking it never allocates.
+	 */
+	class Mutex {
+	public:
+		Mutex();
+		~Mutex();
+		void lock();
+		bool tryLock();
+		void unlock();
+
+	private:
+		SemaphoreHandle_t m_mutex;
+	};
 };
 
 
@@ -0,0 +1,491 @@
+/*
+ * BLEThroughputBenchmark.cpp
+ *
+ * Measure how fast the BLE classes handle events against the simulated stack, and how often they
+ * allocate.  A server with a command and a notifying status characteristic has three clients:
+ *
+ * - write, write without response, read: a client accesses the command characteristic.
+ * - notify: the status is notified to every subscribed client.
+ * - scan stream: advertising reports from a hall of beacons feed a streaming scan.
+ * - scan filtered: the same reports, none of which pass the scan filter.
+ *
+ * The device then acts as a central to four peripherals whose answers take a fixed time over the air:
+ *
+ * - client read, client read async: their status is read with readValue() and readValueAsync().
+ * - client notify: their status notifications are routed to the right characteristic callback.
+ * - manager notify: the same notifications are queued by a BLEConnectionManager.
+ * - reconnect discover, reconnect cached: a link is remade and the peripheral discovered, or built
+ *   from the discovery cache.  These are also reported per connection.
+ * - manager reconnect: the links of the connection manager's peers are dropped for it to remake.
+ *
+ * Each scenario reports events per second, values notified per second and heap allocations per event,
+ * and the statistics of the manager's peers are printed last.
+ *
+ * Usage: ble_throughput_benchmark [iterations]
+ *
+ * The exit status is non-zero if an event was lost, a callback count does not match what was injected,
+ * or a scenario allocates more per event than its own maximum.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <esp_log.h>
+#include "BLE2902.h"
+#include "BLECharacteristic.h"
+#include "BLEConnectionManager.h"
+#include "BLEDevice.h"
+#include "BLEDiscoveryCache.h"
+#include "BLEHostSim.h"
+#include "BLERemoteCharacteristic.h"
+#include "BLEScan.h"
+#include "BLEScanStream.h"
+#include "BLEServer.h"
+
+#define SERVICE_UUID "4fafc201-1fb5-459e-8fcc-c5c9c331914b"
+#define COMMAND_UUID "beb5483e-36e1-4688-b7f5-ea07361b26a8"
+#define STATUS_UUID  "beb5483e-36e1-4688-b7f5-ea07361b26a9"
+
+static const uint16_t CLIENTS = 3;
+static const uint16_t MTU     = 247;
+static const uint16_t BEACONS = 64;
+static const uint16_t PEERS   = 4;
+static const uint32_t LINK_LATENCY_US = 500;
+
+static std::atomic<uint64_t> allocations(0);
+
+
+void* operator new(size_t size) {
+	allocations++;
+	void* p = malloc(size > 0 ? size : 1);
+	if (p == nullptr) throw std::bad_alloc();
+	return p;
+}
+
+void* operator new[](size_t size) {
+	return operator new(size);
+}
+
+// Kept out of line, or GCC matches the inlined free() against the new expression and warns of a mismatch.
+__attribute__((noinline)) void operator delete(void* p) noexcept {
+	free(p);
+}
+
+void operator delete[](void* p) noexcept {
+	operator delete(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+	operator delete(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+	operator delete(p);
+}
+
+
+class CountingCallbacks : public BLECharacteristicCallbacks {
+public:
+	std::atomic<uint32_t> reads;
+	std::atomic<uint32_t> writes;
+
+	CountingCallbacks() : reads(0), writes(0) {}
+	void onRead(BLECharacteristic*) override { reads++; }
+	void onWrite(BLECharacteristic*) override { writes++; }
+};
+
+
+class CountingStreamCallbacks : public BLEScanStreamCallbacks {
+public:
+	std::atomic<uint32_t> found;
+	std::atomic<uint32_t> updated;
+	std::atomic<uint32_t> lost;
+
+	CountingStreamCallbacks() : found(0), updated(0), lost(0) {}
+	void onNew(BLETrackedDevice*) override { found++; }
+	void onUpdated(BLETrackedDevice*) override { updated++; }
+	void onLost(BLETrackedDevice*) override { lost++; }
+};
+
+
+typedef struct {
+	const char* name;
+	double      maxAllocations;   // Per event, as last measured; 0.01 allows for storage that is only filled once.
+	double      seconds;
+	uint32_t    events;
+	uint32_t    notifications;
+	uint64_t    allocations;
+} result_t;
+
+
+static BLECharacteristic* pCommand;
+static BLECharacteristic* pStatus;
+static CountingCallbacks  callbacks;
+static CountingStreamCallbacks streamCallbacks;
+static BLERemoteCharacteristic* peerStatus[PEERS];
+static std::atomic<uint32_t>    peerReads(0);
+static std::atomic<uint32_t>    peerNotifications(0);
+static std::atomic<uint32_t>    managerConnected(0);
+static std::atomic<uint32_t>    managerDisconnected(0);
+static std::atomic<uint32_t>    managerNotifications(0);
+
+
+static void onPeerRead(BLERemoteOperation* pOperation) {
+	if (pOperation->getStatus() == ESP_GATT_OK && pOperation->getValue().length() == 4) peerReads++;
+}
+
+
+static void onPeerNotify(BLERemoteCharacteristic*, uint8_t*, size_t length, bool) {
+	if (length == 4) peerNotifications++;
+}
+
+
+/*
+ * The application task of the connection manager: take its events off the queue and count them.
+ */
+static void consumeManagerEvents(void* pData) {
+	BLEConnectionManager* pManager = (BLEConnectionManager*) pData;
+	ble_connection_event_t event;
+	while (true) {
+		if (!pManager->receive(&event)) continue;
+		if (event.type == BLEConnectionManager::EVENT_CONNECTED) managerConnected++;
+		if (event.type == BLEConnectionManager::EVENT_DISCONNECTED) managerDisconnected++;
+		if (event.type == BLEConnectionManager::EVENT_NOTIFY && event.length == 4) managerNotifications++;
+	}
+}
+
+
+/*
+ * Wait up to five seconds for a count to reach a value.
+ */
+static bool waitForCount(std::atomic<uint32_t>& count, uint32_t expected) {
+	for (int i = 0; i < 5000 && count < expected; i++) {
+		::vTaskDelay(1);
+	}
+	return count >= expected;
+}
+
+
+/*
+ * Run a scenario: inject through the function given, wait for the stack to go idle, and measure.
+ */
+template<typename Inject>
+static result_t measure(const char* name, double maxAllocations, Inject inject) {
+	BLEHostSim::flush();
+	BLEHostSim::resetStats();
+	uint64_t allocationsBefore = allocations;
+	auto start = std::chrono::steady_clock::now();
+
+	inject();
+	BLEHostSim::flush();
+
+	auto end = std::chrono::steady_clock::now();
+	BLEHostSim::stats_t stats = BLEHostSim::getStats();
+	result_t result;
+	result.name           = name;
+	result.maxAllocations = maxAllocations;
+	result.seconds       = std::chrono::duration<double>(end - start).count();
+	result.events        = stats.events;
+	result.notifications = stats.notifications + stats.indications;
+	result.allocations   = allocations - allocationsBefore;
+	return result;
+}
+
+
+static void setup() {
+	BLEDevice::init("Elevator");
+	BLEServer*  pServer  = BLEDevice::createServer();
+	BLEService* pService = pServer->createService(SERVICE_UUID);
+
+	pCommand = pService->createCharacteristic(COMMAND_UUID,
+		BLECharacteristic::PROPERTY_READ | BLECharacteristic::PROPERTY_WRITE | BLECharacteristic::PROPERTY_WRITE_NR);
+	pCommand->setCallbacks(&callbacks);
+	uint8_t floor = 0;
+	pCommand->setValue(&floor, 1);
+
+	pStatus = pService->createCharacteristic(STATUS_UUID,
+		BLECharacteristic::PROPERTY_READ | BLECharacteristic::PROPERTY_NOTIFY);
+	pStatus->addDescriptor(new BLE2902());
+
+	pService->start();
+	BLEHostSim::flush();
+
+	uint16_t cccdHandle = pStatus->getDescriptorByUUID((uint16_t)0x2902)->getHandle();
+	const uint8_t enableNotify[] = { 0x01, 0x00 };
+	for (uint16_t connId = 0; connId < CLIENTS; connId++) {
+		BLEHostSim::connect(connId);
+		BLEHostSim::setMTU(connId, MTU);
+		BLEHostSim::write(connId, cccdHandle, enableNotify, sizeof(enableNotify));
+	}
+	BLEHostSim::flush();
+}
+
+
+/*
+ * Connect to the simulated peripherals and discover their status characteristics.
+ */
+static bool setupPeers() {
+	for (uint16_t i = 0; i < PEERS; i++) {
+		uint8_t    address[6] = { 0xd0, 0x00, 0x00, 0x00, 0x00, (uint8_t)i };
+		BLEClient* pClient    = BLEDevice::createClient();
+		if (!pClient->connect(BLEAddress(address))) return false;
+		BLERemoteService* pService = pClient->getService(BLEUUID(BLEHostSim::PERIPHERAL_SERVICE_UUID));
+		if (pService == nullptr) return false;
+		peerStatus[i] = pService->getCharacteristic(BLEUUID(BLEHostSim::PERIPHERAL_STATUS_UUID));
+		if (peerStatus[i] == nullptr) return false;
+		peerStatus[i]->registerForNotify(onPeerNotify);
+	}
+	return true;
+}
+
+
+/*
+ * Drop the connection of a client and connect again, then read the status of the peripheral as an
+ * application would straight after connecting.
+ */
+static bool reconnect(BLEClient* pClient, BLEAddress address) {
+	pClient->disconnect();
+	BLEHostSim::flush();
+	if (!pClient->connect(address)) return false;
+	BLERemoteService* pService = pClient->getService(BLEUUID(BLEHostSim::PERIPHERAL_SERVICE_UUID));
+	if (pService == nullptr) return false;
+	BLERemoteCharacteristic* pCharacteristic = pService->getCharacteristic(BLEUUID(BLEHostSim::PERIPHERAL_STATUS_UUID));
+	return pCharacteristic != nullptr && pCharacteristic->readValue().length() == 4;
+}
+
+
+static bool report(const result_t& result) {
+	double allocationsPerEvent = result.events > 0 ? (double)result.allocations / result.events : 0.0;
+	printf("%-22s %10.3f %12.0f %12.0f %10.2f\n",
+		result.name,
+		result.seconds * 1000,
+		result.events / result.seconds,
+		result.notifications / result.seconds,
+		allocationsPerEvent);
+	if (allocationsPerEvent > result.maxAllocations) {
+		printf("FAIL: %s allocates more than %.2f times per event\n", result.name, result.maxAllocations);
+		return false;
+	}
+	return true;
+}
+
+
+int main(int argc, char* argv[]) {
+	uint32_t iterations = argc > 1 ? strtoul(argv[1], nullptr, 0) : 100000;
+	int      rc         = EXIT_SUCCESS;
+
+	esp_log_level_set("*", ESP_LOG_WARN);
+	esp_log_level_set("gattClientEventHandler", ESP_LOG_NONE);   // BLEClient reports every disconnection as an error.
+	setup();
+
+	uint16_t commandHandle = pCommand->getHandle();
+	uint8_t  value[20]     = { 0 };
+
+	result_t results[10];
+	results[0] = measure("write", 0.01, [&] {
+		for (uint32_t i = 0; i < iterations; i++) {
+			value[0] = (uint8_t)i;
+			BLEHostSim::write(i % CLIENTS, commandHandle, value, 1, true);
+		}
+	});
+	results[1] = measure("write without response", 0.01, [&] {
+		for (uint32_t i = 0; i < iterations; i++) {
+			value[0] = (uint8_t)i;
+			BLEHostSim::write(i % CLIENTS, commandHandle, value, 1, false);
+		}
+	});
+	results[2] = measure("read", 0.01, [&] {
+		for (uint32_t i = 0; i < iterations; i++) {
+			BLEHostSim::read(i % CLIENTS, commandHandle);
+		}
+	});
+	results[3] = measure("notify", 0.01, [&] {
+		for (uint32_t i = 0; i < iterations; i++) {
+			value[0] = (uint8_t)i;
+			pStatus->setValue(value, sizeof(value));
+			pStatus->notify();
+		}
+	});
+
+	BLEScan* pScan = BLEDevice::getScan();
+	pScan->setStreamCallbacks(&streamCallbacks, 2 * BEACONS);
+	pScan->start(0, nullptr);
+	BLEHostSim::flush();
+	const uint8_t advertisement[] = {
+		0x02, 0x01, 0x06,                           // Flags
+		0x03, 0x03, 0x0f, 0x18,                     // Complete list of 16 bit service UUIDs: 0x180f
+		0x06, 0x09, 'P', 'a', 'n', 'e', 'l'         // Complete local name
+	};
+	results[4] = measure("scan stream", 0.01, [&] {
+		uint8_t address[6] = { 0xc0, 0x00, 0x00, 0x00, 0x00, 0x00 };
+		for (uint32_t i = 0; i < iterations; i++) {
+			address[5] = (uint8_t)(i % BEACONS);
+			BLEHostSim::advertise(address, -60 - (int)(i % 20), advertisement, sizeof(advertisement));
+		}
+	});
+	BLEScanFilter filter;
+	filter.setManufacturerId(0x02e5);  // None of the beacons send manufacturer data.
+	pScan->addFilter(filter);
+	results[5] = measure("scan filtered", 0.01, [&] {
+		uint8_t address[6] = { 0xc1, 0x00, 0x00, 0x00, 0x00, 0x00 };
+		for (uint32_t i = 0; i < iterations; i++) {
+			address[5] = (uint8_t)(i % BEACONS);
+			BLEHostSim::advertise(address, -60 - (int)(i % 20), advertisement, sizeof(advertisement));
+		}
+	});
+	pScan->stop();
+	BLEHostSim::flush();
+
+	if (!setupPeers()) {
+		printf("FAIL: could not connect to and discover the peripherals\n");
+		return EXIT_FAILURE;
+	}
+	BLEHostSim::setLinkLatency(LINK_LATENCY_US);
+	uint32_t peerIterations = iterations / 100 > PEERS ? iterations / 100 : PEERS;
+	uint32_t blockingReads  = 0;
+	results[6] = measure("client read", 2.1, [&] {
+		for (uint32_t i = 0; i < peerIterations; i++) {
+			if (peerStatus[i % PEERS]->readValue().length() == 4) blockingReads++;
+		}
+	});
+	results[7] = measure("client read async", 4.05, [&] {
+		for (uint32_t i = 0; i < peerIterations; i++) {
+			peerStatus[i % PEERS]->readValueAsync(onPeerRead);
+		}
+	});
+	results[8] = measure("client notify", 0.01, [&] {
+		for (uint32_t i = 0; i < iterations; i++) {
+			value[0] = (uint8_t)i;
+			BLEHostSim::notifyClient(peerStatus[i % PEERS]->getRemoteService()->getClient()->getConnId(),
+				peerStatus[i % PEERS]->getHandle(), value, 4);
+		}
+	});
+
+
+	BLEConnectionManager* pManager = new BLEConnectionManager();   // Like the clients, kept for the life of the process.
+	pManager->setStagger(5);
+	pManager->setBackoff(10, 100);
+	for (uint16_t i = 0; i < PEERS; i++) {
+		uint8_t address[6] = { 0xd2, 0x00, 0x00, 0x00, 0x00, (uint8_t)i };
+		pManager->addPeer(BLEAddress(address));
+	}
+	pManager->addNotify(BLEUUID(BLEHostSim::PERIPHERAL_SERVICE_UUID), BLEUUID(BLEHostSim::PERIPHERAL_STATUS_UUID));
+	::xTaskCreate(&consumeManagerEvents, "consumer", 4096, pManager, 5, nullptr);
+	pManager->start();
+	if (!waitForCount(managerConnected, PEERS)) {
+		printf("FAIL: the connection manager did not connect to the peripherals\n%s", pManager->toString().c_str());
+		return EXIT_FAILURE;
+	}
+	results[9] = measure("manager notify", 0.01, [&] {
+		for (uint32_t i = 0; i < iterations; i++) {
+			value[0] = (uint8_t)i;
+			BLEHostSim::notifyClient(pManager->getClient(i % PEERS)->getConnId(), peerStatus[0]->getHandle(), value, 4);
+		}
+		BLEHostSim::flush();
+		for (int i = 0; i < 5000 && managerNotifications + pManager->getDropped() < iterations; i++) {
+			::vTaskDelay(1);
+		}
+	});
+
+	uint8_t    address[6] = { 0xd1, 0x00, 0x00, 0x00, 0x00, 0x00 };
+	BLEClient* pClient    = BLEDevice::createClient();
+	pClient->connect(BLEAddress(address));
+	uint32_t reconnectIterations = iterations / 2000 > PEERS ? iterations / 2000 : PEERS;
+	uint32_t reconnects          = 0;
+	result_t connectResults[3];
+	connectResults[0] = measure("reconnect discover", 6.4, [&] {
+		for (uint32_t i = 0; i < reconnectIterations; i++) {
+			BLEDiscoveryCache::erase(BLEAddress(address));
+			if (reconnect(pClient, BLEAddress(address))) reconnects++;
+		}
+	});
+	connectResults[1] = measure("reconnect cached", 8.85, [&] {
+		for (uint32_t i = 0; i < reconnectIterations; i++) {
+			if (reconnect(pClient, BLEAddress(address))) reconnects++;
+		}
+	});
+	connectResults[2] = measure("manager reconnect", 7.6, [&] {
+		for (uint32_t i = 0; i < reconnectIterations; i++) {
+			uint32_t connected = managerConnected;
+			for (uint16_t peer = 0; peer < PEERS; peer++) {
+				BLEHostSim::dropLink(pManager->getClient(peer)->getConnId());
+			}
+			waitForCount(managerConnected, connected + PEERS);
+		}
+	});
+	for (uint32_t i = 0; i < 8 * PEERS; i++) {   // Give the manager's peers a latency to report.
+		pManager->getClient(i % PEERS)->getService(BLEUUID(BLEHostSim::PERIPHERAL_SERVICE_UUID))
+			->getCharacteristic(BLEUUID(BLEHostSim::PERIPHERAL_STATUS_UUID))->readValue();
+	}
+	BLEHostSim::setLinkLatency(0);
+
+	printf("%u iterations, %u clients, MTU %u, %u peripherals %u us away\n", iterations, CLIENTS, MTU, PEERS, LINK_LATENCY_US);
+	printf("%-22s %10s %12s %12s %10s\n", "scenario", "ms", "events/s", "notifies/s", "allocs/evt");
+	for (auto& result : results) {
+		if (!report(result)) rc = EXIT_FAILURE;
+	}
+	for (auto& result : connectResults) {
+		if (!report(result)) rc = EXIT_FAILURE;
+	}
+	// A cached reconnection has fewer events than one that discovers, so compare them per connection.
+	uint32_t connections[3] = { reconnectIterations, reconnectIterations, PEERS * reconnectIterations };
+	double   connectionAllocations[3];
+	printf("%-22s %10s %12s\n", "scenario", "ms/conn", "allocs/conn");
+	for (int i = 0; i < 3; i++) {
+		connectionAllocations[i] = (double)connectResults[i].allocations / connections[i];
+		printf("%-22s %10.3f %12.1f\n", connectResults[i].name, connectResults[i].seconds * 1000 / connections[i], connectionAllocations[i]);
+	}
+	if (connectionAllocations[1] >= connectionAllocations[0]) {
+		printf("FAIL: a reconnection from the discovery cache allocates no less than one that discovers\n");
+		rc = EXIT_FAILURE;
+	}
+	printf("%s", pManager->toString().c_str());
+
+	BLEHostSim::stats_t stats = BLEHostSim::getStats();
+	if (stats.dropped > 0) {
+		printf("FAIL: %u events dropped by the simulated stack\n", stats.dropped);
+		rc = EXIT_FAILURE;
+	}
+	if (callbacks.writes != 2 * iterations) {
+		printf("FAIL: %u writes injected but %u seen\n", 2 * iterations, (uint32_t)callbacks.writes);
+		rc = EXIT_FAILURE;
+	}
+	if (callbacks.reads != iterations) {
+		printf("FAIL: %u reads injected but %u seen\n", iterations, (uint32_t)callbacks.reads);
+		rc = EXIT_FAILURE;
+	}
+	if (streamCallbacks.found + streamCallbacks.updated != iterations || streamCallbacks.lost != 0) {
+		printf("FAIL: %u reports injected but %u new, %u updated and %u lost seen\n", iterations,
+			(uint32_t)streamCallbacks.found, (uint32_t)streamCallbacks.updated, (uint32_t)streamCallbacks.lost);
+		rc = EXIT_FAILURE;
+	}
+	if (blockingReads != peerIterations || peerReads != peerIterations) {
+		printf("FAIL: %u reads of each kind made but %u blocking and %u asynchronous completed\n", peerIterations,
+			blockingReads, (uint32_t)peerReads);
+		rc = EXIT_FAILURE;
+	}
+	if (reconnects != 2 * reconnectIterations) {
+		printf("FAIL: %u reconnections made but %u read the status\n", 2 * reconnectIterations, reconnects);
+		rc = EXIT_FAILURE;
+	}
+	if (peerNotifications != iterations) {
+		printf("FAIL: %u notifications sent by the peripherals but %u seen\n", iterations, (uint32_t)peerNotifications);
+		rc = EXIT_FAILURE;
+	}
+	if (managerNotifications + pManager->getDropped() != iterations) {
+		printf("FAIL: %u notifications sent to the connection manager but %u received and %u dropped\n", iterations,
+			(uint32_t)managerNotifications, pManager->getDropped());
+		rc = EXIT_FAILURE;
+	}
+	if (managerDisconnected != PEERS * reconnectIterations || managerConnected != PEERS * (reconnectIterations + 1)) {
+		printf("FAIL: %u links of the connection manager dropped but %u disconnections and %u reconnections seen\n",
+			PEERS * reconnectIterations, (uint32_t)managerDisconnected, (uint32_t)managerConnected - PEERS);
+		rc = EXIT_FAILURE;
+	}
+	if (pScan->getFilteredCount() != iterations) {
+		printf("FAIL: %u reports should have been filtered but %u were\n", iterations, pScan->getFilteredCount());
+		rc = EXIT_FAILURE;
+	}
+	return rc;
+}
@@ -0,0 +1,69 @@
+#ifndef HOST_ESP_BT_H_
+#define HOST_ESP_BT_H_
+#include <stdint.h>
+#include "esp_err.h"
+
+typedef enum {
+	ESP_BT_MODE_IDLE       = 0x00,
+	ESP_BT_MODE_BLE        = 0x01,
+	ESP_BT_MODE_CLASSIC_BT = 0x02,
+	ESP_BT_MODE_BTDM       = 0x03,
+} esp_bt_mode_t;
+
+typedef enum {
+	ESP_BT_CONTROLLER_STATUS_IDLE = 0,
+	ESP_BT_CONTROLLER_STATUS_INITED,
+	ESP_BT_CONTROLLER_STATUS_ENABLED,
+	ESP_BT_CONTROLLER_STATUS_NUM,
+} esp_bt_controller_status_t;
+
+typedef enum {
+	ESP_PWR_LVL_N12 = 0,
+	ESP_PWR_LVL_N9  = 1,
+	ESP_PWR_LVL_N6  = 2,
+	ESP_PWR_LVL_N3  = 3,
+	ESP_PWR_LVL_N0  = 4,
+	ESP_PWR_LVL_P3  = 5,
+	ESP_PWR_LVL_P6  = 6,
+	ESP_PWR_LVL_P9  = 7,
+	ESP_PWR_LVL_N14 = ESP_PWR_LVL_N12,
+	ESP_PWR_LVL_N11 = ESP_PWR_LVL_N9,
+	ESP_PWR_LVL_N8  = ESP_PWR_LVL_N6,
+	ESP_PWR_LVL_N5  = ESP_PWR_LVL_N3,
+	ESP_PWR_LVL_N2  = ESP_PWR_LVL_N0,
+	ESP_PWR_LVL_P1  = ESP_PWR_LVL_P3,
+	ESP_PWR_LVL_P4  = ESP_PWR_LVL_P6,
+	ESP_PWR_LVL_P7  = ESP_PWR_LVL_P9,
+} esp_power_level_t;
+
+typedef enum {
+	ESP_BLE_PWR_TYPE_CONN_HDL0 = 0,
+	ESP_BLE_PWR_TYPE_ADV       = 9,
+	ESP_BLE_PWR_TYPE_SCAN      = 10,
+	ESP_BLE_PWR_TYPE_DEFAULT   = 11,
+	ESP_BLE_PWR_TYPE_NUM       = 12,
+} esp_ble_power_type_t;
+
+typedef struct {
+	uint16_t controller_task_stack_size;
+	uint8_t  controller_task_prio;
+	uint8_t  mode;
+} esp_bt_controller_config_t;
+
+#define BT_CONTROLLER_INIT_CONFIG_DEFAULT() { 4096, 23, ESP_BT_MODE_BLE }
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+esp_err_t esp_bt_controller_init(esp_bt_controller_config_t* cfg);
+esp_err_t esp_bt_controller_deinit(void);
+esp_err_t esp_bt_controller_enable(esp_bt_mode_t mode);
+esp_err_t esp_bt_controller_disable(void);
+esp_bt_controller_status_t esp_bt_controller_get_status(void);
+esp_err_t esp_bt_controller_mem_release(esp_bt_mode_t mode);
+esp_err_t esp_ble_tx_power_set(esp_ble_power_type_t power_type, esp_power_level_t power_level);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOST_ESP_BT_H_ */
@@ -0,0 +1,72 @@
+#ifndef HOST_ESP_BT_DEFS_H_
+#define HOST_ESP_BT_DEFS_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+typedef enum {
+	ESP_BT_STATUS_SUCCESS = 0,
+	ESP_BT_STATUS_FAIL,
+	ESP_BT_STATUS_NOT_READY,
+	ESP_BT_STATUS_NOMEM,
+	ESP_BT_STATUS_BUSY,
+	ESP_BT_STATUS_DONE = 5,
+	ESP_BT_STATUS_UNSUPPORTED,
+	ESP_BT_STATUS_PARM_INVALID,
+	ESP_BT_STATUS_UNHANDLED,
+	ESP_BT_STATUS_AUTH_FAILURE,
+	ESP_BT_STATUS_RMT_DEV_DOWN = 10,
+	ESP_BT_STATUS_AUTH_REJECTED,
+	ESP_BT_STATUS_INVALID_STATIC_RAND_ADDR,
+	ESP_BT_STATUS_PENDING,
+	ESP_BT_STATUS_UNACCEPT_CONN_INTERVAL,
+	ESP_BT_STATUS_PARAM_OUT_OF_RANGE,
+	ESP_BT_STATUS_TIMEOUT,
+	ESP_BT_STATUS_PEER_LE_DATA_LEN_UNSUPPORTED,
+	ESP_BT_STATUS_CONTROL_LE_DATA_LEN_UNSUPPORTED,
+	ESP_BT_STATUS_ERR_ILLEGAL_PARAMETER_FMT,
+	ESP_BT_STATUS_MEMORY_FULL = 20,
+	ESP_BT_STATUS_EIR_TOO_LARGE,
+} esp_bt_status_t;
+
+#define ESP_UUID_LEN_16  2
+#define ESP_UUID_LEN_32  4
+#define ESP_UUID_LEN_128 16
+
+typedef struct {
+	uint16_t len;
+	union {
+		uint16_t uuid16;
+		uint32_t uuid32;
+		uint8_t  uuid128[ESP_UUID_LEN_128];
+	} uuid;
+} __attribute__((packed)) esp_bt_uuid_t;
+
+typedef enum {
+	ESP_BT_DEVICE_TYPE_BREDR = 0x01,
+	ESP_BT_DEVICE_TYPE_BLE   = 0x02,
+	ESP_BT_DEVICE_TYPE_DUMO  = 0x03,
+} esp_bt_dev_type_t;
+
+#define ESP_BD_ADDR_LEN 6
+typedef uint8_t esp_bd_addr_t[ESP_BD_ADDR_LEN];
+
+typedef enum {
+	BLE_ADDR_TYPE_PUBLIC     = 0x00,
+	BLE_ADDR_TYPE_RANDOM     = 0x01,
+	BLE_ADDR_TYPE_RPA_PUBLIC = 0x02,
+	BLE_ADDR_TYPE_RPA_RANDOM = 0x03,
+} esp_ble_addr_type_t;
+
+typedef enum {
+	BLE_WL_ADDR_TYPE_PUBLIC = 0x00,
+	BLE_WL_ADDR_TYPE_RANDOM = 0x01,
+} esp_ble_wl_addr_type_t;
+
+#define ESP_BT_OCTET16_LEN 16
+typedef uint8_t esp_bt_octet16_t[ESP_BT_OCTET16_LEN];
+#define ESP_BT_OCTET8_LEN 8
+typedef uint8_t esp_bt_octet8_t[ESP_BT_OCTET8_LEN];
+typedef uint8_t esp_link_key[ESP_BT_OCTET16_LEN];
+
+#endif /* HOST_ESP_BT_DEFS_H_ */
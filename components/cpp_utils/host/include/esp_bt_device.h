@@ -0,0 +1,14 @@
+#ifndef HOST_ESP_BT_DEVICE_H_
+#define HOST_ESP_BT_DEVICE_H_
+#include "esp_bt_defs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+const uint8_t* esp_bt_dev_get_address(void);
+esp_err_t      esp_bt_dev_set_device_name(const char* name);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOST_ESP_BT_DEVICE_H_ */
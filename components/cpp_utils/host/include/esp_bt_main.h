@@ -0,0 +1,23 @@
+#ifndef HOST_ESP_BT_MAIN_H_
+#define HOST_ESP_BT_MAIN_H_
+#include "esp_err.h"
+
+typedef enum {
+	ESP_BLUEDROID_STATUS_UNINITIALIZED = 0,
+	ESP_BLUEDROID_STATUS_INITIALIZED,
+	ESP_BLUEDROID_STATUS_ENABLED,
+} esp_bluedroid_status_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+esp_bluedroid_status_t esp_bluedroid_get_status(void);
+esp_err_t esp_bluedroid_enable(void);
+esp_err_t esp_bluedroid_disable(void);
+esp_err_t esp_bluedroid_init(void);
+esp_err_t esp_bluedroid_deinit(void);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOST_ESP_BT_MAIN_H_ */
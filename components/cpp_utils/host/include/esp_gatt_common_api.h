@@ -0,0 +1,14 @@
+#ifndef HOST_ESP_GATT_COMMON_API_H_
+#define HOST_ESP_GATT_COMMON_API_H_
+#include "esp_bt_defs.h"
+#include "esp_gatt_defs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+esp_err_t esp_ble_gatt_set_local_mtu(uint16_t mtu);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOST_ESP_GATT_COMMON_API_H_ */
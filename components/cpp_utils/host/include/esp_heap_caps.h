@@ -0,0 +1,18 @@
+#ifndef HOST_ESP_HEAP_CAPS_H_
+#define HOST_ESP_HEAP_CAPS_H_
+#include <stddef.h>
+#include <stdint.h>
+
+#define MALLOC_CAP_8BIT    (1 << 2)
+#define MALLOC_CAP_DEFAULT (1 << 12)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+size_t heap_caps_get_free_size(uint32_t caps);
+size_t heap_caps_get_minimum_free_size(uint32_t caps);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOST_ESP_HEAP_CAPS_H_ */
@@ -0,0 +1,34 @@
+#ifndef HOST_ESP_SYSTEM_H_
+#define HOST_ESP_SYSTEM_H_
+#include <stdint.h>
+#include "esp_err.h"
+
+typedef enum {
+	CHIP_ESP32 = 1,
+} esp_chip_model_t;
+
+#define CHIP_FEATURE_EMB_FLASH (1 << 0)
+#define CHIP_FEATURE_WIFI_BGN  (1 << 1)
+#define CHIP_FEATURE_BLE       (1 << 4)
+#define CHIP_FEATURE_BT        (1 << 5)
+
+typedef struct {
+	esp_chip_model_t model;
+	uint32_t         features;
+	uint8_t          cores;
+	uint8_t          revision;
+} esp_chip_info_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+void        esp_chip_info(esp_chip_info_t* out_info);
+const char* esp_get_idf_version(void);
+uint32_t    esp_get_free_heap_size(void);
+uint32_t    esp_random(void);
+void        esp_restart(void);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOST_ESP_SYSTEM_H_ */
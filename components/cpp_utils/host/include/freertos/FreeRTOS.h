@@ -0,0 +1,37 @@
+/*
+ * FreeRTOS.h
+ *
+ * Host stand-in for the FreeRTOS kernel types.  Tasks map onto pthreads and ticks are milliseconds.
+ */
+#ifndef HOST_FREERTOS_FREERTOS_H_
+#define HOST_FREERTOS_FREERTOS_H_
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <assert.h>
+#include "sdkconfig.h"
+
+typedef int32_t  BaseType_t;
+typedef uint32_t UBaseType_t;
+typedef uint32_t TickType_t;
+typedef uint32_t StackType_t;
+
+#define pdFALSE ((BaseType_t)0)
+#define pdTRUE  ((BaseType_t)1)
+#define pdFAIL  pdFALSE
+#define pdPASS  pdTRUE
+
+#define portMAX_DELAY       ((TickType_t)0xffffffffUL)
+#define portTICK_PERIOD_MS  ((TickType_t)1000 / CONFIG_FREERTOS_HZ)
+#define portTICK_RATE_MS    portTICK_PERIOD_MS
+#define pdMS_TO_TICKS(ms)   ((TickType_t)(((TickType_t)(ms) * (TickType_t)CONFIG_FREERTOS_HZ) / (TickType_t)1000))
+#define tskNO_AFFINITY      0x7fffffff
+#define configMAX_PRIORITIES 25
+
+#define portYIELD_FROM_ISR()
+#define portENTER_CRITICAL(mux)
+#define portEXIT_CRITICAL(mux)
+#define portMUX_INITIALIZER_UNLOCKED 0
+typedef int portMUX_TYPE;
+
+#endif /* HOST_FREERTOS_FREERTOS_H_ */
@@ -0,0 +1,8 @@
+#ifndef HOST_FREERTOS_EVENT_GROUPS_H_
+#define HOST_FREERTOS_EVENT_GROUPS_H_
+#include "FreeRTOS.h"
+
+typedef struct host_event_group* EventGroupHandle_t;
+typedef uint32_t                 EventBits_t;
+
+#endif /* HOST_FREERTOS_EVENT_GROUPS_H_ */
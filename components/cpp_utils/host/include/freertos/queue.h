@@ -0,0 +1,22 @@
+#ifndef HOST_FREERTOS_QUEUE_H_
+#define HOST_FREERTOS_QUEUE_H_
+#include "FreeRTOS.h"
+
+typedef struct host_queue* QueueHandle_t;
+typedef QueueHandle_t      xQueueHandle;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+QueueHandle_t xQueueCreate(UBaseType_t uxQueueLength, UBaseType_t uxItemSize);
+BaseType_t    xQueueSend(QueueHandle_t xQueue, const void* pvItemToQueue, TickType_t xTicksToWait);
+BaseType_t    xQueueSendToBack(QueueHandle_t xQueue, const void* pvItemToQueue, TickType_t xTicksToWait);
+BaseType_t    xQueueSendFromISR(QueueHandle_t xQueue, const void* pvItemToQueue, BaseType_t* pxHigherPriorityTaskWoken);
+BaseType_t    xQueueReceive(QueueHandle_t xQueue, void* pvBuffer, TickType_t xTicksToWait);
+UBaseType_t   uxQueueMessagesWaiting(QueueHandle_t xQueue);
+void          vQueueDelete(QueueHandle_t xQueue);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOST_FREERTOS_QUEUE_H_ */
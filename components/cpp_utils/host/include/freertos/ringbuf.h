@@ -0,0 +1,26 @@
+#ifndef HOST_FREERTOS_RINGBUF_H_
+#define HOST_FREERTOS_RINGBUF_H_
+#include "FreeRTOS.h"
+
+typedef struct host_ringbuf* RingbufHandle_t;
+
+typedef enum {
+	RINGBUF_TYPE_NOSPLIT = 0,
+	RINGBUF_TYPE_ALLOWSPLIT,
+	RINGBUF_TYPE_BYTEBUF,
+	RINGBUF_TYPE_MAX,
+} RingbufferType_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+RingbufHandle_t xRingbufferCreate(size_t xBufferSize, RingbufferType_t xBufferType);
+BaseType_t      xRingbufferSend(RingbufHandle_t xRingbuffer, const void* pvItem, size_t xItemSize, TickType_t xTicksToWait);
+void*           xRingbufferReceive(RingbufHandle_t xRingbuffer, size_t* pxItemSize, TickType_t xTicksToWait);
+void            vRingbufferReturnItem(RingbufHandle_t xRingbuffer, void* pvItem);
+void            vRingbufferDelete(RingbufHandle_t xRingbuffer);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOST_FREERTOS_RINGBUF_H_ */
@@ -0,0 +1,25 @@
+#ifndef HOST_FREERTOS_TASK_H_
+#define HOST_FREERTOS_TASK_H_
+#include "FreeRTOS.h"
+
+typedef struct host_task* TaskHandle_t;
+typedef TaskHandle_t      xTaskHandle;
+typedef void (*TaskFunction_t)(void*);
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+BaseType_t   xTaskCreate(TaskFunction_t pvTaskCode, const char* pcName, uint32_t usStackDepth, void* pvParameters, UBaseType_t uxPriority, TaskHandle_t* pxCreatedTask);
+BaseType_t   xTaskCreatePinnedToCore(TaskFunction_t pvTaskCode, const char* pcName, uint32_t usStackDepth, void* pvParameters, UBaseType_t uxPriority, TaskHandle_t* pxCreatedTask, BaseType_t xCoreID);
+void         vTaskDelete(TaskHandle_t xTaskToDelete);
+void         vTaskDelay(TickType_t xTicksToDelay);
+TickType_t   xTaskGetTickCount(void);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+uint32_t     ulTaskNotifyTake(BaseType_t xClearCountOnExit, TickType_t xTicksToWait);
+BaseType_t   xTaskNotifyGive(TaskHandle_t xTaskToNotify);
+UBaseType_t  uxTaskGetStackHighWaterMark(TaskHandle_t xTask);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOST_FREERTOS_TASK_H_ */
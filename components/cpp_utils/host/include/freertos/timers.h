@@ -0,0 +1,25 @@
+#ifndef HOST_FREERTOS_TIMERS_H_
+#define HOST_FREERTOS_TIMERS_H_
+#include "FreeRTOS.h"
+
+typedef struct host_timer* TimerHandle_t;
+typedef void (*TimerCallbackFunction_t)(TimerHandle_t xTimer);
+typedef void (*PendedFunction_t)(void* pvParameter1, uint32_t ulParameter2);
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+TimerHandle_t xTimerCreate(const char* pcTimerName, TickType_t xTimerPeriod, UBaseType_t uxAutoReload, void* pvTimerID, TimerCallbackFunction_t pxCallbackFunction);
+BaseType_t    xTimerDelete(TimerHandle_t xTimer, TickType_t xTicksToWait);
+BaseType_t    xTimerStart(TimerHandle_t xTimer, TickType_t xTicksToWait);
+BaseType_t    xTimerStop(TimerHandle_t xTimer, TickType_t xTicksToWait);
+BaseType_t    xTimerReset(TimerHandle_t xTimer, TickType_t xTicksToWait);
+BaseType_t    xTimerChangePeriod(TimerHandle_t xTimer, TickType_t xNewPeriod, TickType_t xTicksToWait);
+BaseType_t    xTimerPendFunctionCall(PendedFunction_t xFunctionToPend, void* pvParameter1, uint32_t ulParameter2, TickType_t xTicksToWait);
+const char*   pcTimerGetTimerName(TimerHandle_t xTimer);
+void*         pvTimerGetTimerID(TimerHandle_t xTimer);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOST_FREERTOS_TIMERS_H_ */
@@ -0,0 +1,33 @@
+#ifndef HOST_NVS_H_
+#define HOST_NVS_H_
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+typedef uint32_t nvs_handle;
+typedef nvs_handle nvs_handle_t;
+
+typedef enum {
+	NVS_READONLY,
+	NVS_READWRITE
+} nvs_open_mode;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+esp_err_t nvs_open(const char* name, nvs_open_mode open_mode, nvs_handle* out_handle);
+void      nvs_close(nvs_handle handle);
+esp_err_t nvs_commit(nvs_handle handle);
+esp_err_t nvs_erase_key(nvs_handle handle, const char* key);
+esp_err_t nvs_erase_all(nvs_handle handle);
+esp_err_t nvs_set_blob(nvs_handle handle, const char* key, const void* value, size_t length);
+esp_err_t nvs_get_blob(nvs_handle handle, const char* key, void* out_value, size_t* length);
+esp_err_t nvs_set_str(nvs_handle handle, const char* key, const char* value);
+esp_err_t nvs_get_str(nvs_handle handle, const char* key, char* out_value, size_t* length);
+esp_err_t nvs_set_u32(nvs_handle handle, const char* key, uint32_t value);
+esp_err_t nvs_get_u32(nvs_handle handle, const char* key, uint32_t* out_value);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOST_NVS_H_ */
@@ -0,0 +1,41 @@
+/*
+ * sdkconfig.h
+ *
+ * Host build configuration.  Mirrors the subset of the project sdkconfig that the BLE classes test for.
+ */
+#ifndef HOST_SDKCONFIG_H_
+#define HOST_SDKCONFIG_H_
+
+#define CONFIG_IDF_TARGET "host"
+#define CONFIG_BT_ENABLED 1
+#define CONFIG_BT_BLUEDROID_ENABLED 1
+#define CONFIG_GATTS_ENABLE 1
+#define CONFIG_GATTC_ENABLE 1
+#define CONFIG_BLE_SMP_ENABLE 1
+#define CONFIG_BT_GATTS_ENABLE 1
+#define CONFIG_BT_GATTC_ENABLE 1
+#define CONFIG_BT_BLE_SMP_ENABLE 1
+#define CONFIG_CXX_EXCEPTIONS 1
+#define CONFIG_COMPILER_CXX_EXCEPTIONS 1
+#define CONFIG_BTDM_CTRL_BLE_MAX_CONN 3
+#define CONFIG_BTDM_CTRL_BLE_MAX_CONN_EFF 3
+#define CONFIG_FREERTOS_HZ 1000
+#define CONFIG_BLE_GATTS_ATTR_TABLE 1
+#define CONFIG_BLE_NOTIFY_QUEUE_SIZE 8
+#define CONFIG_BLE_EVENT_RING_SIZE 16
+#define CONFIG_BLE_EVENT_RING_DATA_SIZE 32
+#define CONFIG_BLE_SCAN_TABLE_SIZE 64
+#define CONFIG_BLE_SCAN_STREAM_SIZE 32
+#define CONFIG_BLE_SCAN_STREAM_LOST_MS 10000
+#define CONFIG_BLE_GATTC_DISCOVERY_CACHE 1
+#define CONFIG_BLE_CONNECTION_QUEUE_SIZE 32
+#define CONFIG_BLE_CONNECTION_EVENT_DATA_SIZE 32
+
+#ifndef CONFIG_LOG_DEFAULT_LEVEL
+#define CONFIG_LOG_DEFAULT_LEVEL 3
+#endif
+#if CONFIG_LOG_DEFAULT_LEVEL > 4
+#define CONFIG_BLE_UTILS_ASSIGNED_NUMBER_NAMES 1
+#endif
+
+#endif /* HOST_SDKCONFIG_H_ */
@@ -0,0 +1,66 @@
+/*
+ * BLEHostSim.h
+ */
+
+#ifndef COMPONENTS_CPP_UTILS_HOST_SIM_BLEHOSTSIM_H_
+#define COMPONENTS_CPP_UTILS_HOST_SIM_BLEHOSTSIM_H_
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Drive the simulated Bluetooth stack of the host build.
+ *
+ * On the host the esp_ble_gatts_*, esp_ble_gap_* and esp_ble_gattc_* calls are answered by a simulated
+ * stack.  Like Bluedroid it delivers its events to the registered callbacks from a task of its own, so
+ * the classes see the same threading as on the device.  Calls made by the classes complete the way the
+ * real stack would: creating a service produces ESP_GATTS_CREATE_EVT, a notification produces
+ * ESP_GATTS_CONF_EVT, and so on.  Indications are confirmed at once.
+ *
+ * The methods here play the part of the clients and of devices advertising nearby: they inject the events
+ * a phone would cause.  Events are queued and this returns at once; call flush() to wait until everything
+ * injected so far, and all that it caused, has been handled.
+ *
+ * For the GATT client every address can be connected to, see setConnectable(), and each is a peripheral
+ * with the attributes
+ *
+ *   1-5    Generic Access service 0x1800, with the device name (read) at 3 and the appearance (read) at 5
+ *   20-25  Service PERIPHERAL_SERVICE_UUID, with
+ *   22       PERIPHERAL_STATUS_UUID (read, notify), 4 bytes of 0, and its client configuration at 23
+ *   25       PERIPHERAL_COMMAND_UUID (read, write, write without response)
+ *
+ * Values written are kept per connection.  Answers to reads, writes and discovery can be made to take the
+ * time they would over the air, discovery taking an exchange per attribute; see setLinkLatency().
+ */
+class BLEHostSim {
+public:
+	static const uint16_t PERIPHERAL_SERVICE_UUID = 0xfff0;
+	static const uint16_t PERIPHERAL_STATUS_UUID  = 0xfff1;
+	static const uint16_t PERIPHERAL_COMMAND_UUID = 0xfff2;
+
+	typedef struct {
+		uint32_t events;         // Events delivered to the callbacks.
+		uint32_t dropped;        // Events lost because the stack's queue was full.
+		uint32_t notifications;  // Notifications sent by the server.
+		uint32_t indications;    // Indications sent by the server.
+		uint64_t notifyBytes;    // Bytes of value carried by notifications and indications.
+		uint32_t responses;      // Responses sent by the server to reads and writes.
+	} stats_t;
+
+	static void    advertise(const uint8_t* pAddress, int rssi, const uint8_t* pData, size_t advLength, size_t scanRspLength = 0);
+	static void    connect(uint16_t connId);
+	static void    congest(uint16_t connId, bool congested);
+	static void    disconnect(uint16_t connId);
+	static void    dropLink(uint16_t connId);
+	static void    flush();
+	static stats_t getStats();
+	static void    notifyClient(uint16_t connId, uint16_t handle, const uint8_t* pData, size_t length, bool isNotify = true);
+	static void    read(uint16_t connId, uint16_t handle);
+	static void    resetStats();
+	static void    serviceChanged(uint16_t connId);
+	static void    setConnectable(bool isConnectable);
+	static void    setLinkLatency(uint32_t latencyUs);
+	static void    setMTU(uint16_t connId, uint16_t mtu);
+	static void    write(uint16_t connId, uint16_t handle, const uint8_t* pData, size_t length, bool needRsp = true);
+}; // BLEHostSim
+
+#endif /* COMPONENTS_CPP_UTILS_HOST_SIM_BLEHOSTSIM_H_ */
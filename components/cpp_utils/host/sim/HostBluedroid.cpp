@@ -0,0 +1,1334 @@
+/*
+ * HostBluedroid.cpp
+ *
+ * A simulated Bluedroid: the controller, GAP, GATT server and GATT client calls used by cpp_utils.
+ * Every call that completes with an event on the device queues that event here, and a stack thread
+ * delivers queued events to the registered callbacks one at a time.
+ */
+#include <esp_bt.h>
+#include <esp_bt_device.h>
+#include <esp_bt_main.h>
+#include <esp_gap_ble_api.h>
+#include <esp_gatt_common_api.h>
+#include <esp_gattc_api.h>
+#include <esp_gatts_api.h>
+#include <stddef.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "BLEHostSim.h"
+
+static const size_t   EVENT_QUEUE_SIZE  = 256;
+static const size_t   EVENT_DATA_SIZE   = 600;  // ESP_GATT_MAX_ATTR_LEN
+static const size_t   EVENT_MAX_HANDLES = 128;
+static const uint16_t FIRST_HANDLE      = 40;   // Bluedroid's own services come first.
+static const uint16_t FIRST_GATT_IF     = 3;
+
+typedef enum {
+	KIND_GATTS,
+	KIND_GATTC,
+	KIND_GAP
+} event_kind_t;
+
+typedef struct {
+	event_kind_t kind;
+	int          event;
+	uint16_t     gattIf;
+	union {
+		esp_ble_gatts_cb_param_t gatts;
+		esp_ble_gattc_cb_param_t gattc;
+		esp_ble_gap_cb_param_t   gap;
+	} param;
+	uint8_t      data[EVENT_DATA_SIZE];
+	uint16_t     handles[EVENT_MAX_HANDLES];
+} sim_event_t;
+
+static esp_gatts_cb_t   gattsCallback = nullptr;
+static esp_gattc_cb_t   gattcCallback = nullptr;
+static esp_gap_ble_cb_t gapCallback   = nullptr;
+
+// The stack thread waits on these for as long as the process runs, so they are never destroyed.
+static std::mutex&              queueMutex   = *new std::mutex();
+static std::condition_variable& queueChanged = *new std::condition_variable();
+static sim_event_t             queue[EVENT_QUEUE_SIZE];   // Preallocated so the simulation itself never allocates per event.
+static size_t                  queueHead  = 0;
+static size_t                  queueCount = 0;
+static bool                    delivering = false;
+static bool                    threadStarted = false;
+static std::thread::id         stackThreadId;
+
+static std::atomic<uint32_t>   statEvents(0);
+static std::atomic<uint32_t>   statDropped(0);
+static std::atomic<uint32_t>   statNotifications(0);
+static std::atomic<uint32_t>   statIndications(0);
+static std::atomic<uint64_t>   statNotifyBytes(0);
+static std::atomic<uint32_t>   statResponses(0);
+
+static std::mutex                               gattMutex;      // Guards the simulated GATT database.
+static uint16_t                                 nextHandle = FIRST_HANDLE;
+static uint16_t                                 nextGattIf = FIRST_GATT_IF;
+static uint16_t                                 gattsIf    = 0;
+static std::map<uint16_t, std::vector<uint8_t>> attrValues;
+
+// Answers from the simulated peripherals wait here, guarded by queueMutex, until the link has carried them.
+typedef struct {
+	bool        used;
+	uint64_t    dueUs;
+	uint32_t    sequence;  // Orders answers due at the same time.
+	uint16_t    connId;
+	sim_event_t event;
+} sim_delayed_t;
+
+static std::condition_variable&   delayedChanged = *new std::condition_variable();
+static sim_delayed_t              delayed[EVENT_QUEUE_SIZE];
+static size_t                     delayedCount = 0;
+static uint32_t                   delayedSequence = 0;
+static bool                       linkThreadStarted = false;
+static uint32_t                   linkLatencyUs = 0;
+static std::map<uint16_t, uint64_t> linkBusyUntil;   // By connection id.
+
+// The connections of the GATT client, guarded by gattMutex.
+typedef struct {
+	uint16_t      gattcIf;
+	esp_bd_addr_t bda;
+} sim_link_t;
+
+static std::map<uint16_t, sim_link_t>           links;          // By connection id.
+static uint16_t                                 nextConnId = 0;
+static bool                                     connectable = true;
+static std::map<uint32_t, std::vector<uint8_t>> peerValues;     // By connection id << 16 | handle.
+
+static esp_bluedroid_status_t     bluedroidStatus  = ESP_BLUEDROID_STATUS_UNINITIALIZED;
+static esp_bt_controller_status_t controllerStatus = ESP_BT_CONTROLLER_STATUS_IDLE;
+static const uint8_t              localAddress[ESP_BD_ADDR_LEN] = { 0x24, 0x0a, 0xc4, 0x00, 0x00, 0x01 };
+
+
+/*
+ * Deliver queued events until told to stop.  The lock is released while a callback runs so that the
+ * callback may itself call into the stack.
+ */
+static void stackThread() {
+	std::unique_lock<std::mutex> lock(queueMutex);
+	while (true) {
+		queueChanged.wait(lock, [] { return queueCount > 0; });
+		sim_event_t* pEvent = &queue[queueHead];
+		delivering = true;
+		lock.unlock();
+
+		switch (pEvent->kind) {
+			case KIND_GATTS:
+				if (pEvent->event == ESP_GATTS_WRITE_EVT) pEvent->param.gatts.write.value = pEvent->data;
+				if (pEvent->event == ESP_GATTS_CONF_EVT) pEvent->param.gatts.conf.value = pEvent->data;
+				if (pEvent->event == ESP_GATTS_CREAT_ATTR_TAB_EVT) pEvent->param.gatts.add_attr_tab.handles = pEvent->handles;
+				if (gattsCallback != nullptr) gattsCallback((esp_gatts_cb_event_t)pEvent->event, pEvent->gattIf, &pEvent->param.gatts);
+				break;
+			case KIND_GATTC:
+				if (pEvent->event == ESP_GATTC_READ_CHAR_EVT || pEvent->event == ESP_GATTC_READ_DESCR_EVT) pEvent->param.gattc.read.value = pEvent->data;
+				if (pEvent->event == ESP_GATTC_NOTIFY_EVT) pEvent->param.gattc.notify.value = pEvent->data;
+				if (gattcCallback != nullptr) gattcCallback((esp_gattc_cb_event_t)pEvent->event, pEvent->gattIf, &pEvent->param.gattc);
+				break;
+			case KIND_GAP:
+				if (gapCallback != nullptr) gapCallback((esp_gap_ble_cb_event_t)pEvent->event, &pEvent->param.gap);
+				break;
+		}
+		statEvents++;
+
+		lock.lock();
+		queueHead = (queueHead + 1) % EVENT_QUEUE_SIZE;
+		queueCount--;
+		delivering = false;
+		queueChanged.notify_all();
+	}
+}
+
+
+/*
+ * Reserve the next free event, waiting for room unless called from the stack thread itself, which would
+ * wait for ever.  Returns nullptr if the event had to be dropped.  Call postEvent() to queue it.
+ */
+static sim_event_t* allocEvent(std::unique_lock<std::mutex>& lock, event_kind_t kind, int event, uint16_t gattIf) {
+	if (!threadStarted) {
+		threadStarted = true;
+		std::thread thread(stackThread);
+		stackThreadId = thread.get_id();
+		thread.detach();
+	}
+	if (std::this_thread::get_id() == stackThreadId) {
+		if (queueCount == EVENT_QUEUE_SIZE) {
+			statDropped++;
+			return nullptr;
+		}
+	} else {
+		queueChanged.wait(lock, [] { return queueCount < EVENT_QUEUE_SIZE; });
+	}
+	sim_event_t* pEvent = &queue[(queueHead + queueCount) % EVENT_QUEUE_SIZE];
+	pEvent->kind   = kind;
+	pEvent->event  = event;
+	pEvent->gattIf = gattIf;
+	memset(&pEvent->param, 0, sizeof(pEvent->param));
+	return pEvent;
+}
+
+
+static void postEvent() {
+	queueCount++;
+	queueChanged.notify_all();
+}
+
+
+static uint64_t nowUs() {
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+/*
+ * Hand each answer of a peripheral to the stack thread once the link has carried it.
+ */
+static void linkThread() {
+	std::unique_lock<std::mutex> lock(queueMutex);
+	while (true) {
+		delayedChanged.wait(lock, [] { return delayedCount > 0; });
+		sim_delayed_t* pNext = nullptr;
+		for (auto& slot : delayed) {
+			if (slot.used && (pNext == nullptr || slot.dueUs < pNext->dueUs ||
+					(slot.dueUs == pNext->dueUs && (int32_t)(slot.sequence - pNext->sequence) < 0))) {
+				pNext = &slot;
+			}
+		}
+		uint64_t now = nowUs();
+		if (pNext->dueUs > now) {
+			delayedChanged.wait_for(lock, std::chrono::microseconds(pNext->dueUs - now));
+			continue;
+		}
+		uint32_t     sequence = pNext->sequence;
+		sim_event_t* pEvent   = allocEvent(lock, pNext->event.kind, pNext->event.event, pNext->event.gattIf);
+		if (!pNext->used || pNext->sequence != sequence) continue;  // The connection closed while we waited for room.
+		memcpy(pEvent, &pNext->event, sizeof(sim_event_t));
+		pNext->used = false;
+		delayedCount--;
+		postEvent();
+		delayedChanged.notify_all();
+	}
+}
+
+
+/*
+ * When will a peripheral's answer to a request sent now on a connection arrive?  A link carries one
+ * request at a time, in order.
+ */
+static uint64_t linkDue(uint16_t connId, bool needRsp = true) {
+	uint64_t  now  = nowUs();
+	uint64_t& busy = linkBusyUntil[connId];
+	busy = (busy > now ? busy : now) + (needRsp ? linkLatencyUs : 0);
+	return busy;
+}
+
+
+/*
+ * Reserve an event for a peripheral's answer, due at a time from linkDue().  With no link latency it
+ * goes straight to the stack's queue.  Returns nullptr if the event had to be dropped.  Call postAnswer()
+ * to queue it.
+ */
+static sim_event_t* allocAnswer(std::unique_lock<std::mutex>& lock, uint64_t dueUs, uint16_t connId, int event, uint16_t gattIf) {
+	if (linkLatencyUs == 0) return allocEvent(lock, KIND_GATTC, event, gattIf);
+	if (!linkThreadStarted) {
+		linkThreadStarted = true;
+		std::thread(linkThread).detach();
+	}
+	if (std::this_thread::get_id() == stackThreadId) {
+		if (delayedCount == EVENT_QUEUE_SIZE) {
+			statDropped++;
+			return nullptr;
+		}
+	} else {
+		delayedChanged.wait(lock, [] { return delayedCount < EVENT_QUEUE_SIZE; });
+	}
+	for (auto& slot : delayed) {
+		if (slot.used) continue;
+		slot.dueUs        = dueUs;
+		slot.sequence     = delayedSequence++;
+		slot.connId       = connId;
+		slot.event.kind   = KIND_GATTC;
+		slot.event.event  = event;
+		slot.event.gattIf = gattIf;
+		memset(&slot.event.param, 0, sizeof(slot.event.param));
+		return &slot.event;
+	}
+	return nullptr;
+}
+
+
+static void postAnswer(sim_event_t* pEvent) {
+	if (linkLatencyUs == 0) {
+		postEvent();
+		return;
+	}
+	sim_delayed_t* pSlot = reinterpret_cast<sim_delayed_t*>(reinterpret_cast<uint8_t*>(pEvent) - offsetof(sim_delayed_t, event));
+	pSlot->used = true;
+	delayedCount++;
+	delayedChanged.notify_all();
+}
+
+
+static void postGatts(esp_gatts_cb_event_t event, uint16_t gattIf, const esp_ble_gatts_cb_param_t& param, const uint8_t* pData = nullptr, size_t length = 0) {
+	std::unique_lock<std::mutex> lock(queueMutex);
+	sim_event_t* pEvent = allocEvent(lock, KIND_GATTS, event, gattIf);
+	if (pEvent == nullptr) return;
+	pEvent->param.gatts = param;
+	if (length > EVENT_DATA_SIZE) length = EVENT_DATA_SIZE;
+	if (length > 0) memcpy(pEvent->data, pData, length);
+	postEvent();
+}
+
+
+static void postGap(esp_gap_ble_cb_event_t event, const esp_ble_gap_cb_param_t& param) {
+	std::unique_lock<std::mutex> lock(queueMutex);
+	sim_event_t* pEvent = allocEvent(lock, KIND_GAP, event, 0);
+	if (pEvent == nullptr) return;
+	pEvent->param.gap = param;
+	postEvent();
+}
+
+
+static void postGapStatus(esp_gap_ble_cb_event_t event) {
+	esp_ble_gap_cb_param_t param;
+	memset(&param, 0, sizeof(param));
+	param.adv_data_cmpl.status = ESP_BT_STATUS_SUCCESS;  // Every *_cmpl member starts with its status.
+	postGap(event, param);
+}
+
+
+static void addressOf(uint16_t connId, esp_bd_addr_t bda) {
+	const uint8_t address[ESP_BD_ADDR_LEN] = { 0x02, 0x00, 0x00, 0x00, (uint8_t)(connId >> 8), (uint8_t)connId };
+	memcpy(bda, address, ESP_BD_ADDR_LEN);
+}
+
+
+// ---------------------------------------------------------------------------------------------------
+// The clients
+// ---------------------------------------------------------------------------------------------------
+
+/**
+ * @brief A device advertises and the scan reports it.  Reports arrive whether or not a scan is running,
+ * as they may on the device just after a scan is stopped.
+ * @param [in] pAddress The 6 byte address of the device.
+ * @param [in] rssi The signal strength of the report.
+ * @param [in] pData The advertising data followed by any scan response.
+ * @param [in] advLength The length of the advertising data, at most 31 bytes.
+ * @param [in] scanRspLength The length of the scan response, at most 31 bytes.
+ */
+void BLEHostSim::advertise(const uint8_t* pAddress, int rssi, const uint8_t* pData, size_t advLength, size_t scanRspLength) {
+	if (advLength > ESP_BLE_ADV_DATA_LEN_MAX) advLength = ESP_BLE_ADV_DATA_LEN_MAX;
+	if (scanRspLength > ESP_BLE_SCAN_RSP_DATA_LEN_MAX) scanRspLength = ESP_BLE_SCAN_RSP_DATA_LEN_MAX;
+	std::unique_lock<std::mutex> lock(queueMutex);
+	sim_event_t* pEvent = allocEvent(lock, KIND_GAP, ESP_GAP_BLE_SCAN_RESULT_EVT, 0);
+	if (pEvent == nullptr) return;
+	esp_ble_gap_cb_param_t::ble_scan_result_evt_param& result = pEvent->param.gap.scan_rst;
+	memset(&result, 0, sizeof(result));
+	result.search_evt    = ESP_GAP_SEARCH_INQ_RES_EVT;
+	result.dev_type      = ESP_BT_DEVICE_TYPE_BLE;
+	result.ble_addr_type = BLE_ADDR_TYPE_PUBLIC;
+	result.ble_evt_type  = ESP_BLE_EVT_CONN_ADV;
+	result.rssi          = rssi;
+	result.num_resps     = 1;
+	result.adv_data_len  = advLength;
+	result.scan_rsp_len  = scanRspLength;
+	memcpy(result.bda, pAddress, ESP_BD_ADDR_LEN);
+	memcpy(result.ble_adv, pData, advLength + scanRspLength);
+	postEvent();
+} // advertise
+
+
+/**
+ * @brief A client connects.  The client's address is derived from the connection id.
+ * @param [in] connId The connection id.
+ */
+void BLEHostSim::connect(uint16_t connId) {
+	esp_ble_gatts_cb_param_t param;
+	memset(&param, 0, sizeof(param));
+	param.connect.conn_id                = connId;
+	param.connect.conn_params.interval   = 24;
+	param.connect.conn_params.latency    = 0;
+	param.connect.conn_params.timeout    = 400;
+	addressOf(connId, param.connect.remote_bda);
+	postGatts(ESP_GATTS_CONNECT_EVT, gattsIf, param);
+} // connect
+
+
+/**
+ * @brief The link to a client becomes congested or clears.
+ * @param [in] connId The connection id.
+ * @param [in] congested True if the link is congested.
+ */
+void BLEHostSim::congest(uint16_t connId, bool congested) {
+	esp_ble_gatts_cb_param_t param;
+	memset(&param, 0, sizeof(param));
+	param.congest.conn_id   = connId;
+	param.congest.congested = congested;
+	postGatts(ESP_GATTS_CONGEST_EVT, gattsIf, param);
+} // congest
+
+
+/**
+ * @brief A client disconnects.
+ * @param [in] connId The connection id.
+ */
+void BLEHostSim::disconnect(uint16_t connId) {
+	esp_ble_gatts_cb_param_t param;
+	memset(&param, 0, sizeof(param));
+	param.disconnect.conn_id = connId;
+	param.disconnect.reason  = ESP_GATT_CONN_TERMINATE_PEER_USER;
+	addressOf(connId, param.disconnect.remote_bda);
+	postGatts(ESP_GATTS_DISCONNECT_EVT, gattsIf, param);
+} // disconnect
+
+
+/**
+ * @brief Wait until every event queued so far, and every event those caused, has been delivered.
+ */
+void BLEHostSim::flush() {
+	std::unique_lock<std::mutex> lock(queueMutex);
+	queueChanged.wait(lock, [] { return queueCount == 0 && !delivering && delayedCount == 0; });
+} // flush
+
+
+/**
+ * @brief Get the counters of the simulated stack.
+ * @return The counters.
+ */
+BLEHostSim::stats_t BLEHostSim::getStats() {
+	stats_t stats;
+	stats.events        = statEvents;
+	stats.dropped       = statDropped;
+	stats.notifications = statNotifications;
+	stats.indications   = statIndications;
+	stats.notifyBytes   = statNotifyBytes;
+	stats.responses     = statResponses;
+	return stats;
+} // getStats
+
+
+/**
+ * @brief A client reads an attribute.
+ * @param [in] connId The connection id.
+ * @param [in] handle The handle of the attribute.
+ */
+void BLEHostSim::read(uint16_t connId, uint16_t handle) {
+	static std::atomic<uint32_t> transId(1);
+	esp_ble_gatts_cb_param_t param;
+	memset(&param, 0, sizeof(param));
+	param.read.conn_id  = connId;
+	param.read.trans_id = transId++;
+	param.read.handle   = handle;
+	param.read.need_rsp = true;
+	addressOf(connId, param.read.bda);
+	postGatts(ESP_GATTS_READ_EVT, gattsIf, param);
+} // read
+
+
+/**
+ * @brief Reset the counters of the simulated stack.
+ */
+void BLEHostSim::resetStats() {
+	statEvents        = 0;
+	statDropped       = 0;
+	statNotifications = 0;
+	statIndications   = 0;
+	statNotifyBytes   = 0;
+	statResponses     = 0;
+} // resetStats
+
+
+/**
+ * @brief A client and the server agree on an MTU.
+ * @param [in] connId The connection id.
+ * @param [in] mtu The MTU.
+ */
+void BLEHostSim::setMTU(uint16_t connId, uint16_t mtu) {
+	esp_ble_gatts_cb_param_t param;
+	memset(&param, 0, sizeof(param));
+	param.mtu.conn_id = connId;
+	param.mtu.mtu     = mtu;
+	postGatts(ESP_GATTS_MTU_EVT, gattsIf, param);
+} // setMTU
+
+
+/**
+ * @brief A client writes an attribute.
+ * @param [in] connId The connection id.
+ * @param [in] handle The handle of the attribute.
+ * @param [in] pData The value written.
+ * @param [in] length The length of the value, at most 600 bytes.
+ * @param [in] needRsp False for a write without response.
+ */
+void BLEHostSim::write(uint16_t connId, uint16_t handle, const uint8_t* pData, size_t length, bool needRsp) {
+	static std::atomic<uint32_t> transId(1);
+	esp_ble_gatts_cb_param_t param;
+	memset(&param, 0, sizeof(param));
+	param.write.conn_id  = connId;
+	param.write.trans_id = transId++;
+	param.write.handle   = handle;
+	param.write.need_rsp = needRsp;
+	param.write.len      = length < EVENT_DATA_SIZE ? length : EVENT_DATA_SIZE;
+	addressOf(connId, param.write.bda);
+	postGatts(ESP_GATTS_WRITE_EVT, gattsIf, param, pData, length);
+} // write
+
+
+// ---------------------------------------------------------------------------------------------------
+// Controller and Bluedroid
+// ---------------------------------------------------------------------------------------------------
+esp_err_t esp_bt_controller_init(esp_bt_controller_config_t*) {
+	controllerStatus = ESP_BT_CONTROLLER_STATUS_INITED;
+	return ESP_OK;
+}
+
+esp_err_t esp_bt_controller_deinit(void) {
+	controllerStatus = ESP_BT_CONTROLLER_STATUS_IDLE;
+	return ESP_OK;
+}
+
+esp_err_t esp_bt_controller_enable(esp_bt_mode_t) {
+	controllerStatus = ESP_BT_CONTROLLER_STATUS_ENABLED;
+	return ESP_OK;
+}
+
+esp_err_t esp_bt_controller_disable(void) {
+	controllerStatus = ESP_BT_CONTROLLER_STATUS_INITED;
+	return ESP_OK;
+}
+
+esp_bt_controller_status_t esp_bt_controller_get_status(void) {
+	return controllerStatus;
+}
+
+esp_err_t esp_bt_controller_mem_release(esp_bt_mode_t) {
+	return ESP_OK;
+}
+
+esp_err_t esp_ble_tx_power_set(esp_ble_power_type_t, esp_power_level_t) {
+	return ESP_OK;
+}
+
+esp_bluedroid_status_t esp_bluedroid_get_status(void) {
+	return bluedroidStatus;
+}
+
+esp_err_t esp_bluedroid_init(void) {
+	bluedroidStatus = ESP_BLUEDROID_STATUS_INITIALIZED;
+	return ESP_OK;
+}
+
+esp_err_t esp_bluedroid_deinit(void) {
+	bluedroidStatus = ESP_BLUEDROID_STATUS_UNINITIALIZED;
+	return ESP_OK;
+}
+
+esp_err_t esp_bluedroid_enable(void) {
+	bluedroidStatus = ESP_BLUEDROID_STATUS_ENABLED;
+	return ESP_OK;
+}
+
+esp_err_t esp_bluedroid_disable(void) {
+	bluedroidStatus = ESP_BLUEDROID_STATUS_INITIALIZED;
+	return ESP_OK;
+}
+
+const uint8_t* esp_bt_dev_get_address(void) {
+	return localAddress;
+}
+
+esp_err_t esp_bt_dev_set_device_name(const char*) {
+	return ESP_OK;
+}
+
+esp_err_t esp_ble_gatt_set_local_mtu(uint16_t) {
+	return ESP_OK;
+}
+
+
+// ---------------------------------------------------------------------------------------------------
+// GATT server
+// ---------------------------------------------------------------------------------------------------
+esp_err_t esp_ble_gatts_register_callback(esp_gatts_cb_t callback) {
+	gattsCallback = callback;
+	return ESP_OK;
+}
+
+esp_err_t esp_ble_gatts_app_register(uint16_t app_id) {
+	esp_ble_gatts_cb_param_t param;
+	memset(&param, 0, sizeof(param));
+	param.reg.status = ESP_GATT_OK;
+	param.reg.app_id = app_id;
+	{
+		std::lock_guard<std::mutex> lock(gattMutex);
+		gattsIf = nextGattIf++;
+	}
+	postGatts(ESP_GATTS_REG_EVT, gattsIf, param);
+	return ESP_OK;
+}
+
+esp_err_t esp_ble_gatts_app_unregister(esp_gatt_if_t gatts_if) {
+	esp_ble_gatts_cb_param_t param;
+	memset(&param, 0, sizeof(param));
+	postGatts(ESP_GATTS_UNREG_EVT, gatts_if, param);
+	return ESP_OK;
+}
+
+esp_err_t esp_ble_gatts_create_service(esp_gatt_if_t gatts_if, esp_gatt_srvc_id_t* service_id, uint16_t) {
+	esp_ble_gatts_cb_param_t param;
+	memset(&param, 0, sizeof(param));
+	param.create.status     = ESP_GATT_OK;
+	param.create.service_id = *service_id;
+	{
+		std::lock_guard<std::mutex> lock(gattMutex);
+		param.create.service_handle = nextHandle++;
+	}
+	postGatts(ESP_GATTS_CREATE_EVT, gatts_if, param);
+	return ESP_OK;
+}
+
+esp_err_t esp_ble_gatts_create_attr_tab(const esp_gatts_attr_db_t* gatts_attr_db, esp_gatt_if_t gatts_if, uint8_t max_nb_attr, uint8_t srvc_inst_id) {
+	if (max_nb_attr == 0 || max_nb_attr > ESP_GATT_ATTR_HANDLE_MAX) return ESP_ERR_INVALID_ARG;
+	std::unique_lock<std::mutex> gattLock(gattMutex);
+	uint16_t firstHandle = nextHandle;
+	nextHandle += max_nb_attr;
+	gattLock.unlock();
+
+	std::unique_lock<std::mutex> lock(queueMutex);
+	sim_event_t* pEvent = allocEvent(lock, KIND_GATTS, ESP_GATTS_CREAT_ATTR_TAB_EVT, gatts_if);
+	if (pEvent == nullptr) return ESP_FAIL;
+	esp_ble_gatts_cb_param_t& param = pEvent->param.gatts;
+	param.add_attr_tab.status      = ESP_GATT_OK;
+	param.add_attr_tab.svc_inst_id = srvc_inst_id;
+	param.add_attr_tab.num_handle  = max_nb_attr;
+	param.add_attr_tab.svc_uuid.len = gatts_attr_db[0].att_desc.length;  // The value of the service declaration.
+	memcpy(&param.add_attr_tab.svc_uuid.uuid, gatts_attr_db[0].att_desc.value, gatts_attr_db[0].att_desc.length);
+	for (uint8_t i = 0; i < max_nb_attr; i++) {
+		pEvent->handles[i] = firstHandle + i;
+	}
+	postEvent();
+	return ESP_OK;
+}
+
+esp_err_t esp_ble_gatts_add_included_service(uint16_t service_handle, uint16_t) {
+	esp_ble_gatts_cb_param_t param;
+	memset(&param, 0, sizeof(param));
+	param.add_incl_srvc.status         = ESP_GATT_OK;
+	param.add_incl_srvc.service_handle = service_handle;
+	{
+		std::lock_guard<std::mutex> lock(gattMutex);
+		param.add_incl_srvc.attr_handle = nextHandle++;
+	}
+	postGatts(ESP_GATTS_ADD_INCL_SRVC_EVT, gattsIf, param);
+	return ESP_OK;
+}
+
+esp_err_t esp_ble_gatts_add_char(uint16_t service_handle, esp_bt_uuid_t* char_uuid, esp_gatt_perm_t, esp_gatt_char_prop_t, esp_attr_value_t*, esp_attr_control_t*) {
+	esp_ble_gatts_cb_param_t param;
+	memset(&param, 0, sizeof(param));
+	param.add_char.status         = ESP_GATT_OK;
+	param.add_char.service_handle = service_handle;
+	param.add_char.char_uuid      = *char_uuid;
+	{
+		std::lock_guard<std::mutex> lock(gattMutex);
+		nextHandle++;                                  // The characteristic declaration.
+		param.add_char.attr_handle = nextHandle++;     // The characteristic value.
+	}
+	postGatts(ESP_GATTS_ADD_CHAR_EVT, gattsIf, param);
+	return ESP_OK;
+}
+
+esp_err_t esp_ble_gatts_add_char_descr(uint16_t service_handle, esp_bt_uuid_t* descr_uuid, esp_gatt_perm_t, esp_attr_value_t*, esp_attr_control_t*) {
+	esp_ble_gatts_cb_param_t param;
+	memset(&param, 0, sizeof(param));
+	param.add_char_descr.status         = ESP_GATT_OK;
+	param.add_char_descr.service_handle = service_handle;
+	param.add_char_descr.descr_uuid     = *descr_uuid;
+	{
+		std::lock_guard<std::mutex> lock(gattMutex);
+		param.add_char_descr.attr_handle = nextHandle++;
+	}
+	postGatts(ESP_GATTS_ADD_CHAR_DESCR_EVT, gattsIf, param);
+	return ESP_OK;
+}
+
+esp_err_t esp_ble_gatts_delete_service(uint16_t service_handle) {
+	esp_ble_gatts_cb_param_t param;
+	memset(&param, 0, sizeof(param));
+	param.del.status         = ESP_GATT_OK;
+	param.del.service_handle = service_handle;
+	postGatts(ESP_GATTS_DELETE_EVT, gattsIf, param);
+	return ESP_OK;
+}
+
+esp_err_t esp_ble_gatts_start_service(uint16_t service_handle) {
+	esp_ble_gatts_cb_param_t param;
+	memset(&param, 0, sizeof(param));
+	param.start.status         = ESP_GATT_OK;
+	param.start.service_handle = service_handle;
+	postGatts(ESP_GATTS_START_EVT, gattsIf, param);
+	return ESP_OK;
+}
+
+esp_err_t esp_ble_gatts_stop_service(uint16_t service_handle) {
+	esp_ble_gatts_cb_param_t param;
+	memset(&param, 0, sizeof(param));
+	param.stop.status         = ESP_GATT_OK;
+	param.stop.service_handle = service_handle;
+	postGatts(ESP_GATTS_STOP_EVT, gattsIf, param);
+	return ESP_OK;
+}
+
+/*
+ * The client takes every notification and confirms every indication straight away, so either way the
+ * server gets an ESP_GATTS_CONF_EVT.
+ */
+esp_err_t esp_ble_gatts_send_indicate(esp_gatt_if_t gatts_if, uint16_t conn_id, uint16_t attr_handle, uint16_t value_len, uint8_t* value, bool need_confirm) {
+	if (need_confirm) {
+		statIndications++;
+	} else {
+		statNotifications++;
+	}
+	statNotifyBytes += value_len;
+	esp_ble_gatts_cb_param_t param;
+	memset(&param, 0, sizeof(param));
+	param.conf.status  = ESP_GATT_OK;
+	param.conf.conn_id = conn_id;
+	param.conf.handle  = attr_handle;
+	param.conf.len     = value_len;
+	postGatts(ESP_GATTS_CONF_EVT, gatts_if, param, value, value_len);
+	return ESP_OK;
+}
+
+esp_err_t esp_ble_gatts_send_response(esp_gatt_if_t gatts_if, uint16_t, uint32_t, esp_gatt_status_t, esp_gatt_rsp_t* rsp) {
+	statResponses++;
+	esp_ble_gatts_cb_param_t param;
+	memset(&param, 0, sizeof(param));
+	param.rsp.status = ESP_GATT_OK;
+	param.rsp.handle = rsp != nullptr ? rsp->attr_value.handle : 0;
+	postGatts(ESP_GATTS_RESPONSE_EVT, gatts_if, param);
+	return ESP_OK;
+}
+
+esp_err_t esp_ble_gatts_set_attr_value(uint16_t attr_handle, uint16_t length, const uint8_t* value) {
+	{
+		std::lock_guard<std::mutex> lock(gattMutex);
+		attrValues[attr_handle].assign(value, value + length);
+	}
+	esp_ble_gatts_cb_param_t param;
+	memset(&param, 0, sizeof(param));
+	param.set_attr_val.attr_handle = attr_handle;
+	param.set_attr_val.status      = ESP_GATT_OK;
+	postGatts(ESP_GATTS_SET_ATTR_VAL_EVT, gattsIf, param);
+	return ESP_OK;
+}
+
+esp_gatt_status_t esp_ble_gatts_get_attr_value(uint16_t attr_handle, uint16_t* length, const uint8_t** value) {
+	std::lock_guard<std::mutex> lock(gattMutex);
+	auto it = attrValues.find(attr_handle);
+	if (it == attrValues.end()) return ESP_GATT_NOT_FOUND;
+	*length = it->second.size();
+	*value  = it->second.data();
+	return ESP_GATT_OK;
+}
+
+esp_err_t esp_ble_gatts_open(esp_gatt_if_t, esp_bd_addr_t, bool) {
+	return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t esp_ble_gatts_close(esp_gatt_if_t, uint16_t conn_id) {
+	BLEHostSim::disconnect(conn_id);
+	return ESP_OK;
+}
+
+esp_err_t esp_ble_gatts_send_service_change_indication(esp_gatt_if_t gatts_if, esp_bd_addr_t) {
+	esp_ble_gatts_cb_param_t param;
+	memset(&param, 0, sizeof(param));
+	param.service_change.status = ESP_GATT_OK;
+	postGatts(ESP_GATTS_SEND_SERVICE_CHANGE_EVT, gatts_if, param);
+	return ESP_OK;
+}
+
+
+// ---------------------------------------------------------------------------------------------------
+// GAP
+// ---------------------------------------------------------------------------------------------------
+esp_err_t esp_ble_gap_register_callback(esp_gap_ble_cb_t callback) {
+	gapCallback = callback;
+	return ESP_OK;
+}
+
+esp_err_t esp_ble_gap_config_adv_data(esp_ble_adv_data_t* adv_data) {
+	postGapStatus(adv_data->set_scan_rsp ? ESP_GAP_BLE_SCAN_RSP_DATA_SET_COMPLETE_EVT : ESP_GAP_BLE_ADV_DATA_SET_COMPLETE_EVT);
+	return ESP_OK;
+}
+
+esp_err_t esp_ble_gap_config_adv_data_raw(uint8_t*, uint32_t raw_data_len) {
+	if (raw_data_len > ESP_BLE_ADV_DATA_LEN_MAX) return ESP_ERR_INVALID_ARG;
+	postGapStatus(ESP_GAP_BLE_ADV_DATA_RAW_SET_COMPLETE_EVT);
+	return ESP_OK;
+}
+
+esp_err_t esp_ble_gap_config_scan_rsp_data_raw(uint8_t*, uint32_t raw_data_len) {
+	if (raw_data_len > ESP_BLE_SCAN_RSP_DATA_LEN_MAX) return ESP_ERR_INVALID_ARG;
+	postGapStatus(ESP_GAP_BLE_SCAN_RSP_DATA_RAW_SET_COMPLETE_EVT);
+	return ESP_OK;
+}
+
+esp_err_t esp_ble_gap_set_scan_params(esp_ble_scan_params_t*) {
+	postGapStatus(ESP_GAP_BLE_SCAN_PARAM_SET_COMPLETE_EVT);
+	return ESP_OK;
+}
+
+esp_err_t esp_ble_gap_start_scanning(uint32_t) {
+	postGapStatus(ESP_GAP_BLE_SCAN_START_COMPLETE_EVT);
+	return ESP_OK;
+}
+
+esp_err_t esp_ble_gap_stop_scanning(void) {
+	postGapStatus(ESP_GAP_BLE_SCAN_STOP_COMPLETE_EVT);
+	return ESP_OK;
+}
+
+esp_err_t esp_ble_gap_start_advertising(esp_ble_adv_params_t*) {
+	postGapStatus(ESP_GAP_BLE_ADV_START_COMPLETE_EVT);
+	return ESP_OK;
+}
+
+esp_err_t esp_ble_gap_stop_advertising(void) {
+	postGapStatus(ESP_GAP_BLE_ADV_STOP_COMPLETE_EVT);
+	return ESP_OK;
+}
+
+/*
+ * The client grants the longest interval asked for.
+ */
+esp_err_t esp_ble_gap_update_conn_params(esp_ble_conn_update_params_t* params) {
+	esp_ble_gap_cb_param_t param;
+	memset(&param, 0, sizeof(param));
+	param.update_conn_params.status   = ESP_BT_STATUS_SUCCESS;
+	memcpy(param.update_conn_params.bda, params->bda, ESP_BD_ADDR_LEN);
+	param.update_conn_params.min_int  = params->min_int;
+	param.update_conn_params.max_int  = params->max_int;
+	param.update_conn_params.latency  = params->latency;
+	param.update_conn_params.conn_int = params->max_int;
+	param.update_conn_params.timeout  = params->timeout;
+	postGap(ESP_GAP_BLE_UPDATE_CONN_PARAMS_EVT, param);
+	return ESP_OK;
+}
+
+esp_err_t esp_ble_gap_set_pkt_data_len(esp_bd_addr_t, uint16_t) {
+	postGapStatus(ESP_GAP_BLE_SET_PKT_LENGTH_COMPLETE_EVT);
+	return ESP_OK;
+}
+
+esp_err_t esp_ble_gap_set_rand_addr(esp_bd_addr_t) {
+	postGapStatus(ESP_GAP_BLE_SET_STATIC_RAND_ADDR_EVT);
+	return ESP_OK;
+}
+
+esp_err_t esp_ble_gap_config_local_privacy(bool) {
+	postGapStatus(ESP_GAP_BLE_SET_LOCAL_PRIVACY_COMPLETE_EVT);
+	return ESP_OK;
+}
+
+esp_err_t esp_ble_gap_update_whitelist(bool, esp_bd_addr_t, esp_ble_wl_addr_type_t) {
+	postGapStatus(ESP_GAP_BLE_UPDATE_WHITELIST_COMPLETE_EVT);
+	return ESP_OK;
+}
+
+esp_err_t esp_ble_gap_set_device_name(const char*) {
+	return ESP_OK;
+}
+
+esp_err_t esp_ble_gap_read_rssi(esp_bd_addr_t remote_addr) {
+	esp_ble_gap_cb_param_t param;
+	memset(&param, 0, sizeof(param));
+	param.read_rssi_cmpl.status = ESP_BT_STATUS_SUCCESS;
+	param.read_rssi_cmpl.rssi   = -50;
+	memcpy(param.read_rssi_cmpl.remote_addr, remote_addr, ESP_BD_ADDR_LEN);
+	postGap(ESP_GAP_BLE_READ_RSSI_COMPLETE_EVT, param);
+	return ESP_OK;
+}
+
+esp_err_t esp_ble_gap_set_security_param(esp_ble_sm_param_t, void*, uint8_t) {
+	return ESP_OK;
+}
+
+esp_err_t esp_ble_gap_security_rsp(esp_bd_addr_t, bool) {
+	return ESP_OK;
+}
+
+esp_err_t esp_ble_set_encryption(esp_bd_addr_t, esp_ble_sec_act_t) {
+	return ESP_OK;
+}
+
+esp_err_t esp_ble_passkey_reply(esp_bd_addr_t, bool, uint32_t) {
+	return ESP_OK;
+}
+
+esp_err_t esp_ble_confirm_reply(esp_bd_addr_t, bool) {
+	return ESP_OK;
+}
+
+esp_err_t esp_ble_gap_disconnect(esp_bd_addr_t remote_device) {
+	BLEHostSim::disconnect(((uint16_t)remote_device[4] << 8) | remote_device[5]);
+	return ESP_OK;
+}
+
+/*
+ * Find an AD structure of a type in advertising data.
+ */
+uint8_t* esp_ble_resolve_adv_data(uint8_t* adv_data, uint8_t type, uint8_t* length) {
+	size_t offset = 0;
+	*length = 0;
+	if (adv_data == nullptr) return nullptr;
+	while (offset < ESP_BLE_ADV_DATA_LEN_MAX + ESP_BLE_SCAN_RSP_DATA_LEN_MAX && adv_data[offset] != 0) {
+		uint8_t fieldLength = adv_data[offset];
+		if (adv_data[offset + 1] == type) {
+			*length = fieldLength - 1;
+			return &adv_data[offset + 2];
+		}
+		offset += fieldLength + 1;
+	}
+	return nullptr;
+}
+
+
+// ---------------------------------------------------------------------------------------------------
+// GATT client
+//
+// Every address connected to is a peripheral with the same attributes, described in BLEHostSim.h.
+// Each connection keeps its own copy of the values written to it.
+// ---------------------------------------------------------------------------------------------------
+typedef struct {
+	uint16_t startHandle;
+	uint16_t endHandle;
+	uint16_t uuid;
+} sim_peer_service_t;
+
+typedef struct {
+	uint16_t             handle;   // Of the value.
+	uint16_t             uuid;
+	esp_gatt_char_prop_t properties;
+} sim_peer_char_t;
+
+static const sim_peer_service_t peerServices[] = {
+	{ 1,  5,  0x1800 },
+	{ 20, 25, BLEHostSim::PERIPHERAL_SERVICE_UUID }
+};
+
+static const sim_peer_char_t peerChars[] = {
+	{ 3,  0x2a00, ESP_GATT_CHAR_PROP_BIT_READ },
+	{ 5,  0x2a01, ESP_GATT_CHAR_PROP_BIT_READ },
+	{ 22, BLEHostSim::PERIPHERAL_STATUS_UUID,  ESP_GATT_CHAR_PROP_BIT_READ | ESP_GATT_CHAR_PROP_BIT_NOTIFY },
+	{ 25, BLEHostSim::PERIPHERAL_COMMAND_UUID, ESP_GATT_CHAR_PROP_BIT_READ | ESP_GATT_CHAR_PROP_BIT_WRITE | ESP_GATT_CHAR_PROP_BIT_WRITE_NR }
+};
+
+static const uint16_t peerCCCDHandle = 23;  // Of the status characteristic.
+
+
+static void setUUID16(esp_bt_uuid_t* pUUID, uint16_t uuid) {
+	memset(pUUID, 0, sizeof(*pUUID));
+	pUUID->len         = ESP_UUID_LEN_16;
+	pUUID->uuid.uuid16 = uuid;
+}
+
+
+/*
+ * The value of an attribute of a peripheral.  Call with gattMutex held.
+ */
+static std::vector<uint8_t>& peerValue(uint16_t connId, uint16_t handle) {
+	auto it = peerValues.find(((uint32_t)connId << 16) | handle);
+	if (it != peerValues.end()) return it->second;
+	std::vector<uint8_t>& value = peerValues[((uint32_t)connId << 16) | handle];
+	if (handle == 3) {
+		const char name[] = "Hall panel";
+		value.assign(name, name + sizeof(name) - 1);
+	} else if (handle == 22) {
+		value.assign(4, 0);
+	}
+	return value;
+}
+
+
+/*
+ * Look up a connection of the client.  Call with gattMutex held.
+ */
+static esp_err_t closeLink(uint16_t conn_id, esp_gatt_conn_reason_t reason);
+
+static sim_link_t* findLink(uint16_t connId) {
+	auto it = links.find(connId);
+	return it != links.end() ? &it->second : nullptr;
+}
+
+
+/*
+ * Queue the peripheral's answer to a read of an attribute.
+ */
+static esp_err_t answerRead(esp_gatt_if_t gattc_if, uint16_t conn_id, uint16_t handle, esp_gattc_cb_event_t event) {
+	std::unique_lock<std::mutex> gattLock(gattMutex);
+	if (findLink(conn_id) == nullptr) return ESP_ERR_INVALID_STATE;
+	std::vector<uint8_t> value = peerValue(conn_id, handle);
+	gattLock.unlock();
+	std::unique_lock<std::mutex> lock(queueMutex);
+	sim_event_t* pEvent = allocAnswer(lock, linkDue(conn_id), conn_id, event, gattc_if);
+	if (pEvent == nullptr) return ESP_FAIL;
+	size_t length = value.size() < EVENT_DATA_SIZE ? value.size() : EVENT_DATA_SIZE;
+	pEvent->param.gattc.read.status    = ESP_GATT_OK;
+	pEvent->param.gattc.read.conn_id   = conn_id;
+	pEvent->param.gattc.read.handle    = handle;
+	pEvent->param.gattc.read.value_len = length;
+	if (length > 0) memcpy(pEvent->data, value.data(), length);
+	postAnswer(pEvent);
+	return ESP_OK;
+}
+
+
+/*
+ * Store a value written to an attribute and queue the peripheral's answer.  A write without response is
+ * answered as soon as it has been sent.
+ */
+static esp_err_t answerWrite(esp_gatt_if_t gattc_if, uint16_t conn_id, uint16_t handle, uint16_t value_len, uint8_t* value, esp_gatt_write_type_t write_type, esp_gattc_cb_event_t event) {
+	std::unique_lock<std::mutex> gattLock(gattMutex);
+	if (findLink(conn_id) == nullptr) return ESP_ERR_INVALID_STATE;
+	peerValue(conn_id, handle).assign(value, value + value_len);
+	gattLock.unlock();
+	std::unique_lock<std::mutex> lock(queueMutex);
+	sim_event_t* pEvent = allocAnswer(lock, linkDue(conn_id, write_type == ESP_GATT_WRITE_TYPE_RSP), conn_id, event, gattc_if);
+	if (pEvent == nullptr) return ESP_FAIL;
+	pEvent->param.gattc.write.status  = ESP_GATT_OK;
+	pEvent->param.gattc.write.conn_id = conn_id;
+	pEvent->param.gattc.write.handle  = handle;
+	postAnswer(pEvent);
+	return ESP_OK;
+}
+
+
+/**
+ * @brief A peripheral the client is connected to notifies or indicates a value.
+ * @param [in] connId The connection id of the client's connection.
+ * @param [in] handle The handle of the characteristic.
+ * @param [in] pData The value.
+ * @param [in] length The length of the value, at most 600 bytes.
+ * @param [in] isNotify False for an indication.
+ */
+void BLEHostSim::notifyClient(uint16_t connId, uint16_t handle, const uint8_t* pData, size_t length, bool isNotify) {
+	std::unique_lock<std::mutex> gattLock(gattMutex);
+	sim_link_t* pLink = findLink(connId);
+	if (pLink == nullptr) return;
+	sim_link_t link = *pLink;
+	gattLock.unlock();
+	std::unique_lock<std::mutex> lock(queueMutex);
+	sim_event_t* pEvent = allocEvent(lock, KIND_GATTC, ESP_GATTC_NOTIFY_EVT, link.gattcIf);
+	if (pEvent == nullptr) return;
+	if (length > EVENT_DATA_SIZE) length = EVENT_DATA_SIZE;
+	pEvent->param.gattc.notify.conn_id   = connId;
+	pEvent->param.gattc.notify.handle    = handle;
+	pEvent->param.gattc.notify.value_len = length;
+	pEvent->param.gattc.notify.is_notify = isNotify;
+	memcpy(pEvent->param.gattc.notify.remote_bda, link.bda, ESP_BD_ADDR_LEN);
+	if (length > 0) memcpy(pEvent->data, pData, length);
+	postEvent();
+} // notifyClient
+
+
+/**
+ * @brief A peripheral the client is connected to indicates that its services have changed.
+ * @param [in] connId The connection id of the client's connection.
+ */
+void BLEHostSim::serviceChanged(uint16_t connId) {
+	std::unique_lock<std::mutex> gattLock(gattMutex);
+	sim_link_t* pLink = findLink(connId);
+	if (pLink == nullptr) return;
+	sim_link_t link = *pLink;
+	gattLock.unlock();
+	std::unique_lock<std::mutex> lock(queueMutex);
+	sim_event_t* pEvent = allocEvent(lock, KIND_GATTC, ESP_GATTC_SRVC_CHG_EVT, link.gattcIf);
+	if (pEvent == nullptr) return;
+	memcpy(pEvent->param.gattc.srvc_chg.remote_bda, link.bda, ESP_BD_ADDR_LEN);
+	postEvent();
+} // serviceChanged
+
+
+/**
+ * @brief The link to a peripheral the client is connected to is lost, as when it goes out of range.
+ * @param [in] connId The connection id of the client's connection.
+ */
+void BLEHostSim::dropLink(uint16_t connId) {
+	closeLink(connId, ESP_GATT_CONN_TIMEOUT);
+} // dropLink
+
+
+/**
+ * @brief Set whether the client's attempts to connect succeed.
+ * @param [in] isConnectable False to have every peripheral out of range.  True, the default, to have
+ * every peripheral accept.
+ */
+void BLEHostSim::setConnectable(bool isConnectable) {
+	std::lock_guard<std::mutex> lock(gattMutex);
+	connectable = isConnectable;
+} // setConnectable
+
+
+/**
+ * @brief Set how long a peripheral takes to answer a request from the client.
+ *
+ * Each connection carries one request at a time, so requests on one connection are answered one after
+ * another while requests on different connections overlap, as over the air.  Registration, connection
+ * and notifications are not delayed.
+ *
+ * @param [in] latencyUs The time from a request to its answer, in microseconds.  0, the default,
+ * answers at once.
+ */
+void BLEHostSim::setLinkLatency(uint32_t latencyUs) {
+	flush();
+	std::lock_guard<std::mutex> lock(queueMutex);
+	linkLatencyUs = latencyUs;
+} // setLinkLatency
+
+
+esp_err_t esp_ble_gattc_register_callback(esp_gattc_cb_t callback) {
+	gattcCallback = callback;
+	return ESP_OK;
+}
+
+esp_err_t esp_ble_gattc_app_register(uint16_t app_id) {
+	std::unique_lock<std::mutex> gattLock(gattMutex);
+	uint16_t gattcIf = nextGattIf++;
+	gattLock.unlock();
+	std::unique_lock<std::mutex> lock(queueMutex);
+	sim_event_t* pEvent = allocEvent(lock, KIND_GATTC, ESP_GATTC_REG_EVT, gattcIf);
+	if (pEvent == nullptr) return ESP_FAIL;
+	pEvent->param.gattc.reg.status = ESP_GATT_OK;
+	pEvent->param.gattc.reg.app_id = app_id;
+	postEvent();
+	return ESP_OK;
+}
+
+esp_err_t esp_ble_gattc_app_unregister(esp_gatt_if_t) {
+	return ESP_OK;
+}
+
+/*
+ * Every peripheral is in range and accepts the connection, unless BLEHostSim::setConnectable() says
+ * otherwise, when the attempt fails at once rather than after the stack's timeout.
+ */
+esp_err_t esp_ble_gattc_open(esp_gatt_if_t gattc_if, esp_bd_addr_t remote_bda, esp_ble_addr_type_t, bool) {
+	std::unique_lock<std::mutex> gattLock(gattMutex);
+	if (!connectable) {
+		gattLock.unlock();
+		std::unique_lock<std::mutex> lock(queueMutex);
+		sim_event_t* pEvent = allocEvent(lock, KIND_GATTC, ESP_GATTC_OPEN_EVT, gattc_if);
+		if (pEvent == nullptr) return ESP_FAIL;
+		pEvent->param.gattc.open.status  = ESP_GATT_ERROR;
+		pEvent->param.gattc.open.conn_id = 0;
+		memcpy(pEvent->param.gattc.open.remote_bda, remote_bda, ESP_BD_ADDR_LEN);
+		postEvent();
+		return ESP_OK;
+	}
+	uint16_t connId = nextConnId++;
+	sim_link_t& link = links[connId];
+	link.gattcIf = gattc_if;
+	memcpy(link.bda, remote_bda, ESP_BD_ADDR_LEN);
+	gattLock.unlock();
+
+	std::unique_lock<std::mutex> lock(queueMutex);
+	sim_event_t* pEvent = allocEvent(lock, KIND_GATTC, ESP_GATTC_CONNECT_EVT, gattc_if);
+	if (pEvent == nullptr) return ESP_FAIL;
+	pEvent->param.gattc.connect.conn_id                = connId;
+	pEvent->param.gattc.connect.conn_params.interval   = 24;
+	pEvent->param.gattc.connect.conn_params.timeout    = 400;
+	memcpy(pEvent->param.gattc.connect.remote_bda, remote_bda, ESP_BD_ADDR_LEN);
+	postEvent();
+
+	pEvent = allocEvent(lock, KIND_GATTC, ESP_GATTC_OPEN_EVT, gattc_if);
+	if (pEvent == nullptr) return ESP_FAIL;
+	pEvent->param.gattc.open.status  = ESP_GATT_OK;
+	pEvent->param.gattc.open.conn_id = connId;
+	pEvent->param.gattc.open.mtu     = ESP_GATT_DEF_BLE_MTU_SIZE;
+	memcpy(pEvent->param.gattc.open.remote_bda, remote_bda, ESP_BD_ADDR_LEN);
+	postEvent();
+	return ESP_OK;
+}
+
+/*
+ * End a connection of the client.  Answers still on their way are lost with it.
+ */
+static esp_err_t closeLink(uint16_t conn_id, esp_gatt_conn_reason_t reason) {
+	std::unique_lock<std::mutex> gattLock(gattMutex);
+	sim_link_t* pLink = findLink(conn_id);
+	if (pLink == nullptr) return ESP_OK;
+	sim_link_t link = *pLink;
+	links.erase(conn_id);
+	gattLock.unlock();
+
+	std::unique_lock<std::mutex> lock(queueMutex);
+	for (auto& slot : delayed) {
+		if (slot.used && slot.connId == conn_id) {
+			slot.used = false;
+			delayedCount--;
+		}
+	}
+	linkBusyUntil.erase(conn_id);
+	delayedChanged.notify_all();
+	queueChanged.notify_all();
+
+	sim_event_t* pEvent = allocEvent(lock, KIND_GATTC, ESP_GATTC_DISCONNECT_EVT, link.gattcIf);
+	if (pEvent == nullptr) return ESP_FAIL;
+	pEvent->param.gattc.disconnect.reason  = reason;
+	pEvent->param.gattc.disconnect.conn_id = conn_id;
+	memcpy(pEvent->param.gattc.disconnect.remote_bda, link.bda, ESP_BD_ADDR_LEN);
+	postEvent();
+
+	pEvent = allocEvent(lock, KIND_GATTC, ESP_GATTC_CLOSE_EVT, link.gattcIf);
+	if (pEvent == nullptr) return ESP_FAIL;
+	pEvent->param.gattc.close.status  = ESP_GATT_OK;
+	pEvent->param.gattc.close.conn_id = conn_id;
+	pEvent->param.gattc.close.reason  = reason;
+	memcpy(pEvent->param.gattc.close.remote_bda, link.bda, ESP_BD_ADDR_LEN);
+	postEvent();
+	return ESP_OK;
+}
+
+esp_err_t esp_ble_gattc_close(esp_gatt_if_t, uint16_t conn_id) {
+	return closeLink(conn_id, ESP_GATT_CONN_TERMINATE_LOCAL_HOST);
+}
+
+esp_err_t esp_ble_gattc_send_mtu_req(esp_gatt_if_t gattc_if, uint16_t conn_id) {
+	std::unique_lock<std::mutex> lock(queueMutex);
+	sim_event_t* pEvent = allocEvent(lock, KIND_GATTC, ESP_GATTC_CFG_MTU_EVT, gattc_if);
+	if (pEvent == nullptr) return ESP_FAIL;
+	pEvent->param.gattc.cfg_mtu.status  = ESP_GATT_OK;
+	pEvent->param.gattc.cfg_mtu.conn_id = conn_id;
+	pEvent->param.gattc.cfg_mtu.mtu     = 247;
+	postEvent();
+	return ESP_OK;
+}
+
+esp_err_t esp_ble_gattc_search_service(esp_gatt_if_t gattc_if, uint16_t conn_id, esp_bt_uuid_t* filter_uuid) {
+	std::unique_lock<std::mutex> gattLock(gattMutex);
+	if (findLink(conn_id) == nullptr) return ESP_ERR_INVALID_STATE;
+	gattLock.unlock();
+
+	// Over the air the discovery is an exchange for each service, characteristic and descriptor found,
+	// and one more for each list to learn that it has ended.  Bluedroid reports it all at the end.
+	std::unique_lock<std::mutex> lock(queueMutex);
+	size_t   exchanges = 1 + sizeof(peerServices) / sizeof(peerServices[0]) * 2 + sizeof(peerChars) / sizeof(peerChars[0]) * 2;
+	uint64_t due = 0;
+	for (size_t i = 0; i < exchanges; i++) {
+		due = linkDue(conn_id);
+	}
+	for (auto& service : peerServices) {
+		if (filter_uuid != nullptr && (filter_uuid->len != ESP_UUID_LEN_16 || filter_uuid->uuid.uuid16 != service.uuid)) continue;
+		sim_event_t* pEvent = allocAnswer(lock, due, conn_id, ESP_GATTC_SEARCH_RES_EVT, gattc_if);
+		if (pEvent == nullptr) return ESP_FAIL;
+		pEvent->param.gattc.search_res.conn_id      = conn_id;
+		pEvent->param.gattc.search_res.start_handle = service.startHandle;
+		pEvent->param.gattc.search_res.end_handle   = service.endHandle;
+		pEvent->param.gattc.search_res.is_primary   = true;
+		setUUID16(&pEvent->param.gattc.search_res.srvc_id.uuid, service.uuid);
+		postAnswer(pEvent);
+	}
+	sim_event_t* pEvent = allocAnswer(lock, due, conn_id, ESP_GATTC_SEARCH_CMPL_EVT, gattc_if);
+	if (pEvent == nullptr) return ESP_FAIL;
+	pEvent->param.gattc.search_cmpl.status                  = ESP_GATT_OK;
+	pEvent->param.gattc.search_cmpl.conn_id                 = conn_id;
+	pEvent->param.gattc.search_cmpl.searched_service_source = ESP_GATT_SERVICE_FROM_REMOTE_DEVICE;
+	postAnswer(pEvent);
+	return ESP_OK;
+}
+
+esp_gatt_status_t esp_ble_gattc_get_service(esp_gatt_if_t, uint16_t, esp_bt_uuid_t* svc_uuid, esp_gattc_service_elem_t* result, uint16_t* count, uint16_t offset) {
+	uint16_t found = 0;
+	for (auto& service : peerServices) {
+		if (svc_uuid != nullptr && (svc_uuid->len != ESP_UUID_LEN_16 || svc_uuid->uuid.uuid16 != service.uuid)) continue;
+		if (offset > 0) {
+			offset--;
+			continue;
+		}
+		if (found == *count) break;
+		result[found].is_primary   = true;
+		result[found].start_handle = service.startHandle;
+		result[found].end_handle   = service.endHandle;
+		setUUID16(&result[found].uuid, service.uuid);
+		found++;
+	}
+	*count = found;
+	return found > 0 ? ESP_GATT_OK : ESP_GATT_NOT_FOUND;
+}
+
+esp_gatt_status_t esp_ble_gattc_get_all_char(esp_gatt_if_t, uint16_t, uint16_t start_handle, uint16_t end_handle, esp_gattc_char_elem_t* result, uint16_t* count, uint16_t offset) {
+	uint16_t found = 0;
+	for (auto& characteristic : peerChars) {
+		if (characteristic.handle < start_handle || characteristic.handle > end_handle) continue;
+		if (offset > 0) {
+			offset--;
+			continue;
+		}
+		if (found == *count) break;
+		result[found].char_handle = characteristic.handle;
+		result[found].properties  = characteristic.properties;
+		setUUID16(&result[found].uuid, characteristic.uuid);
+		found++;
+	}
+	*count = found;
+	return found > 0 ? ESP_GATT_OK : ESP_GATT_NOT_FOUND;
+}
+
+esp_gatt_status_t esp_ble_gattc_get_all_descr(esp_gatt_if_t, uint16_t, uint16_t char_handle, esp_gattc_descr_elem_t* result, uint16_t* count, uint16_t offset) {
+	if (char_handle != peerCCCDHandle - 1 || offset > 0 || *count == 0) {
+		*count = 0;
+		return ESP_GATT_NOT_FOUND;
+	}
+	result[0].handle = peerCCCDHandle;
+	setUUID16(&result[0].uuid, 0x2902);
+	*count = 1;
+	return ESP_GATT_OK;
+}
+
+esp_err_t esp_ble_gattc_read_char(esp_gatt_if_t gattc_if, uint16_t conn_id, uint16_t handle, esp_gatt_auth_req_t) {
+	return answerRead(gattc_if, conn_id, handle, ESP_GATTC_READ_CHAR_EVT);
+}
+
+esp_err_t esp_ble_gattc_read_char_descr(esp_gatt_if_t gattc_if, uint16_t conn_id, uint16_t handle, esp_gatt_auth_req_t) {
+	return answerRead(gattc_if, conn_id, handle, ESP_GATTC_READ_DESCR_EVT);
+}
+
+esp_err_t esp_ble_gattc_write_char(esp_gatt_if_t gattc_if, uint16_t conn_id, uint16_t handle, uint16_t value_len, uint8_t* value, esp_gatt_write_type_t write_type, esp_gatt_auth_req_t) {
+	return answerWrite(gattc_if, conn_id, handle, value_len, value, write_type, ESP_GATTC_WRITE_CHAR_EVT);
+}
+
+esp_err_t esp_ble_gattc_write_char_descr(esp_gatt_if_t gattc_if, uint16_t conn_id, uint16_t handle, uint16_t value_len, uint8_t* value, esp_gatt_write_type_t write_type, esp_gatt_auth_req_t) {
+	return answerWrite(gattc_if, conn_id, handle, value_len, value, write_type, ESP_GATTC_WRITE_DESCR_EVT);
+}
+
+esp_err_t esp_ble_gattc_register_for_notify(esp_gatt_if_t gattc_if, esp_bd_addr_t, uint16_t handle) {
+	std::unique_lock<std::mutex> lock(queueMutex);
+	sim_event_t* pEvent = allocEvent(lock, KIND_GATTC, ESP_GATTC_REG_FOR_NOTIFY_EVT, gattc_if);
+	if (pEvent == nullptr) return ESP_FAIL;
+	pEvent->param.gattc.reg_for_notify.status = ESP_GATT_OK;
+	pEvent->param.gattc.reg_for_notify.handle = handle;
+	postEvent();
+	return ESP_OK;
+}
+
+esp_err_t esp_ble_gattc_unregister_for_notify(esp_gatt_if_t gattc_if, esp_bd_addr_t, uint16_t handle) {
+	std::unique_lock<std::mutex> lock(queueMutex);
+	sim_event_t* pEvent = allocEvent(lock, KIND_GATTC, ESP_GATTC_UNREG_FOR_NOTIFY_EVT, gattc_if);
+	if (pEvent == nullptr) return ESP_FAIL;
+	pEvent->param.gattc.unreg_for_notify.status = ESP_GATT_OK;
+	pEvent->param.gattc.unreg_for_notify.handle = handle;
+	postEvent();
+	return ESP_OK;
+}
+
+esp_err_t esp_ble_gattc_cache_refresh(esp_bd_addr_t) {
+	return ESP_OK;
+}
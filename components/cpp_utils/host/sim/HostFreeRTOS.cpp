@@ -0,0 +1,442 @@
+/*
+ * HostFreeRTOS.cpp
+ *
+ * The FreeRTOS kernel calls used by cpp_utils, built on the C++11 thread library.  A tick is a
+ * millisecond counted from program start.
+ */
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/ringbuf.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <freertos/timers.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+typedef std::chrono::steady_clock clock_type;
+
+static const clock_type::time_point startTime = clock_type::now();
+
+static clock_type::duration ticksToDuration(TickType_t ticks) {
+	return std::chrono::milliseconds((uint64_t)ticks * portTICK_PERIOD_MS);
+}
+
+
+/*
+ * Wait on a condition for up to a number of ticks.  Returns true if the condition became true.
+ */
+template<typename Predicate>
+static bool waitFor(std::condition_variable& cv, std::unique_lock<std::mutex>& lock, TickType_t ticks, Predicate pred) {
+	if (ticks == portMAX_DELAY) {
+		cv.wait(lock, pred);
+		return true;
+	}
+	return cv.wait_for(lock, ticksToDuration(ticks), pred);
+}
+
+
+// ---------------------------------------------------------------------------------------------------
+// Queues and semaphores
+//
+// A queue is a ring of fixed size items.  A semaphore is a queue of zero sized items whose count is the
+// semaphore's count.
+// ---------------------------------------------------------------------------------------------------
+struct host_queue {
+	std::mutex              mutex;
+	std::condition_variable changed;
+	std::vector<uint8_t>    storage;
+	UBaseType_t             length;
+	UBaseType_t             itemSize;
+	UBaseType_t             count;
+	UBaseType_t             head;
+};
+
+
+static QueueHandle_t createQueue(UBaseType_t length, UBaseType_t itemSize, UBaseType_t initialCount) {
+	host_queue* pQueue = new host_queue();
+	pQueue->storage.resize(length * itemSize);
+	pQueue->length   = length;
+	pQueue->itemSize = itemSize;
+	pQueue->count    = initialCount;
+	pQueue->head     = 0;
+	return pQueue;
+}
+
+
+static BaseType_t queueSend(QueueHandle_t xQueue, const void* pvItem, TickType_t xTicksToWait) {
+	std::unique_lock<std::mutex> lock(xQueue->mutex);
+	if (!waitFor(xQueue->changed, lock, xTicksToWait, [xQueue] { return xQueue->count < xQueue->length; })) {
+		return pdFALSE;
+	}
+	if (xQueue->itemSize > 0) {
+		UBaseType_t slot = (xQueue->head + xQueue->count) % xQueue->length;
+		memcpy(&xQueue->storage[slot * xQueue->itemSize], pvItem, xQueue->itemSize);
+	}
+	xQueue->count++;
+	xQueue->changed.notify_all();
+	return pdTRUE;
+}
+
+
+static BaseType_t queueReceive(QueueHandle_t xQueue, void* pvBuffer, TickType_t xTicksToWait) {
+	std::unique_lock<std::mutex> lock(xQueue->mutex);
+	if (!waitFor(xQueue->changed, lock, xTicksToWait, [xQueue] { return xQueue->count > 0; })) {
+		return pdFALSE;
+	}
+	if (xQueue->itemSize > 0) {
+		memcpy(pvBuffer, &xQueue->storage[xQueue->head * xQueue->itemSize], xQueue->itemSize);
+		xQueue->head = (xQueue->head + 1) % xQueue->length;
+	}
+	xQueue->count--;
+	xQueue->changed.notify_all();
+	return pdTRUE;
+}
+
+
+QueueHandle_t xQueueCreate(UBaseType_t uxQueueLength, UBaseType_t uxItemSize) {
+	return createQueue(uxQueueLength, uxItemSize, 0);
+}
+
+BaseType_t xQueueSend(QueueHandle_t xQueue, const void* pvItemToQueue, TickType_t xTicksToWait) {
+	return queueSend(xQueue, pvItemToQueue, xTicksToWait);
+}
+
+BaseType_t xQueueSendToBack(QueueHandle_t xQueue, const void* pvItemToQueue, TickType_t xTicksToWait) {
+	return queueSend(xQueue, pvItemToQueue, xTicksToWait);
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t xQueue, const void* pvItemToQueue, BaseType_t* pxHigherPriorityTaskWoken) {
+	if (pxHigherPriorityTaskWoken != nullptr) *pxHigherPriorityTaskWoken = pdFALSE;
+	return queueSend(xQueue, pvItemToQueue, 0);
+}
+
+BaseType_t xQueueReceive(QueueHandle_t xQueue, void* pvBuffer, TickType_t xTicksToWait) {
+	return queueReceive(xQueue, pvBuffer, xTicksToWait);
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t xQueue) {
+	std::lock_guard<std::mutex> lock(xQueue->mutex);
+	return xQueue->count;
+}
+
+void vQueueDelete(QueueHandle_t xQueue) {
+	delete xQueue;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void) {
+	return createQueue(1, 0, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+	return createQueue(1, 0, 1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t uxMaxCount, UBaseType_t uxInitialCount) {
+	return createQueue(uxMaxCount, 0, uxInitialCount);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t xSemaphore, TickType_t xTicksToWait) {
+	return queueReceive(xSemaphore, nullptr, xTicksToWait);
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t xSemaphore) {
+	return queueSend(xSemaphore, nullptr, 0);
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t xSemaphore, BaseType_t* pxHigherPriorityTaskWoken) {
+	if (pxHigherPriorityTaskWoken != nullptr) *pxHigherPriorityTaskWoken = pdFALSE;
+	return queueSend(xSemaphore, nullptr, 0);
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t xSemaphore) {
+	delete xSemaphore;
+}
+
+
+// ---------------------------------------------------------------------------------------------------
+// Tasks
+//
+// Each task is a detached thread.  Threads not created through xTaskCreate() (such as main) are given a
+// task the first time they ask for one.  Task handles are never freed since another task may still
+// notify a task that has ended.
+// ---------------------------------------------------------------------------------------------------
+struct host_task {
+	std::mutex              mutex;
+	std::condition_variable notified;
+	uint32_t                notifyCount = 0;
+	std::string             name;
+	TaskFunction_t          pvTaskCode  = nullptr;
+	void*                   pvParameters = nullptr;
+};
+
+static thread_local host_task* pCurrentTask = nullptr;
+
+
+BaseType_t xTaskCreate(TaskFunction_t pvTaskCode, const char* pcName, uint32_t, void* pvParameters, UBaseType_t, TaskHandle_t* pxCreatedTask) {
+	host_task* pTask = new host_task();
+	pTask->name         = pcName != nullptr ? pcName : "";
+	pTask->pvTaskCode   = pvTaskCode;
+	pTask->pvParameters = pvParameters;
+	if (pxCreatedTask != nullptr) *pxCreatedTask = pTask;
+	std::thread([pTask] {
+		pCurrentTask = pTask;
+		pTask->pvTaskCode(pTask->pvParameters);
+	}).detach();
+	return pdPASS;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t pvTaskCode, const char* pcName, uint32_t usStackDepth, void* pvParameters, UBaseType_t uxPriority, TaskHandle_t* pxCreatedTask, BaseType_t) {
+	return xTaskCreate(pvTaskCode, pcName, usStackDepth, pvParameters, uxPriority, pxCreatedTask);
+}
+
+/*
+ * A task may only delete itself; a thread cannot be stopped from outside.
+ */
+void vTaskDelete(TaskHandle_t xTaskToDelete) {
+	if (xTaskToDelete == nullptr || xTaskToDelete == pCurrentTask) {
+		pthread_exit(nullptr);
+	}
+}
+
+void vTaskDelay(TickType_t xTicksToDelay) {
+	std::this_thread::sleep_for(ticksToDuration(xTicksToDelay));
+}
+
+TickType_t xTaskGetTickCount(void) {
+	return (TickType_t)(std::chrono::duration_cast<std::chrono::milliseconds>(clock_type::now() - startTime).count() / portTICK_PERIOD_MS);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+	if (pCurrentTask == nullptr) {
+		pCurrentTask = new host_task();
+	}
+	return pCurrentTask;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t xClearCountOnExit, TickType_t xTicksToWait) {
+	host_task* pTask = xTaskGetCurrentTaskHandle();
+	std::unique_lock<std::mutex> lock(pTask->mutex);
+	if (!waitFor(pTask->notified, lock, xTicksToWait, [pTask] { return pTask->notifyCount > 0; })) {
+		return 0;
+	}
+	uint32_t count = pTask->notifyCount;
+	pTask->notifyCount = xClearCountOnExit ? 0 : count - 1;
+	return count;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t xTaskToNotify) {
+	std::lock_guard<std::mutex> lock(xTaskToNotify->mutex);
+	xTaskToNotify->notifyCount++;
+	xTaskToNotify->notified.notify_all();
+	return pdPASS;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t) {
+	return 0;
+}
+
+
+// ---------------------------------------------------------------------------------------------------
+// Software timers
+//
+// Timer callbacks run one at a time on a timer thread, as they do on the FreeRTOS timer daemon task.
+// ---------------------------------------------------------------------------------------------------
+struct host_timer {
+	std::string             name;
+	TickType_t              period;
+	bool                    autoReload;
+	void*                   pvTimerID;
+	TimerCallbackFunction_t pxCallbackFunction;
+	bool                    active;
+	clock_type::time_point  expiry;
+};
+
+// The timer thread waits on these for as long as the process runs, so they are never destroyed.
+static std::mutex&              timerMutex   = *new std::mutex();
+static std::condition_variable& timerChanged = *new std::condition_variable();
+static std::list<host_timer*>  timerList;
+static std::list<std::function<void()>> timerPended;   // Calls for the timer thread to make, in order.
+static bool                    timerThreadStarted = false;
+
+
+static void timerThread() {
+	std::unique_lock<std::mutex> lock(timerMutex);
+	while (true) {
+		if (!timerPended.empty()) {
+			std::function<void()> pended = timerPended.front();
+			timerPended.pop_front();
+			lock.unlock();
+			pended();
+			lock.lock();
+			continue;
+		}
+		host_timer* pNext = nullptr;
+		for (auto pTimer : timerList) {
+			if (pTimer->active && (pNext == nullptr || pTimer->expiry < pNext->expiry)) pNext = pTimer;
+		}
+		if (pNext == nullptr) {
+			timerChanged.wait(lock);
+			continue;
+		}
+		if (timerChanged.wait_until(lock, pNext->expiry) != std::cv_status::timeout) {
+			continue;  // The timers have changed; look again.
+		}
+		if (!pNext->active || clock_type::now() < pNext->expiry) continue;
+		if (pNext->autoReload) {
+			pNext->expiry += ticksToDuration(pNext->period);
+		} else {
+			pNext->active = false;
+		}
+		lock.unlock();
+		pNext->pxCallbackFunction(pNext);
+		lock.lock();
+	}
+}
+
+
+static void startTimerThread() {
+	if (!timerThreadStarted) {
+		timerThreadStarted = true;
+		std::thread(timerThread).detach();
+	}
+	timerChanged.notify_all();
+}
+
+
+static void armTimer(TimerHandle_t xTimer) {
+	xTimer->active = true;
+	xTimer->expiry = clock_type::now() + ticksToDuration(xTimer->period);
+	startTimerThread();
+}
+
+
+TimerHandle_t xTimerCreate(const char* pcTimerName, TickType_t xTimerPeriod, UBaseType_t uxAutoReload, void* pvTimerID, TimerCallbackFunction_t pxCallbackFunction) {
+	host_timer* pTimer = new host_timer();
+	pTimer->name               = pcTimerName != nullptr ? pcTimerName : "";
+	pTimer->period             = xTimerPeriod;
+	pTimer->autoReload         = uxAutoReload != pdFALSE;
+	pTimer->pvTimerID          = pvTimerID;
+	pTimer->pxCallbackFunction = pxCallbackFunction;
+	pTimer->active             = false;
+	std::lock_guard<std::mutex> lock(timerMutex);
+	timerList.push_back(pTimer);
+	return pTimer;
+}
+
+BaseType_t xTimerDelete(TimerHandle_t xTimer, TickType_t) {
+	std::lock_guard<std::mutex> lock(timerMutex);
+	timerList.remove(xTimer);
+	delete xTimer;
+	timerChanged.notify_all();
+	return pdPASS;
+}
+
+BaseType_t xTimerStart(TimerHandle_t xTimer, TickType_t) {
+	std::lock_guard<std::mutex> lock(timerMutex);
+	armTimer(xTimer);
+	return pdPASS;
+}
+
+BaseType_t xTimerStop(TimerHandle_t xTimer, TickType_t) {
+	std::lock_guard<std::mutex> lock(timerMutex);
+	xTimer->active = false;
+	timerChanged.notify_all();
+	return pdPASS;
+}
+
+BaseType_t xTimerReset(TimerHandle_t xTimer, TickType_t) {
+	std::lock_guard<std::mutex> lock(timerMutex);
+	armTimer(xTimer);
+	return pdPASS;
+}
+
+BaseType_t xTimerChangePeriod(TimerHandle_t xTimer, TickType_t xNewPeriod, TickType_t) {
+	std::lock_guard<std::mutex> lock(timerMutex);
+	xTimer->period = xNewPeriod;
+	armTimer(xTimer);  // Changing the period of a dormant timer starts it.
+	return pdPASS;
+}
+
+BaseType_t xTimerPendFunctionCall(PendedFunction_t xFunctionToPend, void* pvParameter1, uint32_t ulParameter2, TickType_t) {
+	std::lock_guard<std::mutex> lock(timerMutex);
+	timerPended.push_back([=] { xFunctionToPend(pvParameter1, ulParameter2); });
+	startTimerThread();
+	return pdPASS;
+}
+
+const char* pcTimerGetTimerName(TimerHandle_t xTimer) {
+	return xTimer->name.c_str();
+}
+
+void* pvTimerGetTimerID(TimerHandle_t xTimer) {
+	return xTimer->pvTimerID;
+}
+
+
+// ---------------------------------------------------------------------------------------------------
+// Ring buffers
+//
+// Every item is held whole, whatever the ring buffer type.
+// ---------------------------------------------------------------------------------------------------
+struct host_ringbuf {
+	std::mutex                        mutex;
+	std::condition_variable           changed;
+	std::deque<std::vector<uint8_t>>  items;
+	size_t                            size;
+	size_t                            used;
+};
+
+
+RingbufHandle_t xRingbufferCreate(size_t xBufferSize, RingbufferType_t) {
+	host_ringbuf* pRingbuf = new host_ringbuf();
+	pRingbuf->size = xBufferSize;
+	pRingbuf->used = 0;
+	return pRingbuf;
+}
+
+BaseType_t xRingbufferSend(RingbufHandle_t xRingbuffer, const void* pvItem, size_t xItemSize, TickType_t xTicksToWait) {
+	std::unique_lock<std::mutex> lock(xRingbuffer->mutex);
+	if (xItemSize > xRingbuffer->size) return pdFALSE;
+	if (!waitFor(xRingbuffer->changed, lock, xTicksToWait,
+			[xRingbuffer, xItemSize] { return xRingbuffer->used + xItemSize <= xRingbuffer->size; })) {
+		return pdFALSE;
+	}
+	const uint8_t* pBytes = (const uint8_t*)pvItem;
+	xRingbuffer->items.push_back(std::vector<uint8_t>(pBytes, pBytes + xItemSize));
+	xRingbuffer->used += xItemSize;
+	xRingbuffer->changed.notify_all();
+	return pdTRUE;
+}
+
+void* xRingbufferReceive(RingbufHandle_t xRingbuffer, size_t* pxItemSize, TickType_t xTicksToWait) {
+	std::unique_lock<std::mutex> lock(xRingbuffer->mutex);
+	if (!waitFor(xRingbuffer->changed, lock, xTicksToWait, [xRingbuffer] { return !xRingbuffer->items.empty(); })) {
+		return nullptr;
+	}
+	std::vector<uint8_t>& item = xRingbuffer->items.front();
+	void* pItem = malloc(item.size() > 0 ? item.size() : 1);
+	memcpy(pItem, item.data(), item.size());
+	*pxItemSize = item.size();
+	xRingbuffer->used -= item.size();
+	xRingbuffer->items.pop_front();
+	xRingbuffer->changed.notify_all();
+	return pItem;
+}
+
+void vRingbufferReturnItem(RingbufHandle_t, void* pvItem) {
+	free(pvItem);
+}
+
+void vRingbufferDelete(RingbufHandle_t xRingbuffer) {
+	delete xRingbuffer;
+}
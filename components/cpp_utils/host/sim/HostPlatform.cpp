@@ -0,0 +1,247 @@
+/*
+ * HostPlatform.cpp
+ *
+ * The ESP-IDF system, logging and NVS calls used by cpp_utils.  Logging goes to stdout and NVS is held
+ * in memory for the life of the process.
+ */
+#include <esp_err.h>
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+#include <esp_system.h>
+#include <esp_timer.h>
+#include <nvs.h>
+#include <nvs_flash.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+static const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+
+// ---------------------------------------------------------------------------------------------------
+// Logging
+// ---------------------------------------------------------------------------------------------------
+static std::mutex                             logMutex;
+static esp_log_level_t                        logDefaultLevel = ESP_LOG_VERBOSE;
+static std::map<std::string, esp_log_level_t> logTagLevels;
+
+
+void esp_log_level_set(const char* tag, esp_log_level_t level) {
+	std::lock_guard<std::mutex> lock(logMutex);
+	if (strcmp(tag, "*") == 0) {
+		logDefaultLevel = level;
+		logTagLevels.clear();
+	} else {
+		logTagLevels[tag] = level;
+	}
+}
+
+uint32_t esp_log_timestamp(void) {
+	return (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+void esp_log_write(esp_log_level_t level, const char* tag, const char* format, ...) {
+	static const char letters[] = "NEWIDV";
+	std::lock_guard<std::mutex> lock(logMutex);
+	esp_log_level_t tagLevel = logDefaultLevel;
+	if (!logTagLevels.empty()) {
+		auto it = logTagLevels.find(tag);
+		if (it != logTagLevels.end()) tagLevel = it->second;
+	}
+	if (level > tagLevel) return;
+	printf("%c (%u) %s: ", letters[level], esp_log_timestamp(), tag);
+	va_list args;
+	va_start(args, format);
+	vprintf(format, args);
+	va_end(args);
+	printf("\n");
+}
+
+void esp_log_buffer_hex_internal(const char* tag, const void* buffer, uint16_t buff_len, esp_log_level_t level) {
+	const uint8_t* pBytes = (const uint8_t*)buffer;
+	char line[16 * 3 + 1];
+	for (uint16_t offset = 0; offset < buff_len; offset += 16) {
+		int used = 0;
+		for (uint16_t i = offset; i < buff_len && i < offset + 16; i++) {
+			used += sprintf(&line[used], "%02x ", pBytes[i]);
+		}
+		line[used] = '\0';
+		esp_log_write(level, tag, "%s", line);
+	}
+}
+
+void esp_log_buffer_hexdump_internal(const char* tag, const void* buffer, uint16_t buff_len, esp_log_level_t level) {
+	esp_log_buffer_hex_internal(tag, buffer, buff_len, level);
+}
+
+
+// ---------------------------------------------------------------------------------------------------
+// System
+// ---------------------------------------------------------------------------------------------------
+const char* esp_err_to_name(esp_err_t code) {
+	switch (code) {
+		case ESP_OK:                return "ESP_OK";
+		case ESP_FAIL:              return "ESP_FAIL";
+		case ESP_ERR_NO_MEM:        return "ESP_ERR_NO_MEM";
+		case ESP_ERR_INVALID_ARG:   return "ESP_ERR_INVALID_ARG";
+		case ESP_ERR_INVALID_STATE: return "ESP_ERR_INVALID_STATE";
+		case ESP_ERR_INVALID_SIZE:  return "ESP_ERR_INVALID_SIZE";
+		case ESP_ERR_NOT_FOUND:     return "ESP_ERR_NOT_FOUND";
+		case ESP_ERR_NOT_SUPPORTED: return "ESP_ERR_NOT_SUPPORTED";
+		case ESP_ERR_TIMEOUT:       return "ESP_ERR_TIMEOUT";
+		case ESP_ERR_NVS_NOT_FOUND: return "ESP_ERR_NVS_NOT_FOUND";
+		default:                    return "UNKNOWN ERROR";
+	}
+}
+
+void esp_chip_info(esp_chip_info_t* out_info) {
+	out_info->model    = CHIP_ESP32;
+	out_info->features = CHIP_FEATURE_WIFI_BGN | CHIP_FEATURE_BLE | CHIP_FEATURE_BT;
+	out_info->cores    = 2;
+	out_info->revision = 1;
+}
+
+const char* esp_get_idf_version(void) {
+	return "host";
+}
+
+uint32_t esp_get_free_heap_size(void) {
+	return 0;
+}
+
+uint32_t esp_random(void) {
+	return (uint32_t)rand();
+}
+
+void esp_restart(void) {
+	exit(EXIT_FAILURE);
+}
+
+size_t heap_caps_get_free_size(uint32_t) {
+	return 0;
+}
+
+size_t heap_caps_get_minimum_free_size(uint32_t) {
+	return 0;
+}
+
+int64_t esp_timer_get_time(void) {
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+
+// ---------------------------------------------------------------------------------------------------
+// NVS
+//
+// A handle is an index into the list of opened namespaces.  Writes are visible immediately; commit does
+// nothing.
+// ---------------------------------------------------------------------------------------------------
+typedef std::map<std::string, std::vector<uint8_t>> nvs_namespace_t;
+
+static std::mutex                             nvsMutex;
+static std::map<std::string, nvs_namespace_t> nvsStore;
+static std::vector<std::string>               nvsHandles;
+
+
+static nvs_namespace_t* nvsNamespace(nvs_handle handle) {
+	if (handle == 0 || handle > nvsHandles.size()) return nullptr;
+	return &nvsStore[nvsHandles[handle - 1]];
+}
+
+
+static esp_err_t nvsSet(nvs_handle handle, const char* key, const void* value, size_t length) {
+	std::lock_guard<std::mutex> lock(nvsMutex);
+	nvs_namespace_t* pNamespace = nvsNamespace(handle);
+	if (pNamespace == nullptr) return ESP_ERR_NVS_INVALID_HANDLE;
+	const uint8_t* pBytes = (const uint8_t*)value;
+	(*pNamespace)[key] = std::vector<uint8_t>(pBytes, pBytes + length);
+	return ESP_OK;
+}
+
+
+static esp_err_t nvsGet(nvs_handle handle, const char* key, void* out_value, size_t* length) {
+	std::lock_guard<std::mutex> lock(nvsMutex);
+	nvs_namespace_t* pNamespace = nvsNamespace(handle);
+	if (pNamespace == nullptr) return ESP_ERR_NVS_INVALID_HANDLE;
+	auto it = pNamespace->find(key);
+	if (it == pNamespace->end()) return ESP_ERR_NVS_NOT_FOUND;
+	if (out_value == nullptr) {
+		*length = it->second.size();
+		return ESP_OK;
+	}
+	if (*length < it->second.size()) return ESP_ERR_NVS_INVALID_LENGTH;
+	memcpy(out_value, it->second.data(), it->second.size());
+	*length = it->second.size();
+	return ESP_OK;
+}
+
+
+esp_err_t nvs_flash_init(void) {
+	return ESP_OK;
+}
+
+esp_err_t nvs_flash_erase(void) {
+	std::lock_guard<std::mutex> lock(nvsMutex);
+	nvsStore.clear();
+	return ESP_OK;
+}
+
+esp_err_t nvs_open(const char* name, nvs_open_mode, nvs_handle* out_handle) {
+	std::lock_guard<std::mutex> lock(nvsMutex);
+	nvsHandles.push_back(name);
+	*out_handle = nvsHandles.size();
+	return ESP_OK;
+}
+
+void nvs_close(nvs_handle) {
+}
+
+esp_err_t nvs_commit(nvs_handle) {
+	return ESP_OK;
+}
+
+esp_err_t nvs_erase_key(nvs_handle handle, const char* key) {
+	std::lock_guard<std::mutex> lock(nvsMutex);
+	nvs_namespace_t* pNamespace = nvsNamespace(handle);
+	if (pNamespace == nullptr) return ESP_ERR_NVS_INVALID_HANDLE;
+	return pNamespace->erase(key) > 0 ? ESP_OK : ESP_ERR_NVS_NOT_FOUND;
+}
+
+esp_err_t nvs_erase_all(nvs_handle handle) {
+	std::lock_guard<std::mutex> lock(nvsMutex);
+	nvs_namespace_t* pNamespace = nvsNamespace(handle);
+	if (pNamespace == nullptr) return ESP_ERR_NVS_INVALID_HANDLE;
+	pNamespace->clear();
+	return ESP_OK;
+}
+
+esp_err_t nvs_set_blob(nvs_handle handle, const char* key, const void* value, size_t length) {
+	return nvsSet(handle, key, value, length);
+}
+
+esp_err_t nvs_get_blob(nvs_handle handle, const char* key, void* out_value, size_t* length) {
+	return nvsGet(handle, key, out_value, length);
+}
+
+esp_err_t nvs_set_str(nvs_handle handle, const char* key, const char* value) {
+	return nvsSet(handle, key, value, strlen(value) + 1);
+}
+
+esp_err_t nvs_get_str(nvs_handle handle, const char* key, char* out_value, size_t* length) {
+	return nvsGet(handle, key, out_value, length);
+}
+
+esp_err_t nvs_set_u32(nvs_handle handle, const char* key, uint32_t value) {
+	return nvsSet(handle, key, &value, sizeof(value));
+}
+
+esp_err_t nvs_get_u32(nvs_handle handle, const char* key, uint32_t* out_value) {
+	size_t length = sizeof(*out_value);
+	return nvsGet(handle, key, out_value, &length);
+}
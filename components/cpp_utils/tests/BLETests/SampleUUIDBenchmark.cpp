@@ -0,0 +1,62 @@
+/**
+ * Compare the cost of building and formatting BLEUUIDs the old way, parsing text at run time and
+ * formatting through a std::string, with parsing at compile time and formatting into a fixed buffer.
+ * No BLE activity is involved; the results are logged.
+ */
+#include "BLEUUID.h"
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <string>
+
+#include "sdkconfig.h"
+
+static const char LOG_TAG[] = "SampleUUIDBenchmark";
+
+#define ITERATIONS 10000
+
+static constexpr BLEUUIDLiteral SERVICE_UUID("4fafc201-1fb5-459e-8fcc-c5c9c331914b");
+
+static volatile uint32_t sink;   // Keeps the compiler from optimizing the loops away.
+
+static void run() {
+	int64_t start;
+	char    buffer[BLEUUID::STRING_SIZE];
+
+	start = esp_timer_get_time();
+	for (int i = 0; i < ITERATIONS; i++) {
+		BLEUUID uuid(std::string("4fafc201-1fb5-459e-8fcc-c5c9c331914b"));
+		sink += uuid.getNative()->uuid.uuid128[0];
+	}
+	int64_t parseRuntime = esp_timer_get_time() - start;
+
+	start = esp_timer_get_time();
+	for (int i = 0; i < ITERATIONS; i++) {
+		BLEUUID uuid(SERVICE_UUID);
+		sink += uuid.getNative()->uuid.uuid128[0];
+	}
+	int64_t parseConstexpr = esp_timer_get_time() - start;
+
+	BLEUUID uuid(SERVICE_UUID);
+	start = esp_timer_get_time();
+	for (int i = 0; i < ITERATIONS; i++) {
+		sink += uuid.toString().length();
+	}
+	int64_t formatString = esp_timer_get_time() - start;
+
+	start = esp_timer_get_time();
+	for (int i = 0; i < ITERATIONS; i++) {
+		sink += uuid.toString(buffer)[0];
+	}
+	int64_t formatBuffer = esp_timer_get_time() - start;
+
+	ESP_LOGI(LOG_TAG, "%d iterations", ITERATIONS);
+	ESP_LOGI(LOG_TAG, "parse  std::string:    %lld us", parseRuntime);
+	ESP_LOGI(LOG_TAG, "parse  BLEUUIDLiteral: %lld us", parseConstexpr);
+	ESP_LOGI(LOG_TAG, "format std::string:    %lld us", formatString);
+	ESP_LOGI(LOG_TAG, "format char buffer:    %lld us", formatBuffer);
+}
+
+void SampleUUIDBenchmark(void)
+{
+	run();
+} // SampleUUIDBenchmark
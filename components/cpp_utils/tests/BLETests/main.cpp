@@ -20,6 +20,7 @@ void SampleRead(void);
 void SampleScan(void);
 void SampleSensorTag(void);
 void SampleServer(void);
+void SampleUUIDBenchmark(void);
 void SampleWrite(void);
 
 //
@@ -39,5 +40,6 @@ void app_main(void) {
 	//SampleSensorTag();
 	//SampleScan();
 	SampleServer();
+	//SampleUUIDBenchmark();
 	//SampleWrite();
 } // app_main
@@ -0,0 +1,105 @@
+/*
+ * ConnParamsTuner.cpp
+ */
+#include <esp_log.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "ConnParamsTuner.h"
+
+static const char* LOG_TAG = "ConnParamsTuner";
+
+/**
+ * @brief Connection parameters asked for in each profile.
+ * Intervals are in units of 1.25ms and the timeout in units of 10ms.  Both sets keep within the limits
+ * phones accept: a minimum interval of at least 15ms, a range of at least 15ms and a supervision
+ * timeout of more than three times the effective interval.
+ */
+typedef struct {
+	uint16_t minInterval;
+	uint16_t maxInterval;
+	uint16_t latency;
+	uint16_t timeout;
+} conn_params_t;
+
+static const conn_params_t activeParams = { 12,  24, 0, 400 };  // 15-30ms, no latency, 4s.
+static const conn_params_t idleParams   = { 80, 160, 4, 600 };  // 100-200ms, skip up to 4 events, 6s.
+
+static uint32_t nowMs() {
+	return xTaskGetTickCount() * portTICK_PERIOD_MS;
+}
+
+
+/**
+ * @brief Construct a tuner for the clients of a server.
+ * @param [in] pServer The server whose connections are tuned.
+ */
+ConnParamsTuner::ConnParamsTuner(BLEServer* pServer) {
+	m_pServer  = pServer;
+	m_profile  = PROFILE_NONE;
+	m_lastBusy = 0;
+} // ConnParamsTuner
+
+
+/**
+ * @brief Get the profile currently applied.
+ * @return The profile.
+ */
+ConnParamsTuner::profile_t ConnParamsTuner::getProfile() {
+	return m_profile;
+} // getProfile
+
+
+/**
+ * @brief Are the parameters granted to a client those of a profile?
+ * @param [in] status The state of the connection.
+ * @param [in] profile The profile.
+ * @return True if the granted interval and latency are those asked for by the profile.
+ */
+bool ConnParamsTuner::isGranted(const conn_status_t& status, profile_t profile) {
+	const conn_params_t& params = (profile == PROFILE_ACTIVE) ? activeParams : idleParams;
+	return status.conn_interval >= params.minInterval &&
+		status.conn_interval <= params.maxInterval &&
+		status.conn_latency == params.latency;
+} // isGranted
+
+
+/**
+ * @brief Apply the policy.  Call this regularly while clients are connected.
+ * @param [in] busy True if a call is active or the car is moving.
+ */
+void ConnParamsTuner::update(bool busy) {
+	uint32_t now = nowMs();
+	if (busy) {
+		m_lastBusy = now;
+	}
+	profile_t profile = (busy || now - m_lastBusy < IDLE_AFTER_MS) ? PROFILE_ACTIVE : PROFILE_IDLE;
+	if (profile != m_profile) {
+		ESP_LOGI(LOG_TAG, "Switching to %s connection parameters", profile == PROFILE_ACTIVE ? "active" : "idle");
+		m_profile = profile;
+	}
+	const conn_params_t& params = (profile == PROFILE_ACTIVE) ? activeParams : idleParams;
+
+	std::map<uint16_t, conn_status_t> peers = m_pServer->getPeerDevices(false);
+
+	// Forget the clients that have gone.
+	for (auto it = m_clients.begin(); it != m_clients.end(); ) {
+		if (peers.find(it->first) == peers.end()) {
+			it = m_clients.erase(it);
+		} else {
+			++it;
+		}
+	}
+
+	for (auto &myPair : peers) {
+		if (isGranted(myPair.second, profile)) continue;
+
+		client_t& client = m_clients[myPair.first];  // Zero initialized for a new client.
+		if (client.requested == profile && now - client.requestedAt < RETRY_MS) continue;
+
+		ESP_LOGD(LOG_TAG, "conn_id %d: asking for interval %d-%d, latency %d", myPair.first,
+			params.minInterval, params.maxInterval, params.latency);
+		m_pServer->updateConnParams(myPair.first, params.minInterval, params.maxInterval, params.latency, params.timeout);
+		client.requested   = profile;
+		client.requestedAt = now;
+	}
+} // update
@@ -0,0 +1,50 @@
+/*
+ * ConnParamsTuner.h
+ */
+
+#ifndef MAIN_CONNPARAMSTUNER_H_
+#define MAIN_CONNPARAMSTUNER_H_
+#include <stdint.h>
+#include <map>
+#include <BLEServer.h>
+
+/**
+ * @brief Choose the connection parameters of each client from what the elevator is doing.
+ *
+ * While a call is active or the car is moving the clients are asked for a short connection interval so
+ * calls and status changes get through quickly.  Once the elevator has been idle for a while they are
+ * asked for a long interval with slave latency so the radio can sleep.  Each client is only asked again
+ * when the parameters it was granted do not match the current profile, and no more often than
+ * RETRY_MS, since a phone is free to refuse.
+ */
+class ConnParamsTuner {
+public:
+	typedef enum {
+		PROFILE_NONE,
+		PROFILE_ACTIVE,
+		PROFILE_IDLE
+	} profile_t;
+
+	static const uint32_t IDLE_AFTER_MS = 10000;  // How long the elevator must be idle before relaxing.
+	static const uint32_t RETRY_MS      = 5000;   // Minimum time between two requests to one client.
+
+	ConnParamsTuner(BLEServer* pServer);
+
+	profile_t getProfile();
+	void      update(bool busy);
+
+private:
+	typedef struct {
+		profile_t requested;
+		uint32_t  requestedAt;
+	} client_t;
+
+	bool      isGranted(const conn_status_t& status, profile_t profile);
+
+	BLEServer*                    m_pServer;
+	profile_t                     m_profile;
+	uint32_t                      m_lastBusy;
+	std::map<uint16_t, client_t>  m_clients;
+}; // ConnParamsTuner
+
+#endif /* MAIN_CONNPARAMSTUNER_H_ */
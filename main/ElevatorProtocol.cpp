@@ -0,0 +1,112 @@
+/*
+ * ElevatorProtocol.cpp
+ */
+#include "ElevatorProtocol.h"
+
+#define TLV_HEADER_SIZE 2
+
+
+/**
+ * @brief Construct a parser over a written frame.  The data is not copied.
+ * @param [in] pData The frame.
+ * @param [in] length The length of the frame.
+ */
+ElevatorProtocol::ElevatorProtocol(const uint8_t* pData, size_t length) {
+	m_pData  = pData;
+	m_length = length;
+	m_offset = 1;  // Skip the version byte.
+} // ElevatorProtocol
+
+
+/**
+ * @brief Is the frame a single floor index in the original format?
+ * @return True if the frame is one byte long.
+ */
+bool ElevatorProtocol::isLegacy() {
+	return m_length == 1;
+} // isLegacy
+
+
+/**
+ * @brief Get the next command of a validated frame.
+ * @param [out] pCommand The command.
+ * @return True if a command was returned, false at the end of the frame.
+ */
+bool ElevatorProtocol::next(command_t* pCommand) {
+	if (m_offset + TLV_HEADER_SIZE > m_length) return false;
+	pCommand->type   = m_pData[m_offset];
+	pCommand->length = m_pData[m_offset + 1];
+	pCommand->pValue = &m_pData[m_offset + TLV_HEADER_SIZE];
+	m_offset += TLV_HEADER_SIZE + pCommand->length;
+	return true;
+} // next
+
+
+/**
+ * @brief Check that the whole frame is well formed.
+ * @param [in] floorCount The number of floors; a floor index must be below it.
+ * @return nullptr if the frame is valid, otherwise a description of the first problem found.
+ */
+const char* ElevatorProtocol::validate(uint8_t floorCount) {
+	if (m_length == 0) return "empty write";
+	if (isLegacy()) {
+		return m_pData[0] < floorCount ? nullptr : "floor out of range";
+	}
+	if (m_pData[0] != VERSION) return "unsupported version";
+
+	size_t offset = 1;
+	if (offset == m_length) return "no commands";
+	while (offset < m_length) {
+		if (offset + TLV_HEADER_SIZE > m_length) return "truncated command header";
+		uint8_t        type   = m_pData[offset];
+		uint8_t        length = m_pData[offset + 1];
+		const uint8_t* pValue = &m_pData[offset + TLV_HEADER_SIZE];
+		if (offset + TLV_HEADER_SIZE + length > m_length) return "truncated command value";
+
+		switch (type) {
+			case CMD_FLOOR_CALL:
+			case CMD_CANCEL: {
+				if (length == 0) return "no floors given";
+				for (uint8_t i = 0; i < length; i++) {
+					if (pValue[i] >= floorCount) return "floor out of range";
+				}
+				break;
+			}
+
+			case CMD_HALL_CALL: {
+				if (length == 0 || length % 2 != 0) return "bad hall call length";
+				for (uint8_t i = 0; i < length; i += 2) {
+					if (pValue[i] >= floorCount) return "floor out of range";
+					if (pValue[i + 1] != HALL_UP && pValue[i + 1] != HALL_DOWN) return "bad hall call direction";
+				}
+				break;
+			}
+
+			case CMD_STATUS_QUERY: {
+				if (length != 0) return "bad status query length";
+				break;
+			}
+
+			case CMD_TIME_SYNC: {
+				if (length != 4) return "bad time sync length";
+				break;
+			}
+
+			default:
+				return "unknown command";
+		} // switch type
+		offset += TLV_HEADER_SIZE + length;
+	}
+	return nullptr;
+} // validate
+
+
+/**
+ * @brief Get the time carried by a CMD_TIME_SYNC command.
+ * @param [in] pCommand The command.
+ * @return Seconds since the epoch.
+ */
+uint32_t ElevatorProtocol::getTimeSync(const command_t* pCommand) {
+	const uint8_t* p = pCommand->pValue;
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+} // getTimeSync
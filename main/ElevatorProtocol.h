@@ -0,0 +1,68 @@
+/*
+ * ElevatorProtocol.h
+ */
+
+#ifndef MAIN_ELEVATORPROTOCOL_H_
+#define MAIN_ELEVATORPROTOCOL_H_
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @brief Commands written by the app to the elevator characteristic.
+ *
+ * A write is a frame made of a version byte followed by one or more TLV commands:
+ *
+ *   [version: 1 byte] { [type: 1 byte][length: 1 byte][length bytes of value] } ...
+ *
+ * | Type             | Value                                                    |
+ * |------------------|----------------------------------------------------------|
+ * | CMD_FLOOR_CALL   | One byte per floor to add to the list of chosen floors.  |
+ * | CMD_CANCEL       | One byte per floor to remove from the list.              |
+ * | CMD_HALL_CALL    | Pairs of [floor][direction], direction being HALL_UP or  |
+ * |                  | HALL_DOWN.                                               |
+ * | CMD_STATUS_QUERY | Empty.  The status is notified straight away.            |
+ * | CMD_TIME_SYNC    | Seconds since the epoch, 4 bytes little endian.          |
+ *
+ * A write of exactly one byte is the original format: the index of a single floor to call.
+ *
+ * The whole frame is validated before any command is acted upon so that a malformed write changes
+ * nothing.  Parsing is done in place; the values handed out point into the written data.
+ */
+class ElevatorProtocol {
+public:
+	static const uint8_t VERSION = 1;
+
+	typedef enum {
+		CMD_FLOOR_CALL   = 0x01,
+		CMD_CANCEL       = 0x02,
+		CMD_HALL_CALL    = 0x03,
+		CMD_STATUS_QUERY = 0x04,
+		CMD_TIME_SYNC    = 0x05
+	} command_type_t;
+
+	typedef enum {
+		HALL_UP   = 0,
+		HALL_DOWN = 1
+	} hall_direction_t;
+
+	typedef struct {
+		uint8_t        type;
+		uint8_t        length;
+		const uint8_t* pValue;  // Points into the frame; valid only as long as the written data is.
+	} command_t;
+
+	ElevatorProtocol(const uint8_t* pData, size_t length);
+
+	bool        isLegacy();
+	bool        next(command_t* pCommand);
+	const char* validate(uint8_t floorCount);
+
+	static uint32_t getTimeSync(const command_t* pCommand);
+
+private:
+	const uint8_t* m_pData;
+	size_t         m_length;
+	size_t         m_offset;
+}; // ElevatorProtocol
+
+#endif /* MAIN_ELEVATORPROTOCOL_H_ */
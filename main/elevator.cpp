@@ -2,6 +2,7 @@
 #include <BLEServer.h>
 #include <BLEDevice.h>
 #include <BLE2902.h>
+#include <BLEEventRing.h>
 #include <GPIO.h>
 #include <GeneralUtils.h>
 #include <Task.h>
@@ -13,6 +14,8 @@
 #include <sstream>
 
 #include "sdkconfig.h"
+#include "ElevatorProtocol.h"
+#include "ConnParamsTuner.h"
 
 #define DEBUG_APP 1
 
@@ -20,17 +23,33 @@
 // See the following for generating UUIDs:
 // https://www.uuidgenerator.net/
 
-#define SERVICE_UUID        "4fafc201-1fb5-459e-8fcc-c5c9c331914b"
-#define CHARACTERISTIC_UUID "beb5483e-36e1-4688-b7f5-ea07361b26a8"
+// Parsed at compile time.
+static constexpr BLEUUIDLiteral SERVICE_UUID("4fafc201-1fb5-459e-8fcc-c5c9c331914b");
+static constexpr BLEUUIDLiteral CHARACTERISTIC_UUID("beb5483e-36e1-4688-b7f5-ea07361b26a8");
+static constexpr BLEUUIDLiteral EVENTS_CHARACTERISTIC_UUID("beb5483e-36e1-4688-b7f5-ea07361b26a9");
 #define MAX_FLOOR 4
 
 static char LOG_TAG[] = "ElevatorApp";
 static int currentFloor = 1;
 //---------------Floor position: 0, 1, 2, 3, 4, 5, 6, 7 // 0 change to G for display
 static int chosenFloorList[8] = {0, 0, 1, 0, 0, 0, 0, 0};
+// Hall calls waiting at each floor, one bit per ElevatorProtocol::hall_direction_t
+static uint8_t hallCallList[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+static volatile bool carMoving = false;
+static volatile bool carGoingDown = false;
 
 BLECharacteristic *pCharacteristic;
+BLECharacteristic *pEventsCharacteristic;
 BLEAdvertising *pAdvertising;
+ConnParamsTuner *pConnParamsTuner;
+
+// Events handed from the BLE callbacks to BleEventTask
+typedef enum {
+	EVT_CONNECT,
+	EVT_DISCONNECT,
+	EVT_WRITE
+} ElevatorEvent_t;
+static BLEEventRing eventRing;
 
 static int convertChosenFloor() {
     int decimal = 0;
@@ -41,18 +60,99 @@ static int convertChosenFloor() {
     return decimal;
 }
 
+// Floors with a hall call going the given way, one bit per floor.
+static int convertHallCalls(ElevatorProtocol::hall_direction_t direction) {
+	int mask = 0;
+	for (int i = 7; i >= 0; i--) {
+		mask = (mask * 2) + ((hallCallList[i] >> direction) & 1);
+	}
+	return mask;
+}
+
+// Floors the car has to stop at, for a call from inside the car or from the hall.
+static int convertCalledFloors() {
+	return convertChosenFloor() | convertHallCalls(ElevatorProtocol::HALL_UP) | convertHallCalls(ElevatorProtocol::HALL_DOWN);
+}
+
+// Status broadcast in the advertising manufacturer data for observers that do not connect:
+// [company id: 0xffff, little endian][format: 1][current floor][flags][called floor mask]
+#define STATUS_ADV_FORMAT        1
+#define STATUS_ADV_FLAG_MOVING   0x01
+#define STATUS_ADV_FLAG_DOWN     0x02
+#define STATUS_ADV_MIN_PERIOD_MS 1000
+
+static uint8_t statusFlags() {
+	uint8_t flags = 0;
+	if (carMoving) flags |= STATUS_ADV_FLAG_MOVING;
+	if (carGoingDown) flags |= STATUS_ADV_FLAG_DOWN;
+	return flags;
+}
+
+static void advertiseStatus() {
+	static std::string lastStatus;
+	static TickType_t lastUpdate = 0;
+
+	if (pAdvertising == nullptr) return;
+
+	char status[6] = {
+		(char)0xff, (char)0xff,
+		STATUS_ADV_FORMAT,
+		(char)currentFloor,
+		(char)statusFlags(),
+		(char)convertCalledFloors()
+	};
+	std::string data(status, sizeof(status));
+
+	// Only change the advertising data when the status changes, and not more often than once a period;
+	// a change held back is sent on a later call.
+	TickType_t now = xTaskGetTickCount();
+	if (data == lastStatus || (now - lastUpdate) * portTICK_PERIOD_MS < STATUS_ADV_MIN_PERIOD_MS) return;
+	lastStatus = data;
+	lastUpdate = now;
+	pAdvertising->setManufacturerData(data);
+}
+
+// Status notified to connected apps: [current floor][called floor mask][hall up mask][hall down mask]
+static void notifyStatus() {
+	uint8_t value[4];
+	value[0] = currentFloor;
+	value[1] = convertCalledFloors();
+	value[2] = convertHallCalls(ElevatorProtocol::HALL_UP);
+	value[3] = convertHallCalls(ElevatorProtocol::HALL_DOWN);
+#if DEBUG_APP == 1
+	// ESP_LOGI(LOG_TAG, "Current floor: %d | called: 0x%.2x", value[0], value[1]);
+#endif
+	pCharacteristic->setValue(value, sizeof(value));
+	pCharacteristic->notify();
+}
+
+// Records notified on the events characteristic, packed several to a notification by BLENotifyQueue:
+// [type][length][data] ...
+#define RECORD_POSITION 1  // [current floor][flags]; only the latest is sent.
+#define RECORD_CALL     2  // [floor][CALL_ADDED, CALL_CANCELLED or CALL_SERVED]; every one is sent.
+#define CALL_ADDED      0
+#define CALL_CANCELLED  1
+#define CALL_SERVED     2
+
+static void notifyPosition() {
+	if (pEventsCharacteristic == nullptr) return;
+	uint8_t record[2] = { (uint8_t)currentFloor, statusFlags() };
+	pEventsCharacteristic->notifyRecord(RECORD_POSITION, record, sizeof(record), true);
+}
+
+static void notifyCall(int floor, uint8_t action) {
+	if (pEventsCharacteristic == nullptr) return;
+	uint8_t record[2] = { (uint8_t)floor, action };
+	pEventsCharacteristic->notifyRecord(RECORD_CALL, record, sizeof(record));
+}
+
 class MyNotifyTask: public Task {
 	void run(void *data) {
-		uint8_t value[2];
 		while(1) {
 			delay(600);
-			value[0] = currentFloor;
-			value[1] = convertChosenFloor();
-#if DEBUG_APP == 1
-			// ESP_LOGI(LOG_TAG, "Current floor: %d | chosen: 0x%.2x", value[0], value[1]);
-#endif
-			pCharacteristic->setValue(value, 2);
-			pCharacteristic->notify();
+			notifyStatus();
+			// Short intervals while there is a call to serve, long ones when idle.
+			pConnParamsTuner->update(convertCalledFloors() != 0 || carMoving);
 		} // While 1
 	} // run
 }; // MyNotifyTask
@@ -64,15 +164,31 @@ class MainTask: public Task {
 		GOING_DOWN
 	} FloorDirection_t;
 
+	static uint8_t hallBit(FloorDirection_t dir) {
+		return 1 << (dir == GOING_UP ? ElevatorProtocol::HALL_UP : ElevatorProtocol::HALL_DOWN);
+	}
+
+	// The car stops on its way for calls from inside it and for hall calls going the same way.
+	bool stopsAt(int floor, FloorDirection_t dir) {
+		return chosenFloorList[floor] || (hallCallList[floor] & hallBit(dir));
+	}
+
+	// Going up, the nearest floor above to stop at or else the highest hall call above, which the car
+	// turns around at.  Going down the same, counting the current floor, and with the lowest hall call.
 	int getDestinationFloor(FloorDirection_t &dir) {
 		int result = -1;
 		if (dir == GOING_UP) {
 			for (int i = currentFloor+1; i < MAX_FLOOR; i++) {
-				if (chosenFloorList[i]) { // chosen 
+				if (stopsAt(i, GOING_UP)) {
 					result = i;
 					break;
 				}
 			}
+			for (int i = MAX_FLOOR - 1; result == -1 && i > currentFloor; i--) {
+				if (hallCallList[i]) {
+					result = i;
+				}
+			}
 			if (result == -1) {
 				dir = GOING_DOWN;
 			}
@@ -80,11 +196,16 @@ class MainTask: public Task {
 
 		if (dir == GOING_DOWN) { 
 			for (int i = currentFloor; i >= 0; i--) {
-				if (chosenFloorList[i]) { // chosen 
+				if (stopsAt(i, GOING_DOWN)) {
 					result = i;
 					break;
 				}
 			}
+			for (int i = 0; result == -1 && i <= currentFloor; i++) {
+				if (hallCallList[i]) {
+					result = i;
+				}
+			}
 			if (result == -1) {
 				dir = GOING_UP;
 			}
@@ -93,8 +214,25 @@ class MainTask: public Task {
 		return result;
 	}
 
-	void deleteChosenFloor(int floor) {
+	// Is there a call the car has to go on past the floor for?
+	bool callsBeyond(int floor, FloorDirection_t dir) {
+		int step = (dir == GOING_UP) ? 1 : -1;
+		for (int i = floor + step; i >= 0 && i < MAX_FLOOR; i += step) {
+			if (chosenFloorList[i] || hallCallList[i]) return true;
+		}
+		return false;
+	}
+
+	// Arriving going one way serves the hall call going that way; the other one is served too when
+	// the car turns around here.
+	void deleteChosenFloor(int floor, FloorDirection_t dir) {
 		chosenFloorList[floor] = 0;
+		if (callsBeyond(floor, dir)) {
+			hallCallList[floor] &= ~hallBit(dir);
+		} else {
+			hallCallList[floor] = 0;
+		}
+		notifyCall(floor, CALL_SERVED);
 	}
 
 	bool elevatorDetected(int floor) {
@@ -140,6 +278,8 @@ class MainTask: public Task {
 		int nextFloor = 0;
 
 		while(1) {
+			advertiseStatus();
+
 			if (!isMoving) {
 				destinationFloor = getDestinationFloor(currentDirection);
 				ESP_LOGI(LOG_TAG, "destinationFloor: %d", destinationFloor);
@@ -148,6 +288,7 @@ class MainTask: public Task {
 
 			if (destinationFloor == -1) {
 				isMoving = false;
+				carMoving = false;
 				ESP_LOGI(LOG_TAG, "No chosen floor pick, wait for 1s");
 				delay(1000);
 				continue;
@@ -176,8 +317,10 @@ class MainTask: public Task {
 					ESP_LOGI(LOG_TAG, "Stopping motor...");
 					myStepper_->stop();
 					currentFloor = destinationFloor;
-					deleteChosenFloor(destinationFloor);
+					deleteChosenFloor(destinationFloor, currentDirection);
 					isMoving = false;
+					carMoving = false;
+					notifyPosition();
 					
 					delay(2500); // Set delay simulation
 					continue;
@@ -186,11 +329,14 @@ class MainTask: public Task {
 				if (elevatorDetected(nextFloor)) {
 					currentFloor = nextFloor;
 					ESP_LOGI(LOG_TAG, "Current floor %d", currentFloor);
+					notifyPosition();
 				}
 
 			}
 
 			// Here move motor
+			carMoving = true;
+			carGoingDown = (currentDirection == GOING_DOWN);
 			int stepsDir = (currentDirection == GOING_UP) ? 1 : -1;
 			myStepper_->step(10 * stepsDir);
 
@@ -200,25 +346,131 @@ class MainTask: public Task {
 	}
 };
 
-class MyCallbacks: public BLECharacteristicCallbacks {
-	void onWrite(BLECharacteristic *pCharacteristic) {
-		std::string value = pCharacteristic->getValue();
-		if (value.length() > 0) {
-				int tmp = value[0];
-				chosenFloorList[tmp] = 1;
-				ESP_LOGI(LOG_TAG, "Floor %d added to list", tmp);
+class BleEventTask: public Task {
+	int connectedClients = 0;
+
+	void handleCommand(const uint8_t *pData, size_t length) {
+		// Parse in place in the event slot.
+		ElevatorProtocol frame(pData, length);
+		const char* error = frame.validate(MAX_FLOOR);
+		if (error != nullptr) {
+			ESP_LOGW(LOG_TAG, "Command rejected: %s", error);
+			return;
+		}
+
+		if (frame.isLegacy()) {
+			int tmp = pData[0];
+			chosenFloorList[tmp] = 1;
+			notifyCall(tmp, CALL_ADDED);
+			ESP_LOGI(LOG_TAG, "Floor %d added to list", tmp);
+			return;
+		}
+
+		bool statusQueried = false;
+		ElevatorProtocol::command_t command;
+		while (frame.next(&command)) {
+			switch (command.type) {
+				case ElevatorProtocol::CMD_FLOOR_CALL:
+					for (int i = 0; i < command.length; i++) {
+						chosenFloorList[command.pValue[i]] = 1;
+						notifyCall(command.pValue[i], CALL_ADDED);
+						ESP_LOGI(LOG_TAG, "Floor %d added to list", command.pValue[i]);
+					}
+					break;
+
+				case ElevatorProtocol::CMD_CANCEL:
+					for (int i = 0; i < command.length; i++) {
+						chosenFloorList[command.pValue[i]] = 0;
+						hallCallList[command.pValue[i]] = 0;
+						notifyCall(command.pValue[i], CALL_CANCELLED);
+						ESP_LOGI(LOG_TAG, "Floor %d removed from list", command.pValue[i]);
+					}
+					break;
+
+				case ElevatorProtocol::CMD_HALL_CALL:
+					for (int i = 0; i < command.length; i += 2) {
+						int floor = command.pValue[i];
+						hallCallList[floor] |= (1 << command.pValue[i + 1]);
+						notifyCall(floor, CALL_ADDED);
+						ESP_LOGI(LOG_TAG, "Hall call at floor %d going %s", floor,
+							command.pValue[i + 1] == ElevatorProtocol::HALL_UP ? "up" : "down");
+					}
+					break;
+
+				case ElevatorProtocol::CMD_STATUS_QUERY:
+					statusQueried = true;
+					break;
+
+				case ElevatorProtocol::CMD_TIME_SYNC: {
+					struct timeval tv;
+					tv.tv_sec  = ElevatorProtocol::getTimeSync(&command);
+					tv.tv_usec = 0;
+					settimeofday(&tv, nullptr);
+					ESP_LOGI(LOG_TAG, "Time set to %ld", (long)tv.tv_sec);
+					break;
+				}
+
+				default:
+					break;
+			}
+		}
+
+		// Answer after all the calls of this write have been applied so the status reflects them.
+		if (statusQueried) {
+			notifyStatus();
+		}
+	}
+
+	void run(void *data) {
+		ble_event_t event;
+		while (1) {
+			eventRing.wait();
+			while (eventRing.pop(&event)) {
+				switch (event.type) {
+					case EVT_CONNECT:
+						// Only the first client starts the task.
+						if (connectedClients++ == 0) {
+							pMyNotifyTask->start();
+						}
+						break;
+
+					case EVT_DISCONNECT:
+						if (connectedClients > 0 && --connectedClients == 0) {
+							pMyNotifyTask->stop();
+						}
+						break;
+
+					case EVT_WRITE:
+						if (event.truncated) {
+							ESP_LOGW(LOG_TAG, "Command rejected: too long");
+							break;
+						}
+						handleCommand(event.data, event.length);
+						break;
+
+					default:
+						break;
+				}
 			}
 		}
+	}
+};
+BleEventTask *pBleEventTask;
+
+// The BLE callbacks run in the Bluedroid task, so they only copy the event into the ring and return.
+class MyCallbacks: public BLECharacteristicCallbacks {
+	void onWrite(BLECharacteristic *pCharacteristic) {
+		eventRing.push(EVT_WRITE, 0, pCharacteristic, pCharacteristic->getData(), pCharacteristic->getLength());
+	}
 };
 
 class MyServerCallbacks: public BLEServerCallbacks {
-	void onConnect(BLEServer* pServer) {
-		pMyNotifyTask->start();
-		pAdvertising->start();
+	void onConnect(BLEServer* pServer, esp_ble_gatts_cb_param_t *param) {
+		eventRing.push(EVT_CONNECT, param->connect.conn_id);
 	};
 
 	void onDisconnect(BLEServer* pServer) {
-		pMyNotifyTask->stop();
+		eventRing.push(EVT_DISCONNECT, 0);
 	}
 };
 
@@ -233,28 +485,46 @@ void RunElevator() {
 	pMainTask->setStackSize(5000);
 	pMainTask->start();
 
+	pBleEventTask = new BleEventTask();
+	pBleEventTask->setStackSize(5000);
+	pBleEventTask->start();
+
 	BLEDevice::init("Elevator");
 	BLEDevice::setPower(ESP_PWR_LVL_P1);
 	BLEServer *pServer = BLEDevice::createServer();
 	pServer->setCallbacks(new MyServerCallbacks());
+	pConnParamsTuner = new ConnParamsTuner(pServer);
 
 	BLEService *pService = pServer->createService(BLEUUID(SERVICE_UUID));
 
+	// Calls are idempotent, so the app may submit them with write without response and take the
+	// next status notification, which carries the chosen floors, as the acknowledgement.
 	pCharacteristic = pService->createCharacteristic(
 		BLEUUID(CHARACTERISTIC_UUID),
-		BLECharacteristic::PROPERTY_WRITE | BLECharacteristic::PROPERTY_NOTIFY
+		BLECharacteristic::PROPERTY_WRITE | BLECharacteristic::PROPERTY_WRITE_NR | BLECharacteristic::PROPERTY_NOTIFY
 	);
 
 	pCharacteristic->setCallbacks(new MyCallbacks());
 
-	BLE2902* p2902Descriptor = new BLE2902();
-	p2902Descriptor->setNotifications(true);
-	pCharacteristic->addDescriptor(p2902Descriptor);
+	// Each client subscribes by writing this descriptor; only subscribed clients are notified.
+	pCharacteristic->addDescriptor(new BLE2902());
+
+	// Position and call changes as they happen, for apps that want more than the periodic status.
+	pEventsCharacteristic = pService->createCharacteristic(
+		BLEUUID(EVENTS_CHARACTERISTIC_UUID),
+		BLECharacteristic::PROPERTY_NOTIFY
+	);
+	pEventsCharacteristic->addDescriptor(new BLE2902());
 
 	pService->start();
 
 	pAdvertising = pServer->getAdvertising();
 	pAdvertising->addServiceUUID(BLEUUID(pService->getUUID()));
-	pAdvertising->start();
+
+	// Fast advertising after boot and after a disconnect, slow once nobody has connected for a while,
+	// none while every connection slot is taken.
+	BLEAdvertisingManager *pAdvertisingManager = new BLEAdvertisingManager(pAdvertising);
+	pServer->setAdvertisingManager(pAdvertisingManager);
+	pAdvertisingManager->start();
 	
 }
\ No newline at end of file